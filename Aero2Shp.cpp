@@ -13,28 +13,20 @@ Aero2Shp::~Aero2Shp()
 	//OGRCleanupAll();
 }
 
-struct ptd
-{
-	double dx;
-	double dy;
-};
-
-
 void Aero2Shp::TranslateFile(const QString& strAeroFile, const QStringList& strShpFileList)
 {
-	OGRRegisterAll();
-	CPLSetConfigOption("GDAL_FILENAME_IS_UTF8", "YES");
-	OGRSFDriverRegistrar* poR = OGRSFDriverRegistrar::GetRegistrar();
-	OGRSFDriver* poDriver = poR->GetDriverByName("ESRI Shapefile");
-
-	if (poDriver == nullptr)
+	QList<QList<ptd> > listLines;
+	if (!ReadFile(strAeroFile, listLines))
 		return;
 
+	WriteShp(listLines, strShpFileList);
+}
+
+bool Aero2Shp::ReadFile(const QString& strAeroFile, QList<QList<ptd> >& listLines)
+{
 	QFile file(strAeroFile);
 	if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
-		return;
-
-	QList<QList<ptd> > listLines;
+		return false;
 
 	QList<ptd> currentLine;
 
@@ -70,6 +62,19 @@ void Aero2Shp::TranslateFile(const QString& strAeroFile, const QStringList& strS
 		currentLine.clear();
 	}
 
+	return true;
+}
+
+void Aero2Shp::WriteShp(const QList<QList<ptd> >& listLines, const QStringList& strShpFileList)
+{
+	OGRRegisterAll();
+	CPLSetConfigOption("GDAL_FILENAME_IS_UTF8", "YES");
+	OGRSFDriverRegistrar* poR = OGRSFDriverRegistrar::GetRegistrar();
+	OGRSFDriver* poDriver = poR->GetDriverByName("ESRI Shapefile");
+
+	if (poDriver == nullptr)
+		return;
+
 	OGRDataSource* poDSLine = poDriver->CreateDataSource(strShpFileList[0].toUtf8().data());
 	OGRDataSource* poDSPoint = poDriver->CreateDataSource(strShpFileList[1].toUtf8().data());
 
@@ -86,14 +91,14 @@ void Aero2Shp::TranslateFile(const QString& strAeroFile, const QStringList& strS
 	OGRFeatureDefn* pDefnPoint = poLayerPoint->GetLayerDefn();
 
 	//
-	for (QList<QList<ptd> >::iterator itr = listLines.begin(); itr != listLines.end();itr ++)
+	for (QList<QList<ptd> >::const_iterator itr = listLines.begin(); itr != listLines.end();itr ++)
 	{
-		QList<ptd>& line = *itr;
+		const QList<ptd>& line = *itr;
 		OGRLineString lineString;
 		
-		for (QList<ptd>::iterator itrLine = line.begin(); itrLine != line.end(); itrLine ++)
+		for (QList<ptd>::const_iterator itrLine = line.begin(); itrLine != line.end(); itrLine ++)
 		{
-			ptd& point = *itrLine;
+			const ptd& point = *itrLine;
 			lineString.addPoint(point.dx, point.dy);
 		}
 
@@ -110,33 +115,36 @@ void Aero2Shp::TranslateFile(const QString& strAeroFile, const QStringList& strS
 	oField.SetWidth(32);
 	poLayerPoint->CreateField(&oField);
 
-	char strName[33];
-	char lineId = 'a';
+	int nLine = 0;
 	int nPointTag = 1;
-	for (QList<QList<ptd> >::iterator itr = listLines.begin(); itr != listLines.end(); itr++)
+	for (QList<QList<ptd> >::const_iterator itr = listLines.begin(); itr != listLines.end(); itr++)
 	{
-		QList<ptd>& line = *itr;
+		const QList<ptd>& line = *itr;
 		
-		for (QList<ptd>::iterator itrLine = line.begin(); itrLine != line.end(); itrLine++)
+		for (QList<ptd>::const_iterator itrLine = line.begin(); itrLine != line.end(); itrLine++)
 		{
-			ptd& point = *itrLine;
+			const ptd& point = *itrLine;
 			OGRPoint ogrPoint(point.dx, point.dy);
 
 			OGRFeature* poFeature = OGRFeature::CreateFeature(pDefnPoint);
 			poFeature->SetGeometry(&ogrPoint);
 
-			sprintf(strName, "%c%d", lineId, nPointTag);
-			poFeature->SetField("Name", strName);
+			poFeature->SetField("Name", WaypointName(nLine, nPointTag).toUtf8().data());
 			poLayerPoint->CreateFeature(poFeature);
 
 			OGRFeature::DestroyFeature(poFeature);
 			nPointTag++;
 		}
 
-		lineId += 1;
+		nLine += 1;
 		nPointTag = 1;
 	}
 
 	OGRDataSource::DestroyDataSource(poDSLine);
 	OGRDataSource::DestroyDataSource(poDSPoint);
 }
+
+QString Aero2Shp::WaypointName(int nLine, int nPoint)
+{
+	return QString("%1%2").arg(QChar('a' + nLine)).arg(nPoint);
+}
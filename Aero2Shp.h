@@ -2,6 +2,14 @@
 #define AERO2SHP_H
 
 #include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QList>
+
+struct ptd
+{
+	double dx;
+	double dy;
+};
 
 class Aero2Shp
 {
@@ -11,6 +19,15 @@ public:
 
 	static void TranslateFile(const QString& strAeroFile, const QStringList& strShpFileList);
 
+	//read the route lines of an AeroLine file, dx is longitude and dy latitude
+	static bool ReadFile(const QString& strAeroFile, QList<QList<ptd> >& listLines);
+
+	//write the lines and their waypoints to the line/point shapefiles in strShpFileList
+	static void WriteShp(const QList<QList<ptd> >& listLines, const QStringList& strShpFileList);
+
+	//label of a waypoint: a letter per line and the 1-based point number, e.g. "b3"
+	static QString WaypointName(int nLine, int nPoint);
+
 private:
 	
 };
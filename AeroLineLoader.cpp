@@ -0,0 +1,220 @@
+#include "AeroLineLoader.h"
+#include <QtCore/QFileInfo>
+#include "Trace.h"
+
+AeroLineLoader::AeroLineLoader(osg::Group* pRoot, const osg::EllipsoidModel* pEllipsoid, QObject *parent)
+	: QObject(parent), m_bWatching(false)
+{
+	m_pRouteNode = new RouteBatchNode(pEllipsoid);
+	m_pRouteNode->SetColor(osg::Vec4(1.0f, 0.0f, 0.0f, 1.0f));
+	m_pRouteNode->SetLineWidth(4.0f);
+	pRoot->addChild(m_pRouteNode.get());
+
+	m_pWaypointNode = new WaypointSpriteNode(pEllipsoid);
+	m_pWaypointNode->SetColors(osg::Vec4(1.0f, 0.0f, 0.0f, 1.0f), osg::Vec4(1.0f, 1.0f, 0.0f, 1.0f));
+	pRoot->addChild(m_pWaypointNode.get());
+
+	m_pLabelNode = new WaypointLabelNode(pEllipsoid);
+	pRoot->addChild(m_pLabelNode.get());
+
+	//editors save in several steps, wait for the file to settle before reloading
+	m_timerReload.setSingleShot(true);
+	m_timerReload.setInterval(200);
+
+	connect(&m_timerReload, SIGNAL(timeout()), this, SLOT(slotReload()));
+	connect(&m_watcher, SIGNAL(fileChanged(const QString&)), this, SLOT(slotFileChanged(const QString&)));
+}
+
+AeroLineLoader::~AeroLineLoader()
+{
+
+}
+
+bool AeroLineLoader::Load(const QString& strFileName)
+{
+	RM_TRACE_ZONE("AeroLine load");
+
+	QList<QList<ptd> > listLines;
+	{
+		RM_TRACE_ZONE("AeroLine read");
+		if (!Aero2Shp::ReadFile(strFileName, listLines))
+			return false;
+	}
+
+	if (!m_strFileName.isEmpty())
+		m_watcher.removePath(m_strFileName);
+
+	m_strFileName = strFileName;
+
+	if (m_bWatching)
+		m_watcher.addPath(m_strFileName);
+
+	Apply(listLines);
+	return true;
+}
+
+void AeroLineLoader::SetWatching(bool bWatch)
+{
+	m_bWatching = bWatch;
+
+	if (m_strFileName.isEmpty())
+		return;
+
+	if (m_bWatching)
+	{
+		m_watcher.addPath(m_strFileName);
+
+		//pick up edits made while not watching
+		slotReload();
+	}
+	else
+	{
+		m_watcher.removePath(m_strFileName);
+		m_timerReload.stop();
+	}
+}
+
+void AeroLineLoader::slotFileChanged(const QString& strPath)
+{
+	if (strPath != m_strFileName)
+		return;
+
+	m_timerReload.start();
+}
+
+void AeroLineLoader::slotReload()
+{
+	//saving through a rename drops the path from the watcher
+	if (m_bWatching && !m_watcher.files().contains(m_strFileName) && QFileInfo(m_strFileName).exists())
+		m_watcher.addPath(m_strFileName);
+
+	QList<QList<ptd> > listLines;
+	if (!Aero2Shp::ReadFile(m_strFileName, listLines))
+		return;
+
+	Apply(listLines);
+}
+
+void AeroLineLoader::Apply(const QList<QList<ptd> >& listLines)
+{
+	RM_TRACE_ZONE("AeroLine apply");
+
+	std::vector<LoadedLine> vecNewLines(listLines.size());
+
+	QMultiHash<uint, size_t> hashOld;
+	for (size_t i = 0; i < m_vecLines.size(); i++)
+	{
+		hashOld.insert(m_vecLines[i].nHash, i);
+	}
+
+	std::vector<bool> vecMatched(m_vecLines.size(), false);
+	int nAdded = 0;
+	int nRemoved = 0;
+
+	for (int i = 0; i < listLines.size(); i++)
+	{
+		LoadedLine& line = vecNewLines[i];
+		for (QList<ptd>::const_iterator itr = listLines[i].begin(); itr != listLines[i].end(); itr++)
+		{
+			line.vecLonLat.push_back(osg::Vec2d(itr->dx, itr->dy));
+		}
+		line.nHash = HashLine(line.vecLonLat);
+		line.nIndex = i;
+
+		//reuse an unchanged line already in the scene
+		bool bFound = false;
+		QMultiHash<uint, size_t>::iterator itrOld = hashOld.find(line.nHash);
+		for (; itrOld != hashOld.end() && itrOld.key() == line.nHash; itrOld++)
+		{
+			LoadedLine& old = m_vecLines[itrOld.value()];
+			if (vecMatched[itrOld.value()] || old.vecLonLat != line.vecLonLat)
+				continue;
+
+			vecMatched[itrOld.value()] = true;
+			line.nRouteId = old.nRouteId;
+			line.nWaypointId = old.nWaypointId;
+			line.nLabelId = old.nLabelId;
+
+			//waypoint names carry the line index, so a shifted line only needs new labels
+			if (old.nIndex != line.nIndex)
+			{
+				m_pLabelNode->RemoveLine(line.nLabelId);
+				line.nLabelId = AddLabels(line);
+			}
+
+			bFound = true;
+			break;
+		}
+
+		if (!bFound)
+		{
+			AddLine(line);
+			nAdded++;
+		}
+	}
+
+	for (size_t i = 0; i < m_vecLines.size(); i++)
+	{
+		if (!vecMatched[i])
+		{
+			RemoveLine(m_vecLines[i]);
+			nRemoved++;
+		}
+	}
+
+	m_vecLines.swap(vecNewLines);
+
+	{
+		RM_TRACE_ZONE("AeroLine update");
+		m_pRouteNode->Update();
+		m_pWaypointNode->Update();
+		m_pLabelNode->Update();
+	}
+
+	emit sigLinesChanged(nAdded, nRemoved);
+}
+
+void AeroLineLoader::AddLine(LoadedLine& line)
+{
+	line.nRouteId = m_pRouteNode->AddLine(line.vecLonLat);
+	line.nWaypointId = m_pWaypointNode->AddLine(line.vecLonLat);
+	line.nLabelId = AddLabels(line);
+
+	m_conformance.AddLine(line.nRouteId, line.vecLonLat);
+}
+
+void AeroLineLoader::GetLines(std::vector<std::vector<osg::Vec2d> >& vecLines) const
+{
+	vecLines.resize(m_vecLines.size());
+	for (size_t i = 0; i < m_vecLines.size(); i++)
+		vecLines[i] = m_vecLines[i].vecLonLat;
+}
+
+void AeroLineLoader::RemoveLine(const LoadedLine& line)
+{
+	m_pRouteNode->RemoveLine(line.nRouteId);
+	m_pWaypointNode->RemoveLine(line.nWaypointId);
+	m_pLabelNode->RemoveLine(line.nLabelId);
+
+	m_conformance.RemoveLine(line.nRouteId);
+}
+
+unsigned int AeroLineLoader::AddLabels(const LoadedLine& line)
+{
+	std::vector<std::string> vecNames;
+	for (size_t i = 0; i < line.vecLonLat.size(); i++)
+	{
+		vecNames.push_back(Aero2Shp::WaypointName(line.nIndex, i + 1).toStdString());
+	}
+
+	return m_pLabelNode->AddLine(line.vecLonLat, vecNames);
+}
+
+uint AeroLineLoader::HashLine(const std::vector<osg::Vec2d>& vecLonLat)
+{
+	if (vecLonLat.empty())
+		return 0;
+
+	QByteArray bytes = QByteArray::fromRawData(reinterpret_cast<const char*>(&vecLonLat[0]), vecLonLat.size() * sizeof(osg::Vec2d));
+	return qHash(bytes);
+}
@@ -0,0 +1,95 @@
+#ifndef AEROLINELOADER_H
+#define AEROLINELOADER_H
+
+#include <QObject>
+#include <QtCore/QFileSystemWatcher>
+#include <QtCore/QTimer>
+#include <QtCore/QMultiHash>
+
+#include <osg/Group>
+#include <osg/EllipsoidModel>
+
+#include "Aero2Shp.h"
+#include "RouteBatchNode.h"
+#include "WaypointSpriteNode.h"
+#include "WaypointLabelNode.h"
+#include "RouteConformance.h"
+
+/**
+* Loads an AeroLine file into the route, waypoint and label nodes and keeps
+* them in sync with the file.
+*
+* Every (re)load is applied as a diff against the lines already in the
+* scene: lines are matched by a hash of their waypoints, so only the added,
+* removed or changed lines are rebuilt. In watch mode the file is reloaded
+* that way whenever it is saved.
+*/
+class AeroLineLoader : public QObject
+{
+	Q_OBJECT
+
+public:
+	AeroLineLoader(osg::Group* pRoot, const osg::EllipsoidModel* pEllipsoid, QObject *parent = nullptr);
+	~AeroLineLoader();
+
+	//load strFileName, replacing the lines of the previous file
+	bool Load(const QString& strFileName);
+
+	void SetWatching(bool bWatch);
+
+	bool IsWatching() const { return m_bWatching; }
+
+	RouteBatchNode* GetRouteNode() const { return m_pRouteNode.get(); }
+
+	RouteConformance* GetConformance() { return &m_conformance; }
+
+	//waypoints of every loaded line as (lon, lat)
+	void GetLines(std::vector<std::vector<osg::Vec2d> >& vecLines) const;
+
+signals:
+
+	void sigLinesChanged(int nAdded, int nRemoved);
+
+private slots:
+
+	void slotFileChanged(const QString& strPath);
+
+	void slotReload();
+
+private:
+
+	struct LoadedLine
+	{
+		std::vector<osg::Vec2d> vecLonLat;
+		uint nHash;
+		int nIndex;
+		unsigned int nRouteId;
+		unsigned int nWaypointId;
+		unsigned int nLabelId;
+	};
+
+	void Apply(const QList<QList<ptd> >& listLines);
+
+	void AddLine(LoadedLine& line);
+
+	void RemoveLine(const LoadedLine& line);
+
+	unsigned int AddLabels(const LoadedLine& line);
+
+	static uint HashLine(const std::vector<osg::Vec2d>& vecLonLat);
+
+	osg::ref_ptr<RouteBatchNode> m_pRouteNode;
+	osg::ref_ptr<WaypointSpriteNode> m_pWaypointNode;
+	osg::ref_ptr<WaypointLabelNode> m_pLabelNode;
+
+	std::vector<LoadedLine> m_vecLines;
+
+	RouteConformance m_conformance;
+
+	QString m_strFileName;
+	QFileSystemWatcher m_watcher;
+	QTimer m_timerReload;
+	bool m_bWatching;
+};
+
+#endif // AEROLINELOADER_H
@@ -0,0 +1,70 @@
+#include "CompressedImageLayer.h"
+#include "Metrics.h"
+
+#include <osgEarth/ImageUtils>
+#include <osg/Timer>
+
+CompressedImageLayer::CompressedImageLayer(const osgEarth::ImageLayerOptions& options, TextureCompressor::Format nFormat)
+	: osgEarth::ImageLayer(options)
+	, m_nFormat(nFormat)
+{
+
+}
+
+CompressedImageLayer::CompressedImageLayer(const osgEarth::ImageLayerOptions& options, osgEarth::TileSource* pSource, TextureCompressor::Format nFormat)
+	: osgEarth::ImageLayer(options, pSource)
+	, m_nFormat(nFormat)
+{
+
+}
+
+CompressedImageLayer::~CompressedImageLayer()
+{
+
+}
+
+osgEarth::ImageLayer* CompressedImageLayer::Create(const osgEarth::ImageLayerOptions& options, TextureCompressor::Format nFormat, osgEarth::TileSource* pSource)
+{
+	if (nFormat == TextureCompressor::FORMAT_NONE)
+		return pSource ? new osgEarth::ImageLayer(options, pSource) : new osgEarth::ImageLayer(options);
+
+	return pSource ? new CompressedImageLayer(options, pSource, nFormat) : new CompressedImageLayer(options, nFormat);
+}
+
+TextureCompressor::Format CompressedImageLayer::ParseFormat(const std::string& strFormat)
+{
+	if (strFormat == "bc1" || strFormat == "dxt1")
+		return TextureCompressor::FORMAT_BC1;
+	if (strFormat == "bc3" || strFormat == "dxt5")
+		return TextureCompressor::FORMAT_BC3;
+	if (strFormat == "auto")
+		return TextureCompressor::FORMAT_AUTO;
+	return TextureCompressor::FORMAT_NONE;
+}
+
+osgEarth::GeoImage CompressedImageLayer::createImage(const osgEarth::TileKey& key, osgEarth::ProgressCallback* pProgress)
+{
+	//ȡƴӺͶӰImageLayer,õkeyͶӰµƬ
+	osgEarth::GeoImage geoImage = osgEarth::ImageLayer::createImage(key, pProgress);
+	if (!geoImage.valid() || m_nFormat == TextureCompressor::FORMAT_NONE)
+		return geoImage;
+
+	const osg::Image* pImage = geoImage.getImage();
+	if (pImage->isCompressed())
+		return geoImage;
+
+	osg::Timer_t tStart = osg::Timer::instance()->tick();
+
+	osg::ref_ptr<const osg::Image> rgba = pImage;
+	if (pImage->getDataType() != GL_UNSIGNED_BYTE || (pImage->getPixelFormat() != GL_RGBA && pImage->getPixelFormat() != GL_RGB))
+		rgba = osgEarth::ImageUtils::convertToRGBA8(pImage);
+
+	osg::ref_ptr<osg::Image> compressed = rgba.valid() ? TextureCompressor::Compress(rgba.get(), m_nFormat) : nullptr;
+	if (!compressed.valid())
+		return geoImage;
+
+	double dSeconds = osg::Timer::instance()->delta_s(tStart, osg::Timer::instance()->tick());
+	Metrics::Instance()->CountTextureCompression(TextureCompressor::GetRgbaBytes(compressed->s(), compressed->t()),
+		compressed->getTotalSizeInBytesIncludingMipmaps(), dSeconds);
+	return osgEarth::GeoImage(compressed.get(), geoImage.getExtent());
+}
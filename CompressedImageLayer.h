@@ -0,0 +1,50 @@
+#ifndef COMPRESSEDIMAGELAYER_H
+#define COMPRESSEDIMAGELAYER_H
+
+#include "TextureCompressor.h"
+
+#include <osgEarth/ImageLayer>
+
+/**
+* Image layer that hands out its tiles block compressed with
+* TextureCompressor, so they are uploaded as BC1 or BC3 instead of RGBA8.
+*
+* createImage first lets ImageLayer read the tile from the cache or build
+* it from the source, mosaicked and reprojected into the key's profile, so
+* spherical-mercator sources such as Bing and XYZ are compressed on the
+* global-geodetic map too. The cache therefore keeps the raw tiles and the
+* encoding runs on every load, on the osgEarth pager threads, never on the
+* draw thread. Each compressed tile adds its saved bytes and encoding time
+* to Metrics.
+*
+* Callers that only want the tile cached (seeding, prefetching) call
+* osgEarth::ImageLayer::createImage directly to skip the encoding.
+*/
+class CompressedImageLayer : public osgEarth::ImageLayer
+{
+public:
+
+	CompressedImageLayer(const osgEarth::ImageLayerOptions& options, TextureCompressor::Format nFormat);
+
+	CompressedImageLayer(const osgEarth::ImageLayerOptions& options, osgEarth::TileSource* pSource, TextureCompressor::Format nFormat);
+
+	//a plain ImageLayer for FORMAT_NONE, else a CompressedImageLayer; the driver in options is used without pSource
+	static osgEarth::ImageLayer* Create(const osgEarth::ImageLayerOptions& options, TextureCompressor::Format nFormat, osgEarth::TileSource* pSource = nullptr);
+
+	//none, bc1, bc3 or auto
+	static TextureCompressor::Format ParseFormat(const std::string& strFormat);
+
+	TextureCompressor::Format GetFormat() const { return m_nFormat; }
+
+	virtual osgEarth::GeoImage createImage(const osgEarth::TileKey& key, osgEarth::ProgressCallback* pProgress = 0L) override;
+
+protected:
+
+	virtual ~CompressedImageLayer();
+
+private:
+
+	TextureCompressor::Format m_nFormat;
+};
+
+#endif // COMPRESSEDIMAGELAYER_H
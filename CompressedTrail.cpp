@@ -0,0 +1,190 @@
+#include "CompressedTrail.h"
+
+#include <algorithm>
+#include <math.h>
+
+//: ʱ1,γ1e-7(Լ1),߶1
+static const double s_pScale[4] = { 1000.0, 1e7, 1e7, 10.0 };
+
+static void Quantize(const CompressedTrail::Point& point, long long* pValues)
+{
+	pValues[0] = (long long)floor(point.dTime * s_pScale[0] + 0.5);
+	pValues[1] = (long long)floor(point.dLon * s_pScale[1] + 0.5);
+	pValues[2] = (long long)floor(point.dLat * s_pScale[2] + 0.5);
+	pValues[3] = (long long)floor(point.dAlt * s_pScale[3] + 0.5);
+}
+
+static void Dequantize(const long long* pValues, CompressedTrail::Point& point)
+{
+	point.dTime = pValues[0] / s_pScale[0];
+	point.dLon = pValues[1] / s_pScale[1];
+	point.dLat = pValues[2] / s_pScale[2];
+	point.dAlt = pValues[3] / s_pScale[3];
+}
+
+//zigzagСĸӳС,ٰÿֽ7λд
+static void WriteVarint(long long nValue, std::string& strData)
+{
+	unsigned long long n = ((unsigned long long)nValue << 1) ^ (unsigned long long)(nValue >> 63);
+	while (n >= 0x80)
+	{
+		strData.push_back((char)(n | 0x80));
+		n >>= 7;
+	}
+	strData.push_back((char)n);
+}
+
+static long long ReadVarint(const unsigned char*& p)
+{
+	unsigned long long n = 0;
+	int nShift = 0;
+	while (*p & 0x80)
+	{
+		n |= (unsigned long long)(*p ++ & 0x7f) << nShift;
+		nShift += 7;
+	}
+	n |= (unsigned long long)(*p ++) << nShift;
+
+	return (long long)(n >> 1) ^ -(long long)(n & 1);
+}
+
+CompressedTrail::CompressedTrail()
+{
+	m_nPoints = 0;
+}
+
+bool CompressedTrail::Append(const Point& point)
+{
+	m_vecOpen.push_back(point);
+	m_nPoints ++;
+
+	if (m_vecOpen.size() < BLOCK_POINTS)
+		return false;
+
+	Seal();
+	return true;
+}
+
+void CompressedTrail::Clear()
+{
+	m_dequeBlocks.clear();
+	m_vecOpen.clear();
+	m_nPoints = 0;
+}
+
+void CompressedTrail::PopFront()
+{
+	if (m_dequeBlocks.empty())
+		return;
+
+	m_nPoints -= m_dequeBlocks.front().info.nCount;
+	m_dequeBlocks.pop_front();
+}
+
+void CompressedTrail::Seal()
+{
+	Block block;
+	BlockInfo& info = block.info;
+	info.nCount = m_vecOpen.size();
+	info.dTimeMin = info.dTimeMax = m_vecOpen[0].dTime;
+	info.dLonMin = info.dLonMax = m_vecOpen[0].dLon;
+	info.dLatMin = info.dLatMax = m_vecOpen[0].dLat;
+
+	block.strData.reserve(m_vecOpen.size() * 8);
+
+	long long pPrev[4] = { 0, 0, 0, 0 };
+	long long pDelta[4] = { 0, 0, 0, 0 };
+	long long pValues[4];
+
+	for (size_t i = 0; i < m_vecOpen.size(); i ++)
+	{
+		const Point& point = m_vecOpen[i];
+		info.dTimeMin = std::min(info.dTimeMin, point.dTime);
+		info.dTimeMax = std::max(info.dTimeMax, point.dTime);
+		info.dLonMin = std::min(info.dLonMin, point.dLon);
+		info.dLonMax = std::max(info.dLonMax, point.dLon);
+		info.dLatMin = std::min(info.dLatMin, point.dLat);
+		info.dLatMax = std::max(info.dLatMax, point.dLat);
+
+		//һֵ,ڶֵ,ֵ֮Ĳֵ
+		Quantize(point, pValues);
+		for (int n = 0; n < 4; n ++)
+		{
+			long long nDelta = pValues[n] - pPrev[n];
+			WriteVarint(i < 2 ? nDelta : nDelta - pDelta[n], block.strData);
+			pDelta[n] = i == 0 ? 0 : nDelta;
+			pPrev[n] = pValues[n];
+		}
+	}
+
+	Dequantize(pPrev, info.last);
+
+	//ԤСö,ȥ
+	std::string(block.strData).swap(block.strData);
+
+	m_dequeBlocks.push_back(block);
+	m_vecOpen.clear();
+}
+
+void CompressedTrail::DecodeBlock(unsigned int nBlock, std::vector<Point>& vecPoints) const
+{
+	const Block& block = m_dequeBlocks[nBlock];
+	const unsigned char* p = reinterpret_cast<const unsigned char*>(block.strData.data());
+
+	long long pValues[4] = { 0, 0, 0, 0 };
+	long long pDelta[4] = { 0, 0, 0, 0 };
+
+	Point point;
+	for (unsigned int i = 0; i < block.info.nCount; i ++)
+	{
+		for (int n = 0; n < 4; n ++)
+		{
+			long long nValue = ReadVarint(p);
+			if (i >= 2)
+				nValue += pDelta[n];
+			pDelta[n] = i == 0 ? 0 : nValue;
+			pValues[n] += nValue;
+		}
+
+		Dequantize(pValues, point);
+		vecPoints.push_back(point);
+	}
+}
+
+unsigned int CompressedTrail::Query(double dBegin, double dEnd, std::vector<Point>& vecPoints) const
+{
+	unsigned int nStart = vecPoints.size();
+
+	std::vector<Point> vecBlock;
+	for (unsigned int i = 0; i < m_dequeBlocks.size(); i ++)
+	{
+		const BlockInfo& info = m_dequeBlocks[i].info;
+		if (info.dTimeMax < dBegin || info.dTimeMin > dEnd)
+			continue;
+
+		vecBlock.clear();
+		DecodeBlock(i, vecBlock);
+		for (size_t n = 0; n < vecBlock.size(); n ++)
+		{
+			if (vecBlock[n].dTime >= dBegin && vecBlock[n].dTime <= dEnd)
+				vecPoints.push_back(vecBlock[n]);
+		}
+	}
+
+	for (size_t n = 0; n < m_vecOpen.size(); n ++)
+	{
+		if (m_vecOpen[n].dTime >= dBegin && m_vecOpen[n].dTime <= dEnd)
+			vecPoints.push_back(m_vecOpen[n]);
+	}
+
+	return vecPoints.size() - nStart;
+}
+
+size_t CompressedTrail::GetMemoryBytes() const
+{
+	size_t nBytes = m_vecOpen.capacity() * sizeof(Point);
+	for (size_t i = 0; i < m_dequeBlocks.size(); i ++)
+		nBytes += sizeof(Block) + m_dequeBlocks[i].strData.capacity();
+
+	return nBytes;
+}
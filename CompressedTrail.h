@@ -0,0 +1,91 @@
+#ifndef COMPRESSEDTRAIL_H
+#define COMPRESSEDTRAIL_H
+
+#include <deque>
+#include <string>
+#include <vector>
+
+/**
+* Position history of one track, compressed in fixed-size blocks.
+*
+* Time is quantized to milliseconds, lon/lat to 1e-7 degree and altitude to
+* decimeters. Inside a block every value is stored as the zigzag varint of
+* its second difference, which is zero or close to it for a track flying
+* straight at constant speed, so a point takes a few bytes instead of the
+* 24 of an ECEF osg::Vec3d. The newest points stay uncompressed until
+* BLOCK_POINTS of them are collected. Blocks keep their time span and
+* bounding box, so readers can pick the blocks they need and decode only
+* those.
+*/
+class CompressedTrail
+{
+public:
+
+	enum { BLOCK_POINTS = 256 };
+
+	struct Point
+	{
+		double dTime;		//seconds since the epoch
+		double dLon;
+		double dLat;
+		double dAlt;
+	};
+
+	struct BlockInfo
+	{
+		unsigned int nCount;
+		double dTimeMin;
+		double dTimeMax;
+		double dLonMin;
+		double dLonMax;
+		double dLatMin;
+		double dLatMax;
+
+		//last point as it decodes, the first vertex of the next block's line
+		Point last;
+	};
+
+	CompressedTrail();
+
+	//returns true if the point completed a block
+	bool Append(const Point& point);
+
+	void Clear();
+
+	//drops the oldest compressed block
+	void PopFront();
+
+	unsigned int GetNumBlocks() const { return m_dequeBlocks.size(); }
+
+	const BlockInfo& GetBlockInfo(unsigned int nBlock) const { return m_dequeBlocks[nBlock].info; }
+
+	//appends the points of one compressed block
+	void DecodeBlock(unsigned int nBlock, std::vector<Point>& vecPoints) const;
+
+	//points not compressed yet
+	const std::vector<Point>& GetOpenPoints() const { return m_vecOpen; }
+
+	//appends the points in [dBegin, dEnd], decoding only the blocks overlapping it
+	unsigned int Query(double dBegin, double dEnd, std::vector<Point>& vecPoints) const;
+
+	unsigned int GetNumPoints() const { return m_nPoints; }
+
+	//heap memory held by the trail
+	size_t GetMemoryBytes() const;
+
+private:
+
+	struct Block
+	{
+		BlockInfo info;
+		std::string strData;
+	};
+
+	void Seal();
+
+	std::deque<Block> m_dequeBlocks;
+	std::vector<Point> m_vecOpen;
+	unsigned int m_nPoints;
+};
+
+#endif // COMPRESSEDTRAIL_H
@@ -0,0 +1,127 @@
+#include "ConflictNode.h"
+
+#include <osg/Geode>
+#include <osg/LineWidth>
+#include <osg/Timer>
+
+#include <QDateTime>
+
+static const osg::Vec4 s_colorConflict(1.0f, 0.0f, 0.0f, 1.0f);
+static const osg::Vec4 s_colorPredicted(1.0f, 0.5f, 0.0f, 1.0f);
+
+namespace
+{
+	class ConflictUpdateCallback : public osg::NodeCallback
+	{
+	public:
+
+		virtual void operator()(osg::Node* node, osg::NodeVisitor* nv)
+		{
+			if (nv->getFrameStamp())
+				static_cast<ConflictNode*>(node)->Refresh(nv->getFrameStamp()->getReferenceTime());
+
+			traverse(node, nv);
+		}
+	};
+}
+
+ConflictNode::ConflictNode(const osg::EllipsoidModel* pEllipsoid, WorkerPool* pPool, double dInterval)
+	: m_pEllipsoid(pEllipsoid)
+	, m_dInterval(dInterval)
+	, m_dLastTime(-1.0)
+	, m_dRunTime(0.0)
+	, m_probe(pPool)
+{
+	setName("conflicts");
+
+	m_pVertices = new osg::Vec3Array;
+	m_pColors = new osg::Vec4Array;
+	m_pPrimitive = new osg::DrawArrays(osg::PrimitiveSet::LINES, 0, 0);
+
+	m_pGeometry = new osg::Geometry;
+	m_pGeometry->setUseDisplayList(false);
+	m_pGeometry->setUseVertexBufferObjects(true);
+	m_pGeometry->setDataVariance(osg::Object::DYNAMIC);
+	m_pGeometry->setVertexArray(m_pVertices.get());
+	m_pGeometry->setColorArray(m_pColors.get(), osg::Array::BIND_PER_VERTEX);
+	m_pGeometry->addPrimitiveSet(m_pPrimitive.get());
+
+	osg::Geode* pGeode = new osg::Geode;
+	pGeode->addDrawable(m_pGeometry.get());
+	addChild(pGeode);
+
+	osg::StateSet* pStateSet = getOrCreateStateSet();
+	pStateSet->setMode(GL_LIGHTING, osg::StateAttribute::OFF | osg::StateAttribute::OVERRIDE);
+	pStateSet->setAttribute(new osg::LineWidth(3.0));
+
+	setUpdateCallback(new ConflictUpdateCallback);
+}
+
+ConflictNode::~ConflictNode()
+{
+}
+
+osg::Vec3d ConflictNode::ToWorld(double dLon, double dLat, double dAlt) const
+{
+	osg::Vec3d world;
+	m_pEllipsoid->convertLatLongHeightToXYZ(osg::DegreesToRadians(dLat), osg::DegreesToRadians(dLon), dAlt, world.x(), world.y(), world.z());
+	return world;
+}
+
+void ConflictNode::Refresh(double dTime)
+{
+	if (m_dLastTime >= 0.0 && dTime - m_dLastTime < m_dInterval)
+		return;
+	m_dLastTime = dTime;
+
+	osg::Timer_t tickStart = osg::Timer::instance()->tick();
+
+	TrackTable::Instance()->Snapshot(m_vecRows);
+	m_probe.Run(m_vecRows, QDateTime::currentMSecsSinceEpoch() / 1000.0, m_vecConflicts);
+
+	m_dRunTime = osg::Timer::instance()->delta_m(tickStart, osg::Timer::instance()->tick());
+
+	UpdateGeometry();
+}
+
+void ConflictNode::UpdateGeometry()
+{
+	m_pVertices->clear();
+	m_pColors->clear();
+
+	//Եһͻ,֤float
+	osg::Vec3d origin;
+	if (!m_vecConflicts.empty())
+	{
+		const ConflictProbe::Conflict& first = m_vecConflicts[0];
+		origin = ToWorld(first.dLonA, first.dLatA, m_vecRows[first.nIndexA].dAlt);
+	}
+	setMatrix(osg::Matrix::translate(origin));
+
+	for (size_t i = 0; i < m_vecConflicts.size(); i ++)
+	{
+		const ConflictProbe::Conflict& conflict = m_vecConflicts[i];
+		double dAltA = m_vecRows[conflict.nIndexA].dAlt;
+		double dAltB = m_vecRows[conflict.nIndexB].dAlt;
+		osg::Vec3 a(ToWorld(conflict.dLonA, conflict.dLatA, dAltA) - origin);
+		osg::Vec3 b(ToWorld(conflict.dLonB, conflict.dLatB, dAltB) - origin);
+
+		m_pVertices->push_back(a);
+		m_pVertices->push_back(b);
+		m_pColors->push_back(s_colorConflict);
+		m_pColors->push_back(s_colorConflict);
+
+		m_pVertices->push_back(a);
+		m_pVertices->push_back(osg::Vec3(ToWorld(conflict.dLonCpaA, conflict.dLatCpaA, dAltA) - origin));
+		m_pVertices->push_back(b);
+		m_pVertices->push_back(osg::Vec3(ToWorld(conflict.dLonCpaB, conflict.dLatCpaB, dAltB) - origin));
+		for (int j = 0; j < 4; j ++)
+			m_pColors->push_back(s_colorPredicted);
+	}
+
+	m_pVertices->dirty();
+	m_pColors->dirty();
+	m_pPrimitive->setCount(m_pVertices->size());
+	m_pPrimitive->dirty();
+	m_pGeometry->dirtyBound();
+}
@@ -0,0 +1,64 @@
+#ifndef CONFLICTNODE_H
+#define CONFLICTNODE_H
+
+#include <osg/MatrixTransform>
+#include <osg/Geometry>
+#include <osg/EllipsoidModel>
+
+#include <vector>
+
+#include "ConflictProbe.h"
+
+/**
+* Runs the conflict probe over the track table and marks the conflicts on
+* the globe.
+*
+* The probe runs from the update traversal at most every dInterval seconds.
+* Every conflict is drawn as a red line between the two tracks and an
+* orange line from each track to its position at the closest point of
+* approach, all in one line geometry that is refilled in place.
+*/
+class ConflictNode : public osg::MatrixTransform
+{
+public:
+
+	ConflictNode(const osg::EllipsoidModel* pEllipsoid, WorkerPool* pPool = nullptr, double dInterval = 0.25);
+
+	ConflictProbe& GetProbe() { return m_probe; }
+
+	const std::vector<ConflictProbe::Conflict>& GetConflicts() const { return m_vecConflicts; }
+
+	unsigned int GetNumConflicts() const { return m_vecConflicts.size(); }
+
+	//time of the last probe run in ms
+	double GetRunTime() const { return m_dRunTime; }
+
+	//called from the update callback
+	void Refresh(double dTime);
+
+protected:
+
+	virtual ~ConflictNode();
+
+private:
+
+	osg::Vec3d ToWorld(double dLon, double dLat, double dAlt) const;
+
+	void UpdateGeometry();
+
+	osg::ref_ptr<const osg::EllipsoidModel> m_pEllipsoid;
+	double m_dInterval;
+	double m_dLastTime;
+	double m_dRunTime;
+
+	ConflictProbe m_probe;
+	std::vector<TrackTable::Row> m_vecRows;
+	std::vector<ConflictProbe::Conflict> m_vecConflicts;
+
+	osg::ref_ptr<osg::Geometry> m_pGeometry;
+	osg::ref_ptr<osg::Vec3Array> m_pVertices;
+	osg::ref_ptr<osg::Vec4Array> m_pColors;
+	osg::ref_ptr<osg::DrawArrays> m_pPrimitive;
+};
+
+#endif // CONFLICTNODE_H
@@ -0,0 +1,288 @@
+#include "ConflictProbe.h"
+#include "WorkerPool.h"
+
+#include <osg/Math>
+
+#include <algorithm>
+#include <math.h>
+
+//ÿγȵ
+static const double s_dMetersPerDegree = 6371000.0 * osg::PI / 180.0;
+
+//γȴȸӻܿ,γȰγ
+static const double s_dMaxGridLatitude = 89.0;
+
+//ÿηָһ̵߳ĸ
+static const unsigned int s_nCellGrain = 8;
+
+static bool CompareTime(const ConflictProbe::Conflict& a, const ConflictProbe::Conflict& b)
+{
+	return a.dTime < b.dTime;
+}
+
+static double WrapLongitude(double dLon)
+{
+	if (dLon > 180.0)
+		return dLon - 360.0;
+	if (dLon < -180.0)
+		return dLon + 360.0;
+	return dLon;
+}
+
+ConflictProbe::ConflictProbe(WorkerPool* pPool)
+	: m_pPool(pPool)
+	, m_dSeparation(5.0 * 1852.0)
+	, m_dVerticalSeparation(304.8)
+	, m_dLookAhead(120.0)
+	, m_dMaxAge(30.0)
+	, m_dCellLon(1.0)
+	, m_dCellLat(1.0)
+	, m_nColumns(360)
+	, m_nGridRows(180)
+	, m_nPairsTested(0)
+{
+
+}
+
+void ConflictProbe::SetSeparation(double dHorizontal, double dVertical)
+{
+	m_dSeparation = dHorizontal;
+	m_dVerticalSeparation = dVertical;
+}
+
+unsigned int ConflictProbe::Run(const std::vector<TrackTable::Row>& vecRows, double dNow, std::vector<Conflict>& vecConflicts)
+{
+	m_vecTracks.clear();
+	m_vecCells.clear();
+	m_nPairsTested = 0;
+
+	//Ƶͬһʱ,ͬʱҳٶȺߵγӴС
+	double dMaxSpeed = 0.0;
+	double dMaxLat = 0.0;
+	for (unsigned int i = 0; i < vecRows.size(); i ++)
+	{
+		const TrackTable::Row& row = vecRows[i];
+		if (!(row.nFlags & TrackTable::FLAG_VALID))
+			continue;
+
+		double dAge = dNow - row.dTime;
+		if (dAge > m_dMaxAge)
+			continue;
+
+		Track track;
+		track.nIndex = i;
+		track.dAlt = row.dAlt;
+		track.dSpeed = row.dVelocity;
+		track.dEast = row.dVelocity * sin(osg::DegreesToRadians(row.dHeading));
+		track.dNorth = row.dVelocity * cos(osg::DegreesToRadians(row.dHeading));
+		track.dLat = row.dLat + track.dNorth * dAge / s_dMetersPerDegree;
+		track.dLat = osg::clampBetween(track.dLat, -90.0, 90.0);
+		track.dCos = cos(osg::DegreesToRadians(track.dLat));
+		track.dLon = row.dLon;
+		if (track.dCos > 1e-6)
+			track.dLon = WrapLongitude(row.dLon + track.dEast * dAge / (s_dMetersPerDegree * track.dCos));
+
+		dMaxSpeed = std::max(dMaxSpeed, track.dSpeed);
+		dMaxLat = std::max(dMaxLat, fabs(track.dLat));
+		m_vecTracks.push_back(track);
+	}
+
+	if (m_vecTracks.size() < 2)
+	{
+		vecConflicts.clear();
+		return 0;
+	}
+
+	//ӲСԤʱڿܽӽ,ֻȽڸ
+	double dReach = m_dSeparation + 2.0 * dMaxSpeed * m_dLookAhead;
+	m_nGridRows = std::max(1, (int)(180.0 / (dReach / s_dMetersPerDegree)));
+	m_dCellLat = 180.0 / m_nGridRows;
+	double dCellLon = m_dCellLat / cos(osg::DegreesToRadians(std::min(dMaxLat, s_dMaxGridLatitude)));
+	m_nColumns = std::max(1, (int)(360.0 / dCellLon));
+	m_dCellLon = 360.0 / m_nColumns;
+
+	//ÿҪȽϵ: пһγ(γ),һеĶȿԶСڿɽӽ
+	m_vecRowSpan.resize(m_nGridRows);
+	for (unsigned int i = 0; i < m_nGridRows; i ++)
+	{
+		double dEdge = std::min(std::max(fabs(i * m_dCellLat - 90.0), fabs((i + 1) * m_dCellLat - 90.0)), dMaxLat);
+		double dCos = cos(osg::DegreesToRadians(dEdge));
+		double dSpan = dCos > 1e-9 ? dReach / (s_dMetersPerDegree * dCos * m_dCellLon) : m_nColumns;
+		m_vecRowSpan[i] = (unsigned int)std::max(1.0, std::min(ceil(dSpan - 1e-9), (double)m_nColumns));
+	}
+
+	//ֻԸӱ,ٰ˳ᶯ
+	m_vecOrder.resize(m_vecTracks.size());
+	for (unsigned int i = 0; i < m_vecTracks.size(); i ++)
+	{
+		const Track& track = m_vecTracks[i];
+		unsigned int nRow = std::min((unsigned int)((track.dLat + 90.0) / m_dCellLat), m_nGridRows - 1);
+		unsigned int nColumn = std::min((unsigned int)((track.dLon + 180.0) / m_dCellLon), m_nColumns - 1);
+		m_vecOrder[i] = std::make_pair((unsigned long long)nRow * m_nColumns + nColumn, i);
+	}
+	std::sort(m_vecOrder.begin(), m_vecOrder.end());
+
+	m_vecSorted.resize(m_vecTracks.size());
+	m_vecRowStart.assign(m_nGridRows + 1, 0);
+	for (unsigned int i = 0; i < m_vecOrder.size(); i ++)
+	{
+		unsigned long long nCell = m_vecOrder[i].first;
+		m_vecSorted[i] = m_vecTracks[m_vecOrder[i].second];
+		if (m_vecCells.empty() || m_vecCells.back().nCell != nCell)
+		{
+			Cell cell;
+			cell.nCell = nCell;
+			cell.nBegin = i;
+			m_vecCells.push_back(cell);
+			m_vecRowStart[nCell / m_nColumns + 1] = m_vecCells.size();
+		}
+		m_vecCells.back().nEnd = i + 1;
+	}
+	m_vecTracks.swap(m_vecSorted);
+
+	//ÿеһӵ,һеĽβ
+	for (unsigned int i = 1; i <= m_nGridRows; i ++)
+		m_vecRowStart[i] = std::max(m_vecRowStart[i], m_vecRowStart[i - 1]);
+
+	unsigned int nWorkers = m_pPool ? m_pPool->GetNumWorkers() : 1;
+	m_vecWorkerConflicts.resize(nWorkers);
+	m_vecWorkerPairs.assign(nWorkers, 0);
+	for (unsigned int i = 0; i < nWorkers; i ++)
+		m_vecWorkerConflicts[i].clear();
+
+	WorkerPool::Func func = [this](unsigned int nBegin, unsigned int nEnd, unsigned int nWorker)
+	{
+		unsigned long long nPairs = 0;
+		for (unsigned int i = nBegin; i < nEnd; i ++)
+			ProbeCell(i, m_vecWorkerConflicts[nWorker], nPairs);
+		m_vecWorkerPairs[nWorker] += nPairs;
+	};
+
+	if (m_pPool)
+		m_pPool->ParallelFor(m_vecCells.size(), s_nCellGrain, func);
+	else
+		func(0, m_vecCells.size(), 0);
+
+	vecConflicts.clear();
+	for (unsigned int i = 0; i < nWorkers; i ++)
+	{
+		vecConflicts.insert(vecConflicts.end(), m_vecWorkerConflicts[i].begin(), m_vecWorkerConflicts[i].end());
+		m_nPairsTested += m_vecWorkerPairs[i];
+	}
+	std::sort(vecConflicts.begin(), vecConflicts.end(), CompareTime);
+
+	return vecConflicts.size();
+}
+
+int ConflictProbe::FindCell(unsigned int nRow, unsigned int nColumn) const
+{
+	//ֻһеĸ
+	std::vector<Cell>::const_iterator itBegin = m_vecCells.begin() + m_vecRowStart[nRow];
+	std::vector<Cell>::const_iterator itEnd = m_vecCells.begin() + m_vecRowStart[nRow + 1];
+	unsigned long long nCell = (unsigned long long)nRow * m_nColumns + nColumn;
+	std::vector<Cell>::const_iterator it = std::lower_bound(itBegin, itEnd, nCell
+		, [](const Cell& cell, unsigned long long n) { return cell.nCell < n; });
+	if (it == itEnd || it->nCell != nCell)
+		return -1;
+
+	return it - m_vecCells.begin();
+}
+
+void ConflictProbe::ProbeCell(unsigned int nCell, std::vector<Conflict>& vecConflicts, unsigned long long& nPairs) const
+{
+	const Cell& cell = m_vecCells[nCell];
+	unsigned int nRow = (unsigned int)(cell.nCell / m_nColumns);
+	unsigned int nColumn = (unsigned int)(cell.nCell % m_nColumns);
+
+	//ÿԺֻŽСһڸһ
+	Conflict conflict;
+	auto probeCell = [&](const Cell& other)
+	{
+		for (unsigned int i = cell.nBegin; i < cell.nEnd; i ++)
+		{
+			const Track& a = m_vecTracks[i];
+			unsigned int nBegin = std::max(other.nBegin, i + 1);
+			if (nBegin >= other.nEnd)
+				continue;
+
+			nPairs += other.nEnd - nBegin;
+			for (unsigned int j = nBegin; j < other.nEnd; j ++)
+			{
+				if (ProbePair(a, m_vecTracks[j], conflict))
+					vecConflicts.push_back(conflict);
+			}
+		}
+	};
+
+	for (int dr = -1; dr <= 1; dr ++)
+	{
+		int nNeighborRow = (int)nRow + dr;
+		if (nNeighborRow < 0 || nNeighborRow >= (int)m_nGridRows)
+			continue;
+
+		//ϴ,߿ͬ,ȷβ;ʱֱһкĸ,ظ
+		unsigned int nSpan = std::max(m_vecRowSpan[nRow], m_vecRowSpan[nNeighborRow]);
+		if (2 * nSpan + 1 >= m_nColumns)
+		{
+			for (unsigned int n = m_vecRowStart[nNeighborRow]; n < m_vecRowStart[nNeighborRow + 1]; n ++)
+				probeCell(m_vecCells[n]);
+			continue;
+		}
+
+		for (unsigned int c = 0; c < 2 * nSpan + 1; c ++)
+		{
+			int nNeighbor = FindCell(nNeighborRow, (nColumn + m_nColumns - nSpan + c) % m_nColumns);
+			if (nNeighbor >= 0)
+				probeCell(m_vecCells[nNeighbor]);
+		}
+	}
+}
+
+bool ConflictProbe::ProbePair(const Track& a, const Track& b, Conflict& conflict) const
+{
+	if (fabs(b.dAlt - a.dAlt) >= m_dVerticalSeparation)
+		return false;
+
+	//ϱѾ̫ԶĲ㾭
+	double dReach = m_dSeparation + (a.dSpeed + b.dSpeed) * m_dLookAhead;
+	double dy = (b.dLat - a.dLat) * s_dMetersPerDegree;
+	if (fabs(dy) >= dReach)
+		return false;
+
+	//еΪеƽ,xy;಻Զ,γȡƽ
+	double dCos = (a.dCos + b.dCos) * 0.5;
+	double dx = WrapLongitude(b.dLon - a.dLon) * s_dMetersPerDegree * dCos;
+	double dRange2 = dx * dx + dy * dy;
+	if (dRange2 >= dReach * dReach)
+		return false;
+
+	double wx = b.dEast - a.dEast;
+	double wy = b.dNorth - a.dNorth;
+	double w2 = wx * wx + wy * wy;
+	double dTime = w2 > 1e-9 ? -(dx * wx + dy * wy) / w2 : 0.0;
+	dTime = osg::clampBetween(dTime, 0.0, m_dLookAhead);
+
+	double mx = dx + wx * dTime;
+	double my = dy + wy * dTime;
+	double dMiss2 = mx * mx + my * my;
+	if (dMiss2 >= m_dSeparation * m_dSeparation)
+		return false;
+
+	conflict.nIndexA = a.nIndex;
+	conflict.nIndexB = b.nIndex;
+	conflict.dTime = dTime;
+	conflict.dMiss = sqrt(dMiss2);
+	conflict.dRange = sqrt(dRange2);
+	conflict.dLonA = a.dLon;
+	conflict.dLatA = a.dLat;
+	conflict.dLonB = b.dLon;
+	conflict.dLatB = b.dLat;
+
+	double dDegreeLon = dCos > 1e-6 ? 1.0 / (s_dMetersPerDegree * dCos) : 0.0;
+	conflict.dLonCpaA = WrapLongitude(a.dLon + a.dEast * dTime * dDegreeLon);
+	conflict.dLatCpaA = a.dLat + a.dNorth * dTime / s_dMetersPerDegree;
+	conflict.dLonCpaB = WrapLongitude(b.dLon + b.dEast * dTime * dDegreeLon);
+	conflict.dLatCpaB = b.dLat + b.dNorth * dTime / s_dMetersPerDegree;
+
+	return true;
+}
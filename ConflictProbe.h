@@ -0,0 +1,125 @@
+#ifndef CONFLICTPROBE_H
+#define CONFLICTPROBE_H
+
+#include <utility>
+#include <vector>
+
+#include "TrackTable.h"
+
+class WorkerPool;
+
+/**
+* Finds the track pairs that will lose separation within the look-ahead.
+*
+* Every track is first extrapolated to a common time along its heading at
+* its ground speed. Two tracks can only come closer than the separation
+* within the look-ahead if they are now within the separation plus both
+* speeds times the look-ahead, so the tracks are bucketed into a lon/lat
+* grid whose cells are at least that far across (from the fastest track of
+* the cycle), and only tracks in neighbouring cells are compared. Inside a
+* polar cap a cell can be narrower than that east to west, so rows there
+* compare as many columns as the distance needs, up to the whole row. For each
+* remaining pair the closest point of approach is solved in a flat tangent
+* plane around the pair, which is accurate at these distances.
+*
+* The grid cells are shared out over the worker pool, each worker collecting
+* its conflicts in its own list. Vertical rates are not known, so the
+* vertical test only compares the current altitudes.
+*/
+class ConflictProbe
+{
+public:
+
+	struct Conflict
+	{
+		//indices into the rows given to Run
+		unsigned int nIndexA;
+		unsigned int nIndexB;
+
+		double dTime;		//seconds from now to the closest point of approach
+		double dMiss;		//horizontal distance in meters at that point
+		double dRange;		//horizontal distance in meters now
+
+		//positions now and at the closest point of approach
+		double dLonA, dLatA, dLonB, dLatB;
+		double dLonCpaA, dLatCpaA, dLonCpaB, dLatCpaB;
+	};
+
+	//pPool may be null to run on the calling thread only
+	ConflictProbe(WorkerPool* pPool = nullptr);
+
+	//5 nm
+	void SetSeparation(double dHorizontal, double dVertical = 304.8);
+
+	void SetLookAhead(double dSeconds) { m_dLookAhead = dSeconds; }
+
+	//rows last updated more than dSeconds before the probe time are skipped
+	void SetMaxAge(double dSeconds) { m_dMaxAge = dSeconds; }
+
+	double GetSeparation() const { return m_dSeparation; }
+
+	double GetLookAhead() const { return m_dLookAhead; }
+
+	//conflicts among vecRows at time dNow, soonest first; returns their number
+	unsigned int Run(const std::vector<TrackTable::Row>& vecRows, double dNow, std::vector<Conflict>& vecConflicts);
+
+	//pairs whose closest point of approach was solved in the last run
+	unsigned long long GetNumPairsTested() const { return m_nPairsTested; }
+
+private:
+
+	struct Track
+	{
+		unsigned int nIndex;
+		double dLon;
+		double dLat;
+		double dCos;		//of the latitude
+		double dAlt;
+		double dEast;		//velocity in m/s
+		double dNorth;
+		double dSpeed;
+	};
+
+	struct Cell
+	{
+		unsigned long long nCell;
+		unsigned int nBegin;
+		unsigned int nEnd;
+	};
+
+	void ProbeCell(unsigned int nCell, std::vector<Conflict>& vecConflicts, unsigned long long& nPairs) const;
+
+	bool ProbePair(const Track& a, const Track& b, Conflict& conflict) const;
+
+	//index into m_vecCells, -1 if no track is in the cell
+	int FindCell(unsigned int nRow, unsigned int nColumn) const;
+
+	WorkerPool* m_pPool;
+	double m_dSeparation;
+	double m_dVerticalSeparation;
+	double m_dLookAhead;
+	double m_dMaxAge;
+
+	//grid of the current run
+	double m_dCellLon;
+	double m_dCellLat;
+	unsigned int m_nColumns;
+	unsigned int m_nGridRows;
+
+	//tracks sorted by cell, so each cell is a contiguous range
+	std::vector<Track> m_vecTracks;
+	std::vector<Track> m_vecSorted;
+	std::vector<std::pair<unsigned long long, unsigned int> > m_vecOrder;
+
+	//columns compared on either side, per grid row
+	std::vector<unsigned int> m_vecRowSpan;
+
+	//occupied cells in key order, and the first one of every grid row
+	std::vector<Cell> m_vecCells;
+	std::vector<unsigned int> m_vecRowStart;
+	std::vector<std::vector<Conflict> > m_vecWorkerConflicts;
+	std::vector<unsigned long long> m_vecWorkerPairs;
+	unsigned long long m_nPairsTested;
+};
+
+#endif // CONFLICTPROBE_H
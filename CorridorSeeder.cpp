@@ -0,0 +1,519 @@
+#include "CorridorSeeder.h"
+
+#include <osg/Math>
+#include <OpenThreads/ScopedLock>
+
+#include <algorithm>
+#include <map>
+#include <math.h>
+#include <stdio.h>
+
+//ÿγȵ
+static const double s_dMetersPerDegree = 6371000.0 * osg::PI / 180.0;
+
+//īеİ뾶γȷΧ
+static const double s_dMercatorRadius = 6378137.0;
+static const double s_dMercatorMaxLat = 85.05112878;
+
+//ôƬдһν
+static const unsigned long long s_nSaveInterval = 1024;
+
+//ԵƬˮλ
+static const unsigned long long s_nRetrySeq = ~0ull;
+
+static void AddInterval(std::vector<std::pair<unsigned int, unsigned int> >& vecColumns, unsigned int c0, unsigned int c1)
+{
+	//ڵĵͬӵ,ֱӲһ
+	if (!vecColumns.empty())
+	{
+		std::pair<unsigned int, unsigned int>& last = vecColumns.back();
+		if (c0 <= last.second + 1 && c1 + 1 >= last.first)
+		{
+			last.first = std::min(last.first, c0);
+			last.second = std::max(last.second, c1);
+			return;
+		}
+	}
+
+	vecColumns.push_back(std::make_pair(c0, c1));
+}
+
+static void MergeIntervals(std::vector<std::pair<unsigned int, unsigned int> >& vecColumns)
+{
+	std::sort(vecColumns.begin(), vecColumns.end());
+
+	size_t n = 0;
+	for (size_t i = 0; i < vecColumns.size(); i ++)
+	{
+		if (n > 0 && vecColumns[i].first <= vecColumns[n - 1].second + 1)
+			vecColumns[n - 1].second = std::max(vecColumns[n - 1].second, vecColumns[i].second);
+		else
+			vecColumns[n ++] = vecColumns[i];
+	}
+	vecColumns.resize(n);
+}
+
+CorridorSeeder::CorridorSeeder(const Grid& grid, const SeedFunc& func, unsigned int nThreads, unsigned int nQueueSize)
+	: m_grid(grid)
+	, m_func(func)
+	, m_nThreads(std::max(nThreads, 1u))
+	, m_nQueueSize(std::max(nQueueSize, 1u))
+	, m_dBuffer(10000.0)
+	, m_nMinLevel(0)
+	, m_nMaxLevel(10)
+	, m_bRasterized(false)
+	, m_nTiles(0)
+	, m_bProducing(false)
+	, m_bStop(false)
+	, m_nActiveWorkers(0)
+	, m_nWatermark(0)
+	, m_nLastSaved(0)
+	, m_nFailed(0)
+	, m_pProducer(nullptr)
+{
+
+}
+
+CorridorSeeder::~CorridorSeeder()
+{
+	Stop();
+}
+
+void CorridorSeeder::AddLine(const std::vector<osg::Vec2d>& vecLonLat)
+{
+	if (vecLonLat.empty())
+		return;
+
+	m_vecLines.push_back(vecLonLat);
+	m_bRasterized = false;
+}
+
+void CorridorSeeder::SetLevels(unsigned int nMinLevel, unsigned int nMaxLevel)
+{
+	m_nMinLevel = nMinLevel;
+	m_nMaxLevel = std::max(nMinLevel, nMaxLevel);
+	m_bRasterized = false;
+}
+
+void CorridorSeeder::Project(double dLon, double dLat, double& x, double& y) const
+{
+	if (m_grid.bGeographic)
+	{
+		x = dLon;
+		y = dLat;
+		return;
+	}
+
+	dLat = osg::clampBetween(dLat, -s_dMercatorMaxLat, s_dMercatorMaxLat);
+	x = s_dMercatorRadius * osg::DegreesToRadians(dLon);
+	y = s_dMercatorRadius * log(tan(osg::PI_4 + osg::DegreesToRadians(dLat) / 2.0));
+}
+
+void CorridorSeeder::RasterizeLevel(unsigned int nLevel, Level& level) const
+{
+	unsigned int nTilesX = m_grid.nTilesX << nLevel;
+	unsigned int nTilesY = m_grid.nTilesY << nLevel;
+	double dTileWidth = (m_grid.dXMax - m_grid.dXMin) / nTilesX;
+	double dTileHeight = (m_grid.dYMax - m_grid.dYMin) / nTilesY;
+
+	std::map<unsigned int, std::vector<std::pair<unsigned int, unsigned int> > > mapRows;
+	for (size_t i = 0; i < m_vecLines.size(); i ++)
+	{
+		const std::vector<osg::Vec2d>& vecLonLat = m_vecLines[i];
+		for (size_t j = 0; j < vecLonLat.size(); j ++)
+		{
+			//180Ⱦߵĺ߽һ,ֵۻ
+			osg::Vec2d a = vecLonLat[j];
+			osg::Vec2d b = j + 1 < vecLonLat.size() ? vecLonLat[j + 1] : a;
+			if (b.x() - a.x() > 180.0)
+				b.x() -= 360.0;
+			else if (b.x() - a.x() < -180.0)
+				b.x() += 360.0;
+
+			//ܵƬ,֤һƬ
+			double ax, ay, bx, by;
+			Project(a.x(), a.y(), ax, ay);
+			Project(b.x(), b.y(), bx, by);
+			double dSteps = ceil(std::max(fabs(bx - ax) / dTileWidth, fabs(by - ay) / dTileHeight) * 2.0);
+			unsigned int nSteps = (unsigned int)osg::clampBetween(dSteps, 1.0, 1e7);
+			if (j + 1 == vecLonLat.size())
+				nSteps = 1;
+
+			for (unsigned int k = 0; k < nSteps; k ++)
+			{
+				double t = (double)k / nSteps;
+				double dLon = a.x() + (b.x() - a.x()) * t;
+				double dLat = a.y() + (b.y() - a.y()) * t;
+				if (dLon > 180.0)
+					dLon -= 360.0;
+				else if (dLon < -180.0)
+					dLon += 360.0;
+
+				double x, y;
+				Project(dLon, dLat, x, y);
+
+				//뻻ͶӰλ,ȷγȱ
+				double dCos = std::max(cos(osg::DegreesToRadians(dLat)), 0.01);
+				double dBufferY = m_grid.bGeographic ? m_dBuffer / s_dMetersPerDegree : m_dBuffer / dCos;
+				double dBufferX = m_grid.bGeographic ? dBufferY / dCos : dBufferY;
+
+				//ƬкŴӱ
+				long long r0 = (long long)floor((m_grid.dYMax - (y + dBufferY)) / dTileHeight);
+				long long r1 = (long long)floor((m_grid.dYMax - (y - dBufferY)) / dTileHeight);
+				r0 = osg::clampBetween(r0, 0ll, (long long)nTilesY - 1);
+				r1 = osg::clampBetween(r1, 0ll, (long long)nTilesY - 1);
+
+				long long c0 = (long long)floor((x - dBufferX - m_grid.dXMin) / dTileWidth);
+				long long c1 = (long long)floor((x + dBufferX - m_grid.dXMin) / dTileWidth);
+
+				for (long long r = r0; r <= r1; r ++)
+				{
+					std::vector<std::pair<unsigned int, unsigned int> >& vecColumns = mapRows[(unsigned int)r];
+					if (c1 - c0 + 1 >= (long long)nTilesX)
+					{
+						AddInterval(vecColumns, 0, nTilesX - 1);
+					}
+					else if (c0 < 0)
+					{
+						AddInterval(vecColumns, (unsigned int)(c0 + nTilesX), nTilesX - 1);
+						AddInterval(vecColumns, 0, (unsigned int)c1);
+					}
+					else if (c1 >= (long long)nTilesX)
+					{
+						AddInterval(vecColumns, (unsigned int)c0, nTilesX - 1);
+						AddInterval(vecColumns, 0, (unsigned int)(c1 - nTilesX));
+					}
+					else
+					{
+						AddInterval(vecColumns, (unsigned int)c0, (unsigned int)c1);
+					}
+				}
+			}
+		}
+	}
+
+	level.nLevel = nLevel;
+	level.vecRows.clear();
+	level.vecRows.reserve(mapRows.size());
+	for (std::map<unsigned int, std::vector<std::pair<unsigned int, unsigned int> > >::iterator itr = mapRows.begin(); itr != mapRows.end(); itr ++)
+	{
+		level.vecRows.push_back(Row());
+		level.vecRows.back().y = itr->first;
+		level.vecRows.back().vecColumns.swap(itr->second);
+		MergeIntervals(level.vecRows.back().vecColumns);
+	}
+}
+
+void CorridorSeeder::Rasterize()
+{
+	m_vecLevels.resize(m_nMaxLevel - m_nMinLevel + 1);
+	m_nTiles = 0;
+	for (unsigned int nLevel = m_nMinLevel; nLevel <= m_nMaxLevel; nLevel ++)
+	{
+		Level& level = m_vecLevels[nLevel - m_nMinLevel];
+		RasterizeLevel(nLevel, level);
+		for (size_t i = 0; i < level.vecRows.size(); i ++)
+		{
+			const Row& row = level.vecRows[i];
+			for (size_t j = 0; j < row.vecColumns.size(); j ++)
+				m_nTiles += row.vecColumns[j].second - row.vecColumns[j].first + 1;
+		}
+	}
+
+	m_bRasterized = true;
+}
+
+unsigned long long CorridorSeeder::CountTiles()
+{
+	if (!m_bRasterized)
+		Rasterize();
+
+	return m_nTiles;
+}
+
+unsigned long long CorridorSeeder::Signature() const
+{
+	//FNV-1a
+	unsigned long long nHash = 14695981039346656037ull;
+	struct Local
+	{
+		static void Add(unsigned long long& nHash, const void* pData, size_t nSize)
+		{
+			const unsigned char* p = static_cast<const unsigned char*>(pData);
+			for (size_t i = 0; i < nSize; i ++)
+				nHash = (nHash ^ p[i]) * 1099511628211ull;
+		}
+	};
+
+	Local::Add(nHash, &m_grid.bGeographic, sizeof(m_grid.bGeographic));
+	Local::Add(nHash, &m_grid.dXMin, sizeof(double) * 4);
+	Local::Add(nHash, &m_grid.nTilesX, sizeof(unsigned int) * 2);
+	Local::Add(nHash, &m_dBuffer, sizeof(m_dBuffer));
+	Local::Add(nHash, &m_nMinLevel, sizeof(m_nMinLevel));
+	Local::Add(nHash, &m_nMaxLevel, sizeof(m_nMaxLevel));
+	for (size_t i = 0; i < m_vecLines.size(); i ++)
+		Local::Add(nHash, &m_vecLines[i][0], m_vecLines[i].size() * sizeof(osg::Vec2d));
+
+	return nHash;
+}
+
+unsigned long long CorridorSeeder::LoadProgress(std::vector<Tile>& vecFailed) const
+{
+	vecFailed.clear();
+	if (m_strProgressFile.empty())
+		return 0;
+
+	FILE* pFile = fopen(m_strProgressFile.c_str(), "r");
+	if (!pFile)
+		return 0;
+
+	//߻ñ˾ʹͷʼ
+	unsigned long long nSignature = 0, nWatermark = 0;
+	bool bValid = fscanf(pFile, "%llx %llu", &nSignature, &nWatermark) == 2 && nSignature == Signature();
+
+	//ÿһʧܵƬ
+	Tile tile;
+	while (bValid && fscanf(pFile, "%u %u %u", &tile.nLevel, &tile.x, &tile.y) == 3)
+		vecFailed.push_back(tile);
+	fclose(pFile);
+
+	return bValid ? std::min(nWatermark, m_nTiles) : 0;
+}
+
+void CorridorSeeder::SaveProgress(unsigned long long nWatermark) const
+{
+	if (m_strProgressFile.empty())
+		return;
+
+	FILE* pFile = fopen(m_strProgressFile.c_str(), "w");
+	if (!pFile)
+		return;
+
+	fprintf(pFile, "%llx %llu\n", Signature(), nWatermark);
+	for (std::set<Tile>::const_iterator it = m_setFailed.begin(); it != m_setFailed.end(); ++ it)
+		fprintf(pFile, "%u %u %u\n", it->nLevel, it->x, it->y);
+	fclose(pFile);
+}
+
+bool CorridorSeeder::Start()
+{
+	if (IsRunning())
+		return false;
+
+	//һε߳Ѿ,յ
+	Stop();
+
+	if (!m_bRasterized)
+		Rasterize();
+
+	m_nWatermark = LoadProgress(m_vecRetry);
+	m_nLastSaved = m_nWatermark;
+	m_setFinished.clear();
+	m_setFailed.clear();
+	m_setFailed.insert(m_vecRetry.begin(), m_vecRetry.end());
+	m_dequeQueue.clear();
+	m_nFailed = 0;
+	m_bStop = false;
+	m_bProducing = true;
+	m_nActiveWorkers = m_nThreads;
+
+	m_pProducer = new Producer(this);
+	m_pProducer->start();
+	for (unsigned int i = 0; i < m_nThreads; i ++)
+	{
+		Worker* pWorker = new Worker(this);
+		m_vecWorkers.push_back(pWorker);
+		pWorker->start();
+	}
+
+	return true;
+}
+
+void CorridorSeeder::Stop()
+{
+	if (!m_pProducer)
+		return;
+
+	{
+		OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+		m_bStop = true;
+		m_conditionNotEmpty.broadcast();
+		m_conditionNotFull.broadcast();
+	}
+
+	m_pProducer->join();
+	delete m_pProducer;
+	m_pProducer = nullptr;
+
+	for (unsigned int i = 0; i < m_vecWorkers.size(); i ++)
+	{
+		m_vecWorkers[i]->join();
+		delete m_vecWorkers[i];
+	}
+	m_vecWorkers.clear();
+
+	SaveProgress(m_nWatermark);
+}
+
+bool CorridorSeeder::IsRunning() const
+{
+	OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+	return m_pProducer && !m_bStop && m_nActiveWorkers > 0;
+}
+
+unsigned long long CorridorSeeder::GetNumDone() const
+{
+	OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+	return m_nWatermark + m_setFinished.size();
+}
+
+unsigned long long CorridorSeeder::GetNumFailed() const
+{
+	OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+	return m_nFailed;
+}
+
+unsigned long long CorridorSeeder::GetNumPendingRetries() const
+{
+	OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+	return m_setFailed.size();
+}
+
+void CorridorSeeder::Produce()
+{
+	//ϴʧܵƬ
+	for (size_t i = 0; i < m_vecRetry.size(); i ++)
+	{
+		Task task;
+		task.nSeq = s_nRetrySeq;
+		task.nLevel = m_vecRetry[i].nLevel;
+		task.x = m_vecRetry[i].x;
+		task.y = m_vecRetry[i].y;
+
+		OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+		while (!m_bStop && m_dequeQueue.size() >= m_nQueueSize)
+			m_conditionNotFull.wait(&m_mutex);
+
+		if (m_bStop)
+			return;
+
+		m_dequeQueue.push_back(task);
+		m_conditionNotEmpty.signal();
+	}
+
+	//̶˳,ˮλµ
+	unsigned long long nSeq = 0;
+	unsigned long long nResume = m_nWatermark;
+	for (size_t i = 0; i < m_vecLevels.size(); i ++)
+	{
+		const Level& level = m_vecLevels[i];
+		for (size_t j = 0; j < level.vecRows.size(); j ++)
+		{
+			const Row& row = level.vecRows[j];
+			for (size_t k = 0; k < row.vecColumns.size(); k ++)
+			{
+				unsigned int nCount = row.vecColumns[k].second - row.vecColumns[k].first + 1;
+				if (nSeq + nCount <= nResume)
+				{
+					nSeq += nCount;
+					continue;
+				}
+
+				for (unsigned int x = row.vecColumns[k].first; x <= row.vecColumns[k].second; x ++, nSeq ++)
+				{
+					if (nSeq < nResume)
+						continue;
+
+					Task task;
+					task.nSeq = nSeq;
+					task.nLevel = level.nLevel;
+					task.x = x;
+					task.y = row.y;
+
+					OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+					while (!m_bStop && m_dequeQueue.size() >= m_nQueueSize)
+						m_conditionNotFull.wait(&m_mutex);
+
+					if (m_bStop)
+						return;
+
+					m_dequeQueue.push_back(task);
+					m_conditionNotEmpty.signal();
+				}
+			}
+		}
+	}
+
+	OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+	m_bProducing = false;
+	m_conditionNotEmpty.broadcast();
+}
+
+void CorridorSeeder::Work()
+{
+	for (;;)
+	{
+		Task task;
+		{
+			OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+			while (!m_bStop && m_bProducing && m_dequeQueue.empty())
+				m_conditionNotEmpty.wait(&m_mutex);
+
+			if (m_bStop || m_dequeQueue.empty())
+			{
+				//һ߳̽ʱս
+				if (-- m_nActiveWorkers == 0 && !m_bStop)
+					SaveProgress(m_nWatermark);
+				return;
+			}
+
+			task = m_dequeQueue.front();
+			m_dequeQueue.pop_front();
+			m_conditionNotFull.signal();
+		}
+
+		bool bOk = m_func(task.nLevel, task.x, task.y);
+
+		OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+
+		//ʧܵƬǽļ,´οʼʱ
+		Tile tile = { task.nLevel, task.x, task.y };
+		if (bOk)
+		{
+			if (task.nSeq == s_nRetrySeq)
+				m_setFailed.erase(tile);
+		}
+		else
+		{
+			m_nFailed ++;
+			m_setFailed.insert(tile);
+		}
+
+		if (task.nSeq == s_nRetrySeq)
+			continue;
+
+		//ʧܵƬҲƽˮλ,Ѿʧб
+		m_setFinished.insert(task.nSeq);
+		while (!m_setFinished.empty() && *m_setFinished.begin() == m_nWatermark)
+		{
+			m_setFinished.erase(m_setFinished.begin());
+			m_nWatermark ++;
+		}
+
+		if (m_nWatermark - m_nLastSaved >= s_nSaveInterval)
+		{
+			SaveProgress(m_nWatermark);
+			m_nLastSaved = m_nWatermark;
+		}
+	}
+}
+
+void CorridorSeeder::Producer::run()
+{
+	m_pSeeder->Produce();
+}
+
+void CorridorSeeder::Worker::run()
+{
+	m_pSeeder->Work();
+}
@@ -0,0 +1,205 @@
+#ifndef CORRIDORSEEDER_H
+#define CORRIDORSEEDER_H
+
+#include <osg/Vec2d>
+
+#include <OpenThreads/Condition>
+#include <OpenThreads/Mutex>
+#include <OpenThreads/Thread>
+
+#include <deque>
+#include <functional>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+* Fills the tile cache along a buffered corridor around a set of routes.
+*
+* For every level of the range the corridor is rasterized into the tile
+* grid of the map profile: the routes are densified to half a tile, and the
+* buffer box around every point adds a column interval to each tile row it
+* covers, so a level ends up as a list of rows of merged intervals. The
+* tiles are then listed level by level, row by row, always in the same
+* order, and a producer thread feeds them through a bounded queue to the
+* worker threads, which call the seed function for each.
+*
+* Because the order is fixed, progress is a single number: the watermark
+* below which every tile is done. It is written to the progress file now
+* and then and on Stop, together with a signature of the routes and the
+* settings, and a later Start with the same signature skips the tiles
+* below it. A tile whose seed function failed still counts for the
+* watermark, but it is listed in the progress file as well, and a later
+* Start fetches the listed tiles again before it resumes.
+*/
+class CorridorSeeder
+{
+public:
+
+	//tile grid of the map profile at level 0; projected grids are spherical mercator
+	struct Grid
+	{
+		bool bGeographic;
+		double dXMin, dYMin, dXMax, dYMax;
+		unsigned int nTilesX, nTilesY;
+	};
+
+	//fetches one tile into the cache; false if it could not be created
+	typedef std::function<bool(unsigned int nLevel, unsigned int x, unsigned int y)> SeedFunc;
+
+	CorridorSeeder(const Grid& grid, const SeedFunc& func, unsigned int nThreads = 4, unsigned int nQueueSize = 256);
+	~CorridorSeeder();
+
+	//route as (lon, lat) degrees
+	void AddLine(const std::vector<osg::Vec2d>& vecLonLat);
+
+	//half width of the corridor in meters
+	void SetBuffer(double dMeters) { m_dBuffer = dMeters; }
+
+	void SetLevels(unsigned int nMinLevel, unsigned int nMaxLevel);
+
+	void SetProgressFile(const std::string& strPath) { m_strProgressFile = strPath; }
+
+	//rasterizes the corridor if needed and returns the number of tiles in it
+	unsigned long long CountTiles();
+
+	//seeds in the background, resuming from the progress file; false if already running
+	bool Start();
+
+	//waits for the tiles being fetched, then saves the progress
+	void Stop();
+
+	//false once every tile is done or after Stop
+	bool IsRunning() const;
+
+	unsigned long long GetNumTiles() const { return m_nTiles; }
+
+	//tiles below the watermark, including the ones skipped on resume
+	unsigned long long GetNumDone() const;
+
+	//failures of this run, retries included
+	unsigned long long GetNumFailed() const;
+
+	//tiles that still have to be retried
+	unsigned long long GetNumPendingRetries() const;
+
+private:
+
+	struct Row
+	{
+		unsigned int y;
+		std::vector<std::pair<unsigned int, unsigned int> > vecColumns;
+	};
+
+	struct Level
+	{
+		unsigned int nLevel;
+		std::vector<Row> vecRows;
+	};
+
+	struct Task
+	{
+		//s_nRetrySeq for a tile that failed before, it does not move the watermark
+		unsigned long long nSeq;
+		unsigned int nLevel;
+		unsigned int x;
+		unsigned int y;
+	};
+
+	struct Tile
+	{
+		unsigned int nLevel;
+		unsigned int x;
+		unsigned int y;
+
+		bool operator<(const Tile& rhs) const
+		{
+			if (nLevel != rhs.nLevel)
+				return nLevel < rhs.nLevel;
+			return y != rhs.y ? y < rhs.y : x < rhs.x;
+		}
+	};
+
+	class Producer : public OpenThreads::Thread
+	{
+	public:
+
+		Producer(CorridorSeeder* pSeeder) : m_pSeeder(pSeeder) {}
+
+		virtual void run() override;
+
+	private:
+
+		CorridorSeeder* m_pSeeder;
+	};
+
+	class Worker : public OpenThreads::Thread
+	{
+	public:
+
+		Worker(CorridorSeeder* pSeeder) : m_pSeeder(pSeeder) {}
+
+		virtual void run() override;
+
+	private:
+
+		CorridorSeeder* m_pSeeder;
+	};
+
+	void Rasterize();
+
+	void RasterizeLevel(unsigned int nLevel, Level& level) const;
+
+	//profile coordinates of (dLon, dLat)
+	void Project(double dLon, double dLat, double& x, double& y) const;
+
+	//signature of the routes and settings, stored with the watermark
+	unsigned long long Signature() const;
+
+	//watermark and the tiles still to be retried
+	unsigned long long LoadProgress(std::vector<Tile>& vecFailed) const;
+
+	void SaveProgress(unsigned long long nWatermark) const;
+
+	void Produce();
+
+	void Work();
+
+	Grid m_grid;
+	SeedFunc m_func;
+	unsigned int m_nThreads;
+	unsigned int m_nQueueSize;
+	double m_dBuffer;
+	unsigned int m_nMinLevel;
+	unsigned int m_nMaxLevel;
+	std::string m_strProgressFile;
+
+	std::vector<std::vector<osg::Vec2d> > m_vecLines;
+	std::vector<Level> m_vecLevels;
+	bool m_bRasterized;
+	unsigned long long m_nTiles;
+
+	mutable OpenThreads::Mutex m_mutex;
+	OpenThreads::Condition m_conditionNotEmpty;
+	OpenThreads::Condition m_conditionNotFull;
+	std::deque<Task> m_dequeQueue;
+	bool m_bProducing;
+	bool m_bStop;
+	unsigned int m_nActiveWorkers;
+
+	//every tile below the watermark is done; the finished ones above it wait in the set
+	unsigned long long m_nWatermark;
+	unsigned long long m_nLastSaved;
+	std::set<unsigned long long> m_setFinished;
+	unsigned long long m_nFailed;
+
+	//failed tiles not fetched since; m_vecRetry is what Start loaded, queued first
+	std::set<Tile> m_setFailed;
+	std::vector<Tile> m_vecRetry;
+
+	Producer* m_pProducer;
+	std::vector<Worker*> m_vecWorkers;
+};
+
+#endif // CORRIDORSEEDER_H
@@ -0,0 +1,116 @@
+#include "CountingCache.h"
+#include "Metrics.h"
+
+#include <OpenThreads/ScopedLock>
+
+CountingCacheBin::CountingCacheBin(osgEarth::CacheBin* pInner)
+	: osgEarth::CacheBin(pInner->getID())
+	, m_pInner(pInner)
+{
+
+}
+
+CountingCacheBin::~CountingCacheBin()
+{
+
+}
+
+osgEarth::ReadResult CountingCacheBin::readObject(const std::string& strKey)
+{
+	osgEarth::ReadResult result = m_pInner->readObject(strKey);
+	Metrics::Instance()->CountTileCache(result.succeeded());
+	return result;
+}
+
+osgEarth::ReadResult CountingCacheBin::readImage(const std::string& strKey)
+{
+	osgEarth::ReadResult result = m_pInner->readImage(strKey);
+	Metrics::Instance()->CountTileCache(result.succeeded());
+	return result;
+}
+
+//ԪݵַȡƬ
+osgEarth::ReadResult CountingCacheBin::readString(const std::string& strKey)
+{
+	return m_pInner->readString(strKey);
+}
+
+bool CountingCacheBin::write(const std::string& strKey, const osg::Object* pObject, const osgEarth::Config& meta)
+{
+	return m_pInner->write(strKey, pObject, meta);
+}
+
+osgEarth::CacheBin::RecordStatus CountingCacheBin::getRecordStatus(const std::string& strKey)
+{
+	return m_pInner->getRecordStatus(strKey);
+}
+
+bool CountingCacheBin::remove(const std::string& strKey)
+{
+	return m_pInner->remove(strKey);
+}
+
+bool CountingCacheBin::touch(const std::string& strKey)
+{
+	return m_pInner->touch(strKey);
+}
+
+bool CountingCacheBin::purge()
+{
+	return m_pInner->purge();
+}
+
+osgEarth::Config CountingCacheBin::readMetadata()
+{
+	return m_pInner->readMetadata();
+}
+
+bool CountingCacheBin::writeMetadata(const osgEarth::Config& meta)
+{
+	return m_pInner->writeMetadata(meta);
+}
+
+CountingCache::CountingCache(osgEarth::Cache* pInner)
+	: m_pInner(pInner)
+{
+
+}
+
+CountingCache::~CountingCache()
+{
+
+}
+
+osgEarth::CacheBin* CountingCache::addBin(const std::string& strBinId)
+{
+	OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+
+	//ͼڶҪͬһbinʱͬһװ
+	std::map<std::string, osg::ref_ptr<CountingCacheBin> >::iterator it = m_mapBins.find(strBinId);
+	if (it != m_mapBins.end())
+		return it->second.get();
+
+	osgEarth::CacheBin* pInner = m_pInner->addBin(strBinId);
+	if (!pInner)
+		return nullptr;
+
+	CountingCacheBin* pBin = new CountingCacheBin(pInner);
+	m_mapBins[strBinId] = pBin;
+	return pBin;
+}
+
+osgEarth::CacheBin* CountingCache::getOrCreateDefaultBin()
+{
+	OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+
+	if (!m_pDefaultBin.valid())
+	{
+		osgEarth::CacheBin* pInner = m_pInner->getOrCreateDefaultBin();
+		if (!pInner)
+			return nullptr;
+
+		m_pDefaultBin = new CountingCacheBin(pInner);
+	}
+
+	return m_pDefaultBin.get();
+}
@@ -0,0 +1,83 @@
+#ifndef COUNTINGCACHE_H
+#define COUNTINGCACHE_H
+
+#include <osgEarth/Cache>
+#include <osgEarth/CacheBin>
+
+#include <OpenThreads/Mutex>
+
+#include <map>
+#include <string>
+
+/**
+* Cache bin decorator that counts tile cache hits and misses.
+*
+* readImage and readObject are forwarded to the wrapped bin and counted in
+* Metrics (routemonitor_tile_cache_requests_total) as a hit when the record
+* was found, else as a miss. Every other call is forwarded unchanged.
+*/
+class CountingCacheBin : public osgEarth::CacheBin
+{
+public:
+
+	CountingCacheBin(osgEarth::CacheBin* pInner);
+
+	virtual osgEarth::ReadResult readObject(const std::string& strKey) override;
+
+	virtual osgEarth::ReadResult readImage(const std::string& strKey) override;
+
+	virtual osgEarth::ReadResult readString(const std::string& strKey) override;
+
+	virtual bool write(const std::string& strKey, const osg::Object* pObject, const osgEarth::Config& meta) override;
+
+	virtual RecordStatus getRecordStatus(const std::string& strKey) override;
+
+	virtual bool remove(const std::string& strKey) override;
+
+	virtual bool touch(const std::string& strKey) override;
+
+	virtual bool purge() override;
+
+	virtual osgEarth::Config readMetadata() override;
+
+	virtual bool writeMetadata(const osgEarth::Config& meta) override;
+
+protected:
+
+	virtual ~CountingCacheBin();
+
+private:
+
+	osg::ref_ptr<osgEarth::CacheBin> m_pInner;
+};
+
+/**
+* Cache decorator given to the map in place of the cache built from
+* seed.ini, so that every layer reads its tiles through a CountingCacheBin.
+* The wrapped cache still creates and stores the bins.
+*/
+class CountingCache : public osgEarth::Cache
+{
+public:
+
+	CountingCache(osgEarth::Cache* pInner);
+
+	virtual osgEarth::CacheBin* addBin(const std::string& strBinId) override;
+
+	virtual osgEarth::CacheBin* getOrCreateDefaultBin() override;
+
+protected:
+
+	virtual ~CountingCache();
+
+private:
+
+	osg::ref_ptr<osgEarth::Cache> m_pInner;
+
+	//one decorator per bin id; osgEarth keeps the bin pointers it got
+	std::map<std::string, osg::ref_ptr<CountingCacheBin> > m_mapBins;
+	osg::ref_ptr<CountingCacheBin> m_pDefaultBin;
+	OpenThreads::Mutex m_mutex;
+};
+
+#endif // COUNTINGCACHE_H
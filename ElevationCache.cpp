@@ -0,0 +1,246 @@
+#include "ElevationCache.h"
+#include "Metrics.h"
+
+#include <osgEarth/ElevationQuery>
+#include <OpenThreads/ScopedLock>
+
+#include <algorithm>
+#include <limits>
+#include <math.h>
+
+ElevationCache::ElevationCache(const osgEarth::Map* pMap, unsigned int nThreads, unsigned int nLevel, unsigned int nMaxTiles)
+	: m_pMap(pMap)
+	, m_nLevel(nLevel)
+	, m_nMaxTiles(nMaxTiles)
+	, m_nFrame(0)
+	, m_bQuit(false)
+{
+	//nLevel: 2^(nLevel+1) x 2^nLevelγȷ
+	m_dTileSize = 180.0 / (double)(1ull << nLevel);
+	m_nTilesX = 2ull << nLevel;
+
+	for (unsigned int i = 0; i < std::max(nThreads, 1u); i ++)
+	{
+		Worker* pWorker = new Worker(this);
+		m_vecWorkers.push_back(pWorker);
+		pWorker->start();
+	}
+}
+
+ElevationCache::~ElevationCache()
+{
+	{
+		OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+		m_bQuit = true;
+		m_condition.broadcast();
+	}
+
+	for (unsigned int i = 0; i < m_vecWorkers.size(); i ++)
+	{
+		m_vecWorkers[i]->join();
+		delete m_vecWorkers[i];
+	}
+}
+
+unsigned long long ElevationCache::TileKey(double dLon, double dLat) const
+{
+	long long x = (long long)floor((dLon + 180.0) / m_dTileSize);
+	long long y = (long long)floor((dLat + 90.0) / m_dTileSize);
+	x = osg::clampBetween(x, 0ll, (long long)m_nTilesX - 1);
+	y = osg::clampBetween(y, 0ll, (long long)(m_nTilesX / 2) - 1);
+	return (unsigned long long)y * m_nTilesX + x;
+}
+
+void ElevationCache::TileOrigin(unsigned long long nKey, double& dWest, double& dSouth) const
+{
+	dWest = (nKey % m_nTilesX) * m_dTileSize - 180.0;
+	dSouth = (nKey / m_nTilesX) * m_dTileSize - 90.0;
+}
+
+void ElevationCache::Queue(unsigned long long nKey)
+{
+	if (m_setPending.insert(nKey).second)
+		m_vecBatch.push_back(nKey);
+}
+
+void ElevationCache::Request(double dLon, double dLat)
+{
+	unsigned long long nKey = TileKey(dLon, dLat);
+	if (m_mapTiles.find(nKey) == m_mapTiles.end())
+		Queue(nKey);
+}
+
+bool ElevationCache::GetElevation(double dLon, double dLat, double& dHeight)
+{
+	unsigned long long nKey = TileKey(dLon, dLat);
+	std::unordered_map<unsigned long long, Tile>::iterator itr = m_mapTiles.find(nKey);
+	if (itr == m_mapTiles.end())
+	{
+		Metrics::Instance()->CountElevationCache(false);
+		Queue(nKey);
+		return false;
+	}
+
+	Metrics::Instance()->CountElevationCache(true);
+
+	itr->second.nLastUse.store(m_nFrame, std::memory_order_relaxed);
+	dHeight = Interpolate(itr->second, nKey, dLon, dLat);
+	return true;
+}
+
+unsigned int ElevationCache::Sample(const double* pLon, const double* pLat, unsigned int nCount, float* pHeights) const
+{
+	//ڵĵͬһ,񲻱ʱٲ
+	unsigned int nMissing = 0;
+	unsigned long long nLastKey = ~0ull;
+	const Tile* pTile = nullptr;
+	for (unsigned int i = 0; i < nCount; i ++)
+	{
+		unsigned long long nKey = TileKey(pLon[i], pLat[i]);
+		if (nKey != nLastKey)
+		{
+			nLastKey = nKey;
+			std::unordered_map<unsigned long long, Tile>::const_iterator itr = m_mapTiles.find(nKey);
+			pTile = itr == m_mapTiles.end() ? nullptr : &itr->second;
+
+			//Ǳ֡Ͳд,ö̷߳дͬһ
+			if (pTile && pTile->nLastUse.load(std::memory_order_relaxed) != m_nFrame)
+				pTile->nLastUse.store(m_nFrame, std::memory_order_relaxed);
+		}
+
+		if (pTile)
+		{
+			pHeights[i] = (float)Interpolate(*pTile, nKey, pLon[i], pLat[i]);
+		}
+		else
+		{
+			pHeights[i] = std::numeric_limits<float>::quiet_NaN();
+			nMissing ++;
+		}
+	}
+
+	return nMissing;
+}
+
+double ElevationCache::Interpolate(const Tile& tile, unsigned long long nKey, double dLon, double dLat) const
+{
+	//ı,˫Բֵ
+	double dWest, dSouth;
+	TileOrigin(nKey, dWest, dSouth);
+	double fx = osg::clampBetween((dLon - dWest) / m_dTileSize, 0.0, 1.0) * (TILE_SAMPLES - 1);
+	double fy = osg::clampBetween((dLat - dSouth) / m_dTileSize, 0.0, 1.0) * (TILE_SAMPLES - 1);
+	int x = std::min((int)fx, TILE_SAMPLES - 2);
+	int y = std::min((int)fy, TILE_SAMPLES - 2);
+	fx -= x;
+	fy -= y;
+
+	const float* pRow0 = &tile.vecHeights[y * TILE_SAMPLES + x];
+	const float* pRow1 = pRow0 + TILE_SAMPLES;
+	double dBottom = pRow0[0] + (pRow0[1] - pRow0[0]) * fx;
+	double dTop = pRow1[0] + (pRow1[1] - pRow1[0]) * fx;
+	return dBottom + (dTop - dBottom) * fy;
+}
+
+void ElevationCache::Flush()
+{
+	m_nFrame ++;
+
+	std::vector<Result> vecResults;
+	{
+		OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+		vecResults.swap(m_vecResults);
+
+		//һ֡ȱķһν߳
+		if (!m_vecBatch.empty())
+		{
+			m_dequeQueue.insert(m_dequeQueue.end(), m_vecBatch.begin(), m_vecBatch.end());
+			m_condition.broadcast();
+		}
+	}
+	m_vecBatch.clear();
+
+	for (size_t i = 0; i < vecResults.size(); i ++)
+	{
+		Tile& tile = m_mapTiles[vecResults[i].nKey];
+		tile.vecHeights.swap(vecResults[i].vecHeights);
+		tile.nLastUse.store(m_nFrame, std::memory_order_relaxed);
+		m_setPending.erase(vecResults[i].nKey);
+	}
+
+	if (m_mapTiles.size() > m_nMaxTiles)
+		Evict();
+}
+
+void ElevationCache::Evict()
+{
+	//һȥûõʮ֮һ,ÿ֡
+	std::vector<std::pair<unsigned int, unsigned long long> > vecUse;
+	vecUse.reserve(m_mapTiles.size());
+	for (std::unordered_map<unsigned long long, Tile>::const_iterator itr = m_mapTiles.begin(); itr != m_mapTiles.end(); itr ++)
+		vecUse.push_back(std::make_pair(itr->second.nLastUse.load(std::memory_order_relaxed), itr->first));
+
+	size_t nRemove = m_mapTiles.size() - m_nMaxTiles * 9 / 10;
+	std::nth_element(vecUse.begin(), vecUse.begin() + nRemove, vecUse.end());
+	for (size_t i = 0; i < nRemove; i ++)
+		m_mapTiles.erase(vecUse[i].second);
+}
+
+size_t ElevationCache::GetMemoryBytes() const
+{
+	return m_mapTiles.size() * (sizeof(Tile) + TILE_SAMPLES * TILE_SAMPLES * sizeof(float) + 2 * sizeof(void*));
+}
+
+void ElevationCache::Worker::run()
+{
+	//ElevationQuery̹ܶ߳,ÿ߳һ
+	osgEarth::ElevationQuery query(m_pCache->m_pMap.get());
+	const osgEarth::SpatialReference* pwgs84 = osgEarth::SpatialReference::get("wgs84");
+	std::vector<osg::Vec3d> vecPoints;
+
+	for (;;)
+	{
+		unsigned long long nKey;
+		{
+			OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_pCache->m_mutex);
+			while (!m_pCache->m_bQuit && m_pCache->m_dequeQueue.empty())
+				m_pCache->m_condition.wait(&m_pCache->m_mutex);
+
+			if (m_pCache->m_bQuit)
+				return;
+
+			nKey = m_pCache->m_dequeQueue.front();
+			m_pCache->m_dequeQueue.pop_front();
+		}
+
+		double dWest, dSouth;
+		m_pCache->TileOrigin(nKey, dWest, dSouth);
+		double dStep = m_pCache->m_dTileSize / (TILE_SAMPLES - 1);
+
+		vecPoints.resize(TILE_SAMPLES * TILE_SAMPLES);
+		for (int y = 0; y < TILE_SAMPLES; y ++)
+		{
+			for (int x = 0; x < TILE_SAMPLES; x ++)
+				vecPoints[y * TILE_SAMPLES + x].set(dWest + x * dStep, dSouth + y * dStep, 0.0);
+		}
+
+		//ûи߳ݵĵ㱣0;ͼľγȵλ
+		query.getElevations(vecPoints, pwgs84, true, dStep);
+
+		std::vector<float> vecHeights(vecPoints.size());
+		for (size_t i = 0; i < vecPoints.size(); i ++)
+			vecHeights[i] = (float)vecPoints[i].z();
+
+		OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_pCache->m_mutex);
+		m_pCache->m_vecResults.push_back(Result());
+		m_pCache->m_vecResults.back().nKey = nKey;
+		m_pCache->m_vecResults.back().vecHeights.swap(vecHeights);
+	}
+}
+
+bool ElevationFrameHandler::handle(const osgGA::GUIEventAdapter& ea, osgGA::GUIActionAdapter& aa)
+{
+	if (ea.getEventType() == osgGA::GUIEventAdapter::FRAME)
+		m_pCache->Flush();
+
+	return false;
+}
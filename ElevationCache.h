@@ -0,0 +1,138 @@
+#ifndef ELEVATIONCACHE_H
+#define ELEVATIONCACHE_H
+
+#include <osgGA/GUIEventHandler>
+#include <osgEarth/Map>
+
+#include <OpenThreads/Condition>
+#include <OpenThreads/Mutex>
+#include <OpenThreads/Thread>
+
+#include <atomic>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/**
+* Terrain heights for track clamping without blocking the caller.
+*
+* Heights are cached per tile of a fixed geodetic level as a small grid of
+* samples and interpolated bilinearly, so all tracks over one tile share a
+* single query. A lookup that misses only queues the tile and returns
+* false. Queued tiles are handed to the worker threads once per frame by
+* Flush(), and the samples the workers finished since the last frame enter
+* the cache there too, so the cache itself is only changed by the thread
+* calling GetElevation and Flush; in between, Sample can read it from
+* several threads. Each worker runs its own ElevationQuery
+* against the elevation layers of the map. The least recently used tiles
+* are dropped beyond nMaxTiles.
+*/
+class ElevationCache
+{
+public:
+
+	enum { TILE_SAMPLES = 17 };
+
+	ElevationCache(const osgEarth::Map* pMap, unsigned int nThreads = 2, unsigned int nLevel = 12, unsigned int nMaxTiles = 1024);
+	~ElevationCache();
+
+	//height above the ellipsoid in meters, false (and the tile queued) if not cached yet
+	bool GetElevation(double dLon, double dLat, double& dHeight);
+
+	//queue the tile of (dLon, dLat) if it is not cached, without reading it
+	void Request(double dLon, double dLat);
+
+	//heights of nCount points for several threads at once; a point without a cached
+	//tile gets NaN and is not queued. Returns the number of such points.
+	//Must not overlap GetElevation, Request or Flush.
+	unsigned int Sample(const double* pLon, const double* pLat, unsigned int nCount, float* pHeights) const;
+
+	//once per frame: publish finished tiles and hand the queued ones to the workers
+	void Flush();
+
+	unsigned int GetNumTiles() const { return m_mapTiles.size(); }
+
+	unsigned int GetNumPending() const { return m_setPending.size(); }
+
+	size_t GetMemoryBytes() const;
+
+private:
+
+	struct Tile
+	{
+		Tile() : nLastUse(0) {}
+
+		std::vector<float> vecHeights;
+
+		//also set by Sample from several threads
+		mutable std::atomic<unsigned int> nLastUse;
+	};
+
+	struct Result
+	{
+		unsigned long long nKey;
+		std::vector<float> vecHeights;
+	};
+
+	class Worker : public OpenThreads::Thread
+	{
+	public:
+
+		Worker(ElevationCache* pCache) : m_pCache(pCache) {}
+
+		virtual void run() override;
+
+	private:
+
+		ElevationCache* m_pCache;
+	};
+
+	unsigned long long TileKey(double dLon, double dLat) const;
+
+	void TileOrigin(unsigned long long nKey, double& dWest, double& dSouth) const;
+
+	void Queue(unsigned long long nKey);
+
+	double Interpolate(const Tile& tile, unsigned long long nKey, double dLon, double dLat) const;
+
+	void Evict();
+
+	osg::ref_ptr<const osgEarth::Map> m_pMap;
+	unsigned int m_nLevel;
+	unsigned int m_nMaxTiles;
+	double m_dTileSize;
+	unsigned long long m_nTilesX;
+
+	//caller thread only
+	std::unordered_map<unsigned long long, Tile> m_mapTiles;
+	std::unordered_set<unsigned long long> m_setPending;
+	std::vector<unsigned long long> m_vecBatch;
+	unsigned int m_nFrame;
+
+	//shared with the workers, guarded by m_mutex
+	OpenThreads::Mutex m_mutex;
+	OpenThreads::Condition m_condition;
+	std::deque<unsigned long long> m_dequeQueue;
+	std::vector<Result> m_vecResults;
+	bool m_bQuit;
+
+	std::vector<Worker*> m_vecWorkers;
+};
+
+/**
+* Calls ElevationCache::Flush once per frame.
+*/
+class ElevationFrameHandler : public osgGA::GUIEventHandler
+{
+public:
+	ElevationFrameHandler(ElevationCache* pCache) : m_pCache(pCache) {}
+
+	virtual bool handle(const osgGA::GUIEventAdapter& ea, osgGA::GUIActionAdapter& aa) override;
+
+private:
+
+	ElevationCache* m_pCache;
+};
+
+#endif // ELEVATIONCACHE_H
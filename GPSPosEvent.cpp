@@ -1 +1,16 @@
 #include "GPSPosEvent.h"
+#include <string.h>
+
+bool DecodePosDatagram(const char* pData, long long nSize, double& dLon, double& dLat, double& dAngle)
+{
+	//ȡγȡ8ֽ,ӵ1ֽڿʼ
+	if (nSize < 25)
+		return false;
+
+	memcpy(&dLon, pData + 1, 8);
+	memcpy(&dLat, pData + 9, 8);
+	memcpy(&dAngle, pData + 17, 8);
+
+	//NaNҲﱻ
+	return dLon >= -180.0 && dLon <= 180.0 && dLat >= -90.0 && dLat <= 90.0;
+}
@@ -14,3 +14,6 @@ struct GPSPosEvent : public osg::Referenced
 	double dLat;
 };
 
+//position datagram: lon, lat and heading as doubles from byte 1;
+//false for short datagrams and out-of-range or NaN positions
+bool DecodePosDatagram(const char* pData, long long nSize, double& dLon, double& dLat, double& dAngle);
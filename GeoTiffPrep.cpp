@@ -0,0 +1,213 @@
+#include "GeoTiffPrep.h"
+#include "gdal_priv.h"
+#include "gdalwarper.h"
+#include "ogr_spatialref.h"
+#include "cpl_string.h"
+
+#include <osgEarth/Registry>
+
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+
+#include <algorithm>
+#include <math.h>
+
+//ȡĲ㼶,ԭʼֱ
+static const int s_nSampleLevels = 6;
+
+QString GeoTiffPrep::GetPreparedName(const QString& strFile)
+{
+	QFileInfo info(strFile);
+	return info.path() + "/" + info.completeBaseName() + ".tiled.tif";
+}
+
+bool GeoTiffPrep::IsPrepared(const QString& strFile)
+{
+	GDALAllRegister();
+	GDALDatasetH hDataset = GDALOpen(strFile.toUtf8().data(), GA_ReadOnly);
+	if (!hDataset)
+		return false;
+
+	bool bPrepared = false;
+	if (GDALGetRasterCount(hDataset) > 0)
+	{
+		//ļͼ,ֻм
+		GDALRasterBandH hBand = GDALGetRasterBand(hDataset, 1);
+		int nBlockX, nBlockY;
+		GDALGetBlockSize(hBand, &nBlockX, &nBlockY);
+		int nSize = std::max(GDALGetRasterXSize(hDataset), GDALGetRasterYSize(hDataset));
+		bPrepared = nBlockX == nBlockY && (GDALGetOverviewCount(hBand) > 0 || nSize <= nBlockX);
+	}
+
+	GDALClose(hDataset);
+	return bPrepared;
+}
+
+QString GeoTiffPrep::Resolve(const QString& strFile)
+{
+	QString strPrepared = GetPreparedName(strFile);
+	QFileInfo prepared(strPrepared);
+	QFileInfo source(strFile);
+	if (prepared.exists() && (!source.exists() || prepared.lastModified() >= source.lastModified()) && IsPrepared(strPrepared))
+		return strPrepared;
+	return strFile;
+}
+
+bool GeoTiffPrep::Prepare(const QString& strSource, const QString& strTarget, const Options& options, QString& strError, bool bProgress)
+{
+	GDALAllRegister();
+	GDALProgressFunc pfnProgress = bProgress ? GDALTermProgress : GDALDummyProgress;
+
+	GDALDatasetH hSource = GDALOpen(strSource.toUtf8().data(), GA_ReadOnly);
+	if (!hSource)
+	{
+		strError = "cannot open " + strSource;
+		return false;
+	}
+
+	//WGS84γȵһεݼ,ʱһͶӰ
+	GDALDatasetH hInput = hSource;
+	if (options.bReproject)
+	{
+		OGRSpatialReference wgs84;
+		wgs84.SetWellKnownGeogCS("WGS84");
+
+		OGRSpatialReference srs;
+		char* pSourceWkt = const_cast<char*>(GDALGetProjectionRef(hSource));
+		if (pSourceWkt && *pSourceWkt && srs.importFromWkt(&pSourceWkt) == OGRERR_NONE && !srs.IsSame(&wgs84))
+		{
+			char* pTargetWkt = nullptr;
+			wgs84.exportToWkt(&pTargetWkt);
+			hInput = GDALAutoCreateWarpedVRT(hSource, nullptr, pTargetWkt, GRA_Bilinear, 0.125, nullptr);
+			CPLFree(pTargetWkt);
+			if (!hInput)
+			{
+				GDALClose(hSource);
+				strError = "cannot reproject " + strSource;
+				return false;
+			}
+		}
+	}
+
+	char** papszOptions = nullptr;
+	papszOptions = CSLSetNameValue(papszOptions, "TILED", "YES");
+	papszOptions = CSLSetNameValue(papszOptions, "BLOCKXSIZE", QByteArray::number(options.nBlockSize).data());
+	papszOptions = CSLSetNameValue(papszOptions, "BLOCKYSIZE", QByteArray::number(options.nBlockSize).data());
+	papszOptions = CSLSetNameValue(papszOptions, "COMPRESS", options.strCompress.c_str());
+	papszOptions = CSLSetNameValue(papszOptions, "BIGTIFF", "IF_SAFER");
+	if (options.strCompress == "JPEG" && GDALGetRasterCount(hInput) == 3)
+		papszOptions = CSLSetNameValue(papszOptions, "PHOTOMETRIC", "YCBCR");
+
+	QString strTemp = strTarget + ".part";
+	GDALDatasetH hTarget = GDALCreateCopy(GDALGetDriverByName("GTiff"), strTemp.toUtf8().data(), hInput, FALSE, papszOptions, pfnProgress, nullptr);
+	CSLDestroy(papszOptions);
+
+	bool bOk = hTarget != nullptr;
+	if (!bOk)
+		strError = "cannot write " + strTemp;
+
+	//2ݼڲ,ֱһװͼ
+	if (bOk)
+	{
+		std::vector<int> vecFactors;
+		int nSize = std::max(GDALGetRasterXSize(hTarget), GDALGetRasterYSize(hTarget));
+		for (int nFactor = 2; nSize > options.nBlockSize; nFactor *= 2)
+		{
+			vecFactors.push_back(nFactor);
+			if (nSize / nFactor <= options.nBlockSize)
+				break;
+		}
+
+		if (!vecFactors.empty() && GDALBuildOverviews(hTarget, options.strResampling.c_str(), vecFactors.size(), &vecFactors[0], 0, nullptr, pfnProgress, nullptr) != CE_None)
+		{
+			bOk = false;
+			strError = "cannot build the overviews of " + strTemp;
+		}
+		GDALClose(hTarget);
+	}
+
+	if (hInput != hSource)
+		GDALClose(hInput);
+	GDALClose(hSource);
+
+	if (bOk)
+	{
+		QFile::remove(strTarget);
+		bOk = QFile::rename(strTemp, strTarget);
+		if (!bOk)
+			strError = "cannot rename " + strTemp;
+	}
+
+	if (!bOk)
+		QFile::remove(strTemp);
+	return bOk;
+}
+
+void GeoTiffPrep::CollectSampleKeys(const QString& strFile, unsigned int nTiles, std::vector<osgEarth::TileKey>& vecKeys)
+{
+	GDALAllRegister();
+	GDALDatasetH hDataset = GDALOpen(strFile.toUtf8().data(), GA_ReadOnly);
+	if (!hDataset)
+		return;
+
+	double pTransform[6];
+	int nSizeX = GDALGetRasterXSize(hDataset);
+	int nSizeY = GDALGetRasterYSize(hDataset);
+	bool bOk = GDALGetGeoTransform(hDataset, pTransform) == CE_None;
+
+	//ĸתɾγ
+	double pX[4] = { 0.0, (double)nSizeX, 0.0, (double)nSizeX };
+	double pY[4] = { 0.0, 0.0, (double)nSizeY, (double)nSizeY };
+	for (int i = 0; i < 4; i ++)
+	{
+		double x = pTransform[0] + pX[i] * pTransform[1] + pY[i] * pTransform[2];
+		double y = pTransform[3] + pX[i] * pTransform[4] + pY[i] * pTransform[5];
+		pX[i] = x;
+		pY[i] = y;
+	}
+
+	OGRSpatialReference wgs84;
+	wgs84.SetWellKnownGeogCS("WGS84");
+	OGRSpatialReference srs;
+	char* pWkt = const_cast<char*>(GDALGetProjectionRef(hDataset));
+	if (bOk && pWkt && *pWkt && srs.importFromWkt(&pWkt) == OGRERR_NONE && !srs.IsSame(&wgs84))
+	{
+		OGRCoordinateTransformation* pTransformation = OGRCreateCoordinateTransformation(&srs, &wgs84);
+		bOk = pTransformation && pTransformation->Transform(4, pX, pY);
+		if (pTransformation)
+			OGRCoordinateTransformation::DestroyCT(pTransformation);
+	}
+	GDALClose(hDataset);
+
+	if (!bOk || nTiles == 0)
+		return;
+
+	double dWest = std::max(*std::min_element(pX, pX + 4), -180.0);
+	double dEast = std::min(*std::max_element(pX, pX + 4), 180.0);
+	double dSouth = std::max(*std::min_element(pY, pY + 4), -90.0);
+	double dNorth = std::min(*std::max_element(pY, pY + 4), 90.0);
+	if (dEast <= dWest || dNorth <= dSouth)
+		return;
+
+	//ȫγʷֵL2^(L+1),ÿ256
+	double dResolution = std::min((dEast - dWest) / nSizeX, (dNorth - dSouth) / nSizeY);
+	int nNativeLevel = std::max(0, (int)ceil(log(360.0 / (256.0 * dResolution)) / log(2.0) - 1.0));
+	int nFirstLevel = std::max(0, nNativeLevel - s_nSampleLevels + 1);
+	unsigned int nPerLevel = std::max(1u, nTiles / (nNativeLevel - nFirstLevel + 1));
+
+	const osgEarth::Profile* pProfile = osgEarth::Registry::instance()->getGlobalGeodeticProfile();
+	for (int nLevel = nFirstLevel; nLevel <= nNativeLevel; nLevel ++)
+	{
+		double dTileSize = 180.0 / (1 << nLevel);
+		unsigned int x0 = (unsigned int)((dWest + 180.0) / dTileSize);
+		unsigned int x1 = std::min((unsigned int)((dEast + 180.0) / dTileSize), (2u << nLevel) - 1);
+		unsigned int y0 = (unsigned int)((90.0 - dNorth) / dTileSize);
+		unsigned int y1 = std::min((unsigned int)((90.0 - dSouth) / dTileSize), (1u << nLevel) - 1);
+
+		//ȵظȡһ
+		unsigned long long nCount = (unsigned long long)(x1 - x0 + 1) * (y1 - y0 + 1);
+		unsigned long long nStep = std::max(1ull, nCount / nPerLevel);
+		for (unsigned long long i = 0; i < nCount && vecKeys.size() < nTiles; i += nStep)
+			vecKeys.push_back(osgEarth::TileKey(nLevel, x0 + (unsigned int)(i % (x1 - x0 + 1)), y0 + (unsigned int)(i / (x1 - x0 + 1)), pProfile));
+	}
+}
@@ -0,0 +1,57 @@
+#ifndef GEOTIFFPREP_H
+#define GEOTIFFPREP_H
+
+#include <osgEarth/TileKey>
+
+#include <QtCore/QString>
+
+#include <string>
+#include <vector>
+
+/**
+* Offline preparation of large GeoTIFF layers for the osgEarth GDAL driver.
+*
+* A raw raster is usually stored in strips without overviews, so every tile
+* request reads and resamples a full resolution window: a level 5 tile of a
+* multi-gigabyte image touches most of the file. Prepare writes a copy
+* warped to geographic WGS84 like the map profile, cut into square blocks of
+* the map tile size, with power of two internal overviews down to a single
+* block. A tile then reads a few blocks of the overview closest to its
+* resolution.
+*
+* The copy is written next to the source as name.tiled.tif. Resolve is
+* what the loaders call: it returns that copy when it is prepared and not
+* older than the source, the source otherwise.
+*/
+class GeoTiffPrep
+{
+public:
+
+	struct Options
+	{
+		Options() : nBlockSize(256), bReproject(true), strCompress("DEFLATE"), strResampling("AVERAGE") {}
+
+		int nBlockSize;				//map tile size
+		bool bReproject;			//warp to WGS84 geographic unless already in it
+		std::string strCompress;	//GTiff COMPRESS, NONE, DEFLATE, LZW or JPEG
+		std::string strResampling;	//overview resampling, NEAREST, AVERAGE, ...
+	};
+
+	//name.tif -> name.tiled.tif
+	static QString GetPreparedName(const QString& strFile);
+
+	//tiled into square blocks, with overviews unless the raster fits in one block
+	static bool IsPrepared(const QString& strFile);
+
+	//the prepared copy of strFile if usable, else strFile
+	static QString Resolve(const QString& strFile);
+
+	//writes strTarget through a temporary file, so a loader never sees a partial copy
+	static bool Prepare(const QString& strSource, const QString& strTarget, const Options& options, QString& strError, bool bProgress = false);
+
+	//about nTiles keys of the global geodetic profile over the raster, spread over the six levels
+	//above its native resolution, coarse levels being the expensive ones for a raw raster
+	static void CollectSampleKeys(const QString& strFile, unsigned int nTiles, std::vector<osgEarth::TileKey>& vecKeys);
+};
+
+#endif // GEOTIFFPREP_H
@@ -0,0 +1,394 @@
+#include "Geofence.h"
+#include "ogr_api.h"
+#include "ogrsf_frmts.h"
+#include <osg/Math>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+//ÿÿߵĸ
+static const int s_nMaxFenceGrid = 256;
+
+namespace
+{
+	void AddRing(const OGRLineString* pRing, std::vector<std::vector<osg::Vec2d> >& vecRings)
+	{
+		if (!pRing || pRing->getNumPoints() < 3)
+			return;
+
+		std::vector<osg::Vec2d> vecRing(pRing->getNumPoints());
+		for (int i = 0; i < pRing->getNumPoints(); i ++)
+			vecRing[i].set(pRing->getX(i), pRing->getY(i));
+		vecRings.push_back(vecRing);
+	}
+
+	//Liang-Barskyü,߶κ;нʱtrue
+	bool SegmentHitsBox(double x0, double y0, double x1, double y1
+		, double dMinX, double dMinY, double dMaxX, double dMaxY)
+	{
+		double p[4] = { x0 - x1, x1 - x0, y0 - y1, y1 - y0 };
+		double q[4] = { x0 - dMinX, dMaxX - x0, y0 - dMinY, dMaxY - y0 };
+		double t0 = 0.0;
+		double t1 = 1.0;
+		for (int i = 0; i < 4; i ++)
+		{
+			if (p[i] == 0.0)
+			{
+				if (q[i] < 0.0)
+					return false;
+				continue;
+			}
+
+			double t = q[i] / p[i];
+			if (p[i] < 0.0)
+				t0 = std::max(t0, t);
+			else
+				t1 = std::min(t1, t);
+		}
+
+		return t0 <= t1;
+	}
+
+	//Ͷл,ڻҲһż
+	void CollectRings(const OGRGeometry* pGeometry, std::vector<std::vector<osg::Vec2d> >& vecRings)
+	{
+		if (!pGeometry)
+			return;
+
+		switch (wkbFlatten(pGeometry->getGeometryType()))
+		{
+		case wkbPolygon:
+		{
+			const OGRPolygon* pPolygon = static_cast<const OGRPolygon*>(pGeometry);
+			AddRing(pPolygon->getExteriorRing(), vecRings);
+			for (int i = 0; i < pPolygon->getNumInteriorRings(); i ++)
+				AddRing(pPolygon->getInteriorRing(i), vecRings);
+			break;
+		}
+		case wkbMultiPolygon:
+		case wkbGeometryCollection:
+		{
+			const OGRGeometryCollection* pCollection = static_cast<const OGRGeometryCollection*>(pGeometry);
+			for (int i = 0; i < pCollection->getNumGeometries(); i ++)
+				CollectRings(pCollection->getGeometryRef(i), vecRings);
+			break;
+		}
+		default:
+			break;
+		}
+	}
+}
+
+Geofence::Geofence(double dCellSize)
+	: m_dCellSize(dCellSize)
+{
+
+}
+
+unsigned int Geofence::Load(const QString& strFile, const char* pNameField)
+{
+	OGRRegisterAll();
+	OGRDataSource* poDS = OGRSFDriverRegistrar::Open(strFile.toUtf8().data(), FALSE);
+	if (poDS == nullptr)
+		return 0;
+
+	OGRSpatialReference wgs84;
+	wgs84.SetWellKnownGeogCS("WGS84");
+
+	unsigned int nAdded = 0;
+	for (int i = 0; i < poDS->GetLayerCount(); i ++)
+	{
+		OGRLayer* poLayer = poDS->GetLayer(i);
+
+		//WGS84ͼתɾγ
+		OGRCoordinateTransformation* pTransform = nullptr;
+		OGRSpatialReference* pSRS = poLayer->GetSpatialRef();
+		if (pSRS && !pSRS->IsSame(&wgs84))
+			pTransform = OGRCreateCoordinateTransformation(pSRS, &wgs84);
+
+		int nNameField = pNameField ? poLayer->GetLayerDefn()->GetFieldIndex(pNameField) : -1;
+
+		poLayer->ResetReading();
+		OGRFeature* poFeature = nullptr;
+		while ((poFeature = poLayer->GetNextFeature()) != nullptr)
+		{
+			OGRGeometry* pGeometry = poFeature->GetGeometryRef();
+			if (pGeometry && pTransform)
+				pGeometry->transform(pTransform);
+
+			std::vector<std::vector<osg::Vec2d> > vecRings;
+			CollectRings(pGeometry, vecRings);
+			if (!vecRings.empty())
+			{
+				std::string strName;
+				if (nNameField >= 0)
+					strName = poFeature->GetFieldAsString(nNameField);
+				else
+					strName = QString("%1 #%2").arg(poLayer->GetName()).arg(poFeature->GetFID()).toUtf8().data();
+
+				AddFence(strName, vecRings);
+				nAdded ++;
+			}
+
+			OGRFeature::DestroyFeature(poFeature);
+		}
+
+		if (pTransform)
+			OGRCoordinateTransformation::DestroyCT(pTransform);
+	}
+
+	OGRDataSource::DestroyDataSource(poDS);
+	return nAdded;
+}
+
+unsigned int Geofence::AddFence(const std::string& strName, const std::vector<std::vector<osg::Vec2d> >& vecRings)
+{
+	unsigned int nFenceId = m_vecFences.size();
+	m_vecFences.push_back(Fence());
+	Fence& fence = m_vecFences.back();
+	fence.strName = strName;
+	fence.dMinX = fence.dMinY = DBL_MAX;
+	fence.dMaxX = fence.dMaxY = -DBL_MAX;
+
+	for (size_t i = 0; i < vecRings.size(); i ++)
+	{
+		const std::vector<osg::Vec2d>& vecRing = vecRings[i];
+		for (size_t j = 0; j < vecRing.size(); j ++)
+		{
+			//һպ,һصһ
+			const osg::Vec2d& a = vecRing[j];
+			const osg::Vec2d& b = vecRing[(j + 1) % vecRing.size()];
+			if (a == b)
+				continue;
+
+			Edge edge = { a.x(), a.y(), b.x(), b.y() };
+			fence.vecEdges.push_back(edge);
+
+			fence.dMinX = std::min(fence.dMinX, a.x());
+			fence.dMinY = std::min(fence.dMinY, a.y());
+			fence.dMaxX = std::max(fence.dMaxX, a.x());
+			fence.dMaxY = std::max(fence.dMaxY, a.y());
+		}
+	}
+
+	if (fence.vecEdges.empty())
+		return nFenceId;
+
+	Prepare(fence);
+
+	//ǼǵΧиǵи;90γ߻180ȾʱΧȼл,ͬһӻǼ
+	int nRows = (int)ceil(180.0 / m_dCellSize);
+	int nCols = (int)ceil(360.0 / m_dCellSize);
+	int nRow0 = osg::clampBetween((int)floor((fence.dMinY + 90.0) / m_dCellSize), 0, nRows - 1);
+	int nRow1 = osg::clampBetween((int)floor((fence.dMaxY + 90.0) / m_dCellSize), 0, nRows - 1);
+	int nCol0 = osg::clampBetween((int)floor((fence.dMinX + 180.0) / m_dCellSize), 0, nCols - 1);
+	int nCol1 = osg::clampBetween((int)floor((fence.dMaxX + 180.0) / m_dCellSize), 0, nCols - 1);
+	Candidate candidate = { nFenceId, fence.dMinX, fence.dMinY, fence.dMaxX, fence.dMaxY };
+	for (int nRow = nRow0; nRow <= nRow1; nRow ++)
+	{
+		for (int nCol = nCol0; nCol <= nCol1; nCol ++)
+			m_mapGrid[CellKey(nRow, nCol)].push_back(candidate);
+	}
+
+	return nFenceId;
+}
+
+void Geofence::Prepare(Fence& fence) const
+{
+	//ԼΪ4,Χеĳȷ
+	double dWidth = std::max(fence.dMaxX - fence.dMinX, 1e-9);
+	double dHeight = std::max(fence.dMaxY - fence.dMinY, 1e-9);
+	double dCells = 4.0 * fence.vecEdges.size();
+	fence.nColumns = osg::clampBetween((int)ceil(sqrt(dCells * dWidth / dHeight)), 1, s_nMaxFenceGrid);
+	fence.nRows = osg::clampBetween((int)ceil(sqrt(dCells * dHeight / dWidth)), 1, s_nMaxFenceGrid);
+	fence.dCellWidth = dWidth / fence.nColumns;
+	fence.dCellHeight = dHeight / fence.nRows;
+
+	fence.vecCells.assign(fence.nColumns * fence.nRows, CELL_OUTSIDE);
+	fence.vecRowStart.assign(fence.nRows + 1, 0);
+
+	//ߵİΧĸӶ߽,©
+	for (int nPass = 0; nPass < 2; nPass ++)
+	{
+		std::vector<unsigned int> vecFill;
+		if (nPass == 1)
+		{
+			for (int i = 0; i < fence.nRows; i ++)
+				fence.vecRowStart[i + 1] += fence.vecRowStart[i];
+			fence.vecRowEdges.resize(fence.vecRowStart[fence.nRows]);
+			vecFill.assign(fence.vecRowStart.begin(), fence.vecRowStart.end() - 1);
+		}
+
+		for (unsigned int i = 0; i < fence.vecEdges.size(); i ++)
+		{
+			const Edge& edge = fence.vecEdges[i];
+			int nRow0 = osg::clampBetween((int)floor((std::min(edge.y0, edge.y1) - fence.dMinY) / fence.dCellHeight), 0, fence.nRows - 1);
+			int nRow1 = osg::clampBetween((int)floor((std::max(edge.y0, edge.y1) - fence.dMinY) / fence.dCellHeight), 0, fence.nRows - 1);
+			for (int nRow = nRow0; nRow <= nRow1; nRow ++)
+			{
+				if (nPass == 0)
+					fence.vecRowStart[nRow + 1] ++;
+				else
+					fence.vecRowEdges[vecFill[nRow] ++] = i;
+			}
+
+			if (nPass == 0)
+			{
+				int nCol0 = osg::clampBetween((int)floor((std::min(edge.x0, edge.x1) - fence.dMinX) / fence.dCellWidth), 0, fence.nColumns - 1);
+				int nCol1 = osg::clampBetween((int)floor((std::max(edge.x0, edge.x1) - fence.dMinX) / fence.dCellWidth), 0, fence.nColumns - 1);
+				for (int nRow = nRow0; nRow <= nRow1; nRow ++)
+				{
+					for (int nCol = nCol0; nCol <= nCol1; nCol ++)
+					{
+						//бֻĸ,΢Ŵһ©
+						double dx0 = fence.dMinX + (nCol - 0.01) * fence.dCellWidth;
+						double dy0 = fence.dMinY + (nRow - 0.01) * fence.dCellHeight;
+						double dx1 = fence.dMinX + (nCol + 1.01) * fence.dCellWidth;
+						double dy1 = fence.dMinY + (nRow + 1.01) * fence.dCellHeight;
+						if (SegmentHitsBox(edge.x0, edge.y0, edge.x1, edge.y1, dx0, dy0, dx1, dy1))
+							fence.vecCells[nRow * fence.nColumns + nCol] = CELL_BORDER;
+					}
+				}
+			}
+		}
+	}
+
+	//ûб,ͬͬ:ߵĽ,һζ
+	std::vector<double> vecCrossings;
+	for (int nRow = 0; nRow < fence.nRows; nRow ++)
+	{
+		double dy = fence.dMinY + (nRow + 0.5) * fence.dCellHeight;
+
+		vecCrossings.clear();
+		for (unsigned int i = fence.vecRowStart[nRow]; i < fence.vecRowStart[nRow + 1]; i ++)
+		{
+			const Edge& edge = fence.vecEdges[fence.vecRowEdges[i]];
+			if ((edge.y0 > dy) != (edge.y1 > dy))
+				vecCrossings.push_back(edge.x0 + (dy - edge.y0) * (edge.x1 - edge.x0) / (edge.y1 - edge.y0));
+		}
+		std::sort(vecCrossings.begin(), vecCrossings.end());
+
+		size_t nCrossing = 0;
+		for (int nCol = 0; nCol < fence.nColumns; nCol ++)
+		{
+			double dx = fence.dMinX + (nCol + 0.5) * fence.dCellWidth;
+			while (nCrossing < vecCrossings.size() && vecCrossings[nCrossing] < dx)
+				nCrossing ++;
+
+			unsigned char& cCell = fence.vecCells[nRow * fence.nColumns + nCol];
+			if (cCell != CELL_BORDER)
+				cCell = (nCrossing & 1) ? CELL_INSIDE : CELL_OUTSIDE;
+		}
+	}
+}
+
+bool Geofence::ContainsSlow(const Fence& fence, int nRow, double dx, double dy) const
+{
+	bool bInside = false;
+	for (unsigned int i = fence.vecRowStart[nRow]; i < fence.vecRowStart[nRow + 1]; i ++)
+	{
+		const Edge& edge = fence.vecEdges[fence.vecRowEdges[i]];
+		if ((edge.y0 > dy) != (edge.y1 > dy)
+			&& dx < edge.x0 + (dy - edge.y0) * (edge.x1 - edge.x0) / (edge.y1 - edge.y0))
+			bInside = !bInside;
+	}
+
+	return bInside;
+}
+
+bool Geofence::Contains(const Fence& fence, double dx, double dy) const
+{
+	int nRow = osg::clampBetween((int)floor((dy - fence.dMinY) / fence.dCellHeight), 0, fence.nRows - 1);
+	int nCol = osg::clampBetween((int)floor((dx - fence.dMinX) / fence.dCellWidth), 0, fence.nColumns - 1);
+	unsigned char cCell = fence.vecCells[nRow * fence.nColumns + nCol];
+	if (cCell != CELL_BORDER)
+		return cCell == CELL_INSIDE;
+
+	return ContainsSlow(fence, nRow, dx, dy);
+}
+
+unsigned int Geofence::CellKey(int nRow, int nCol) const
+{
+	int nRows = (int)ceil(180.0 / m_dCellSize);
+	int nCols = (int)ceil(360.0 / m_dCellSize);
+
+	nRow = osg::clampBetween(nRow, 0, nRows - 1);
+	nCol = osg::clampBetween(nCol, 0, nCols - 1);
+
+	return (unsigned int)nRow * nCols + nCol;
+}
+
+void Geofence::Query(double dLon, double dLat, std::vector<unsigned int>& vecFences) const
+{
+	vecFences.clear();
+
+	std::unordered_map<unsigned int, std::vector<Candidate> >::const_iterator itr = m_mapGrid.find(
+		CellKey((int)floor((dLat + 90.0) / m_dCellSize), (int)floor((dLon + 180.0) / m_dCellSize)));
+	if (itr == m_mapGrid.end())
+		return;
+
+	//Χкͱŷһ,ɸ;ﰴŵǼ,Ȼ
+	const std::vector<Candidate>& vecCandidates = itr->second;
+	for (size_t i = 0; i < vecCandidates.size(); i ++)
+	{
+		const Candidate& candidate = vecCandidates[i];
+		if (dLon < candidate.dMinX || dLon > candidate.dMaxX || dLat < candidate.dMinY || dLat > candidate.dMaxY)
+			continue;
+
+		if (Contains(m_vecFences[candidate.nFenceId], dLon, dLat))
+			vecFences.push_back(candidate.nFenceId);
+	}
+}
+
+unsigned int Geofence::Update(unsigned int nTrackId, double dLon, double dLat, std::vector<Event>& vecEvents)
+{
+	Query(dLon, dLat, m_vecQuery);
+
+	std::vector<unsigned int>& vecState = m_mapTracks[nTrackId];
+	if (vecState == m_vecQuery)
+		return 0;
+
+	//
+	unsigned int nEvents = 0;
+	size_t i = 0;
+	size_t j = 0;
+	while (i < vecState.size() || j < m_vecQuery.size())
+	{
+		Event event;
+		if (j == m_vecQuery.size() || (i < vecState.size() && vecState[i] < m_vecQuery[j]))
+		{
+			event.nFenceId = vecState[i ++];
+			event.bEnter = false;
+		}
+		else if (i == vecState.size() || m_vecQuery[j] < vecState[i])
+		{
+			event.nFenceId = m_vecQuery[j ++];
+			event.bEnter = true;
+		}
+		else
+		{
+			i ++;
+			j ++;
+			continue;
+		}
+
+		vecEvents.push_back(event);
+		nEvents ++;
+	}
+
+	vecState.swap(m_vecQuery);
+	return nEvents;
+}
+
+void Geofence::RemoveTrack(unsigned int nTrackId)
+{
+	m_mapTracks.erase(nTrackId);
+}
+
+void Geofence::Clear()
+{
+	m_vecFences.clear();
+	m_mapGrid.clear();
+	m_mapTracks.clear();
+}
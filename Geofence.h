@@ -0,0 +1,116 @@
+#ifndef GEOFENCE_H
+#define GEOFENCE_H
+
+#include <osg/Vec2d>
+
+#include <QtCore/QString>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+* Tells when a track enters or leaves one of a set of restricted areas.
+*
+* Every fence is a set of rings tested with the even-odd rule, so holes and
+* multipolygon parts need no special handling. Fences are found through a
+* coarse lon/lat grid listing every fence whose bounding box touches a cell.
+* Each fence is prepared with its own grid over its bounding box: cells
+* crossed by no edge are classified inside or outside once, so most points
+* are answered by a lookup, and points in cells along the border cast a ray
+* only against the edges of their grid row.
+*
+* The per-track state is the sorted list of fences the track is in, and
+* Update only reports the difference. Rings must not cross the
+* antimeridian. Not thread safe.
+*/
+class Geofence
+{
+public:
+
+	struct Event
+	{
+		unsigned int nFenceId;
+		bool bEnter;		//false when the track left the fence
+	};
+
+	Geofence(double dCellSize = 1.0);
+
+	//polygons of a shapefile, GeoJSON or any other OGR source; returns the number of fences added
+	unsigned int Load(const QString& strFile, const char* pNameField = "name");
+
+	//first ring is usually the outer one, but every ring counts the same
+	unsigned int AddFence(const std::string& strName, const std::vector<std::vector<osg::Vec2d> >& vecRings);
+
+	void Clear();
+
+	unsigned int GetNumFences() const { return m_vecFences.size(); }
+
+	const std::string& GetName(unsigned int nFenceId) const { return m_vecFences[nFenceId].strName; }
+
+	//ids of the fences containing (dLon, dLat), ascending
+	void Query(double dLon, double dLat, std::vector<unsigned int>& vecFences) const;
+
+	//Query() plus the per track state; appends the transitions to vecEvents and returns their number
+	unsigned int Update(unsigned int nTrackId, double dLon, double dLat, std::vector<Event>& vecEvents);
+
+	//forget a track, without leave events
+	void RemoveTrack(unsigned int nTrackId);
+
+private:
+
+	struct Edge
+	{
+		double x0, y0, x1, y1;
+	};
+
+	enum CellState
+	{
+		CELL_OUTSIDE = 0,
+		CELL_INSIDE = 1,
+		CELL_BORDER = 2
+	};
+
+	struct Fence
+	{
+		std::string strName;
+		double dMinX, dMinY, dMaxX, dMaxY;
+		std::vector<Edge> vecEdges;
+
+		//edge grid over the bounding box
+		int nColumns;
+		int nRows;
+		double dCellWidth;
+		double dCellHeight;
+		std::vector<unsigned char> vecCells;
+
+		//edges overlapping each grid row, rows stored one after the other
+		std::vector<unsigned int> vecRowStart;
+		std::vector<unsigned int> vecRowEdges;
+	};
+
+	struct Candidate
+	{
+		unsigned int nFenceId;
+		double dMinX, dMinY, dMaxX, dMaxY;
+	};
+
+	void Prepare(Fence& fence) const;
+
+	//(dx, dy) must be inside the bounding box of the fence
+	bool Contains(const Fence& fence, double dx, double dy) const;
+
+	//even-odd test against the edges of grid row nRow
+	bool ContainsSlow(const Fence& fence, int nRow, double dx, double dy) const;
+
+	unsigned int CellKey(int nRow, int nCol) const;
+
+	double m_dCellSize;
+
+	std::vector<Fence> m_vecFences;
+	std::unordered_map<unsigned int, std::vector<Candidate> > m_mapGrid;
+	std::unordered_map<unsigned int, std::vector<unsigned int> > m_mapTracks;
+	std::vector<unsigned int> m_vecQuery;
+};
+
+#endif // GEOFENCE_H
@@ -1,7 +1,17 @@
 #include "MainWindow.h"
 
+#include <osgEarth/ImageLayer>
+#include <osgEarth/ElevationLayer>
+#include <osgEarth/TileKey>
+#include <QFileInfo>
+#include "TileArchiveSource.h"
+#include "GeoTiffPrep.h"
+#include <QSettings>
+
 CScreenCapture* g_pScreenCapture = nullptr;
 CScreenCapture::WriteToImageFile* g_pCaptureOperation = nullptr;
+RouteConformance* g_pRouteConformance = nullptr;
+TextureCompressor::Format g_nTextureCompression = TextureCompressor::FORMAT_NONE;
 
 bool DelDir(const QString &path);
 
@@ -9,8 +19,11 @@ DemoMainWindow::DemoMainWindow(osgEarth::QtGui::DataManager* manager, osgEarth::
 	: _manager(manager), _mapNode(mapNode), _annoRoot(annotationRoot), _layerAdded(false), _terrainProfileDock(0L), _viewerWidget(0L)
 {
 	_annotationToolbar = nullptr;
-	m_pCurrentLineModelLayer = nullptr;
-	m_pCurrentPointModelLayer = nullptr;
+	m_dTimelineBegin = 0.0;
+	m_pSeeder = nullptr;
+
+	m_pAeroLineLoader = new AeroLineLoader(g_root, mapNode->getMapSRS()->getEllipsoid(), this);
+	g_pRouteConformance = m_pAeroLineLoader->GetConformance();
 
 	initUi();
 }
@@ -85,99 +98,293 @@ void DemoMainWindow::slotLoadAeroLine()
 	if (strFileName.isEmpty() || strFileName.isNull())
 		return;
 
-	if (m_pCurrentLineModelLayer)
-	{
-		g_MapNode->getMap()->removeModelLayer(m_pCurrentLineModelLayer);
+	if (!m_pAeroLineLoader->Load(strFileName))
+		return;
 
-//		ʾɾosgEarthԶͷ
-// 		delete m_pCurrentModelLayer;
-// 		m_pCurrentModelLayer = nullptr;
-	}
+	m_pActionWatchAeroLine->setEnabled(true);
+	m_pActionSeed->setEnabled(true);
+}
 
-	if (m_pCurrentPointModelLayer)
+void DemoMainWindow::slotWatchAeroLine(bool bWatch)
+{
+	m_pAeroLineLoader->SetWatching(bWatch);
+}
+
+void DemoMainWindow::slotShowStats(bool bShow)
+{
+	if (g_pStatsHUD)
+		g_pStatsHUD->SetEnabled(bShow);
+}
+
+void DemoMainWindow::slotDumpTrace()
+{
+	QString fileName = QFileDialog::getSaveFileName(this, tr("Save File"),
+		"trace.json",
+		tr("Trace (*.json)"));
+
+	if (fileName.isEmpty() || fileName.isNull())
+		return;
+
+	//10ĸټ¼
+	if (!TraceDump(fileName.toLocal8Bit().data(), 10.0))
+		statusBar()->showMessage(QString::fromLocal8Bit("ļдʧ"), 5000);
+}
+
+void DemoMainWindow::slotPlayback(bool bPlayback)
+{
+	if (!g_pTrackPlayback)
+		return;
+
+	if (bPlayback)
 	{
-		g_MapNode->getMap()->removeModelLayer(m_pCurrentPointModelLayer);
+		if (!g_pTrackPlayback->Start())
+		{
+			m_pActionPlayback->setChecked(false);
+			statusBar()->showMessage(QString::fromLocal8Bit("ûпɻطŵĺ¼"), 5000);
+			return;
+		}
 	}
+	else
+	{
+		g_pTrackPlayback->Stop();
+		m_pActionPlay->setChecked(false);
+	}
+
+	m_pActionStop->setEnabled(!bPlayback);
+	m_pActionPlay->setEnabled(bPlayback);
+	m_pComboSpeed->setEnabled(bPlayback);
+	m_pSliderTime->setEnabled(bPlayback);
+}
 
-	QString strResourcePath = QApplication::applicationFilePath();
-	strResourcePath = QFileInfo(strResourcePath).absolutePath();
-	strResourcePath += "/temp";
+void DemoMainWindow::slotPlay(bool bPlay)
+{
+	if (g_pTrackPlayback)
+		g_pTrackPlayback->SetPlaying(bPlay);
+}
 
-	//ڳʱɾʱļУڴ˴ɾ
-	//DelDir(strResourcePath);
+void DemoMainWindow::slotPlaybackSpeed(int nIndex)
+{
+	if (g_pTrackPlayback)
+		g_pTrackPlayback->SetSpeed(m_pComboSpeed->itemData(nIndex).toDouble());
+}
 
-	QDir dir;
-	dir.mkdir(strResourcePath);
+void DemoMainWindow::slotSeek(int nValue)
+{
+	if (g_pTrackPlayback)
+		g_pTrackPlayback->Seek(m_dTimelineBegin + nValue);
+}
 
-	QString strLinePath = strResourcePath + "/" + QUuid::createUuid().toString() + ".shp";
-	QString strPointPath = strResourcePath + "/" + QUuid::createUuid().toString() + ".shp";
-	QStringList strPathList;
-	strPathList.push_back(strLinePath);
-	strPathList.push_back(strPointPath);
+void DemoMainWindow::slotQueryNearby()
+{
+	osgEarth::Util::EarthManipulator* pManipulator = dynamic_cast<osgEarth::Util::EarthManipulator*>(g_viewerMain->getCameraManipulator());
+	if (!pManipulator || !g_pTrackIndex)
+		return;
 
-	Aero2Shp::TranslateFile(strFileName, strPathList);
+	//ͼ20ڵĿ,ûʱһ
+	const double dRadius = 20.0 * 1852.0;
+	osgEarth::GeoPoint center = pManipulator->getViewpoint().focalPoint().get();
 
-	//shp
+	std::vector<TrackSpatialIndex::Hit> vecHits;
+	g_pTrackIndex->QueryRadius(center.x(), center.y(), dRadius, vecHits);
+	if (vecHits.empty())
 	{
-		osgEarth::Drivers::OGRFeatureOptions featureOptions;
-		featureOptions.url() = strLinePath.toUtf8().data();
+		if (g_pTrackIndex->QueryNearest(center.x(), center.y(), 1, vecHits) == 0)
+		{
+			statusBar()->showMessage(QString::fromLocal8Bit("ûĿ"), 5000);
+			return;
+		}
+
+		statusBar()->showMessage(QString::fromLocal8Bit("20ûĿ,  %1,  %2 ")
+			.arg(vecHits[0].nId).arg(vecHits[0].dDistance / 1852.0, 0, 'f', 1), 10000);
+		return;
+	}
 
-		osgEarth::Symbology::Style style;
+	QString strMessage = QString::fromLocal8Bit("20 %1 Ŀ:").arg(vecHits.size());
+	for (size_t i = 0; i < vecHits.size() && i < 10; i ++)
+		strMessage += QString(" %1 (%2)").arg(vecHits[i].nId).arg(vecHits[i].dDistance / 1852.0, 0, 'f', 1);
+	statusBar()->showMessage(strMessage, 10000);
+}
 
-		osgEarth::Symbology::LineSymbol* ls = style.getOrCreateSymbol<osgEarth::Symbology::LineSymbol>();
-		ls->stroke()->color() = osgEarth::Symbology::Color::Red;
-		ls->stroke()->width() = 4.0f;
+//ͼƬϿ; ֻǾֲͼ(data/tilesµĴ浵ŦԼͼ)ΧƬʧ
+static bool LayerMayHaveTile(osgEarth::TerrainLayer* pLayer, const osgEarth::TileKey& key)
+{
+	if (!pLayer->getEnabled() || !pLayer->isKeyInRange(key))
+		return false;
 
-		osgEarth::Drivers::FeatureGeomModelOptions geomOptions;
-		geomOptions.featureOptions() = featureOptions;
-		geomOptions.styles() = new osgEarth::Symbology::StyleSheet();
-		geomOptions.styles()->addStyle(style);
-		geomOptions.enableLighting() = false;
+	osgEarth::TileSource* pSource = pLayer->getTileSource();
+	return !pSource || pSource->hasData(key);
+}
 
-		osgEarth::Drivers::ModelLayerOptions layerOptions("line features", geomOptions);
-		m_pCurrentLineModelLayer = new osgEarth::ModelLayer(layerOptions);
-		g_MapNode->getMap()->addModelLayer(m_pCurrentLineModelLayer);
+void DemoMainWindow::slotSeedCorridor(bool bSeed)
+{
+	if (!bSeed)
+	{
+		m_timerSeed.stop();
+		if (m_pSeeder)
+		{
+			//дļ,´δ
+			m_pSeeder->Stop();
+			statusBar()->showMessage(QString::fromLocal8Bit("·Ԥͣ,  %1/%2")
+				.arg(m_pSeeder->GetNumDone()).arg(m_pSeeder->GetNumTiles()), 5000);
+			delete m_pSeeder;
+			m_pSeeder = nullptr;
+		}
+		return;
 	}
 
-	//صshp
+	std::vector<std::vector<osg::Vec2d> > vecLines;
+	m_pAeroLineLoader->GetLines(vecLines);
+
+	const osgEarth::Profile* pProfile = _mapNode->getMap()->getProfile();
+	CorridorSeeder::Grid grid;
+	grid.bGeographic = pProfile->getSRS()->isGeographic();
+
+	//ûлʱȡƬֱӶ,Ԥֻ˷Ѵ
+	const char* pError = nullptr;
+	if (vecLines.empty())
+		pError = "ûмغ";
+	else if (!grid.bGeographic && !pProfile->getSRS()->isSphericalMercator())
+		pError = "ͼͶӰ֧Ԥ";
+	else if (!_mapNode->getMap()->getCache())
+		pError = "ͼûû, ޷Ԥ";
+
+	if (pError)
 	{
-		osgEarth::Drivers::OGRFeatureOptions featureOptions;
-		featureOptions.url() = strPointPath.toUtf8().data();
-
-		osgEarth::Symbology::Style style;
-
-		osgEarth::Symbology::PointSymbol* ps = style.getOrCreateSymbol<osgEarth::Symbology::PointSymbol>();
-		ps->fill()->color() = osgEarth::Symbology::Color::Yellow;
-		ps->size() = 8.0;
-
-		osgEarth::Symbology::TextSymbol* text = style.getOrCreateSymbol<osgEarth::Symbology::TextSymbol>();
-		text->content() = osgEarth::Symbology::StringExpression("[Name]");
-		//text->priority() = osgEarth::Symbology::NumericExpression("[pop_cntry]");
-		text->removeDuplicateLabels() = true;
-		text->size() = 30.0f;
-		text->alignment() = osgEarth::Symbology::TextSymbol::ALIGN_CENTER_CENTER;
-		text->fill()->color() = osgEarth::Symbology::Color::Green;
-		text->halo()->color() = osgEarth::Symbology::Color::Yellow;
-
-		osgEarth::Drivers::FeatureGeomModelOptions geomOptions;
-		geomOptions.featureOptions() = featureOptions;
-		geomOptions.styles() = new osgEarth::Symbology::StyleSheet();
-		geomOptions.styles()->addStyle(style);
-		geomOptions.enableLighting() = false;
-
-		osgEarth::Drivers::ModelLayerOptions layerOptions("point features", geomOptions);
-		m_pCurrentPointModelLayer = new osgEarth::ModelLayer(layerOptions);
-		g_MapNode->getMap()->addModelLayer(m_pCurrentPointModelLayer);
+		m_pActionSeed->blockSignals(true);
+		m_pActionSeed->setChecked(false);
+		m_pActionSeed->blockSignals(false);
+		statusBar()->showMessage(QString::fromLocal8Bit(pError), 5000);
+		return;
 	}
+
+	grid.dXMin = pProfile->getExtent().xMin();
+	grid.dYMin = pProfile->getExtent().yMin();
+	grid.dXMax = pProfile->getExtent().xMax();
+	grid.dYMax = pProfile->getExtent().yMax();
+	pProfile->getNumTiles(0, grid.nTilesX, grid.nTilesY);
+
+	//ͼȡһƬ,ͼ㰴д뻺;ֱӵImageLayer::createImage,ֻʾʱҪѹ
+	osg::ref_ptr<osgEarth::Map> pMap = _mapNode->getMap();
+	osg::ref_ptr<const osgEarth::Profile> pMapProfile = pProfile;
+	CorridorSeeder::SeedFunc func = [pMap, pMapProfile](unsigned int nLevel, unsigned int x, unsigned int y) -> bool
+	{
+		osgEarth::TileKey key(nLevel, x, y, pMapProfile.get());
+		bool bOk = true;
+
+		osgEarth::ImageLayerVector vecImageLayers;
+		pMap->getImageLayers(vecImageLayers);
+		for (size_t i = 0; i < vecImageLayers.size(); i ++)
+		{
+			if (LayerMayHaveTile(vecImageLayers[i].get(), key))
+				bOk = vecImageLayers[i]->osgEarth::ImageLayer::createImage(key).valid() && bOk;
+		}
+
+		osgEarth::ElevationLayerVector vecElevationLayers;
+		pMap->getElevationLayers(vecElevationLayers);
+		for (size_t i = 0; i < vecElevationLayers.size(); i ++)
+		{
+			if (LayerMayHaveTile(vecElevationLayers[i].get(), key))
+				bOk = vecElevationLayers[i]->createHeightField(key).valid() && bOk;
+		}
+		return bOk;
+	};
+
+	//ȡ㼶Χ߳data/seed.ini
+	QString strDataPath = QFileInfo(QApplication::applicationFilePath()).absolutePath() + "/data/";
+	QSettings settings(strDataPath + "seed.ini", QSettings::IniFormat);
+
+	m_pSeeder = new CorridorSeeder(grid, func, settings.value("seed/threads", 4).toUInt(), settings.value("seed/queue_size", 256).toUInt());
+	m_pSeeder->SetBuffer(settings.value("seed/buffer", 20000.0).toDouble());
+	m_pSeeder->SetLevels(settings.value("seed/min_level", 0).toUInt(), settings.value("seed/max_level", 12).toUInt());
+	m_pSeeder->SetProgressFile((strDataPath + "seed.progress").toLocal8Bit().data());
+	for (size_t i = 0; i < vecLines.size(); i ++)
+		m_pSeeder->AddLine(vecLines[i]);
+
+	m_pSeeder->Start();
+	m_timerSeed.start(1000);
+	slotSeedProgress();
+}
+
+void DemoMainWindow::slotSeedProgress()
+{
+	if (!m_pSeeder)
+		return;
+
+	if (m_pSeeder->IsRunning())
+	{
+		statusBar()->showMessage(QString::fromLocal8Bit("·Ԥ %1/%2")
+			.arg(m_pSeeder->GetNumDone()).arg(m_pSeeder->GetNumTiles()));
+		return;
+	}
+
+	m_timerSeed.stop();
+	if (m_pSeeder->GetNumPendingRetries() > 0)
+		statusBar()->showMessage(QString::fromLocal8Bit("·Ԥ, %1 Ƭ, %2 ʧ, ´Ԥʱ")
+			.arg(m_pSeeder->GetNumTiles()).arg(m_pSeeder->GetNumPendingRetries()), 10000);
+	else
+		statusBar()->showMessage(QString::fromLocal8Bit("·Ԥ, %1 Ƭ").arg(m_pSeeder->GetNumTiles()), 10000);
+	delete m_pSeeder;
+	m_pSeeder = nullptr;
+
+	m_pActionSeed->blockSignals(true);
+	m_pActionSeed->setChecked(false);
+	m_pActionSeed->blockSignals(false);
+}
+
+void DemoMainWindow::slotPlaybackTimeChanged(double dTime)
+{
+	//¼ڻطʱ,ÿζ»鷶Χ
+	double dBegin, dEnd;
+	if (!g_pTrackPlayback->GetTimeRange(dBegin, dEnd))
+		return;
+
+	m_dTimelineBegin = floor(dBegin);
+
+	m_pSliderTime->blockSignals(true);
+	m_pSliderTime->setRange(0, (int)ceil(dEnd - m_dTimelineBegin));
+	m_pSliderTime->setValue((int)(dTime - m_dTimelineBegin));
+	m_pSliderTime->blockSignals(false);
+
+	m_pActionPlay->blockSignals(true);
+	m_pActionPlay->setChecked(g_pTrackPlayback->IsPlaying());
+	m_pActionPlay->blockSignals(false);
+
+	m_pLabelTime->setText(QDateTime::fromMSecsSinceEpoch((qint64)(dTime * 1000.0)).toString("yyyy-MM-dd hh:mm:ss"));
+}
+
+void DemoMainWindow::slotConformanceChanged(int nPort, bool bAlert, double dCrossTrack)
+{
+	if (bAlert)
+		statusBar()->showMessage(QString::fromLocal8Bit("Ŀ %1 ƫ뺽").arg(nPort));
+	else
+		statusBar()->showMessage(QString::fromLocal8Bit("Ŀ %1 ص, ƫ %2 m").arg(nPort).arg(dCrossTrack, 0, 'f', 0), 5000);
+}
+
+void DemoMainWindow::slotGeofenceChanged(int nPort, const QString& strFence, bool bEnter)
+{
+	if (bEnter)
+		statusBar()->showMessage(QString::fromLocal8Bit("Ŀ %1  %2").arg(nPort).arg(strFence));
+	else
+		statusBar()->showMessage(QString::fromLocal8Bit("Ŀ %1 뿪 %2").arg(nPort).arg(strFence), 5000);
 }
 
 void DemoMainWindow::addRemoveLayer()
 {
 	if (!_testLayer.valid())
 	{
-		osgEarth::Drivers::GDALOptions layerOpt;
-		layerOpt.url() = osgEarth::URI("../data/nyc-inset-wgs84.tif");
-		_testLayer = new osgEarth::ImageLayer(osgEarth::ImageLayerOptions("ny_inset", layerOpt));
+		//Աдõͬ.rmtaʱ,ÿδtifز
+		osg::ref_ptr<TileArchiveSource> source = new TileArchiveSource("../data/nyc-inset-wgs84.rmta");
+		if (source->IsOpen() && !source->IsElevation())
+		{
+			_testLayer = CompressedImageLayer::Create(osgEarth::ImageLayerOptions("ny_inset"), g_nTextureCompression, source.get());
+		}
+		else
+		{
+			osgEarth::Drivers::GDALOptions layerOpt;
+			//Ԥķֿ汾
+			layerOpt.url() = osgEarth::URI(GeoTiffPrep::Resolve("../data/nyc-inset-wgs84.tif").toUtf8().data());
+			_testLayer = CompressedImageLayer::Create(osgEarth::ImageLayerOptions("ny_inset", layerOpt), g_nTextureCompression);
+		}
 	}
 
 	if (!_layerAdded)
@@ -229,6 +436,10 @@ void DemoMainWindow::closeEvent(QCloseEvent *event)
 		_viewerWidget->getViewer()->setDone(true);
 	}
 
+	//˳ǰͣԤ,
+	delete m_pSeeder;
+	m_pSeeder = nullptr;
+
 	event->accept();
 }
 
@@ -253,6 +464,66 @@ void DemoMainWindow::initUi()
 
 	QAction* pActionLoadAreoLine = pToolBar->addAction(QString::fromLocal8Bit("غ"));
 	connect(pActionLoadAreoLine, SIGNAL(triggered()), this, SLOT(slotLoadAeroLine()));
+
+	m_pActionWatchAeroLine = pToolBar->addAction(QString::fromLocal8Bit("Ӻ"));
+	m_pActionWatchAeroLine->setCheckable(true);
+	m_pActionWatchAeroLine->setEnabled(false);
+
+	connect(m_pActionWatchAeroLine, SIGNAL(toggled(bool)), this, SLOT(slotWatchAeroLine(bool)));
+
+	QAction* pActionStats = pToolBar->addAction(QString::fromLocal8Bit("ͳ"));
+	pActionStats->setCheckable(true);
+
+	connect(pActionStats, SIGNAL(toggled(bool)), this, SLOT(slotShowStats(bool)));
+
+	QAction* pActionNearby = pToolBar->addAction(QString::fromLocal8Bit("Ŀ"));
+	connect(pActionNearby, SIGNAL(triggered()), this, SLOT(slotQueryNearby()));
+
+	m_pActionSeed = pToolBar->addAction(QString::fromLocal8Bit("·Ԥ"));
+	m_pActionSeed->setCheckable(true);
+	m_pActionSeed->setEnabled(false);
+
+	connect(m_pActionSeed, SIGNAL(toggled(bool)), this, SLOT(slotSeedCorridor(bool)));
+	connect(&m_timerSeed, SIGNAL(timeout()), this, SLOT(slotSeedProgress()));
+
+	//طʱڴڵײ
+	QToolBar* pTimeline = new QToolBar("timeline", this);
+	addToolBar(Qt::BottomToolBarArea, pTimeline);
+
+	m_pActionPlayback = pTimeline->addAction(QString::fromLocal8Bit("ط"));
+	m_pActionPlayback->setCheckable(true);
+
+	connect(m_pActionPlayback, SIGNAL(toggled(bool)), this, SLOT(slotPlayback(bool)));
+
+	m_pActionPlay = pTimeline->addAction(QString::fromLocal8Bit(""));
+	m_pActionPlay->setCheckable(true);
+	m_pActionPlay->setEnabled(false);
+
+	connect(m_pActionPlay, SIGNAL(toggled(bool)), this, SLOT(slotPlay(bool)));
+
+	m_pComboSpeed = new QComboBox(pTimeline);
+	double pSpeeds[] = { 1.0, 2.0, 4.0, 8.0, 16.0, 60.0 };
+	for (int i = 0; i < 6; i ++)
+		m_pComboSpeed->addItem(QString("%1x").arg(pSpeeds[i]), pSpeeds[i]);
+	m_pComboSpeed->setEnabled(false);
+	pTimeline->addWidget(m_pComboSpeed);
+
+	connect(m_pComboSpeed, SIGNAL(currentIndexChanged(int)), this, SLOT(slotPlaybackSpeed(int)));
+
+	m_pSliderTime = new QSlider(Qt::Horizontal, pTimeline);
+	m_pSliderTime->setEnabled(false);
+	pTimeline->addWidget(m_pSliderTime);
+
+	connect(m_pSliderTime, SIGNAL(valueChanged(int)), this, SLOT(slotSeek(int)));
+
+	m_pLabelTime = new QLabel(pTimeline);
+	m_pLabelTime->setMinimumWidth(140);
+	pTimeline->addWidget(m_pLabelTime);
+
+#ifdef ROUTEMONITOR_TRACE
+	QAction* pActionTrace = pToolBar->addAction(QString::fromLocal8Bit(""));
+	connect(pActionTrace, SIGNAL(triggered()), this, SLOT(slotDumpTrace()));
+#endif
 }
 
 void DemoMainWindow::createActions()
@@ -35,6 +35,7 @@
 #include <osgEarthAnnotation/ScaleDecoration>
 #include <osgEarthDrivers/gdal/GDALOptions>
 #include <osgEarth/GeoData>
+#include <osgEarthUtil/EarthManipulator>
 #include <osgEarthDrivers/feature_ogr/OGRFeatureOptions>
 #include <osgEarthDrivers/model_feature_geom/FeatureGeomModelOptions>
 
@@ -43,19 +44,37 @@
 #include <QtGui>
 #include <QMainWindow>
 #include <QToolBar>
+#include <QStatusBar>
+#include <QComboBox>
+#include <QLabel>
+#include <QSlider>
 #include <QFileDialog>
 #include <QUuid>
+#include <QTimer>
 
 #include <QtWidgets/QApplication>
 #include "ScreenCapture.h"
 #include "Aero2Shp.h"
+#include "AeroLineLoader.h"
+#include "CorridorSeeder.h"
+#include "StatsHUD.h"
+#include "Trace.h"
+#include "TrackPlayback.h"
+#include "TrackSpatialIndex.h"
+#include "CompressedImageLayer.h"
 
 extern bool g_bPlaneMove;
 extern osgViewer::Viewer* g_viewerMain;
 extern osgEarth::MapNode* g_MapNode;
+extern osg::Group* g_root;
 
 extern CScreenCapture* g_pScreenCapture;
 extern CScreenCapture::WriteToImageFile* g_pCaptureOperation;
+extern RouteConformance* g_pRouteConformance;
+extern TextureCompressor::Format g_nTextureCompression;
+extern StatsHUD* g_pStatsHUD;
+extern TrackPlayback* g_pTrackPlayback;
+extern TrackSpatialIndex* g_pTrackIndex;
 
 class DemoMainWindow : public QMainWindow
 {
@@ -69,6 +88,8 @@ public:
 
 	void setTerrainProfileWidget(osgEarth::QtGui::TerrainProfileWidget* widget);
 
+	AeroLineLoader* GetAeroLineLoader() const { return m_pAeroLineLoader; }
+
 private slots:
 
 	void slotStop();
@@ -77,6 +98,36 @@ private slots:
 
 	void slotLoadAeroLine();
 
+	void slotWatchAeroLine(bool bWatch);
+
+	void slotShowStats(bool bShow);
+
+	void slotDumpTrace();
+
+	void slotPlayback(bool bPlayback);
+
+	void slotPlay(bool bPlay);
+
+	void slotPlaybackSpeed(int nIndex);
+
+	void slotSeek(int nValue);
+
+	void slotQueryNearby();
+
+	void slotSeedCorridor(bool bSeed);
+
+	void slotSeedProgress();
+
+public slots:
+
+	void slotConformanceChanged(int nPort, bool bAlert, double dCrossTrack);
+
+	void slotGeofenceChanged(int nPort, const QString& strFence, bool bEnter);
+
+	void slotPlaybackTimeChanged(double dTime);
+
+private slots:
+
 	void addRemoveLayer();
 
 	void addAnnotation();
@@ -95,6 +146,15 @@ private:
 
 	QAction* m_pActionStop;
 	QAction* m_pActionCapture;
+	QAction* m_pActionWatchAeroLine;
+
+	//طʱ,ֵǾ¼
+	QAction* m_pActionPlayback;
+	QAction* m_pActionPlay;
+	QComboBox* m_pComboSpeed;
+	QSlider* m_pSliderTime;
+	QLabel* m_pLabelTime;
+	double m_dTimelineBegin;
 
 	osg::ref_ptr<osgEarth::QtGui::DataManager> _manager;
 	osg::ref_ptr<osgEarth::MapNode> _mapNode;
@@ -110,8 +170,12 @@ private:
 	QToolBar *_fileToolbar;
 	QDockWidget *_terrainProfileDock;
 
-	osgEarth::ModelLayer* m_pCurrentLineModelLayer;
-	osgEarth::ModelLayer* m_pCurrentPointModelLayer;
+	AeroLineLoader* m_pAeroLineLoader;
+
+	//·Ԥ,ʱ
+	QAction* m_pActionSeed;
+	CorridorSeeder* m_pSeeder;
+	QTimer m_timerSeed;
 };
 
 
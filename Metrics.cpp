@@ -0,0 +1,362 @@
+#include "Metrics.h"
+
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <unistd.h>
+#endif
+
+//ʱͰ()
+static const double s_pDecodeBounds[] = { 1e-6, 5e-6, 1e-5, 5e-5, 1e-4, 5e-4, 1e-3, 5e-3, 1e-2 };
+
+//֡ʱͰ()
+static const double s_pFrameBounds[] = { 0.005, 0.010, 0.0167, 0.020, 0.0333, 0.050, 0.100, 0.250, 1.0 };
+
+//ƬѹʱͰ()
+static const double s_pTextureBounds[] = { 5e-4, 1e-3, 2e-3, 5e-3, 1e-2, 2e-2, 5e-2, 0.1, 0.25 };
+
+//------------------------------------------------------------------
+
+MetricsHistogram::MetricsHistogram(const double* pBounds, unsigned int nBounds)
+	: m_vecBounds(pBounds, pBounds + nBounds)
+{
+	m_pBuckets = new std::atomic<unsigned long long>[nBounds + 1];
+	for (unsigned int i = 0; i <= nBounds; i ++)
+		m_pBuckets[i].store(0);
+
+	m_nCount.store(0);
+	m_nSum.store(0);
+}
+
+MetricsHistogram::~MetricsHistogram()
+{
+	delete[] m_pBuckets;
+}
+
+void MetricsHistogram::Observe(double dValue)
+{
+	unsigned int nIndex = 0;
+	while (nIndex < m_vecBounds.size() && dValue > m_vecBounds[nIndex])
+		nIndex ++;
+
+	m_pBuckets[nIndex].fetch_add(1, std::memory_order_relaxed);
+	m_nCount.fetch_add(1, std::memory_order_relaxed);
+	if (dValue > 0.0)
+		m_nSum.fetch_add((unsigned long long)(dValue * 1e9), std::memory_order_relaxed);
+}
+
+unsigned long long MetricsHistogram::GetBucket(unsigned int nIndex) const
+{
+	return m_pBuckets[nIndex].load(std::memory_order_relaxed);
+}
+
+unsigned long long MetricsHistogram::GetCount() const
+{
+	return m_nCount.load(std::memory_order_relaxed);
+}
+
+double MetricsHistogram::GetSum() const
+{
+	return m_nSum.load(std::memory_order_relaxed) * 1e-9;
+}
+
+double MetricsHistogram::Quantile(double dQuantile) const
+{
+	unsigned long long nTotal = 0;
+	for (unsigned int i = 0; i <= m_vecBounds.size(); i ++)
+		nTotal += GetBucket(i);
+
+	if (nTotal == 0 || m_vecBounds.empty())
+		return 0.0;
+
+	double dRank = dQuantile * nTotal;
+	unsigned long long nCumulative = 0;
+	for (unsigned int i = 0; i < m_vecBounds.size(); i ++)
+	{
+		unsigned long long nBucket = GetBucket(i);
+		if (nCumulative + nBucket >= dRank && nBucket > 0)
+		{
+			double dLower = i > 0 ? m_vecBounds[i - 1] : 0.0;
+			return dLower + (m_vecBounds[i] - dLower) * (dRank - nCumulative) / nBucket;
+		}
+		nCumulative += nBucket;
+	}
+
+	//+InfͰʱֻܱ߽
+	return m_vecBounds.back();
+}
+
+//------------------------------------------------------------------
+
+Metrics::PortMetrics::PortMetrics(int nPort)
+	: nPort(nPort)
+	, decodeLatency(s_pDecodeBounds, sizeof(s_pDecodeBounds) / sizeof(s_pDecodeBounds[0]))
+{
+	nReceived.store(0);
+	nDecoded.store(0);
+	nDropped.store(0);
+}
+
+Metrics* Metrics::Instance()
+{
+	static Metrics s_metrics;
+	return &s_metrics;
+}
+
+Metrics::Metrics()
+	: m_frameTime(s_pFrameBounds, sizeof(s_pFrameBounds) / sizeof(s_pFrameBounds[0]))
+	, m_textureLatency(s_pTextureBounds, sizeof(s_pTextureBounds) / sizeof(s_pTextureBounds[0]))
+{
+	m_nTileCacheHits.store(0);
+	m_nTileCacheMisses.store(0);
+	m_nElevationCacheHits.store(0);
+	m_nElevationCacheMisses.store(0);
+	m_nPrefetchHits.store(0);
+	m_nPrefetchMisses.store(0);
+	m_nHistoryWriteErrors.store(0);
+	m_nTexturesCompressed.store(0);
+	m_nTextureRawBytes.store(0);
+	m_nTextureCompressedBytes.store(0);
+}
+
+Metrics::~Metrics()
+{
+	for (unsigned int i = 0; i < m_vecPorts.size(); i ++)
+		delete m_vecPorts[i];
+}
+
+Metrics::PortMetrics* Metrics::RegisterPort(int nPort)
+{
+	for (unsigned int i = 0; i < m_vecPorts.size(); i ++)
+	{
+		if (m_vecPorts[i]->nPort == nPort)
+			return m_vecPorts[i];
+	}
+
+	PortMetrics* pPort = new PortMetrics(nPort);
+	m_vecPorts.push_back(pPort);
+	return pPort;
+}
+
+void Metrics::CountTileCache(bool bHit)
+{
+	if (bHit)
+		m_nTileCacheHits.fetch_add(1, std::memory_order_relaxed);
+	else
+		m_nTileCacheMisses.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Metrics::CountElevationCache(bool bHit)
+{
+	if (bHit)
+		m_nElevationCacheHits.fetch_add(1, std::memory_order_relaxed);
+	else
+		m_nElevationCacheMisses.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Metrics::CountPrefetch(bool bHit)
+{
+	if (bHit)
+		m_nPrefetchHits.fetch_add(1, std::memory_order_relaxed);
+	else
+		m_nPrefetchMisses.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Metrics::CountHistoryWriteError()
+{
+	m_nHistoryWriteErrors.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Metrics::CountTextureCompression(unsigned long long nRawBytes, unsigned long long nCompressedBytes, double dSeconds)
+{
+	m_nTexturesCompressed.fetch_add(1, std::memory_order_relaxed);
+	m_nTextureRawBytes.fetch_add(nRawBytes, std::memory_order_relaxed);
+	m_nTextureCompressedBytes.fetch_add(nCompressedBytes, std::memory_order_relaxed);
+	m_textureLatency.Observe(dSeconds);
+}
+
+void Metrics::AddGauge(const std::string& strName, const std::string& strHelp, const std::string& strLabels, GaugeFunc func)
+{
+	Gauge gauge;
+	gauge.strName = strName;
+	gauge.strHelp = strHelp;
+	gauge.strLabels = strLabels;
+	gauge.func = func;
+	m_vecGauges.push_back(gauge);
+}
+
+double Metrics::GetResidentBytes()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS pmc;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+		return (double)pmc.WorkingSetSize;
+	return 0.0;
+#else
+	FILE* pFile = fopen("/proc/self/statm", "r");
+	if (!pFile)
+		return 0.0;
+
+	long nSize = 0, nResident = 0;
+	int nRead = fscanf(pFile, "%ld %ld", &nSize, &nResident);
+	fclose(pFile);
+
+	return nRead == 2 ? (double)nResident * sysconf(_SC_PAGESIZE) : 0.0;
+#endif
+}
+
+static void AppendLine(std::string& strOut, const char* pFormat, const std::string& strName, const std::string& strLabels, double dValue)
+{
+	char szLine[512];
+	sprintf(szLine, pFormat, strName.c_str(), strLabels.c_str(), dValue);
+	strOut += szLine;
+}
+
+void Metrics::FormatHistogram(std::string& strOut, const std::string& strName, const std::string& strLabels, const MetricsHistogram& histogram) const
+{
+	std::string strPrefix = strLabels.empty() ? "" : strLabels + ",";
+
+	unsigned long long nCumulative = 0;
+	for (unsigned int i = 0; i <= histogram.GetNumBounds(); i ++)
+	{
+		nCumulative += histogram.GetBucket(i);
+
+		char szBound[64];
+		if (i < histogram.GetNumBounds())
+			sprintf(szBound, "le=\"%g\"", histogram.GetBound(i));
+		else
+			sprintf(szBound, "le=\"+Inf\"");
+
+		AppendLine(strOut, "%s_bucket{%s} %.0f\n", strName, strPrefix + szBound, (double)nCumulative);
+	}
+
+	//countȡͰĺϼ,֤+InfͰһ
+	std::string strBraces = strLabels.empty() ? "" : "{" + strLabels + "}";
+	AppendLine(strOut, "%s_sum%s %.9g\n", strName, strBraces, histogram.GetSum());
+	AppendLine(strOut, "%s_count%s %.0f\n", strName, strBraces, (double)nCumulative);
+}
+
+std::string Metrics::Format() const
+{
+	std::string strOut;
+	char szLabels[64];
+
+	strOut += "# HELP routemonitor_datagrams_received_total UDP datagrams read from the socket.\n";
+	strOut += "# TYPE routemonitor_datagrams_received_total counter\n";
+	for (unsigned int i = 0; i < m_vecPorts.size(); i ++)
+	{
+		sprintf(szLabels, "port=\"%d\"", m_vecPorts[i]->nPort);
+		AppendLine(strOut, "%s{%s} %.0f\n", "routemonitor_datagrams_received_total", szLabels, (double)m_vecPorts[i]->nReceived.load(std::memory_order_relaxed));
+	}
+
+	strOut += "# HELP routemonitor_datagrams_decoded_total Datagrams decoded into a position.\n";
+	strOut += "# TYPE routemonitor_datagrams_decoded_total counter\n";
+	for (unsigned int i = 0; i < m_vecPorts.size(); i ++)
+	{
+		sprintf(szLabels, "port=\"%d\"", m_vecPorts[i]->nPort);
+		AppendLine(strOut, "%s{%s} %.0f\n", "routemonitor_datagrams_decoded_total", szLabels, (double)m_vecPorts[i]->nDecoded.load(std::memory_order_relaxed));
+	}
+
+	strOut += "# HELP routemonitor_datagrams_dropped_total Datagrams dropped as short or out of range.\n";
+	strOut += "# TYPE routemonitor_datagrams_dropped_total counter\n";
+	for (unsigned int i = 0; i < m_vecPorts.size(); i ++)
+	{
+		sprintf(szLabels, "port=\"%d\"", m_vecPorts[i]->nPort);
+		AppendLine(strOut, "%s{%s} %.0f\n", "routemonitor_datagrams_dropped_total", szLabels, (double)m_vecPorts[i]->nDropped.load(std::memory_order_relaxed));
+	}
+
+	strOut += "# HELP routemonitor_decode_latency_seconds Time from socket read to the end of position processing.\n";
+	strOut += "# TYPE routemonitor_decode_latency_seconds histogram\n";
+	for (unsigned int i = 0; i < m_vecPorts.size(); i ++)
+	{
+		sprintf(szLabels, "port=\"%d\"", m_vecPorts[i]->nPort);
+		FormatHistogram(strOut, "routemonitor_decode_latency_seconds", szLabels, m_vecPorts[i]->decodeLatency);
+	}
+
+	strOut += "# HELP routemonitor_frame_time_seconds Interval between viewer frames.\n";
+	strOut += "# TYPE routemonitor_frame_time_seconds histogram\n";
+	FormatHistogram(strOut, "routemonitor_frame_time_seconds", "", m_frameTime);
+
+	strOut += "# HELP routemonitor_frame_time_quantile_seconds Frame time percentiles estimated from the histogram buckets.\n";
+	strOut += "# TYPE routemonitor_frame_time_quantile_seconds gauge\n";
+	const double pQuantiles[] = { 0.5, 0.9, 0.99 };
+	for (unsigned int i = 0; i < 3; i ++)
+	{
+		sprintf(szLabels, "quantile=\"%g\"", pQuantiles[i]);
+		AppendLine(strOut, "%s{%s} %.6g\n", "routemonitor_frame_time_quantile_seconds", szLabels, m_frameTime.Quantile(pQuantiles[i]));
+	}
+
+	unsigned long long nHits = m_nTileCacheHits.load(std::memory_order_relaxed);
+	unsigned long long nMisses = m_nTileCacheMisses.load(std::memory_order_relaxed);
+
+	strOut += "# HELP routemonitor_tile_cache_requests_total Tile cache lookups by result.\n";
+	strOut += "# TYPE routemonitor_tile_cache_requests_total counter\n";
+	AppendLine(strOut, "%s{%s} %.0f\n", "routemonitor_tile_cache_requests_total", "result=\"hit\"", (double)nHits);
+	AppendLine(strOut, "%s{%s} %.0f\n", "routemonitor_tile_cache_requests_total", "result=\"miss\"", (double)nMisses);
+
+	strOut += "# HELP routemonitor_tile_cache_hit_ratio Share of tile cache lookups that hit.\n";
+	strOut += "# TYPE routemonitor_tile_cache_hit_ratio gauge\n";
+	AppendLine(strOut, "%s%s %.6g\n", "routemonitor_tile_cache_hit_ratio", "", nHits + nMisses > 0 ? (double)nHits / (nHits + nMisses) : 0.0);
+
+	nHits = m_nElevationCacheHits.load(std::memory_order_relaxed);
+	nMisses = m_nElevationCacheMisses.load(std::memory_order_relaxed);
+
+	strOut += "# HELP routemonitor_elevation_cache_requests_total Terrain height lookups in the elevation cache by result.\n";
+	strOut += "# TYPE routemonitor_elevation_cache_requests_total counter\n";
+	AppendLine(strOut, "%s{%s} %.0f\n", "routemonitor_elevation_cache_requests_total", "result=\"hit\"", (double)nHits);
+	AppendLine(strOut, "%s{%s} %.0f\n", "routemonitor_elevation_cache_requests_total", "result=\"miss\"", (double)nMisses);
+
+	nHits = m_nPrefetchHits.load(std::memory_order_relaxed);
+	nMisses = m_nPrefetchMisses.load(std::memory_order_relaxed);
+
+	strOut += "# HELP routemonitor_prefetch_view_tiles_total Tiles entering the followed view by whether they were prefetched.\n";
+	strOut += "# TYPE routemonitor_prefetch_view_tiles_total counter\n";
+	AppendLine(strOut, "%s{%s} %.0f\n", "routemonitor_prefetch_view_tiles_total", "result=\"hit\"", (double)nHits);
+	AppendLine(strOut, "%s{%s} %.0f\n", "routemonitor_prefetch_view_tiles_total", "result=\"miss\"", (double)nMisses);
+
+	strOut += "# HELP routemonitor_prefetch_hit_ratio Share of tiles entering the followed view that were prefetched.\n";
+	strOut += "# TYPE routemonitor_prefetch_hit_ratio gauge\n";
+	AppendLine(strOut, "%s%s %.6g\n", "routemonitor_prefetch_hit_ratio", "", nHits + nMisses > 0 ? (double)nHits / (nHits + nMisses) : 0.0);
+
+	strOut += "# HELP routemonitor_history_write_errors_total Track history chunk writes that failed and were kept for a retry.\n";
+	strOut += "# TYPE routemonitor_history_write_errors_total counter\n";
+	AppendLine(strOut, "%s%s %.0f\n", "routemonitor_history_write_errors_total", "", (double)m_nHistoryWriteErrors.load(std::memory_order_relaxed));
+
+	unsigned long long nRawBytes = m_nTextureRawBytes.load(std::memory_order_relaxed);
+	unsigned long long nCompressedBytes = m_nTextureCompressedBytes.load(std::memory_order_relaxed);
+
+	strOut += "# HELP routemonitor_texture_tiles_compressed_total Imagery tiles block compressed before upload.\n";
+	strOut += "# TYPE routemonitor_texture_tiles_compressed_total counter\n";
+	AppendLine(strOut, "%s%s %.0f\n", "routemonitor_texture_tiles_compressed_total", "", (double)m_nTexturesCompressed.load(std::memory_order_relaxed));
+
+	strOut += "# HELP routemonitor_texture_bytes_saved_total Texture memory saved against RGBA8 uploads, mipmaps included.\n";
+	strOut += "# TYPE routemonitor_texture_bytes_saved_total counter\n";
+	AppendLine(strOut, "%s%s %.0f\n", "routemonitor_texture_bytes_saved_total", "", nRawBytes > nCompressedBytes ? (double)(nRawBytes - nCompressedBytes) : 0.0);
+
+	strOut += "# HELP routemonitor_texture_compression_ratio Compressed bytes over RGBA8 bytes of the compressed tiles.\n";
+	strOut += "# TYPE routemonitor_texture_compression_ratio gauge\n";
+	AppendLine(strOut, "%s%s %.6g\n", "routemonitor_texture_compression_ratio", "", nRawBytes > 0 ? (double)nCompressedBytes / nRawBytes : 0.0);
+
+	strOut += "# HELP routemonitor_texture_compress_seconds Time added to a tile by the block compression.\n";
+	strOut += "# TYPE routemonitor_texture_compress_seconds histogram\n";
+	FormatHistogram(strOut, "routemonitor_texture_compress_seconds", "", m_textureLatency);
+
+	for (unsigned int i = 0; i < m_vecGauges.size(); i ++)
+	{
+		const Gauge& gauge = m_vecGauges[i];
+		if (i == 0 || m_vecGauges[i - 1].strName != gauge.strName)
+		{
+			strOut += "# HELP " + gauge.strName + " " + gauge.strHelp + "\n";
+			strOut += "# TYPE " + gauge.strName + " gauge\n";
+		}
+
+		std::string strBraces = gauge.strLabels.empty() ? "" : "{" + gauge.strLabels + "}";
+		AppendLine(strOut, "%s%s %.15g\n", gauge.strName, strBraces, gauge.func());
+	}
+
+	return strOut;
+}
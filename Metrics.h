@@ -0,0 +1,135 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+* Fixed-bucket histogram that can be observed from any thread without locks.
+* Buckets are stored non-cumulative and summed when exported.
+*/
+class MetricsHistogram
+{
+public:
+
+	MetricsHistogram(const double* pBounds, unsigned int nBounds);
+	~MetricsHistogram();
+
+	void Observe(double dValue);
+
+	unsigned int GetNumBounds() const { return m_vecBounds.size(); }
+
+	double GetBound(unsigned int nIndex) const { return m_vecBounds[nIndex]; }
+
+	//nIndex == GetNumBounds() is the +Inf bucket
+	unsigned long long GetBucket(unsigned int nIndex) const;
+
+	unsigned long long GetCount() const;
+
+	double GetSum() const;
+
+	//linear interpolation inside the bucket holding the quantile
+	double Quantile(double dQuantile) const;
+
+private:
+
+	MetricsHistogram(const MetricsHistogram&);
+	MetricsHistogram& operator=(const MetricsHistogram&);
+
+	std::vector<double> m_vecBounds;
+	std::atomic<unsigned long long>* m_pBuckets;
+	std::atomic<unsigned long long> m_nCount;
+
+	//sum in units of 1e-9 so it can be an integer atomic
+	std::atomic<unsigned long long> m_nSum;
+};
+
+/**
+* Process-wide counters exported by MetricsServer.
+*
+* Hot paths only touch atomics through pointers obtained at startup
+* (RegisterPort) or the fixed members, all with relaxed ordering. Gauges are
+* callbacks evaluated while formatting, on the thread that serves the scrape.
+*/
+class Metrics
+{
+public:
+
+	struct PortMetrics
+	{
+		PortMetrics(int nPort);
+
+		int nPort;
+		std::atomic<unsigned long long> nReceived;
+		std::atomic<unsigned long long> nDecoded;
+		std::atomic<unsigned long long> nDropped;
+		MetricsHistogram decodeLatency;
+	};
+
+	typedef std::function<double()> GaugeFunc;
+
+	static Metrics* Instance();
+
+	//call before the listener starts receiving
+	PortMetrics* RegisterPort(int nPort);
+
+	MetricsHistogram& GetFrameTime() { return m_frameTime; }
+
+	//a read from a tile cache bin of the map (CountingCacheBin), bHit if the record was found
+	void CountTileCache(bool bHit);
+
+	//a terrain height lookup in ElevationCache, bHit if its grid cell was loaded
+	void CountElevationCache(bool bHit);
+
+	//a tile entering the followed view, bHit if TilePrefetcher had fetched it already
+	void CountPrefetch(bool bHit);
+
+	//a history chunk that could not be written; its points stay buffered for the next attempt
+	void CountHistoryWriteError();
+
+	//an imagery tile block compressed before upload: RGBA8 and compressed bytes with mipmaps, encoding time
+	void CountTextureCompression(unsigned long long nRawBytes, unsigned long long nCompressedBytes, double dSeconds);
+
+	//gauges sharing a name must be added one after another; strLabels is e.g. subsystem="trails"
+	void AddGauge(const std::string& strName, const std::string& strHelp, const std::string& strLabels, GaugeFunc func);
+
+	//resident set size of the whole process in bytes, 0 if unknown
+	static double GetResidentBytes();
+
+	//Prometheus text exposition format 0.0.4
+	std::string Format() const;
+
+private:
+
+	Metrics();
+	~Metrics();
+
+	struct Gauge
+	{
+		std::string strName;
+		std::string strHelp;
+		std::string strLabels;
+		GaugeFunc func;
+	};
+
+	void FormatHistogram(std::string& strOut, const std::string& strName, const std::string& strLabels, const MetricsHistogram& histogram) const;
+
+	std::vector<PortMetrics*> m_vecPorts;
+	MetricsHistogram m_frameTime;
+	std::atomic<unsigned long long> m_nTileCacheHits;
+	std::atomic<unsigned long long> m_nTileCacheMisses;
+	std::atomic<unsigned long long> m_nElevationCacheHits;
+	std::atomic<unsigned long long> m_nElevationCacheMisses;
+	std::atomic<unsigned long long> m_nPrefetchHits;
+	std::atomic<unsigned long long> m_nPrefetchMisses;
+	std::atomic<unsigned long long> m_nHistoryWriteErrors;
+	std::atomic<unsigned long long> m_nTexturesCompressed;
+	std::atomic<unsigned long long> m_nTextureRawBytes;
+	std::atomic<unsigned long long> m_nTextureCompressedBytes;
+	MetricsHistogram m_textureLatency;
+	std::vector<Gauge> m_vecGauges;
+};
+
+#endif // METRICS_H
@@ -0,0 +1,88 @@
+#include "MetricsServer.h"
+#include "Metrics.h"
+
+//ͷ󳤶,Ͽ
+static const int s_nMaxRequestSize = 8192;
+
+MetricsServer::MetricsServer(QObject *parent)
+	: QObject(parent)
+{
+	m_pServer = new QTcpServer(this);
+	connect(m_pServer, SIGNAL(newConnection()), this, SLOT(slotNewConnection()));
+}
+
+MetricsServer::~MetricsServer()
+{
+
+}
+
+bool MetricsServer::Listen(const QString& strAddress, int nPort)
+{
+	return m_pServer->listen(QHostAddress(strAddress), nPort);
+}
+
+void MetricsServer::slotNewConnection()
+{
+	while (m_pServer->hasPendingConnections())
+	{
+		QTcpSocket* pSocket = m_pServer->nextPendingConnection();
+		connect(pSocket, SIGNAL(readyRead()), this, SLOT(slotReadyRead()));
+		connect(pSocket, SIGNAL(disconnected()), pSocket, SLOT(deleteLater()));
+	}
+}
+
+void MetricsServer::slotReadyRead()
+{
+	QTcpSocket* pSocket = qobject_cast<QTcpSocket*>(sender());
+	if (!pSocket)
+		return;
+
+	//ͷٴ
+	QByteArray request = pSocket->peek(s_nMaxRequestSize);
+	if (!request.contains("\r\n\r\n"))
+	{
+		if (request.size() >= s_nMaxRequestSize)
+			pSocket->abort();
+		return;
+	}
+	pSocket->readAll();
+
+	QList<QByteArray> listRequest = request.left(request.indexOf("\r\n")).split(' ');
+
+	QByteArray response;
+	if (listRequest.size() >= 2 && listRequest[0] == "GET" && (listRequest[1] == "/metrics" || listRequest[1].startsWith("/metrics?")))
+	{
+		std::string strBody = Metrics::Instance()->Format();
+		QByteArray body(strBody.c_str(), strBody.size());
+		response = "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: "
+			+ QByteArray::number(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+	}
+	else
+	{
+		response = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+	}
+
+	pSocket->write(response);
+	pSocket->disconnectFromHost();
+}
+
+//------------------------------------------------------------------
+
+FrameMetricsHandler::FrameMetricsHandler()
+	: m_dLastTime(-1.0)
+{
+
+}
+
+bool FrameMetricsHandler::handle(const osgGA::GUIEventAdapter& ea, osgGA::GUIActionAdapter& aa)
+{
+	if (ea.getEventType() == osgGA::GUIEventAdapter::FRAME)
+	{
+		double dTime = ea.getTime();
+		if (m_dLastTime >= 0.0)
+			Metrics::Instance()->GetFrameTime().Observe(dTime - m_dLastTime);
+		m_dLastTime = dTime;
+	}
+
+	return false;
+}
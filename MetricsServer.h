@@ -0,0 +1,49 @@
+#ifndef METRICSSERVER_H
+#define METRICSSERVER_H
+
+#include <QObject>
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QTcpSocket>
+#include <osgGA/GUIEventHandler>
+
+/**
+* Minimal HTTP listener answering GET /metrics with Metrics::Format().
+* Runs on the Qt event loop, so gauges are evaluated on the GUI thread.
+*/
+class MetricsServer : public QObject
+{
+	Q_OBJECT
+
+public:
+	MetricsServer(QObject *parent = nullptr);
+	~MetricsServer();
+
+	bool Listen(const QString& strAddress, int nPort);
+
+private slots:
+
+	void slotNewConnection();
+
+	void slotReadyRead();
+
+private:
+
+	QTcpServer* m_pServer;
+};
+
+/**
+* Feeds the frame time histogram from the viewer's FRAME events.
+*/
+class FrameMetricsHandler : public osgGA::GUIEventHandler
+{
+public:
+	FrameMetricsHandler();
+
+	virtual bool handle(const osgGA::GUIEventAdapter& ea, osgGA::GUIActionAdapter& aa) override;
+
+private:
+
+	double m_dLastTime;
+};
+
+#endif // METRICSSERVER_H
@@ -22,9 +22,10 @@ bool MyManipulator::handle(const osgGA::GUIEventAdapter& ea, osgGA::GUIActionAda
 {
 	bool bRes = osgEarth::Util::EarthManipulator::handle(ea, aa);
 
-	if (ea.getEventType() == osgGA::GUIEventAdapter::SCROLL)
+	//ÿ֡Ƿ仯,仯ʱ¼
+	if (ea.getEventType() == osgGA::GUIEventAdapter::FRAME && aa.asView())
 	{
-		m_scaleBarRefresh.Start();
+		m_scaleBarRefresh.Update(getInverseMatrix(), aa.asView()->getCamera());
 	}
 
 	return bRes;
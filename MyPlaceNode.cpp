@@ -33,6 +33,7 @@
 
 #include <osg/Depth>
 #include <osgText/Text>
+#include "Trace.h"
 
 #define LC "[MyPlaceNode] "
 
@@ -84,6 +85,8 @@ MyPlaceNode::MyPlaceNode(MapNode*              mapNode,
 void
 MyPlaceNode::init()
 {
+	RM_TRACE_ZONE("MyPlaceNode::init");
+
 	//reset.
 	this->clearDecoration();
 	getAttachPoint()->removeChildren(0, getAttachPoint()->getNumChildren());
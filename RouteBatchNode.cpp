@@ -0,0 +1,372 @@
+#include "RouteBatchNode.h"
+#include <osg/Geode>
+#include <osg/LineWidth>
+#include <osgUtil/CullVisitor>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	struct LevelDesc
+	{
+		double dMaxAltitude;	//eye altitude (m) up to which this level is drawn
+		double dSimplify;		//Douglas-Peucker tolerance in degrees, 0 keeps every waypoint
+		double dStep;			//great circle densification step in meters
+	};
+
+	//ordered from near to far
+	const LevelDesc s_levels[RouteBatchNode::NUM_LEVELS] =
+	{
+		{ 800000.0,  0.0,  20000.0 },
+		{ 4000000.0, 0.01, 100000.0 },
+		{ 1.0e30,    0.1,  500000.0 },
+	};
+
+	const double s_dMeanRadius = 6371000.0;
+
+	osg::Vec3d ToUnit(const osg::Vec2d& lonLat)
+	{
+		double dLon = osg::DegreesToRadians(lonLat.x());
+		double dLat = osg::DegreesToRadians(lonLat.y());
+		return osg::Vec3d(cos(dLat) * cos(dLon), cos(dLat) * sin(dLon), sin(dLat));
+	}
+
+	double ArcAngle(const osg::Vec3d& a, const osg::Vec3d& b)
+	{
+		return atan2((a ^ b).length(), a * b);
+	}
+
+	double PointLineDistance(const osg::Vec2d& p, const osg::Vec2d& a, const osg::Vec2d& b)
+	{
+		osg::Vec2d ab = b - a;
+		double dLen2 = ab.length2();
+		if (dLen2 <= 0.0)
+			return (p - a).length();
+
+		double t = osg::clampBetween(((p - a) * ab) / dLen2, 0.0, 1.0);
+		return (p - (a + ab * t)).length();
+	}
+
+	//Douglas-Peucker, iterative so long routes cannot overflow the stack
+	void Simplify(const std::vector<osg::Vec2d>& vecIn, double dTolerance, std::vector<osg::Vec2d>& vecOut)
+	{
+		vecOut.clear();
+		if (dTolerance <= 0.0 || vecIn.size() < 3)
+		{
+			vecOut = vecIn;
+			return;
+		}
+
+		std::vector<bool> vecKeep(vecIn.size(), false);
+		vecKeep.front() = true;
+		vecKeep.back() = true;
+
+		std::vector<std::pair<size_t, size_t> > stack;
+		stack.push_back(std::make_pair((size_t)0, vecIn.size() - 1));
+
+		while (!stack.empty())
+		{
+			size_t nFirst = stack.back().first;
+			size_t nLast = stack.back().second;
+			stack.pop_back();
+
+			double dMax = 0.0;
+			size_t nMax = nFirst;
+			for (size_t i = nFirst + 1; i < nLast; i++)
+			{
+				double d = PointLineDistance(vecIn[i], vecIn[nFirst], vecIn[nLast]);
+				if (d > dMax)
+				{
+					dMax = d;
+					nMax = i;
+				}
+			}
+
+			if (dMax > dTolerance)
+			{
+				vecKeep[nMax] = true;
+				stack.push_back(std::make_pair(nFirst, nMax));
+				stack.push_back(std::make_pair(nMax, nLast));
+			}
+		}
+
+		for (size_t i = 0; i < vecIn.size(); i++)
+		{
+			if (vecKeep[i])
+				vecOut.push_back(vecIn[i]);
+		}
+	}
+}
+
+RouteBatchNode::RouteBatchNode(const osg::EllipsoidModel* pEllipsoid, double dAltitude)
+	: m_pEllipsoid(pEllipsoid), m_dAltitude(dAltitude), m_nNextLineId(1)
+{
+	m_pColors = new osg::Vec4Array;
+	m_pColors->push_back(osg::Vec4(1.0f, 0.0f, 0.0f, 1.0f));
+
+	for (unsigned int i = 0; i < NUM_LEVELS; i++)
+	{
+		m_pLevelGroups[i] = new osg::Group;
+		addChild(m_pLevelGroups[i].get());
+	}
+
+	osg::StateSet* stateset = getOrCreateStateSet();
+	stateset->setMode(GL_LIGHTING, osg::StateAttribute::OFF | osg::StateAttribute::OVERRIDE);
+	stateset->setAttribute(new osg::LineWidth(4.0));
+}
+
+RouteBatchNode::~RouteBatchNode()
+{
+
+}
+
+unsigned int RouteBatchNode::AddLine(const std::vector<osg::Vec2d>& vecLonLat)
+{
+	Line line;
+	line.vecLonLat = vecLonLat;
+	line.nVertices = CountVertices(vecLonLat, s_levels[0].dStep);
+
+	//first batch with room, so that lines removed by a reload leave no holes for long
+	unsigned int nBatch = 0;
+	for (; nBatch < m_vecBatches.size(); nBatch++)
+	{
+		if (m_vecBatches[nBatch].nVertices + line.nVertices <= MAX_BATCH_VERTICES)
+			break;
+	}
+
+	if (nBatch == m_vecBatches.size())
+		m_vecBatches.push_back(Batch());
+
+	Batch& batch = m_vecBatches[nBatch];
+	batch.vecLines.push_back(m_nNextLineId);
+	batch.nVertices += line.nVertices;
+	batch.bDirty = true;
+
+	line.nBatch = nBatch;
+	m_mapLines[m_nNextLineId] = line;
+
+	return m_nNextLineId++;
+}
+
+void RouteBatchNode::RemoveLine(unsigned int nLineId)
+{
+	std::map<unsigned int, Line>::iterator itr = m_mapLines.find(nLineId);
+	if (itr == m_mapLines.end())
+		return;
+
+	Batch& batch = m_vecBatches[itr->second.nBatch];
+	batch.vecLines.erase(std::remove(batch.vecLines.begin(), batch.vecLines.end(), nLineId), batch.vecLines.end());
+	batch.nVertices -= itr->second.nVertices;
+	batch.bDirty = true;
+
+	m_mapLines.erase(itr);
+}
+
+void RouteBatchNode::Clear()
+{
+	m_mapLines.clear();
+
+	for (size_t i = 0; i < m_vecBatches.size(); i++)
+	{
+		m_vecBatches[i].vecLines.clear();
+		m_vecBatches[i].nVertices = 0;
+		m_vecBatches[i].bDirty = true;
+	}
+}
+
+void RouteBatchNode::Update()
+{
+	for (size_t i = 0; i < m_vecBatches.size(); i++)
+	{
+		if (m_vecBatches[i].bDirty)
+			BuildBatch(m_vecBatches[i]);
+	}
+}
+
+void RouteBatchNode::SetColor(const osg::Vec4& color)
+{
+	(*m_pColors)[0] = color;
+	m_pColors->dirty();
+}
+
+void RouteBatchNode::SetLineWidth(float fWidth)
+{
+	getOrCreateStateSet()->setAttribute(new osg::LineWidth(fWidth));
+}
+
+unsigned int RouteBatchNode::GetNumVertices(unsigned int nLevel) const
+{
+	unsigned int nCount = 0;
+	if (nLevel >= NUM_LEVELS)
+		return nCount;
+
+	for (size_t i = 0; i < m_vecBatches.size(); i++)
+	{
+		const osg::MatrixTransform* pTransform = m_vecBatches[i].pLevels[nLevel].get();
+		if (pTransform == nullptr || pTransform->getNumChildren() == 0)
+			continue;
+
+		const osg::Geode* pGeode = pTransform->getChild(0)->asGeode();
+		const osg::Geometry* pGeometry = pGeode ? pGeode->getDrawable(0)->asGeometry() : nullptr;
+		if (pGeometry && pGeometry->getVertexArray())
+			nCount += pGeometry->getVertexArray()->getNumElements();
+	}
+
+	return nCount;
+}
+
+void RouteBatchNode::traverse(osg::NodeVisitor& nv)
+{
+	if (nv.getVisitorType() == osg::NodeVisitor::CULL_VISITOR)
+	{
+		m_pLevelGroups[SelectLevel(nv.getEyePoint())]->accept(nv);
+		return;
+	}
+
+	osg::Group::traverse(nv);
+}
+
+void RouteBatchNode::BuildBatch(Batch& batch)
+{
+	batch.bDirty = false;
+
+	for (unsigned int nLevel = 0; nLevel < NUM_LEVELS; nLevel++)
+	{
+		if (batch.pLevels[nLevel].valid())
+		{
+			m_pLevelGroups[nLevel]->removeChild(batch.pLevels[nLevel].get());
+			batch.pLevels[nLevel] = nullptr;
+		}
+	}
+
+	//vertices are stored relative to the first waypoint to keep float precision;
+	//lines loaded without points draw nothing and cannot give the origin
+	const Line* pFirst = nullptr;
+	for (size_t i = 0; i < batch.vecLines.size() && pFirst == nullptr; i++)
+	{
+		const Line& line = m_mapLines[batch.vecLines[i]];
+		if (!line.vecLonLat.empty())
+			pFirst = &line;
+	}
+
+	if (pFirst == nullptr)
+		return;
+
+	const osg::Vec2d& first = pFirst->vecLonLat.front();
+	osg::Vec3d origin;
+	m_pEllipsoid->convertLatLongHeightToXYZ(osg::DegreesToRadians(first.y()), osg::DegreesToRadians(first.x()), m_dAltitude,
+		origin.x(), origin.y(), origin.z());
+
+	for (unsigned int nLevel = 0; nLevel < NUM_LEVELS; nLevel++)
+	{
+		osg::Geode* pGeode = new osg::Geode;
+		pGeode->addDrawable(BuildLevel(batch, nLevel, origin));
+
+		batch.pLevels[nLevel] = new osg::MatrixTransform(osg::Matrix::translate(origin));
+		batch.pLevels[nLevel]->addChild(pGeode);
+		m_pLevelGroups[nLevel]->addChild(batch.pLevels[nLevel].get());
+	}
+}
+
+osg::Geometry* RouteBatchNode::BuildLevel(const Batch& batch, unsigned int nLevel, const osg::Vec3d& origin)
+{
+	const LevelDesc& level = s_levels[nLevel];
+
+	osg::Vec3Array* pVertices = new osg::Vec3Array;
+	osg::DrawElementsUInt* pIndices = new osg::DrawElementsUInt(osg::PrimitiveSet::LINES);
+
+	std::vector<osg::Vec2d> vecSimplified;
+	std::vector<osg::Vec3d> vecWorld;
+
+	for (size_t i = 0; i < batch.vecLines.size(); i++)
+	{
+		const Line& line = m_mapLines[batch.vecLines[i]];
+		if (line.vecLonLat.size() < 2)
+			continue;
+
+		Simplify(line.vecLonLat, level.dSimplify, vecSimplified);
+
+		vecWorld.clear();
+		for (size_t j = 1; j < vecSimplified.size(); j++)
+		{
+			AppendGreatCircle(vecSimplified[j - 1], vecSimplified[j], level.dStep, j == 1, vecWorld);
+		}
+
+		unsigned int nBase = pVertices->size();
+		for (size_t j = 0; j < vecWorld.size(); j++)
+		{
+			pVertices->push_back(osg::Vec3(vecWorld[j] - origin));
+			if (j > 0)
+			{
+				pIndices->push_back(nBase + j - 1);
+				pIndices->push_back(nBase + j);
+			}
+		}
+	}
+
+	osg::Geometry* pGeometry = new osg::Geometry;
+	pGeometry->setUseDisplayList(false);
+	pGeometry->setUseVertexBufferObjects(true);
+	pGeometry->setVertexArray(pVertices);
+	pGeometry->setColorArray(m_pColors.get(), osg::Array::BIND_OVERALL);
+	pGeometry->addPrimitiveSet(pIndices);
+
+	return pGeometry;
+}
+
+void RouteBatchNode::AppendGreatCircle(const osg::Vec2d& from, const osg::Vec2d& to, double dStep, bool bFirst, std::vector<osg::Vec3d>& vecWorld) const
+{
+	osg::Vec3d a = ToUnit(from);
+	osg::Vec3d b = ToUnit(to);
+
+	double dAngle = ArcAngle(a, b);
+	unsigned int nSteps = std::max(1u, (unsigned int)ceil(dAngle * s_dMeanRadius / dStep));
+	double dSin = sin(dAngle);
+
+	for (unsigned int i = bFirst ? 0 : 1; i <= nSteps; i++)
+	{
+		double t = (double)i / nSteps;
+
+		//slerp; nearly coincident points fall back to the chord
+		osg::Vec3d p;
+		if (dSin < 1e-9)
+			p = a * (1.0 - t) + b * t;
+		else
+			p = a * (sin((1.0 - t) * dAngle) / dSin) + b * (sin(t * dAngle) / dSin);
+
+		double dLat = atan2(p.z(), sqrt(p.x() * p.x() + p.y() * p.y()));
+		double dLon = atan2(p.y(), p.x());
+
+		osg::Vec3d world;
+		m_pEllipsoid->convertLatLongHeightToXYZ(dLat, dLon, m_dAltitude, world.x(), world.y(), world.z());
+		vecWorld.push_back(world);
+	}
+}
+
+unsigned int RouteBatchNode::CountVertices(const std::vector<osg::Vec2d>& vecLonLat, double dStep) const
+{
+	if (vecLonLat.empty())
+		return 0;
+
+	unsigned int nCount = 1;
+	for (size_t i = 1; i < vecLonLat.size(); i++)
+	{
+		double dAngle = ArcAngle(ToUnit(vecLonLat[i - 1]), ToUnit(vecLonLat[i]));
+		nCount += std::max(1u, (unsigned int)ceil(dAngle * s_dMeanRadius / dStep));
+	}
+
+	return nCount;
+}
+
+unsigned int RouteBatchNode::SelectLevel(const osg::Vec3d& eye) const
+{
+	double dLat, dLon, dHeight;
+	m_pEllipsoid->convertXYZToLatLongHeight(eye.x(), eye.y(), eye.z(), dLat, dLon, dHeight);
+
+	unsigned int nLevel = 0;
+	while (nLevel < NUM_LEVELS - 1 && dHeight > s_levels[nLevel].dMaxAltitude)
+		nLevel++;
+
+	return nLevel;
+}
@@ -0,0 +1,96 @@
+#ifndef ROUTEBATCHNODE_H
+#define ROUTEBATCHNODE_H
+
+#include <osg/Group>
+#include <osg/Geometry>
+#include <osg/MatrixTransform>
+#include <osg/EllipsoidModel>
+
+#include <map>
+#include <vector>
+
+/**
+* Draws a route network as a handful of merged vertex buffers instead of one
+* drawable per feature.
+*
+* Lines are packed into batches of at most MAX_BATCH_VERTICES vertices, each
+* batch holding one geometry per level of detail. Segments follow the great
+* circle between waypoints, densified more finely on the near levels, and the
+* far levels are Douglas-Peucker simplified so that continent-scale views only
+* draw a fraction of the vertices. The level is chosen during the cull
+* traversal from the eye altitude.
+*/
+class RouteBatchNode : public osg::Group
+{
+public:
+
+	enum { NUM_LEVELS = 3 };
+	enum { MAX_BATCH_VERTICES = 65536 };
+
+	RouteBatchNode(const osg::EllipsoidModel* pEllipsoid, double dAltitude = 1000.0);
+
+	//add a route given as (lon, lat) degrees; the scene changes on the next Update()
+	unsigned int AddLine(const std::vector<osg::Vec2d>& vecLonLat);
+
+	void RemoveLine(unsigned int nLineId);
+
+	void Clear();
+
+	//rebuild the batches touched since the last call
+	void Update();
+
+	void SetColor(const osg::Vec4& color);
+
+	void SetLineWidth(float fWidth);
+
+	unsigned int GetNumLines() const { return m_mapLines.size(); }
+
+	unsigned int GetNumVertices(unsigned int nLevel) const;
+
+	virtual void traverse(osg::NodeVisitor& nv) override;
+
+protected:
+
+	virtual ~RouteBatchNode();
+
+private:
+
+	struct Line
+	{
+		std::vector<osg::Vec2d> vecLonLat;
+		unsigned int nBatch;
+		unsigned int nVertices;
+	};
+
+	struct Batch
+	{
+		Batch() : nVertices(0), bDirty(true) {}
+
+		std::vector<unsigned int> vecLines;
+		unsigned int nVertices;
+		bool bDirty;
+		osg::ref_ptr<osg::MatrixTransform> pLevels[NUM_LEVELS];
+	};
+
+	void BuildBatch(Batch& batch);
+
+	osg::Geometry* BuildLevel(const Batch& batch, unsigned int nLevel, const osg::Vec3d& origin);
+
+	void AppendGreatCircle(const osg::Vec2d& from, const osg::Vec2d& to, double dStep, bool bFirst, std::vector<osg::Vec3d>& vecWorld) const;
+
+	unsigned int CountVertices(const std::vector<osg::Vec2d>& vecLonLat, double dStep) const;
+
+	unsigned int SelectLevel(const osg::Vec3d& eye) const;
+
+	osg::ref_ptr<const osg::EllipsoidModel> m_pEllipsoid;
+	double m_dAltitude;
+
+	std::map<unsigned int, Line> m_mapLines;
+	std::vector<Batch> m_vecBatches;
+	unsigned int m_nNextLineId;
+
+	osg::ref_ptr<osg::Group> m_pLevelGroups[NUM_LEVELS];
+	osg::ref_ptr<osg::Vec4Array> m_pColors;
+};
+
+#endif // ROUTEBATCHNODE_H
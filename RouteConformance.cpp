@@ -0,0 +1,278 @@
+#include "RouteConformance.h"
+#include <osg/Math>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+	const double s_dMeanRadius = 6371000.0;
+
+	osg::Vec3d ToUnit(double dLon, double dLat)
+	{
+		dLon = osg::DegreesToRadians(dLon);
+		dLat = osg::DegreesToRadians(dLat);
+		return osg::Vec3d(cos(dLat) * cos(dLon), cos(dLat) * sin(dLon), sin(dLat));
+	}
+
+	double ArcAngle(const osg::Vec3d& a, const osg::Vec3d& b)
+	{
+		return atan2((a ^ b).length(), a * b);
+	}
+}
+
+RouteConformance::RouteConformance(double dTolerance, double dCellSize)
+	: m_dTolerance(dTolerance), m_dCellSize(dCellSize)
+{
+
+}
+
+void RouteConformance::SetTolerance(double dTolerance)
+{
+	m_dTolerance = dTolerance;
+
+	m_mapGrid.clear();
+	for (std::map<unsigned int, std::vector<Segment> >::iterator itr = m_mapLines.begin(); itr != m_mapLines.end(); itr++)
+	{
+		IndexLine(itr->first, itr->second);
+	}
+}
+
+void RouteConformance::AddLine(unsigned int nLineId, const std::vector<osg::Vec2d>& vecLonLat)
+{
+	RemoveLine(nLineId);
+
+	std::vector<Segment>& vecSegments = m_mapLines[nLineId];
+
+	double dStart = 0.0;
+	for (size_t i = 1; i < vecLonLat.size(); i++)
+	{
+		Segment segment;
+		segment.a = ToUnit(vecLonLat[i - 1].x(), vecLonLat[i - 1].y());
+		segment.b = ToUnit(vecLonLat[i].x(), vecLonLat[i].y());
+		segment.dLength = ArcAngle(segment.a, segment.b);
+		segment.dStart = dStart;
+
+		segment.normal = segment.a ^ segment.b;
+		if (segment.normal.normalize() == 0.0)
+		{
+			//repeated waypoint, any plane through it will do
+			segment.normal = segment.a ^ osg::Vec3d(0.0, 0.0, 1.0);
+			if (segment.normal.normalize() == 0.0)
+				segment.normal.set(1.0, 0.0, 0.0);
+		}
+
+		vecSegments.push_back(segment);
+		dStart += segment.dLength;
+	}
+
+	IndexLine(nLineId, vecSegments);
+}
+
+void RouteConformance::RemoveLine(unsigned int nLineId)
+{
+	std::map<unsigned int, std::vector<Segment> >::iterator itr = m_mapLines.find(nLineId);
+	if (itr == m_mapLines.end())
+		return;
+
+	for (size_t i = 0; i < itr->second.size(); i++)
+	{
+		const std::vector<unsigned int>& vecCells = itr->second[i].vecCells;
+		for (size_t j = 0; j < vecCells.size(); j++)
+		{
+			std::vector<SegmentRef>& vecRefs = m_mapGrid[vecCells[j]];
+			for (size_t k = 0; k < vecRefs.size(); k++)
+			{
+				if (vecRefs[k].nLineId == nLineId)
+				{
+					vecRefs[k] = vecRefs.back();
+					vecRefs.pop_back();
+					k--;
+				}
+			}
+
+			if (vecRefs.empty())
+				m_mapGrid.erase(vecCells[j]);
+		}
+	}
+
+	m_mapLines.erase(itr);
+}
+
+void RouteConformance::Clear()
+{
+	m_mapLines.clear();
+	m_mapGrid.clear();
+	m_mapAlerts.clear();
+}
+
+void RouteConformance::IndexLine(unsigned int nLineId, std::vector<Segment>& vecSegments)
+{
+	double dToleranceDeg = osg::RadiansToDegrees(m_dTolerance / s_dMeanRadius);
+
+	//sample the great circle finely enough that no cell between two samples is missed
+	double dStep = osg::DegreesToRadians(m_dCellSize) * 0.5;
+
+	for (size_t i = 0; i < vecSegments.size(); i++)
+	{
+		Segment& segment = vecSegments[i];
+		segment.vecCells.clear();
+
+		unsigned int nSamples = std::max(1u, (unsigned int)ceil(segment.dLength / dStep));
+		double dSin = sin(segment.dLength);
+
+		for (unsigned int n = 0; n <= nSamples; n++)
+		{
+			double t = (double)n / nSamples;
+
+			osg::Vec3d p;
+			if (dSin < 1e-12)
+				p = segment.a;
+			else
+				p = segment.a * (sin((1.0 - t) * segment.dLength) / dSin) + segment.b * (sin(t * segment.dLength) / dSin);
+
+			double dLat = osg::RadiansToDegrees(atan2(p.z(), sqrt(p.x() * p.x() + p.y() * p.y())));
+			double dLon = osg::RadiansToDegrees(atan2(p.y(), p.x()));
+
+			//tolerance box around the sample, wider in longitude away from the equator
+			double dHalfLat = dToleranceDeg + m_dCellSize * 0.5;
+			double dCos = std::max(cos(osg::DegreesToRadians(std::min(89.0, fabs(dLat) + dHalfLat))), 1e-3);
+			double dHalfLon = std::min(180.0, dHalfLat / dCos);
+
+			int nRow0 = (int)floor((dLat - dHalfLat + 90.0) / m_dCellSize);
+			int nRow1 = (int)floor((dLat + dHalfLat + 90.0) / m_dCellSize);
+			int nCol0 = (int)floor((dLon - dHalfLon + 180.0) / m_dCellSize);
+			int nCol1 = (int)floor((dLon + dHalfLon + 180.0) / m_dCellSize);
+
+			for (int nRow = nRow0; nRow <= nRow1; nRow++)
+			{
+				for (int nCol = nCol0; nCol <= nCol1; nCol++)
+				{
+					segment.vecCells.push_back(CellKey(nRow, nCol));
+				}
+			}
+		}
+
+		std::sort(segment.vecCells.begin(), segment.vecCells.end());
+		segment.vecCells.erase(std::unique(segment.vecCells.begin(), segment.vecCells.end()), segment.vecCells.end());
+
+		SegmentRef ref = { nLineId, (unsigned int)i };
+		for (size_t j = 0; j < segment.vecCells.size(); j++)
+		{
+			m_mapGrid[segment.vecCells[j]].push_back(ref);
+		}
+	}
+}
+
+unsigned int RouteConformance::CellKey(int nRow, int nCol) const
+{
+	int nRows = (int)ceil(180.0 / m_dCellSize);
+	int nCols = (int)ceil(360.0 / m_dCellSize);
+
+	nRow = osg::clampBetween(nRow, 0, nRows - 1);
+	nCol = ((nCol % nCols) + nCols) % nCols;
+
+	return (unsigned int)nRow * nCols + nCol;
+}
+
+void RouteConformance::TestSegment(const osg::Vec3d& p, unsigned int nLineId, unsigned int nSegment, double& dBest, Result& result) const
+{
+	const Segment& segment = m_mapLines.find(nLineId)->second[nSegment];
+
+	//cross track from the great circle, along track from the projection onto it
+	double dSinXt = osg::clampBetween(p * segment.normal, -1.0, 1.0);
+	double dXt = asin(dSinXt);
+	osg::Vec3d projected = p - segment.normal * dSinXt;
+	double dAlong = atan2((segment.a ^ projected) * segment.normal, segment.a * projected);
+
+	double dDistance;
+	if (dAlong < 0.0)
+		dDistance = ArcAngle(p, segment.a);
+	else if (dAlong > segment.dLength)
+		dDistance = ArcAngle(p, segment.b);
+	else
+		dDistance = fabs(dXt);
+
+	if (dDistance >= dBest)
+		return;
+
+	dBest = dDistance;
+	result.nLineId = nLineId;
+	result.nSegment = nSegment;
+
+	//the normal is a x b, so points right of the direction of flight have a negative dot product
+	result.dCrossTrack = -dXt * s_dMeanRadius;
+	result.dAlongTrack = (segment.dStart + osg::clampBetween(dAlong, 0.0, segment.dLength)) * s_dMeanRadius;
+}
+
+RouteConformance::Result RouteConformance::Check(double dLon, double dLat) const
+{
+	Result result = { false, 0, 0, 0.0, 0.0 };
+	if (m_mapLines.empty())
+		return result;
+
+	int nRow = (int)floor((dLat + 90.0) / m_dCellSize);
+	int nCol = (int)floor((dLon + 180.0) / m_dCellSize);
+
+	osg::Vec3d p = ToUnit(dLon, dLat);
+	double dTolerance = m_dTolerance / s_dMeanRadius;
+	double dBest = DBL_MAX;
+
+	//segments within tolerance are all listed in the position's own cell, and a segment is
+	//listed in the cell of each of its points, so after ring r every segment closer than
+	//r cells has been seen; stop once the best one is within either distance
+	for (int nRing = 0; nRing <= MAX_RINGS; nRing++)
+	{
+		for (int nRowCell = nRow - nRing; nRowCell <= nRow + nRing; nRowCell++)
+		{
+			bool bEdgeRow = nRowCell == nRow - nRing || nRowCell == nRow + nRing;
+			for (int nColCell = nCol - nRing; nColCell <= nCol + nRing; nColCell += (bEdgeRow || nRing == 0) ? 1 : 2 * nRing)
+			{
+				std::unordered_map<unsigned int, std::vector<SegmentRef> >::const_iterator itrCell = m_mapGrid.find(CellKey(nRowCell, nColCell));
+				if (itrCell == m_mapGrid.end())
+					continue;
+
+				const std::vector<SegmentRef>& vecRefs = itrCell->second;
+				for (size_t i = 0; i < vecRefs.size(); i++)
+					TestSegment(p, vecRefs[i].nLineId, vecRefs[i].nSegment, dBest, result);
+			}
+		}
+
+		double dCos = cos(osg::DegreesToRadians(std::min(89.0, fabs(dLat) + (nRing + 1) * m_dCellSize)));
+		if (dBest <= std::max(dTolerance, osg::DegreesToRadians(nRing * m_dCellSize) * dCos))
+		{
+			result.bOnRoute = dBest <= dTolerance;
+			return result;
+		}
+	}
+
+	//far from every route: test all segments
+	for (std::map<unsigned int, std::vector<Segment> >::const_iterator itr = m_mapLines.begin(); itr != m_mapLines.end(); itr++)
+	{
+		for (size_t i = 0; i < itr->second.size(); i++)
+			TestSegment(p, itr->first, (unsigned int)i, dBest, result);
+	}
+
+	result.bOnRoute = dBest <= dTolerance;
+	return result;
+}
+
+bool RouteConformance::Update(unsigned int nTrackId, double dLon, double dLat, Result& result)
+{
+	result = Check(dLon, dLat);
+
+	bool bAlert = !m_mapLines.empty() && !result.bOnRoute;
+	bool& bState = m_mapAlerts[nTrackId];
+	if (bState == bAlert)
+		return false;
+
+	bState = bAlert;
+	return true;
+}
+
+bool RouteConformance::IsAlert(unsigned int nTrackId) const
+{
+	std::unordered_map<unsigned int, bool>::const_iterator itr = m_mapAlerts.find(nTrackId);
+	return itr != m_mapAlerts.end() && itr->second;
+}
@@ -0,0 +1,94 @@
+#ifndef ROUTECONFORMANCE_H
+#define ROUTECONFORMANCE_H
+
+#include <osg/Vec2d>
+#include <osg/Vec3d>
+
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+/**
+* Compares track positions against the planned route lines.
+*
+* All route segments are registered in a geodesic grid of fixed lon/lat
+* cells. A segment is listed in every cell that lies within the tolerance of
+* its great circle, so a position within tolerance only has to be tested
+* against the segments of its own cell: the lookup is a hash probe plus a
+* handful of segments whatever the size of the route set. Off route, the
+* rings of cells around it are searched outward until no unvisited cell can
+* hold a closer segment, and after MAX_RINGS rings every segment is tested.
+*/
+class RouteConformance
+{
+public:
+
+	//the nearest line is reported whether or not it is within tolerance; all zero without lines
+	struct Result
+	{
+		bool bOnRoute;			//within tolerance of the closest segment
+		unsigned int nLineId;	//closest line
+		unsigned int nSegment;	//closest segment of that line
+		double dCrossTrack;		//signed distance from the great circle in meters, right of track positive
+		double dAlongTrack;		//distance flown along the line from its first waypoint in meters
+	};
+
+	enum { MAX_RINGS = 4 };
+
+	RouteConformance(double dTolerance = 5000.0, double dCellSize = 0.5);
+
+	//dTolerance in meters; re-indexes every line
+	void SetTolerance(double dTolerance);
+
+	double GetTolerance() const { return m_dTolerance; }
+
+	void AddLine(unsigned int nLineId, const std::vector<osg::Vec2d>& vecLonLat);
+
+	void RemoveLine(unsigned int nLineId);
+
+	void Clear();
+
+	bool IsEmpty() const { return m_mapLines.empty(); }
+
+	//check a (lon, lat) position in degrees
+	Result Check(double dLon, double dLat) const;
+
+	//Check() plus the per track alert state; returns true when the alert state of nTrackId changed
+	bool Update(unsigned int nTrackId, double dLon, double dLat, Result& result);
+
+	bool IsAlert(unsigned int nTrackId) const;
+
+private:
+
+	struct Segment
+	{
+		osg::Vec3d a;			//unit vectors of the end points
+		osg::Vec3d b;
+		osg::Vec3d normal;		//unit normal of the great circle plane
+		double dLength;			//arc angle in radians
+		double dStart;			//arc angle from the first waypoint to a
+		std::vector<unsigned int> vecCells;
+	};
+
+	struct SegmentRef
+	{
+		unsigned int nLineId;
+		unsigned int nSegment;
+	};
+
+	void IndexLine(unsigned int nLineId, std::vector<Segment>& vecSegments);
+
+	unsigned int CellKey(int nRow, int nCol) const;
+
+	//tests p against one segment, keeping it in result if closer than dBest (radians)
+	void TestSegment(const osg::Vec3d& p, unsigned int nLineId, unsigned int nSegment, double& dBest, Result& result) const;
+
+	double m_dTolerance;
+	double m_dCellSize;
+
+	std::map<unsigned int, std::vector<Segment> > m_mapLines;
+	std::unordered_map<unsigned int, std::vector<SegmentRef> > m_mapGrid;
+	std::unordered_map<unsigned int, bool> m_mapAlerts;
+};
+
+#endif // ROUTECONFORMANCE_H
@@ -1,20 +1,37 @@
 #include "ScaleBarRefresh.h"
 #include "osgViewer/Viewer"
-#include <osgEarthSymbology/Geometry>
 #include <osgEarth/MapNode>
-#include <QtCore/QtMath>
+#include <osgEarth/GeoMath>
 #include "osgText/Text"
+#include "Trace.h"
 
-extern osgViewer::Viewer* g_viewerMain;
 extern osgEarth::MapNode* g_MapNode;
 extern osg::Geometry* g_GeoScaleLine;
 extern osgText::Text* g_pText;
 
+//ݷֱʼһʵıֵ,ܹ19
+static const int s_pScale[] = { 1, 20, 50, 100, 200, 500, 1000, 2000,
+	5000, 10000, 20000, 25000, 50000, 100000, 200000, 500000, 1000000,
+	2000000, 5000000 };
+
+static const char* s_pScaleText[] = { "1 m", "20 m", "50 m", "100 m", "200 m", "500 m", "1 km", "2 km",
+	"5 km", "10 km", "20 km", "25 km", "50 km", "100 km", "200 km", "500 km", "1000 km",
+	"2000 km", "5000 km" };
+
+static const int s_nScaleCount = sizeof(s_pScale) / sizeof(s_pScale[0]);
+
+//Ļߵļ
+static const double s_dProbePixels = 100.0;
+
 ScaleBarRefresh::ScaleBarRefresh(QObject *parent)
 	: QObject(parent)
+	, m_nViewportWidth(0)
+	, m_nViewportHeight(0)
+	, m_bValid(false)
+	, m_nScaleIndex(-1)
+	, m_nDeviceWidth(-1)
 {
-	QObject::connect(&m_timerRefreshScaleBar, SIGNAL(timeout()), this, SLOT(RefreshScaleBar()));
-	m_timerRefreshScaleBar.start(500);
+
 }
 
 ScaleBarRefresh::~ScaleBarRefresh()
@@ -22,72 +39,118 @@ ScaleBarRefresh::~ScaleBarRefresh()
 
 }
 
-void ScaleBarRefresh::RefreshScaleBar()
+void ScaleBarRefresh::Update(const osg::Matrixd& matView, const osg::Camera* pCamera)
 {
-	m_timerRefreshScaleBar.stop();
+	if (!pCamera || !pCamera->getViewport() || !g_GeoScaleLine || !g_MapNode)
+		return;
 
-	osg::Vec3d world;
-	osgEarth::GeoPoint mapPoint;
+	const osg::Viewport* pViewport = pCamera->getViewport();
+	int nWidth = (int)pViewport->width();
+	int nHeight = (int)pViewport->height();
 
-	std::vector<osgViewer::View*> vecViews;
-	g_viewerMain->getViews(vecViews);
-	osgViewer::View* pView = vecViews[0];
+	if (m_bValid && matView == m_matView && pCamera->getProjectionMatrix() == m_matProjection
+		&& nWidth == m_nViewportWidth && nHeight == m_nViewportHeight)
+		return;
 
-	osg::Vec3d vec3d1;
-	osg::Vec3d vec3d2;
+	m_matView = matView;
+	m_matProjection = pCamera->getProjectionMatrix();
+	m_nViewportWidth = nWidth;
+	m_nViewportHeight = nHeight;
+	m_bValid = true;
 
-	bool b1 = false;
-	bool b2 = false;
+	RefreshScaleBar(matView, pCamera);
+}
 
-	if (g_MapNode->getTerrain()->getWorldCoordsUnderMouse(pView->asView(), 0.0, 0.0, world))
-	{
-		mapPoint.fromWorld(g_MapNode->getMapSRS(), world);
-		vec3d1 = mapPoint.vec3d();
-		b1 = true;
-	}
+bool ScaleBarRefresh::IntersectEllipsoid(const osg::Vec3d& start, const osg::Vec3d& end, osg::Vec3d& hit) const
+{
+	const osg::EllipsoidModel* pEllipsoid = g_MapNode->getMapSRS()->getEllipsoid();
+
+	//ŵλ
+	osg::Vec3d scale(1.0 / pEllipsoid->getRadiusEquator(), 1.0 / pEllipsoid->getRadiusEquator(), 1.0 / pEllipsoid->getRadiusPolar());
+	osg::Vec3d p(start.x() * scale.x(), start.y() * scale.y(), start.z() * scale.z());
+	osg::Vec3d d((end.x() - start.x()) * scale.x(), (end.y() - start.y()) * scale.y(), (end.z() - start.z()) * scale.z());
+
+	double a = d * d;
+	double b = 2.0 * (p * d);
+	double c = p * p - 1.0;
+	double dDisc = b * b - 4.0 * a * c;
+	if (a <= 0.0 || dDisc < 0.0)
+		return false;
+
+	double t = (-b - sqrt(dDisc)) / (2.0 * a);
+	if (t < 0.0 || t > 1.0)
+		return false;
+
+	hit = start + (end - start) * t;
+	return true;
+}
+
+bool ScaleBarRefresh::ComputeResolution(const osg::Matrixd& matView, const osg::Camera* pCamera, double& dRes) const
+{
+	const osg::Viewport* pViewport = pCamera->getViewport();
+
+	osg::Matrixd matInverse;
+	if (!matInverse.invert(matView * pCamera->getProjectionMatrix() * pViewport->computeWindowMatrix()))
+		return false;
+
+	double cx = pViewport->x() + pViewport->width() * 0.5;
+	double cy = pViewport->y() + pViewport->height() * 0.5;
+
+	osg::Vec3d center;
+	if (!IntersectEllipsoid(osg::Vec3d(cx, cy, 0.0) * matInverse, osg::Vec3d(cx, cy, 1.0) * matInverse, center))
+		return false;
 
-	if (g_MapNode->getTerrain()->getWorldCoordsUnderMouse(pView->asView(), 10.0, 0.0, world))
+	//Ҳ̽ڵʱ
+	osg::Vec3d side;
+	double dx = s_dProbePixels;
+	if (!IntersectEllipsoid(osg::Vec3d(cx + dx, cy, 0.0) * matInverse, osg::Vec3d(cx + dx, cy, 1.0) * matInverse, side))
 	{
-		mapPoint.fromWorld(g_MapNode->getMapSRS(), world);
-		vec3d2 = mapPoint.vec3d();
-		b2 = true;
+		dx = -dx;
+		if (!IntersectEllipsoid(osg::Vec3d(cx + dx, cy, 0.0) * matInverse, osg::Vec3d(cx + dx, cy, 1.0) * matInverse, side))
+			return false;
 	}
 
-	if (b1 == false || b2 == false)
-		return;
+	const osg::EllipsoidModel* pEllipsoid = g_MapNode->getMapSRS()->getEllipsoid();
 
-	double dRes = qSqrt((vec3d1.x() - vec3d2.x()) * (vec3d1.x() - vec3d2.x()) + (vec3d1.y() - vec3d2.y()) * (vec3d1.y() - vec3d2.y()));
-	dRes /= 10.0;
+	double dLat1, dLon1, dLat2, dLon2, dHeight;
+	pEllipsoid->convertXYZToLatLongHeight(center.x(), center.y(), center.z(), dLat1, dLon1, dHeight);
+	pEllipsoid->convertXYZToLatLongHeight(side.x(), side.y(), side.z(), dLat2, dLon2, dHeight);
 
-	//ݷֱʼһʵıֵ,ܹ19
-	int pScale[] = { 1, 20, 50, 100, 200, 500, 1000, 2000,
-		5000, 10000, 20000, 25000, 50000, 100000, 200000, 500000, 1000000,
-		2000000, 5000000 }; 
+	dRes = osgEarth::GeoMath::distance(dLat1, dLon1, dLat2, dLon2, pEllipsoid->getRadiusEquator()) / s_dProbePixels;
+	return dRes > 0.0;
+}
 
-	char* pScaleText[] = { "1 m", "20 m", "50 m", "100 m", "200 m", "500 m", "1 km", "2 km",
-		"5 km", "10 km", "20 km", "25 km", "50 km", "100 km", "200 km", "500 km", "1000 km",
-		"2000 km", "5000 km" };
+void ScaleBarRefresh::RefreshScaleBar(const osg::Matrixd& matView, const osg::Camera* pCamera)
+{
+	RM_TRACE_ZONE("RefreshScaleBar");
 
-	//200صĿΪ׼м
+	double dRes = 0.0;
+	if (!ComputeResolution(matView, pCamera, dRes))
+	{
+		//ĻĲڵʱر
+		g_GeoScaleLine->setNodeMask(0);
+		g_pText->setNodeMask(0);
+		m_nDeviceWidth = -1;
+		return;
+	}
+
+	g_GeoScaleLine->setNodeMask(~0u);
+	g_pText->setNodeMask(~0u);
+
+	//400صĿΪ׼,ȡóȵ󼶱
 	int nDefaultWidth = 400;
 
 	double dTempValue = nDefaultWidth * dRes;
 	int nIndex = 0;
-	for (int i = 1; i < 19; i ++)
+	for (int i = 0; i < s_nScaleCount; i ++)
 	{
-		if (dTempValue > pScale[i - 1] && dTempValue < pScale[i])
-		{
-			nIndex = i - 1;
-		}
+		if (s_pScale[i] <= dTempValue)
+			nIndex = i;
 	}
 
-	if (dTempValue >= 5000000 && nIndex == 0)
-	{
-		nIndex = 18;
-	}
-
-	int nFinalGeoWidth = pScale[nIndex];
-	int nDeviceWidth = nFinalGeoWidth / dRes;
+	int nDeviceWidth = (int)(s_pScale[nIndex] / dRes);
+	if (nDeviceWidth == m_nDeviceWidth && nIndex == m_nScaleIndex)
+		return;
 
 	double dx = 100.0;
 	double dy = 50.0;
@@ -95,23 +158,25 @@ void ScaleBarRefresh::RefreshScaleBar()
 	double dHeight = 10.0;
 	double dWidth = nDeviceWidth / 2.0;
 
-	osg::Vec3dArray* vertices = new osg::Vec3dArray();
-
-	vertices->push_back(osg::Vec3d(dx, dy + dHeight, 0.0));
-	vertices->push_back(osg::Vec3d(dx, dy, 0.0));
-	vertices->push_back(osg::Vec3d(dx + dWidth, dy, 0.0));
-	vertices->push_back(osg::Vec3d(dx + dWidth, dy + dHeight, 0.0));
-	vertices->push_back(osg::Vec3d(dx + dWidth, dy, 0.0));
-	vertices->push_back(osg::Vec3d(dx + dWidth * 2.0, dy, 0.0));
-	vertices->push_back(osg::Vec3d(dx + dWidth * 2.0, dy + dHeight, 0.0));
-
-	g_GeoScaleLine->setVertexArray(vertices);
+	//ԭ޸Ķ,ÿη
+	osg::Vec3dArray* vertices = dynamic_cast<osg::Vec3dArray*>(g_GeoScaleLine->getVertexArray());
+	if (!vertices || vertices->size() != 7)
+		return;
 
-	g_pText->setText(pScaleText[nIndex]);
+	(*vertices)[0].set(dx, dy + dHeight, 0.0);
+	(*vertices)[1].set(dx, dy, 0.0);
+	(*vertices)[2].set(dx + dWidth, dy, 0.0);
+	(*vertices)[3].set(dx + dWidth, dy + dHeight, 0.0);
+	(*vertices)[4].set(dx + dWidth, dy, 0.0);
+	(*vertices)[5].set(dx + dWidth * 2.0, dy, 0.0);
+	(*vertices)[6].set(dx + dWidth * 2.0, dy + dHeight, 0.0);
+	vertices->dirty();
+	g_GeoScaleLine->dirtyBound();
+
+	if (nIndex != m_nScaleIndex)
+		g_pText->setText(s_pScaleText[nIndex]);
 	g_pText->setPosition(osg::Vec3d(dx + dWidth * 2.0 - 15, dy + dHeight + 8, 0.0));
-}
 
-void ScaleBarRefresh::Start()
-{
-	m_timerRefreshScaleBar.start(500);
+	m_nScaleIndex = nIndex;
+	m_nDeviceWidth = nDeviceWidth;
 }
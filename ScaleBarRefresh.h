@@ -2,8 +2,18 @@
 #define SCALEBARREFRESH_H
 
 #include <QObject>
-#include <QtCore/QTimer>
-
+#include <osg/Camera>
+#include <osg/EllipsoidModel>
+
+/**
+* Keeps the HUD scale bar in step with the camera.
+*
+* The ground resolution is computed analytically: two rays through the
+* screen center are intersected with the ellipsoid and the geodesic distance
+* between the hits gives the meters per pixel. Nothing is done unless the
+* view matrix, the projection matrix or the viewport changed since the last
+* call, so idle frames cost a few matrix compares.
+*/
 class ScaleBarRefresh : public QObject
 {
 	Q_OBJECT
@@ -12,17 +22,26 @@ public:
 	ScaleBarRefresh(QObject *parent = nullptr);
 	~ScaleBarRefresh();
 
-public slots:
+	//called every frame with the view matrix the manipulator is about to apply
+	void Update(const osg::Matrixd& matView, const osg::Camera* pCamera);
 
-	void RefreshScaleBar();
+private:
 
-public:
+	void RefreshScaleBar(const osg::Matrixd& matView, const osg::Camera* pCamera);
 
-	void Start();
+	//meters per pixel at the screen center, false if the center misses the globe
+	bool ComputeResolution(const osg::Matrixd& matView, const osg::Camera* pCamera, double& dRes) const;
 
-private:
-	
-	QTimer m_timerRefreshScaleBar;
+	bool IntersectEllipsoid(const osg::Vec3d& start, const osg::Vec3d& end, osg::Vec3d& hit) const;
+
+	osg::Matrixd m_matView;
+	osg::Matrixd m_matProjection;
+	int m_nViewportWidth;
+	int m_nViewportHeight;
+	bool m_bValid;
+
+	int m_nScaleIndex;
+	int m_nDeviceWidth;
 };
 
 #endif // SCALEBARREFRESH_H
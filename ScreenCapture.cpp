@@ -1,6 +1,7 @@
 #include "ScreenCapture.h"
 
 #include <osgDB/WriteFile>
+#include "Trace.h"
 
 #include <QtCore/QString>
 #include <QtCore/QFileInfo>
@@ -77,6 +78,8 @@ bool CScreenCapture::handle( const osgGA::GUIEventAdapter& ea, osgGA::GUIActionA
 
 void CScreenCapture::WriteToImageFile::operator()( const osg::Image& image, const unsigned int context_id )//ºʵͼƬ
 {
+	RM_TRACE_ZONE("capture write");
+
 	if (!_filename.empty())
 	{
 		bool bTag = image.isDataContiguous();
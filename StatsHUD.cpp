@@ -0,0 +1,212 @@
+#include "StatsHUD.h"
+#include "UDPServer.h"
+#include <osg/LineWidth>
+
+#include <stdio.h>
+
+//HUDΪ1024x1024ͶӰ
+static const float s_fLeft = 10.0f;
+static const float s_fTop = 1010.0f;
+static const float s_fGraphBottom = 620.0f;
+static const float s_fGraphHeight = 100.0f;
+static const float s_fGraphWidth = 256.0f;
+
+//̶Ӧ֡ʱ(ms)
+static const float s_fGraphRange = 50.0f;
+
+namespace
+{
+	class StatsUpdateCallback : public osg::NodeCallback
+	{
+	public:
+
+		virtual void operator()(osg::Node* node, osg::NodeVisitor* nv)
+		{
+			if (nv->getFrameStamp())
+				static_cast<StatsHUD*>(node)->Refresh(nv->getFrameStamp()->getReferenceTime());
+
+			traverse(node, nv);
+		}
+	};
+}
+
+StatsHUD::StatsHUD(osgViewer::Viewer* pViewer, double dInterval)
+	: m_pViewer(pViewer)
+	, m_dInterval(dInterval)
+	, m_dLastTime(-1.0)
+	, m_bEnabled(false)
+	, m_vecHistory(HISTORY_SIZE, 0.0f)
+	, m_nHistoryPos(0)
+{
+	osg::StateSet* stateset = getOrCreateStateSet();
+	stateset->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
+	stateset->setMode(GL_DEPTH_TEST, osg::StateAttribute::OFF);
+	setName("stats");
+
+	m_pText = new osgText::Text;
+	m_pText->setFont("fonts/times.ttf");
+	m_pText->setCharacterSize(18.0f);
+	m_pText->setColor(osg::Vec4(1.0f, 1.0f, 0.0f, 1.0f));
+	m_pText->setAlignment(osgText::Text::LEFT_TOP);
+	m_pText->setPosition(osg::Vec3(s_fLeft, s_fTop, 0.0f));
+	m_pText->setDataVariance(osg::Object::DYNAMIC);
+	addDrawable(m_pText.get());
+
+	//ߺ16.7msο߷ͬһ
+	m_pGraphVertices = new osg::Vec3Array(HISTORY_SIZE + 2);
+	osg::ref_ptr<osg::Vec4Array> colors = new osg::Vec4Array(HISTORY_SIZE + 2);
+	for (unsigned int i = 0; i < HISTORY_SIZE; i ++)
+		(*colors)[i].set(0.0f, 1.0f, 0.0f, 1.0f);
+	(*colors)[HISTORY_SIZE].set(0.5f, 0.5f, 0.5f, 1.0f);
+	(*colors)[HISTORY_SIZE + 1].set(0.5f, 0.5f, 0.5f, 1.0f);
+
+	float fY = s_fGraphBottom + s_fGraphHeight * (16.7f / s_fGraphRange);
+	(*m_pGraphVertices)[HISTORY_SIZE].set(s_fLeft, fY, 0.0f);
+	(*m_pGraphVertices)[HISTORY_SIZE + 1].set(s_fLeft + s_fGraphWidth, fY, 0.0f);
+
+	m_pGraph = new osg::Geometry;
+	m_pGraph->setUseDisplayList(false);
+	m_pGraph->setUseVertexBufferObjects(true);
+	m_pGraph->setDataVariance(osg::Object::DYNAMIC);
+	m_pGraph->setVertexArray(m_pGraphVertices.get());
+	m_pGraph->setColorArray(colors.get(), osg::Array::BIND_PER_VERTEX);
+	m_pGraph->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::LINE_STRIP, 0, HISTORY_SIZE));
+	m_pGraph->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::LINES, HISTORY_SIZE, 2));
+	m_pGraph->getOrCreateStateSet()->setAttribute(new osg::LineWidth(1.0f));
+	addDrawable(m_pGraph.get());
+
+	UpdateGraph();
+
+	setUpdateCallback(new StatsUpdateCallback);
+	setNodeMask(0);
+}
+
+StatsHUD::~StatsHUD()
+{
+
+}
+
+void StatsHUD::AddListener(UDPServer* pServer)
+{
+	Listener listener;
+	listener.pServer = pServer;
+	listener.nLastDatagrams = pServer->m_pMetrics->nReceived.load(std::memory_order_relaxed);
+	listener.nLastDropped = pServer->m_pMetrics->nDropped.load(std::memory_order_relaxed);
+	m_vecListeners.push_back(listener);
+}
+
+void StatsHUD::SetEnabled(bool bEnabled)
+{
+	m_bEnabled = bEnabled;
+	setNodeMask(bEnabled ? ~0u : 0u);
+	m_dLastTime = -1.0;
+
+	osg::ref_ptr<osgViewer::Viewer> pViewer;
+	if (!m_pViewer.lock(pViewer))
+		return;
+
+	if (pViewer->getViewerStats())
+		pViewer->getViewerStats()->collectStats("frame_rate", bEnabled);
+
+	osg::Stats* pCameraStats = pViewer->getCamera()->getStats();
+	if (pCameraStats)
+	{
+		pCameraStats->collectStats("rendering", bEnabled);
+		pCameraStats->collectStats("gpu", bEnabled);
+	}
+}
+
+double StatsHUD::GetAverage(osg::Stats* pStats, const std::string& strName) const
+{
+	double dValue = 0.0;
+	if (!pStats || !pStats->getAveragedAttribute(strName, dValue))
+		return 0.0;
+
+	return dValue;
+}
+
+void StatsHUD::Refresh(double dTime)
+{
+	//Ƶ,֡ʲôҲ
+	if (!m_bEnabled || (m_dLastTime >= 0.0 && dTime - m_dLastTime < m_dInterval))
+		return;
+
+	double dElapsed = m_dLastTime >= 0.0 ? dTime - m_dLastTime : 0.0;
+	m_dLastTime = dTime;
+
+	osg::ref_ptr<osgViewer::Viewer> pViewer;
+	if (!m_pViewer.lock(pViewer))
+		return;
+
+	osg::Stats* pCameraStats = pViewer->getCamera()->getStats();
+	double dFrame = GetAverage(pViewer->getViewerStats(), "Frame duration") * 1000.0;
+	double dCull = GetAverage(pCameraStats, "Cull traversal time taken") * 1000.0;
+	double dDraw = GetAverage(pCameraStats, "Draw traversal time taken") * 1000.0;
+	double dGPU = GetAverage(pCameraStats, "GPU draw time taken") * 1000.0;
+
+	std::string strText;
+	char szLine[256];
+
+	sprintf(szLine, "frame %.2f ms  cull %.2f ms  draw %.2f ms  gpu %.2f ms\n", dFrame, dCull, dDraw, dGPU);
+	strText += szLine;
+
+	osgDB::DatabasePager* pPager = pViewer->getDatabasePager();
+	if (pPager)
+	{
+		sprintf(szLine, "pager  requests %u  compile %u  merge %u\n",
+			pPager->getFileRequestListSize(), pPager->getDataToCompileListSize(), pPager->getDataToMergeListSize());
+		strText += szLine;
+	}
+
+	unsigned int nTracks = 0;
+	unsigned int nTrailVertices = 0;
+	for (unsigned int i = 0; i < m_vecListeners.size(); i ++)
+	{
+		Listener& listener = m_vecListeners[i];
+		const UDPServer* pServer = listener.pServer;
+
+		unsigned long long nDatagrams = pServer->m_pMetrics->nReceived.load(std::memory_order_relaxed);
+		unsigned long long nDropped = pServer->m_pMetrics->nDropped.load(std::memory_order_relaxed);
+
+		double dRate = 0.0;
+		double dDropRate = 0.0;
+		if (dElapsed > 0.0)
+		{
+			dRate = (nDatagrams - listener.nLastDatagrams) / dElapsed;
+			dDropRate = (nDropped - listener.nLastDropped) / dElapsed;
+		}
+		listener.nLastDatagrams = nDatagrams;
+		listener.nLastDropped = nDropped;
+
+		sprintf(szLine, "udp %d  %.0f /s  drops %.0f /s  (%.0f total)\n", pServer->m_nPort, dRate, dDropRate, (double)nDropped);
+		strText += szLine;
+
+		if (pServer->m_pTrail->GetTrail().GetNumPoints() > 0)
+		{
+			nTracks ++;
+			nTrailVertices += pServer->m_pTrail->GetTrail().GetNumPoints();
+		}
+	}
+
+	sprintf(szLine, "tracks %u  trail vertices %u", nTracks, nTrailVertices);
+	strText += szLine;
+
+	m_pText->setText(strText);
+
+	m_vecHistory[m_nHistoryPos] = (float)dFrame;
+	m_nHistoryPos = (m_nHistoryPos + 1) % HISTORY_SIZE;
+	UpdateGraph();
+}
+
+void StatsHUD::UpdateGraph()
+{
+	float fStep = s_fGraphWidth / (HISTORY_SIZE - 1);
+	for (unsigned int i = 0; i < HISTORY_SIZE; i ++)
+	{
+		float fValue = osg::minimum(m_vecHistory[(m_nHistoryPos + i) % HISTORY_SIZE], s_fGraphRange);
+		(*m_pGraphVertices)[i].set(s_fLeft + fStep * i, s_fGraphBottom + s_fGraphHeight * fValue / s_fGraphRange, 0.0f);
+	}
+
+	m_pGraphVertices->dirty();
+	m_pGraph->dirtyBound();
+}
@@ -0,0 +1,73 @@
+#ifndef STATSHUD_H
+#define STATSHUD_H
+
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osgText/Text>
+#include <osgViewer/Viewer>
+
+#include <vector>
+
+class UDPServer;
+
+/**
+* Performance overlay drawn on the scale bar HUD camera.
+*
+* Shows frame, cull, draw and GPU time, the database pager queues, the
+* ingest and drop rate of every UDP listener, the track count and the trail
+* vertex total. Everything is one text drawable plus one line geometry for
+* the frame time graph, and both are only rewritten every dInterval seconds
+* from the update traversal, so frames in between do not touch them.
+*/
+class StatsHUD : public osg::Geode
+{
+public:
+
+	enum { HISTORY_SIZE = 128 };
+
+	StatsHUD(osgViewer::Viewer* pViewer, double dInterval = 0.25);
+
+	void AddListener(UDPServer* pServer);
+
+	//switching off also stops the viewer from collecting the timings
+	void SetEnabled(bool bEnabled);
+
+	bool IsEnabled() const { return m_bEnabled; }
+
+	//called from the update callback
+	void Refresh(double dTime);
+
+protected:
+
+	virtual ~StatsHUD();
+
+private:
+
+	struct Listener
+	{
+		UDPServer* pServer;
+		unsigned long long nLastDatagrams;
+		unsigned long long nLastDropped;
+	};
+
+	double GetAverage(osg::Stats* pStats, const std::string& strName) const;
+
+	void UpdateGraph();
+
+	osg::observer_ptr<osgViewer::Viewer> m_pViewer;
+	double m_dInterval;
+	double m_dLastTime;
+	bool m_bEnabled;
+
+	std::vector<Listener> m_vecListeners;
+
+	osg::ref_ptr<osgText::Text> m_pText;
+	osg::ref_ptr<osg::Geometry> m_pGraph;
+	osg::ref_ptr<osg::Vec3Array> m_pGraphVertices;
+
+	//frame time history in ms, m_nHistoryPos is the oldest sample
+	std::vector<float> m_vecHistory;
+	unsigned int m_nHistoryPos;
+};
+
+#endif // STATSHUD_H
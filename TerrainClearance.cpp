@@ -0,0 +1,185 @@
+#include "TerrainClearance.h"
+#include "ElevationCache.h"
+#include "WorkerPool.h"
+
+#include <osg/Math>
+
+#include <algorithm>
+#include <math.h>
+
+//ÿγȵ
+static const double s_dMetersPerDegree = 6371000.0 * osg::PI / 180.0;
+
+//ߵĵ(8849)ϵĺ澯
+static const double s_dHighestTerrain = 8900.0;
+
+//ÿηָһ̵߳ĺ
+static const unsigned int s_nTrackGrain = 64;
+
+static bool CompareTime(const TerrainClearance::Warning& a, const TerrainClearance::Warning& b)
+{
+	return a.dTime < b.dTime;
+}
+
+TerrainClearance::TerrainClearance(ElevationCache* pCache, WorkerPool* pPool)
+	: m_pCache(pCache)
+	, m_pPool(pPool)
+	, m_dMargin(152.4)
+	, m_dLookAhead(60.0)
+	, m_dStep(2.0)
+	, m_dMaxAge(30.0)
+	, m_nSamples(31)
+	, m_nMissing(0)
+{
+
+}
+
+void TerrainClearance::SetLookAhead(double dSeconds, double dStep)
+{
+	m_dLookAhead = dSeconds;
+	m_dStep = dStep;
+	m_nSamples = (unsigned int)(dSeconds / dStep) + 1;
+}
+
+unsigned int TerrainClearance::Run(const std::vector<TrackTable::Row>& vecRows, double dNow, std::vector<Warning>& vecWarnings)
+{
+	m_vecTracks.clear();
+	m_nMissing = 0;
+
+	//Ƶͬһʱ,ÿľγȱ仯
+	for (unsigned int i = 0; i < vecRows.size(); i ++)
+	{
+		const TrackTable::Row& row = vecRows[i];
+		if (!(row.nFlags & TrackTable::FLAG_VALID) || (row.nFlags & TrackTable::FLAG_CLAMPED))
+			continue;
+
+		double dAge = dNow - row.dTime;
+		if (dAge > m_dMaxAge || row.dAlt > s_dHighestTerrain + m_dMargin)
+			continue;
+
+		Track track;
+		track.nIndex = i;
+		track.dAlt = row.dAlt;
+		track.dLatRate = row.dVelocity * cos(osg::DegreesToRadians(row.dHeading)) / s_dMetersPerDegree;
+		track.dLat = osg::clampBetween(row.dLat + track.dLatRate * dAge, -90.0, 90.0);
+
+		double dCos = std::max(cos(osg::DegreesToRadians(track.dLat)), 1e-6);
+		track.dLonRate = row.dVelocity * sin(osg::DegreesToRadians(row.dHeading)) / (s_dMetersPerDegree * dCos);
+		track.dLon = row.dLon + track.dLonRate * dAge;
+		m_vecTracks.push_back(track);
+	}
+
+	m_vecLon.resize(m_vecTracks.size() * m_nSamples);
+	m_vecLat.resize(m_vecLon.size());
+	m_vecHeights.resize(m_vecLon.size());
+
+	unsigned int nWorkers = m_pPool ? m_pPool->GetNumWorkers() : 1;
+	m_vecWorkerWarnings.resize(nWorkers);
+	m_vecWorkerMissing.resize(nWorkers);
+	for (unsigned int i = 0; i < nWorkers; i ++)
+	{
+		m_vecWorkerWarnings[i].clear();
+		m_vecWorkerMissing[i].clear();
+	}
+
+	if (m_pPool)
+	{
+		m_pPool->ParallelFor(m_vecTracks.size(), s_nTrackGrain,
+			[this](unsigned int nBegin, unsigned int nEnd, unsigned int nWorker) { ProbeTracks(nBegin, nEnd, nWorker); });
+	}
+	else
+	{
+		ProbeTracks(0, m_vecTracks.size(), 0);
+	}
+
+	vecWarnings.clear();
+	for (unsigned int i = 0; i < nWorkers; i ++)
+		vecWarnings.insert(vecWarnings.end(), m_vecWorkerWarnings[i].begin(), m_vecWorkerWarnings[i].end());
+	std::sort(vecWarnings.begin(), vecWarnings.end(), CompareTime);
+
+	//ȱεķŶ,һʱ
+	for (unsigned int i = 0; i < nWorkers; i ++)
+	{
+		for (size_t j = 0; j < m_vecWorkerMissing[i].size(); j ++)
+		{
+			unsigned int nFirst = m_vecWorkerMissing[i][j] * m_nSamples;
+			for (unsigned int k = nFirst; k < nFirst + m_nSamples; k ++)
+			{
+				if (m_vecHeights[k] != m_vecHeights[k])
+				{
+					m_pCache->Request(m_vecLon[k], m_vecLat[k]);
+					m_nMissing ++;
+				}
+			}
+		}
+	}
+
+	return vecWarnings.size();
+}
+
+void TerrainClearance::ProbeTracks(unsigned int nBegin, unsigned int nEnd, unsigned int nWorker)
+{
+	//ȰһκĲź,һȡ߶
+	for (unsigned int i = nBegin; i < nEnd; i ++)
+	{
+		const Track& track = m_vecTracks[i];
+		double* pLon = &m_vecLon[i * m_nSamples];
+		double* pLat = &m_vecLat[i * m_nSamples];
+		for (unsigned int k = 0; k < m_nSamples; k ++)
+		{
+			double t = k * m_dStep;
+			pLon[k] = track.dLon + track.dLonRate * t;
+			pLat[k] = track.dLat + track.dLatRate * t;
+		}
+
+		for (unsigned int k = 0; k < m_nSamples; k ++)
+		{
+			if (pLon[k] > 180.0)
+				pLon[k] -= 360.0;
+			else if (pLon[k] < -180.0)
+				pLon[k] += 360.0;
+			pLat[k] = osg::clampBetween(pLat[k], -90.0, 90.0);
+		}
+	}
+
+	unsigned int nFirst = nBegin * m_nSamples;
+	unsigned int nCount = (nEnd - nBegin) * m_nSamples;
+	if (nCount > 0)
+		m_pCache->Sample(&m_vecLon[nFirst], &m_vecLat[nFirst], nCount, &m_vecHeights[nFirst]);
+
+	for (unsigned int i = nBegin; i < nEnd; i ++)
+	{
+		const Track& track = m_vecTracks[i];
+		const float* pHeights = &m_vecHeights[i * m_nSamples];
+
+		//NaNκȽ϶false,ȱεĵ㰴ȫ
+		bool bMissing = false;
+		for (unsigned int k = 0; k < m_nSamples; k ++)
+		{
+			if (pHeights[k] != pHeights[k])
+			{
+				bMissing = true;
+				continue;
+			}
+
+			if (track.dAlt - pHeights[k] < m_dMargin)
+			{
+				Warning warning;
+				warning.nIndex = track.nIndex;
+				warning.dTime = k * m_dStep;
+				warning.dAlt = track.dAlt;
+				warning.dTerrain = pHeights[k];
+				warning.dClearance = track.dAlt - pHeights[k];
+				warning.dLon = m_vecLon[i * m_nSamples];
+				warning.dLat = m_vecLat[i * m_nSamples];
+				warning.dLonHit = m_vecLon[i * m_nSamples + k];
+				warning.dLatHit = m_vecLat[i * m_nSamples + k];
+				m_vecWorkerWarnings[nWorker].push_back(warning);
+				break;
+			}
+		}
+
+		if (bMissing)
+			m_vecWorkerMissing[nWorker].push_back(i);
+	}
+}
@@ -0,0 +1,104 @@
+#ifndef TERRAINCLEARANCE_H
+#define TERRAINCLEARANCE_H
+
+#include <vector>
+
+#include "TrackTable.h"
+
+class ElevationCache;
+class WorkerPool;
+
+/**
+* Finds the tracks whose projected path comes too close to the terrain.
+*
+* Every track is flown ahead along its heading at its ground speed and
+* constant altitude, and its path is sampled every dStep seconds over the
+* look-ahead. The positions of all samples are laid out in flat lon/lat
+* arrays, one run per track, and the heights under them are read from the
+* shared ElevationCache in batches, the tracks being shared out over the
+* worker pool. The first sample where the altitude is less than the margin
+* above the terrain gives the warning.
+*
+* Samples over tiles that are not cached yet count as clear and their tiles
+* are queued, so a track warns at the latest one cache round trip later.
+* Tracks clamped to the terrain and tracks above the highest terrain plus
+* the margin are skipped.
+*/
+class TerrainClearance
+{
+public:
+
+	struct Warning
+	{
+		//index into the rows given to Run
+		unsigned int nIndex;
+
+		double dTime;		//seconds from now to the first sample below the margin
+		double dClearance;	//altitude above the terrain there, negative below ground
+		double dAlt;
+		double dTerrain;
+
+		//position now and at that sample
+		double dLon, dLat;
+		double dLonHit, dLatHit;
+	};
+
+	//pPool may be null to run on the calling thread only
+	TerrainClearance(ElevationCache* pCache, WorkerPool* pPool = nullptr);
+
+	//500 ft
+	void SetMargin(double dMeters) { m_dMargin = dMeters; }
+
+	void SetLookAhead(double dSeconds, double dStep = 2.0);
+
+	//rows last updated more than dSeconds before the run time are skipped
+	void SetMaxAge(double dSeconds) { m_dMaxAge = dSeconds; }
+
+	double GetMargin() const { return m_dMargin; }
+
+	double GetLookAhead() const { return m_dLookAhead; }
+
+	//warnings for vecRows at time dNow, soonest first; returns their number.
+	//Must run on the thread that flushes the cache.
+	unsigned int Run(const std::vector<TrackTable::Row>& vecRows, double dNow, std::vector<Warning>& vecWarnings);
+
+	//path samples of the last run, and how many of them had no terrain yet
+	unsigned int GetNumSamples() const { return m_vecLon.size(); }
+
+	unsigned int GetNumMissing() const { return m_nMissing; }
+
+private:
+
+	struct Track
+	{
+		unsigned int nIndex;
+		double dLon;
+		double dLat;
+		double dAlt;
+		double dLonRate;	//degrees per second
+		double dLatRate;
+	};
+
+	void ProbeTracks(unsigned int nBegin, unsigned int nEnd, unsigned int nWorker);
+
+	ElevationCache* m_pCache;
+	WorkerPool* m_pPool;
+	double m_dMargin;
+	double m_dLookAhead;
+	double m_dStep;
+	double m_dMaxAge;
+	unsigned int m_nSamples;
+
+	std::vector<Track> m_vecTracks;
+
+	//m_nSamples entries per track
+	std::vector<double> m_vecLon;
+	std::vector<double> m_vecLat;
+	std::vector<float> m_vecHeights;
+
+	std::vector<std::vector<Warning> > m_vecWorkerWarnings;
+	std::vector<std::vector<unsigned int> > m_vecWorkerMissing;
+	unsigned int m_nMissing;
+};
+
+#endif // TERRAINCLEARANCE_H
@@ -0,0 +1,120 @@
+#include "TerrainClearanceNode.h"
+
+#include <osg/Geode>
+#include <osg/LineWidth>
+#include <osg/Timer>
+
+#include <QDateTime>
+
+static const osg::Vec4 s_colorPath(1.0f, 1.0f, 0.0f, 1.0f);
+static const osg::Vec4 s_colorTerrain(1.0f, 0.0f, 0.0f, 1.0f);
+
+namespace
+{
+	class ClearanceUpdateCallback : public osg::NodeCallback
+	{
+	public:
+
+		virtual void operator()(osg::Node* node, osg::NodeVisitor* nv)
+		{
+			if (nv->getFrameStamp())
+				static_cast<TerrainClearanceNode*>(node)->Refresh(nv->getFrameStamp()->getReferenceTime());
+
+			traverse(node, nv);
+		}
+	};
+}
+
+TerrainClearanceNode::TerrainClearanceNode(const osg::EllipsoidModel* pEllipsoid, ElevationCache* pCache, WorkerPool* pPool, double dInterval)
+	: m_pEllipsoid(pEllipsoid)
+	, m_dInterval(dInterval)
+	, m_dLastTime(-1.0)
+	, m_dRunTime(0.0)
+	, m_clearance(pCache, pPool)
+{
+	setName("terrain clearance");
+
+	m_pVertices = new osg::Vec3Array;
+	m_pColors = new osg::Vec4Array;
+	m_pPrimitive = new osg::DrawArrays(osg::PrimitiveSet::LINES, 0, 0);
+
+	m_pGeometry = new osg::Geometry;
+	m_pGeometry->setUseDisplayList(false);
+	m_pGeometry->setUseVertexBufferObjects(true);
+	m_pGeometry->setDataVariance(osg::Object::DYNAMIC);
+	m_pGeometry->setVertexArray(m_pVertices.get());
+	m_pGeometry->setColorArray(m_pColors.get(), osg::Array::BIND_PER_VERTEX);
+	m_pGeometry->addPrimitiveSet(m_pPrimitive.get());
+
+	osg::Geode* pGeode = new osg::Geode;
+	pGeode->addDrawable(m_pGeometry.get());
+	addChild(pGeode);
+
+	osg::StateSet* pStateSet = getOrCreateStateSet();
+	pStateSet->setMode(GL_LIGHTING, osg::StateAttribute::OFF | osg::StateAttribute::OVERRIDE);
+	pStateSet->setAttribute(new osg::LineWidth(3.0));
+
+	setUpdateCallback(new ClearanceUpdateCallback);
+}
+
+TerrainClearanceNode::~TerrainClearanceNode()
+{
+}
+
+osg::Vec3d TerrainClearanceNode::ToWorld(double dLon, double dLat, double dAlt) const
+{
+	osg::Vec3d world;
+	m_pEllipsoid->convertLatLongHeightToXYZ(osg::DegreesToRadians(dLat), osg::DegreesToRadians(dLon), dAlt, world.x(), world.y(), world.z());
+	return world;
+}
+
+void TerrainClearanceNode::Refresh(double dTime)
+{
+	if (m_dLastTime >= 0.0 && dTime - m_dLastTime < m_dInterval)
+		return;
+	m_dLastTime = dTime;
+
+	osg::Timer_t tickStart = osg::Timer::instance()->tick();
+
+	TrackTable::Instance()->Snapshot(m_vecRows);
+	m_clearance.Run(m_vecRows, QDateTime::currentMSecsSinceEpoch() / 1000.0, m_vecWarnings);
+
+	m_dRunTime = osg::Timer::instance()->delta_m(tickStart, osg::Timer::instance()->tick());
+
+	UpdateGeometry();
+}
+
+void TerrainClearanceNode::UpdateGeometry()
+{
+	m_pVertices->clear();
+	m_pColors->clear();
+
+	//Եһ澯,֤float
+	osg::Vec3d origin;
+	if (!m_vecWarnings.empty())
+		origin = ToWorld(m_vecWarnings[0].dLon, m_vecWarnings[0].dLat, m_vecWarnings[0].dAlt);
+	setMatrix(osg::Matrix::translate(origin));
+
+	for (size_t i = 0; i < m_vecWarnings.size(); i ++)
+	{
+		const TerrainClearance::Warning& warning = m_vecWarnings[i];
+		osg::Vec3 hit(ToWorld(warning.dLonHit, warning.dLatHit, warning.dAlt) - origin);
+
+		m_pVertices->push_back(osg::Vec3(ToWorld(warning.dLon, warning.dLat, warning.dAlt) - origin));
+		m_pVertices->push_back(hit);
+		m_pColors->push_back(s_colorPath);
+		m_pColors->push_back(s_colorPath);
+
+		//Ѿڵʱ߳
+		m_pVertices->push_back(hit);
+		m_pVertices->push_back(osg::Vec3(ToWorld(warning.dLonHit, warning.dLatHit, warning.dTerrain) - origin));
+		m_pColors->push_back(s_colorTerrain);
+		m_pColors->push_back(s_colorTerrain);
+	}
+
+	m_pVertices->dirty();
+	m_pColors->dirty();
+	m_pPrimitive->setCount(m_pVertices->size());
+	m_pPrimitive->dirty();
+	m_pGeometry->dirtyBound();
+}
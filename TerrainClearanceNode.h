@@ -0,0 +1,64 @@
+#ifndef TERRAINCLEARANCENODE_H
+#define TERRAINCLEARANCENODE_H
+
+#include <osg/MatrixTransform>
+#include <osg/Geometry>
+#include <osg/EllipsoidModel>
+
+#include <vector>
+
+#include "TerrainClearance.h"
+
+/**
+* Runs the terrain clearance check over the track table and marks the
+* warnings on the globe.
+*
+* The check runs from the update traversal at most every dInterval seconds.
+* Every warning is drawn as a yellow line along the projected path up to
+* the first sample below the margin and a red line from there down to the
+* terrain, all in one line geometry that is refilled in place.
+*/
+class TerrainClearanceNode : public osg::MatrixTransform
+{
+public:
+
+	TerrainClearanceNode(const osg::EllipsoidModel* pEllipsoid, ElevationCache* pCache, WorkerPool* pPool = nullptr, double dInterval = 1.0);
+
+	TerrainClearance& GetClearance() { return m_clearance; }
+
+	const std::vector<TerrainClearance::Warning>& GetWarnings() const { return m_vecWarnings; }
+
+	unsigned int GetNumWarnings() const { return m_vecWarnings.size(); }
+
+	//time of the last run in ms
+	double GetRunTime() const { return m_dRunTime; }
+
+	//called from the update callback
+	void Refresh(double dTime);
+
+protected:
+
+	virtual ~TerrainClearanceNode();
+
+private:
+
+	osg::Vec3d ToWorld(double dLon, double dLat, double dAlt) const;
+
+	void UpdateGeometry();
+
+	osg::ref_ptr<const osg::EllipsoidModel> m_pEllipsoid;
+	double m_dInterval;
+	double m_dLastTime;
+	double m_dRunTime;
+
+	TerrainClearance m_clearance;
+	std::vector<TrackTable::Row> m_vecRows;
+	std::vector<TerrainClearance::Warning> m_vecWarnings;
+
+	osg::ref_ptr<osg::Geometry> m_pGeometry;
+	osg::ref_ptr<osg::Vec3Array> m_pVertices;
+	osg::ref_ptr<osg::Vec4Array> m_pColors;
+	osg::ref_ptr<osg::DrawArrays> m_pPrimitive;
+};
+
+#endif // TERRAINCLEARANCENODE_H
@@ -0,0 +1,339 @@
+#include "TextureCompressor.h"
+
+#include <osg/Texture>
+
+#include <algorithm>
+#include <stdlib.h>
+#include <string.h>
+
+namespace
+{
+	unsigned short Pack565(const int* pColor)
+	{
+		return (unsigned short)((((pColor[0] * 31 + 127) / 255) << 11) | (((pColor[1] * 63 + 127) / 255) << 5) | ((pColor[2] * 31 + 127) / 255));
+	}
+
+	void Unpack565(unsigned short nColor, int* pColor)
+	{
+		int r = (nColor >> 11) & 31;
+		int g = (nColor >> 5) & 63;
+		int b = nColor & 31;
+		pColor[0] = (r << 3) | (r >> 2);
+		pColor[1] = (g << 2) | (g >> 4);
+		pColor[2] = (b << 3) | (b >> 2);
+	}
+
+	//ɫ,BC1BC3ͬ;4ɫģʽҪc0c1
+	void EncodeColors(const unsigned char* pBlock, unsigned char* pOut)
+	{
+		int pMin[3] = { 255, 255, 255 };
+		int pMax[3] = { 0, 0, 0 };
+		int pSum[3] = { 0, 0, 0 };
+		for (int i = 0; i < 16; i ++)
+		{
+			for (int c = 0; c < 3; c ++)
+			{
+				int nValue = pBlock[i * 4 + c];
+				pMin[c] = std::min(pMin[c], nValue);
+				pMax[c] = std::max(pMax[c], nValue);
+				pSum[c] += nValue;
+			}
+		}
+
+		//̺Ժ췴仯ʱ,˵ȡΧеһԽ
+		int nCovRG = 0;
+		int nCovRB = 0;
+		for (int i = 0; i < 16; i ++)
+		{
+			int r = pBlock[i * 4] * 16 - pSum[0];
+			nCovRG += r * (pBlock[i * 4 + 1] * 16 - pSum[1]);
+			nCovRB += r * (pBlock[i * 4 + 2] * 16 - pSum[2]);
+		}
+		if (nCovRG < 0)
+			std::swap(pMin[1], pMax[1]);
+		if (nCovRB < 0)
+			std::swap(pMin[2], pMax[2]);
+
+		//˵1/16,С˵
+		for (int c = 0; c < 3; c ++)
+		{
+			int nInset = (pMax[c] - pMin[c]) / 16;
+			pMax[c] -= nInset;
+			pMin[c] += nInset;
+		}
+
+		unsigned short c0 = Pack565(pMax);
+		unsigned short c1 = Pack565(pMin);
+		if (c0 < c1)
+			std::swap(c0, c1);
+
+		unsigned int nIndices = 0;
+		if (c0 != c1)
+		{
+			int pPalette[4][3];
+			Unpack565(c0, pPalette[0]);
+			Unpack565(c1, pPalette[1]);
+			for (int c = 0; c < 3; c ++)
+			{
+				pPalette[2][c] = (2 * pPalette[0][c] + pPalette[1][c]) / 3;
+				pPalette[3][c] = (pPalette[0][c] + 2 * pPalette[1][c]) / 3;
+			}
+
+			for (int i = 0; i < 16; i ++)
+			{
+				int nBest = 0;
+				int nBestDist = 0x7fffffff;
+				for (int j = 0; j < 4; j ++)
+				{
+					int dr = pBlock[i * 4] - pPalette[j][0];
+					int dg = pBlock[i * 4 + 1] - pPalette[j][1];
+					int db = pBlock[i * 4 + 2] - pPalette[j][2];
+					int nDist = dr * dr + dg * dg + db * db;
+					if (nDist < nBestDist)
+					{
+						nBestDist = nDist;
+						nBest = j;
+					}
+				}
+				nIndices |= nBest << (i * 2);
+			}
+		}
+
+		pOut[0] = (unsigned char)(c0 & 0xff);
+		pOut[1] = (unsigned char)(c0 >> 8);
+		pOut[2] = (unsigned char)(c1 & 0xff);
+		pOut[3] = (unsigned char)(c1 >> 8);
+		for (int i = 0; i < 4; i ++)
+			pOut[4 + i] = (unsigned char)(nIndices >> (i * 8));
+	}
+
+	//a0a1ʱ8ֵ
+	void EncodeAlpha(const unsigned char* pBlock, unsigned char* pOut)
+	{
+		int nMin = 255;
+		int nMax = 0;
+		for (int i = 0; i < 16; i ++)
+		{
+			nMin = std::min(nMin, (int)pBlock[i * 4 + 3]);
+			nMax = std::max(nMax, (int)pBlock[i * 4 + 3]);
+		}
+
+		unsigned long long nIndices = 0;
+		if (nMax > nMin)
+		{
+			int pPalette[8] = { nMax, nMin };
+			for (int k = 1; k < 7; k ++)
+				pPalette[k + 1] = ((7 - k) * nMax + k * nMin) / 7;
+
+			for (int i = 0; i < 16; i ++)
+			{
+				int nBest = 0;
+				int nBestDist = 256;
+				for (int j = 0; j < 8; j ++)
+				{
+					int nDist = abs(pBlock[i * 4 + 3] - pPalette[j]);
+					if (nDist < nBestDist)
+					{
+						nBestDist = nDist;
+						nBest = j;
+					}
+				}
+				nIndices |= (unsigned long long)nBest << (i * 3);
+			}
+		}
+
+		pOut[0] = (unsigned char)nMax;
+		pOut[1] = (unsigned char)nMin;
+		for (int i = 0; i < 6; i ++)
+			pOut[2 + i] = (unsigned char)(nIndices >> (i * 8));
+	}
+}
+
+void TextureCompressor::EncodeBlockBC1(const unsigned char* pBlock, unsigned char* pOut)
+{
+	EncodeColors(pBlock, pOut);
+}
+
+void TextureCompressor::EncodeBlockBC3(const unsigned char* pBlock, unsigned char* pOut)
+{
+	EncodeAlpha(pBlock, pOut);
+	EncodeColors(pBlock, pOut + 8);
+}
+
+void TextureCompressor::DecodeBlock(const unsigned char* pIn, Format nFormat, unsigned char* pBlock)
+{
+	const unsigned char* pColors = pIn;
+	if (nFormat == FORMAT_BC3)
+	{
+		int pAlpha[8] = { pIn[0], pIn[1] };
+		for (int k = 1; k < 7; k ++)
+		{
+			if (pAlpha[0] > pAlpha[1])
+				pAlpha[k + 1] = ((7 - k) * pAlpha[0] + k * pAlpha[1]) / 7;
+			else
+				pAlpha[k + 1] = k < 5 ? ((5 - k) * pAlpha[0] + k * pAlpha[1]) / 5 : (k == 5 ? 0 : 255);
+		}
+
+		unsigned long long nIndices = 0;
+		for (int i = 0; i < 6; i ++)
+			nIndices |= (unsigned long long)pIn[2 + i] << (i * 8);
+		for (int i = 0; i < 16; i ++)
+			pBlock[i * 4 + 3] = (unsigned char)pAlpha[(nIndices >> (i * 3)) & 7];
+		pColors = pIn + 8;
+	}
+
+	unsigned short c0 = pColors[0] | (pColors[1] << 8);
+	unsigned short c1 = pColors[2] | (pColors[3] << 8);
+	int pPalette[4][4];
+	Unpack565(c0, pPalette[0]);
+	Unpack565(c1, pPalette[1]);
+	pPalette[0][3] = pPalette[1][3] = pPalette[2][3] = pPalette[3][3] = 255;
+
+	//BC1c0c1ʱ3ɫ͸
+	bool bFourColors = nFormat == FORMAT_BC3 || c0 > c1;
+	for (int c = 0; c < 3; c ++)
+	{
+		if (bFourColors)
+		{
+			pPalette[2][c] = (2 * pPalette[0][c] + pPalette[1][c]) / 3;
+			pPalette[3][c] = (pPalette[0][c] + 2 * pPalette[1][c]) / 3;
+		}
+		else
+		{
+			pPalette[2][c] = (pPalette[0][c] + pPalette[1][c]) / 2;
+			pPalette[3][c] = 0;
+		}
+	}
+	if (!bFourColors)
+		pPalette[3][3] = 0;
+
+	unsigned int nIndices = pColors[4] | (pColors[5] << 8) | (pColors[6] << 16) | ((unsigned int)pColors[7] << 24);
+	for (int i = 0; i < 16; i ++)
+	{
+		const int* pColor = pPalette[(nIndices >> (i * 2)) & 3];
+		pBlock[i * 4] = (unsigned char)pColor[0];
+		pBlock[i * 4 + 1] = (unsigned char)pColor[1];
+		pBlock[i * 4 + 2] = (unsigned char)pColor[2];
+		if (nFormat != FORMAT_BC3)
+			pBlock[i * 4 + 3] = (unsigned char)pColor[3];
+	}
+}
+
+void TextureCompressor::EncodeLevel(const unsigned char* pRgba, unsigned int nWidth, unsigned int nHeight, unsigned int nStride, Format nFormat, std::vector<unsigned char>& vecOut)
+{
+	unsigned int nBlockBytes = nFormat == FORMAT_BC3 ? 16 : 8;
+	unsigned int nBlocksX = (nWidth + 3) / 4;
+	unsigned int nBlocksY = (nHeight + 3) / 4;
+	size_t nOffset = vecOut.size();
+	vecOut.resize(nOffset + nBlocksX * nBlocksY * nBlockBytes);
+
+	unsigned char pBlock[64];
+	unsigned char* pOut = &vecOut[nOffset];
+	for (unsigned int by = 0; by < nBlocksY; by ++)
+	{
+		for (unsigned int bx = 0; bx < nBlocksX; bx ++)
+		{
+			for (unsigned int y = 0; y < 4; y ++)
+			{
+				const unsigned char* pRow = pRgba + std::min(by * 4 + y, nHeight - 1) * nStride;
+				for (unsigned int x = 0; x < 4; x ++)
+					memcpy(pBlock + (y * 4 + x) * 4, pRow + std::min(bx * 4 + x, nWidth - 1) * 4, 4);
+			}
+
+			if (nFormat == FORMAT_BC3)
+				EncodeBlockBC3(pBlock, pOut);
+			else
+				EncodeBlockBC1(pBlock, pOut);
+			pOut += nBlockBytes;
+		}
+	}
+}
+
+unsigned long long TextureCompressor::GetRgbaBytes(unsigned int nWidth, unsigned int nHeight)
+{
+	unsigned long long nBytes = 0;
+	for (;;)
+	{
+		nBytes += (unsigned long long)nWidth * nHeight * 4;
+		if (nWidth == 1 && nHeight == 1)
+			return nBytes;
+		nWidth = std::max(nWidth / 2, 1u);
+		nHeight = std::max(nHeight / 2, 1u);
+	}
+}
+
+osg::Image* TextureCompressor::Compress(const osg::Image* pImage, Format nFormat)
+{
+	if (!pImage || !pImage->data() || pImage->r() != 1 || pImage->getDataType() != GL_UNSIGNED_BYTE
+		|| (pImage->getPixelFormat() != GL_RGBA && pImage->getPixelFormat() != GL_RGB) || nFormat == FORMAT_NONE)
+		return nullptr;
+
+	//չɽյRGBA8
+	unsigned int nWidth = pImage->s();
+	unsigned int nHeight = pImage->t();
+	bool bRgb = pImage->getPixelFormat() == GL_RGB;
+	std::vector<unsigned char> vecLevel(nWidth * nHeight * 4);
+	bool bOpaque = true;
+	for (unsigned int y = 0; y < nHeight; y ++)
+	{
+		const unsigned char* pRow = pImage->data(0, y);
+		unsigned char* pOut = &vecLevel[y * nWidth * 4];
+		for (unsigned int x = 0; x < nWidth; x ++)
+		{
+			pOut[x * 4] = pRow[0];
+			pOut[x * 4 + 1] = pRow[1];
+			pOut[x * 4 + 2] = pRow[2];
+			pOut[x * 4 + 3] = bRgb ? 255 : pRow[3];
+			bOpaque = bOpaque && pOut[x * 4 + 3] == 255;
+			pRow += bRgb ? 3 : 4;
+		}
+	}
+
+	if (nFormat == FORMAT_AUTO)
+		nFormat = bOpaque ? FORMAT_BC1 : FORMAT_BC3;
+
+	//2x2ƽС,ÿ
+	std::vector<unsigned char> vecData;
+	osg::Image::MipmapDataType vecMipmaps;
+	std::vector<unsigned char> vecNext;
+	unsigned int w = nWidth;
+	unsigned int h = nHeight;
+	for (;;)
+	{
+		if (w != nWidth || h != nHeight)
+			vecMipmaps.push_back(vecData.size());
+		EncodeLevel(&vecLevel[0], w, h, w * 4, nFormat, vecData);
+		if (w == 1 && h == 1)
+			break;
+
+		unsigned int nw = std::max(w / 2, 1u);
+		unsigned int nh = std::max(h / 2, 1u);
+		vecNext.resize(nw * nh * 4);
+		for (unsigned int y = 0; y < nh; y ++)
+		{
+			const unsigned char* pRow0 = &vecLevel[std::min(y * 2, h - 1) * w * 4];
+			const unsigned char* pRow1 = &vecLevel[std::min(y * 2 + 1, h - 1) * w * 4];
+			for (unsigned int x = 0; x < nw; x ++)
+			{
+				unsigned int x0 = std::min(x * 2, w - 1) * 4;
+				unsigned int x1 = std::min(x * 2 + 1, w - 1) * 4;
+				for (unsigned int c = 0; c < 4; c ++)
+					vecNext[(y * nw + x) * 4 + c] = (unsigned char)((pRow0[x0 + c] + pRow0[x1 + c] + pRow1[x0 + c] + pRow1[x1 + c] + 2) / 4);
+			}
+		}
+
+		vecLevel.swap(vecNext);
+		w = nw;
+		h = nh;
+	}
+
+	GLenum nGLFormat = nFormat == FORMAT_BC3 ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	unsigned char* pData = new unsigned char[vecData.size()];
+	memcpy(pData, &vecData[0], vecData.size());
+
+	osg::Image* pResult = new osg::Image;
+	pResult->setImage(nWidth, nHeight, 1, nGLFormat, nGLFormat, GL_UNSIGNED_BYTE, pData, osg::Image::USE_NEW_DELETE);
+	pResult->setMipmapLevels(vecMipmaps);
+	pResult->setOrigin(pImage->getOrigin());
+	return pResult;
+}
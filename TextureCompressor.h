@@ -0,0 +1,52 @@
+#ifndef TEXTURECOMPRESSOR_H
+#define TEXTURECOMPRESSOR_H
+
+#include <osg/Image>
+
+#include <vector>
+
+/**
+* CPU encoder for the S3TC block formats BC1 (DXT1, 8 bytes per 4x4 block,
+* opaque) and BC3 (DXT5, 16 bytes, BC1 colors plus an interpolated alpha
+* block).
+*
+* Colors use a range fit: the endpoints are the corners of the block's color
+* bounding box, flipped along the diagonal that follows the sign of the
+* red/green and red/blue covariance and inset by 1/16 of the range, and
+* every texel takes the nearest of the four palette entries. It is a few
+* times faster than a cluster fit and good enough for satellite imagery.
+*
+* Compress encodes the whole mipmap chain, box filtered on the CPU, since a
+* driver cannot generate mipmaps for a compressed upload. All functions are
+* thread safe.
+*/
+class TextureCompressor
+{
+public:
+
+	enum Format
+	{
+		FORMAT_NONE = 0,
+		FORMAT_BC1 = 1,
+		FORMAT_BC3 = 2,
+		FORMAT_AUTO = 3		//BC3 if any texel is not opaque, else BC1
+	};
+
+	//pBlock holds 16 RGBA8 texels row by row
+	static void EncodeBlockBC1(const unsigned char* pBlock, unsigned char* pOut);
+
+	static void EncodeBlockBC3(const unsigned char* pBlock, unsigned char* pOut);
+
+	static void DecodeBlock(const unsigned char* pIn, Format nFormat, unsigned char* pBlock);
+
+	//appends the blocks of one RGBA8 level, nStride bytes per row; edge blocks repeat the last row and column
+	static void EncodeLevel(const unsigned char* pRgba, unsigned int nWidth, unsigned int nHeight, unsigned int nStride, Format nFormat, std::vector<unsigned char>& vecOut);
+
+	//bytes of an uncompressed RGBA8 texture of this size with all its mipmaps
+	static unsigned long long GetRgbaBytes(unsigned int nWidth, unsigned int nHeight);
+
+	//compressed copy of an RGB8 or RGBA8 image with its mipmaps, null for other pixel formats
+	static osg::Image* Compress(const osg::Image* pImage, Format nFormat);
+};
+
+#endif // TEXTURECOMPRESSOR_H
@@ -0,0 +1,419 @@
+#include "TileArchive.h"
+
+#include <OpenThreads/ScopedLock>
+
+#include <algorithm>
+#include <string.h>
+
+//ļͷ: ʶ,汾,,ͶӰ,ʽ,Ƭ߳,㼶Χ,λ,Ƭ
+static const int s_nHeaderSize = 64;
+static const unsigned int s_nVersion = 1;
+
+//Ƭݰ16ֽڶ
+static const unsigned int s_nAlignment = 16;
+
+//ӳ䴰ڰڳȶ,һص,صȵƬ細
+static const unsigned long long s_nWindowSize = 4 * 1024 * 1024;
+static const unsigned long long s_nWindowOverlap = 512 * 1024;
+
+//ÿ浵ౣӳ䴰
+static const size_t s_nMaxWindows = 8;
+
+namespace
+{
+	struct LevelRecord
+	{
+		unsigned int nFirstRow;
+		unsigned int nRows;
+		unsigned long long nRowTable;
+	};
+
+	struct RowRecord
+	{
+		unsigned int nFirstColumn;
+		unsigned int nColumns;
+		unsigned long long nIndex;
+	};
+
+	struct IndexEntry
+	{
+		unsigned long long nOffset;
+		unsigned int nSize;
+		unsigned int nReserved;
+	};
+}
+
+TileArchive::Window::Window(const TileArchive* pArchive, unsigned char* pMap, unsigned long long nOffset, unsigned long long nSize)
+	: m_pArchive(pArchive)
+	, m_pMap(pMap)
+	, m_nOffset(nOffset)
+	, m_nSize(nSize)
+{
+
+}
+
+TileArchive::Window::~Window()
+{
+	OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_pArchive->m_mutex);
+	m_pArchive->m_file.unmap(m_pMap);
+}
+
+TileArchive::TileArchive()
+	: m_nFileSize(0)
+	, m_nTiles(0)
+{
+
+}
+
+TileArchive::~TileArchive()
+{
+	Close();
+}
+
+bool TileArchive::ReadAt(unsigned long long nOffset, void* pData, unsigned long long nSize) const
+{
+	return m_file.seek(nOffset) && m_file.read(static_cast<char*>(pData), nSize) == (qint64)nSize;
+}
+
+bool TileArchive::Open(const QString& strFile)
+{
+	Close();
+
+	m_file.setFileName(strFile);
+	if (!m_file.open(QIODevice::ReadOnly) || m_file.size() < s_nHeaderSize)
+	{
+		m_file.close();
+		return false;
+	}
+
+	m_nFileSize = m_file.size();
+
+	unsigned char szHead[s_nHeaderSize];
+	if (!ReadAt(0, szHead, s_nHeaderSize))
+	{
+		Close();
+		return false;
+	}
+
+	unsigned int nVersion;
+	unsigned long long nLevelTable;
+	char szFormat[9] = { 0 };
+	memcpy(&nVersion, szHead + 4, 4);
+	memcpy(&m_info.nContent, szHead + 8, 4);
+	memcpy(&m_info.nProfile, szHead + 12, 4);
+	memcpy(szFormat, szHead + 16, 8);
+	memcpy(&m_info.nTileSize, szHead + 24, 4);
+	memcpy(&m_info.nMinLevel, szHead + 28, 4);
+	memcpy(&m_info.nMaxLevel, szHead + 32, 4);
+	memcpy(&nLevelTable, szHead + 40, 8);
+	memcpy(&m_nTiles, szHead + 48, 8);
+	m_info.strFormat = szFormat;
+
+	//λúͳȶļ,дɼͳ,ֵٴҲ
+	unsigned long long nLevels = m_info.nMaxLevel >= m_info.nMinLevel ? (unsigned long long)m_info.nMaxLevel - m_info.nMinLevel + 1 : 0;
+	bool bValid = memcmp(szHead, "RMTA", 4) == 0 && nVersion == s_nVersion && nLevels > 0
+		&& nLevelTable <= m_nFileSize && nLevels <= (m_nFileSize - nLevelTable) / sizeof(LevelRecord);
+
+	std::vector<LevelRecord> vecLevels;
+	if (bValid)
+	{
+		vecLevels.resize((size_t)nLevels);
+		bValid = ReadAt(nLevelTable, &vecLevels[0], nLevels * sizeof(LevelRecord));
+	}
+
+	//бڴ,ݲƬʱٶ
+	std::vector<RowRecord> vecRows;
+	m_vecLevels.resize(vecLevels.size());
+	for (size_t i = 0; bValid && i < vecLevels.size(); i ++)
+	{
+		const LevelRecord& record = vecLevels[i];
+		bValid = record.nRowTable <= m_nFileSize && record.nRows <= (m_nFileSize - record.nRowTable) / sizeof(RowRecord);
+		if (!bValid || record.nRows == 0)
+			continue;
+
+		vecRows.resize(record.nRows);
+		bValid = ReadAt(record.nRowTable, &vecRows[0], (unsigned long long)record.nRows * sizeof(RowRecord));
+
+		Level& level = m_vecLevels[i];
+		level.nFirstRow = record.nFirstRow;
+		level.vecRows.resize(record.nRows);
+		for (unsigned int j = 0; bValid && j < record.nRows; j ++)
+		{
+			const RowRecord& row = vecRows[j];
+			bValid = row.nIndex <= m_nFileSize && row.nColumns <= (m_nFileSize - row.nIndex) / sizeof(IndexEntry);
+
+			level.vecRows[j].nFirstColumn = row.nFirstColumn;
+			level.vecRows[j].nColumns = row.nColumns;
+			level.vecRows[j].nIndex = row.nIndex;
+		}
+	}
+
+	if (!bValid)
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void TileArchive::Close()
+{
+	//ʱҪ,ͷ
+	std::vector<osg::ref_ptr<Window> > vecWindows;
+	{
+		OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+		vecWindows.swap(m_vecWindows);
+	}
+	vecWindows.clear();
+
+	m_file.close();
+
+	m_nFileSize = 0;
+	m_nTiles = 0;
+	m_vecLevels.clear();
+	m_info = Info();
+}
+
+const unsigned char* TileArchive::GetTile(unsigned int nLevel, unsigned int x, unsigned int y, unsigned int& nSize, osg::ref_ptr<Window>& pWindow) const
+{
+	//ȷŵԭеĴ,һ,ʱҪ
+	pWindow = nullptr;
+
+	if (!IsOpen() || nLevel < m_info.nMinLevel || nLevel > m_info.nMaxLevel)
+		return nullptr;
+
+	const Level& level = m_vecLevels[nLevel - m_info.nMinLevel];
+	if (y < level.nFirstRow || y - level.nFirstRow >= level.vecRows.size())
+		return nullptr;
+
+	const Row& row = level.vecRows[y - level.nFirstRow];
+	if (x < row.nFirstColumn || x - row.nFirstColumn >= row.nColumns)
+		return nullptr;
+
+	//֮ǰ,Ĵڽ֮ͷ
+	osg::ref_ptr<Window> pIndexWindow, pEvicted, pDataEvicted;
+	OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+
+	unsigned long long nEntry = row.nIndex + (unsigned long long)(x - row.nFirstColumn) * sizeof(IndexEntry);
+	if (!FindWindow(nEntry, sizeof(IndexEntry), pIndexWindow, pEvicted))
+		return nullptr;
+
+	IndexEntry entry;
+	memcpy(&entry, pIndexWindow->GetData() + (nEntry - pIndexWindow->GetOffset()), sizeof(entry));
+	if (entry.nSize == 0 || entry.nOffset > m_nFileSize || entry.nSize > m_nFileSize - entry.nOffset)
+		return nullptr;
+
+	if (!FindWindow(entry.nOffset, entry.nSize, pWindow, pDataEvicted))
+		return nullptr;
+
+	nSize = entry.nSize;
+	return pWindow->GetData() + (entry.nOffset - pWindow->GetOffset());
+}
+
+bool TileArchive::FindWindow(unsigned long long nOffset, unsigned long long nSize, osg::ref_ptr<Window>& pWindow, osg::ref_ptr<Window>& pEvicted) const
+{
+	unsigned long long nBegin = nOffset / s_nWindowSize * s_nWindowSize;
+	unsigned long long nEnd = std::min(m_nFileSize, nBegin + s_nWindowSize + s_nWindowOverlap);
+
+	//صȵĴƬӳ,ͽ,ڱ
+	if (nSize > nEnd - nOffset)
+	{
+		unsigned char* pMap = m_file.map(nOffset, nSize);
+		pWindow = pMap ? new Window(this, pMap, nOffset, nSize) : nullptr;
+		return pWindow.valid();
+	}
+
+	for (size_t i = 0; i < m_vecWindows.size(); i ++)
+	{
+		if (m_vecWindows[i]->GetOffset() == nBegin)
+		{
+			pWindow = m_vecWindows[i];
+			m_vecWindows.erase(m_vecWindows.begin() + i);
+			m_vecWindows.push_back(pWindow);
+			return true;
+		}
+	}
+
+	unsigned char* pMap = m_file.map(nBegin, nEnd - nBegin);
+	if (!pMap)
+		return false;
+
+	pWindow = new Window(this, pMap, nBegin, nEnd - nBegin);
+	if (m_vecWindows.size() >= s_nMaxWindows)
+	{
+		pEvicted = m_vecWindows.front();
+		m_vecWindows.erase(m_vecWindows.begin());
+	}
+	m_vecWindows.push_back(pWindow);
+	return true;
+}
+
+bool TileArchive::GetRowRange(unsigned int nLevel, unsigned int& nFirstRow, unsigned int& nRows) const
+{
+	if (!IsOpen() || nLevel < m_info.nMinLevel || nLevel > m_info.nMaxLevel)
+		return false;
+
+	const Level& level = m_vecLevels[nLevel - m_info.nMinLevel];
+	nFirstRow = level.nFirstRow;
+	nRows = level.vecRows.size();
+	return nRows > 0;
+}
+
+bool TileArchive::GetColumnRange(unsigned int nLevel, unsigned int& nFirstColumn, unsigned int& nColumns) const
+{
+	if (!IsOpen() || nLevel < m_info.nMinLevel || nLevel > m_info.nMaxLevel)
+		return false;
+
+	//еΪ0,
+	unsigned long long nBegin = ~0ull, nEnd = 0;
+	const Level& level = m_vecLevels[nLevel - m_info.nMinLevel];
+	for (size_t i = 0; i < level.vecRows.size(); i ++)
+	{
+		const Row& row = level.vecRows[i];
+		if (row.nColumns == 0)
+			continue;
+
+		nBegin = std::min(nBegin, (unsigned long long)row.nFirstColumn);
+		nEnd = std::max(nEnd, (unsigned long long)row.nFirstColumn + row.nColumns);
+	}
+
+	if (nBegin >= nEnd)
+		return false;
+
+	nFirstColumn = (unsigned int)nBegin;
+	nColumns = (unsigned int)(nEnd - nBegin);
+	return true;
+}
+
+TileArchiveWriter::TileArchiveWriter(const TileArchive::Info& info)
+	: m_info(info)
+{
+	m_info.nMaxLevel = std::max(m_info.nMinLevel, m_info.nMaxLevel);
+	m_vecLevels.resize(m_info.nMaxLevel - m_info.nMinLevel + 1);
+}
+
+void TileArchiveWriter::Add(unsigned int nLevel, unsigned int x, unsigned int y)
+{
+	if (nLevel >= m_info.nMinLevel && nLevel <= m_info.nMaxLevel)
+		m_vecLevels[nLevel - m_info.nMinLevel].push_back(std::make_pair(y, x));
+}
+
+unsigned long long TileArchiveWriter::GetNumTiles() const
+{
+	unsigned long long nTiles = 0;
+	for (size_t i = 0; i < m_vecLevels.size(); i ++)
+		nTiles += m_vecLevels[i].size();
+	return nTiles;
+}
+
+static bool WritePadding(QFile& file)
+{
+	static const char s_szZeros[s_nAlignment] = { 0 };
+	qint64 nPad = (s_nAlignment - file.pos() % s_nAlignment) % s_nAlignment;
+	return nPad == 0 || file.write(s_szZeros, nPad) == nPad;
+}
+
+bool TileArchiveWriter::Write(const QString& strFile, const ReadFunc& func)
+{
+	QFile file(strFile);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		return false;
+
+	//ļͷͲдһ
+	std::vector<LevelRecord> vecLevels(m_vecLevels.size());
+	std::vector<char> vecHead(s_nHeaderSize + vecLevels.size() * sizeof(LevelRecord), 0);
+	if (file.write(&vecHead[0], vecHead.size()) != (qint64)vecHead.size())
+		return false;
+
+	unsigned long long nTiles = 0;
+	std::vector<RowRecord> vecRows;
+	std::vector<IndexEntry> vecIndex;
+	std::string strData;
+	for (size_t i = 0; i < m_vecLevels.size(); i ++)
+	{
+		std::vector<std::pair<unsigned int, unsigned int> >& vecTiles = m_vecLevels[i];
+		std::sort(vecTiles.begin(), vecTiles.end());
+		vecTiles.erase(std::unique(vecTiles.begin(), vecTiles.end()), vecTiles.end());
+
+		LevelRecord& level = vecLevels[i];
+		memset(&level, 0, sizeof(level));
+		if (vecTiles.empty())
+			continue;
+
+		//ÿдӵһһƬ
+		level.nFirstRow = vecTiles.front().first;
+		level.nRows = vecTiles.back().first - level.nFirstRow + 1;
+		vecRows.assign(level.nRows, RowRecord());
+		memset(&vecRows[0], 0, vecRows.size() * sizeof(RowRecord));
+
+		unsigned long long nEntries = 0;
+		for (size_t j = 0; j < vecTiles.size(); )
+		{
+			size_t k = j;
+			while (k < vecTiles.size() && vecTiles[k].first == vecTiles[j].first)
+				k ++;
+
+			RowRecord& row = vecRows[vecTiles[j].first - level.nFirstRow];
+			row.nFirstColumn = vecTiles[j].second;
+			row.nColumns = vecTiles[k - 1].second - row.nFirstColumn + 1;
+			row.nIndex = nEntries;
+			nEntries += row.nColumns;
+			j = k;
+		}
+
+		level.nRowTable = file.pos();
+		unsigned long long nIndexStart = level.nRowTable + vecRows.size() * sizeof(RowRecord);
+		for (size_t j = 0; j < vecRows.size(); j ++)
+			vecRows[j].nIndex = nIndexStart + vecRows[j].nIndex * sizeof(IndexEntry);
+
+		vecIndex.assign((size_t)nEntries, IndexEntry());
+		memset(&vecIndex[0], 0, vecIndex.size() * sizeof(IndexEntry));
+		if (file.write(reinterpret_cast<const char*>(&vecRows[0]), vecRows.size() * sizeof(RowRecord)) != (qint64)(vecRows.size() * sizeof(RowRecord))
+			|| file.write(reinterpret_cast<const char*>(&vecIndex[0]), vecIndex.size() * sizeof(IndexEntry)) != (qint64)(vecIndex.size() * sizeof(IndexEntry)))
+			return false;
+
+		for (size_t j = 0; j < vecTiles.size(); j ++)
+		{
+			unsigned int nLevel = m_info.nMinLevel + i;
+			strData.clear();
+			if (!func(nLevel, vecTiles[j].second, vecTiles[j].first, strData) || strData.empty())
+				continue;
+
+			if (!WritePadding(file))
+				return false;
+
+			const RowRecord& row = vecRows[vecTiles[j].first - level.nFirstRow];
+			IndexEntry& entry = vecIndex[(row.nIndex - nIndexStart) / sizeof(IndexEntry) + vecTiles[j].second - row.nFirstColumn];
+			entry.nOffset = file.pos();
+			entry.nSize = strData.size();
+			if (file.write(strData.data(), strData.size()) != (qint64)strData.size())
+				return false;
+			nTiles ++;
+		}
+
+		//дٻһ
+		qint64 nEnd = file.pos();
+		if (!file.seek(nIndexStart)
+			|| file.write(reinterpret_cast<const char*>(&vecIndex[0]), vecIndex.size() * sizeof(IndexEntry)) != (qint64)(vecIndex.size() * sizeof(IndexEntry))
+			|| !file.seek(nEnd))
+			return false;
+	}
+
+	unsigned long long nLevelTable = s_nHeaderSize;
+	char szFormat[8] = { 0 };
+	strncpy(szFormat, m_info.strFormat.c_str(), sizeof(szFormat));
+	memcpy(&vecHead[0], "RMTA", 4);
+	memcpy(&vecHead[4], &s_nVersion, 4);
+	memcpy(&vecHead[8], &m_info.nContent, 4);
+	memcpy(&vecHead[12], &m_info.nProfile, 4);
+	memcpy(&vecHead[16], szFormat, 8);
+	memcpy(&vecHead[24], &m_info.nTileSize, 4);
+	memcpy(&vecHead[28], &m_info.nMinLevel, 4);
+	memcpy(&vecHead[32], &m_info.nMaxLevel, 4);
+	memcpy(&vecHead[40], &nLevelTable, 8);
+	memcpy(&vecHead[48], &nTiles, 8);
+	memcpy(&vecHead[s_nHeaderSize], &vecLevels[0], vecLevels.size() * sizeof(LevelRecord));
+
+	return file.seek(0) && file.write(&vecHead[0], vecHead.size()) == (qint64)vecHead.size();
+}
@@ -0,0 +1,185 @@
+#ifndef TILEARCHIVE_H
+#define TILEARCHIVE_H
+
+#include <QFile>
+#include <QString>
+
+#include <OpenThreads/Mutex>
+#include <osg/Referenced>
+#include <osg/ref_ptr>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+* Read-only packed tile archive.
+*
+* The file is a 64 byte header and a table with one record per level. Each
+* level then holds a table with one record per tile row, the dense index of
+* every row (one entry (offset, size) for each column between the first and
+* the last tile of that row, size 0 where there is no tile) and the tile
+* data in row, column order, each tile aligned to 16 bytes. A pan along a
+* row or a seed of one level therefore reads the file front to back.
+*
+* Open reads the header, the level table and the row tables, which take a
+* few bytes per tile row. The rest of the file is memory mapped in windows
+* of a few MB, of which the most recently used few stay mapped, so the
+* address space used does not grow with the archive (a 32-bit build could
+* not map a large one whole). GetTile finds the row in memory and returns a
+* pointer to the tile inside its window; the mutex only guards the window
+* list, the pages are read outside it. Every offset and size read from the
+* file is checked against the file size before it is used. Tiles are stored
+* as the packer got them: encoded images (png, jpg), raw RGBA8 (rgba) or
+* float heights (f32).
+*/
+class TileArchive
+{
+public:
+
+	enum Content
+	{
+		CONTENT_IMAGE = 0,
+		CONTENT_ELEVATION = 1
+	};
+
+	enum Profile
+	{
+		PROFILE_GEODETIC = 0,
+		PROFILE_MERCATOR = 1
+	};
+
+	struct Info
+	{
+		Info() : nContent(CONTENT_IMAGE), nProfile(PROFILE_GEODETIC), nTileSize(256), nMinLevel(0), nMaxLevel(0) {}
+
+		unsigned int nContent;
+		unsigned int nProfile;
+		std::string strFormat;		//png, jpg, rgba or f32
+		unsigned int nTileSize;		//samples per side
+		unsigned int nMinLevel;
+		unsigned int nMaxLevel;
+	};
+
+	/**
+	* A mapped region of the archive. Tile data returned by GetTile stays
+	* valid while its window is referenced, even after the window left the
+	* archive's recently used list. Release every window before Close.
+	*/
+	class Window : public osg::Referenced
+	{
+	public:
+
+		Window(const TileArchive* pArchive, unsigned char* pMap, unsigned long long nOffset, unsigned long long nSize);
+
+		unsigned long long GetOffset() const { return m_nOffset; }
+
+		unsigned long long GetSize() const { return m_nSize; }
+
+		const unsigned char* GetData() const { return m_pMap; }
+
+	protected:
+
+		//unmaps under the archive's mutex, so the last reference must not be dropped while holding it
+		virtual ~Window();
+
+	private:
+
+		const TileArchive* m_pArchive;
+		unsigned char* m_pMap;
+		unsigned long long m_nOffset;
+		unsigned long long m_nSize;
+	};
+
+	TileArchive();
+	~TileArchive();
+
+	bool Open(const QString& strFile);
+
+	void Close();
+
+	bool IsOpen() const { return m_file.isOpen(); }
+
+	const Info& GetInfo() const { return m_info; }
+
+	//data of one tile inside a mapped window, valid while pWindow holds it; null if the archive has no such tile
+	const unsigned char* GetTile(unsigned int nLevel, unsigned int x, unsigned int y, unsigned int& nSize, osg::ref_ptr<Window>& pWindow) const;
+
+	unsigned long long GetNumTiles() const { return m_nTiles; }
+
+	//rows of nLevel present in the archive, false if none
+	bool GetRowRange(unsigned int nLevel, unsigned int& nFirstRow, unsigned int& nRows) const;
+
+	//columns of nLevel spanned by any of its rows, false if none
+	bool GetColumnRange(unsigned int nLevel, unsigned int& nFirstColumn, unsigned int& nColumns) const;
+
+private:
+
+	TileArchive(const TileArchive&);
+	TileArchive& operator=(const TileArchive&);
+
+	//same layout as the row records in the file
+	struct Row
+	{
+		unsigned int nFirstColumn;
+		unsigned int nColumns;
+		unsigned long long nIndex;
+	};
+
+	struct Level
+	{
+		unsigned int nFirstRow;
+		std::vector<Row> vecRows;
+	};
+
+	//reads the tables in Open
+	bool ReadAt(unsigned long long nOffset, void* pData, unsigned long long nSize) const;
+
+	//the window holding [nOffset, nOffset + nSize); a window pushed out of the list is handed to pEvicted
+	//so that it is released after the caller unlocks m_mutex. Caller holds m_mutex
+	bool FindWindow(unsigned long long nOffset, unsigned long long nSize, osg::ref_ptr<Window>& pWindow, osg::ref_ptr<Window>& pEvicted) const;
+
+	mutable QFile m_file;
+	mutable OpenThreads::Mutex m_mutex;
+	unsigned long long m_nFileSize;
+
+	//recently used windows, oldest first
+	mutable std::vector<osg::ref_ptr<Window> > m_vecWindows;
+
+	Info m_info;
+	unsigned long long m_nTiles;
+	std::vector<Level> m_vecLevels;
+};
+
+/**
+* Writes a TileArchive.
+*
+* The tiles are registered first so that the row ranges are known, then
+* Write asks for the data of each tile in file order and streams it out,
+* filling in the index of a level once its data is written.
+*/
+class TileArchiveWriter
+{
+public:
+
+	//fills strData with the stored bytes of one tile; false skips the tile
+	typedef std::function<bool(unsigned int nLevel, unsigned int x, unsigned int y, std::string& strData)> ReadFunc;
+
+	TileArchiveWriter(const TileArchive::Info& info);
+
+	void Add(unsigned int nLevel, unsigned int x, unsigned int y);
+
+	unsigned long long GetNumTiles() const;
+
+	//tiles for which func returned false are left out of the index
+	bool Write(const QString& strFile, const ReadFunc& func);
+
+private:
+
+	TileArchive::Info m_info;
+
+	//(y, x) per level, sorted and made unique in Write
+	std::vector<std::vector<std::pair<unsigned int, unsigned int> > > m_vecLevels;
+};
+
+#endif // TILEARCHIVE_H
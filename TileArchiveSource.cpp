@@ -0,0 +1,156 @@
+#include "TileArchiveSource.h"
+
+#include <osgEarth/Registry>
+#include <osgDB/Registry>
+#include <osg/Image>
+#include <osg/Shape>
+
+#include <istream>
+#include <streambuf>
+#include <string.h>
+
+namespace
+{
+	//ֻڴ,ֱӴӳ
+	class MemoryStreamBuf : public std::streambuf
+	{
+	public:
+
+		MemoryStreamBuf(const unsigned char* pData, unsigned int nSize)
+		{
+			char* pBegin = const_cast<char*>(reinterpret_cast<const char*>(pData));
+			setg(pBegin, pBegin, pBegin + nSize);
+		}
+
+	protected:
+
+		virtual pos_type seekoff(off_type nOffset, std::ios_base::seekdir dir, std::ios_base::openmode mode) override
+		{
+			char* pPos = dir == std::ios_base::beg ? eback() : (dir == std::ios_base::cur ? gptr() : egptr());
+			pPos += nOffset;
+			if (!(mode & std::ios_base::in) || pPos < eback() || pPos > egptr())
+				return pos_type(off_type(-1));
+
+			setg(eback(), pPos, egptr());
+			return pos_type(pPos - eback());
+		}
+
+		virtual pos_type seekpos(pos_type pos, std::ios_base::openmode mode) override
+		{
+			return seekoff(off_type(pos), std::ios_base::beg, mode);
+		}
+	};
+}
+
+TileArchiveSource::TileArchiveSource(const QString& strFile)
+	: osgEarth::TileSource(osgEarth::TileSourceOptions())
+{
+	m_archive.Open(strFile);
+
+	const std::string& strFormat = m_archive.GetInfo().strFormat;
+	if (strFormat == "png" || strFormat == "jpg")
+		m_pReader = osgDB::Registry::instance()->getReaderWriterForExtension(strFormat);
+}
+
+TileArchiveSource::~TileArchiveSource()
+{
+
+}
+
+osgEarth::Status TileArchiveSource::initialize(const osgDB::Options* pDbOptions)
+{
+	if (!m_archive.IsOpen())
+		return osgEarth::Status::Error("Cannot open the tile archive");
+
+	const TileArchive::Info& info = m_archive.GetInfo();
+	if ((info.strFormat == "png" || info.strFormat == "jpg") && !m_pReader.valid())
+		return osgEarth::Status::Error("No reader for " + info.strFormat);
+
+	if (info.nProfile == TileArchive::PROFILE_MERCATOR)
+		setProfile(osgEarth::Registry::instance()->getSphericalMercatorProfile());
+	else
+		setProfile(osgEarth::Registry::instance()->getGlobalGeodeticProfile());
+
+	//㼶¼ݵзΧ,ԤͲȥҪΧƬ
+	for (unsigned int nLevel = info.nMinLevel; nLevel <= info.nMaxLevel; nLevel ++)
+	{
+		unsigned int nFirstRow, nRows, nFirstColumn, nColumns;
+		if (!m_archive.GetRowRange(nLevel, nFirstRow, nRows) || !m_archive.GetColumnRange(nLevel, nFirstColumn, nColumns))
+			continue;
+
+		unsigned int nTilesX, nTilesY;
+		getProfile()->getNumTiles(nLevel, nTilesX, nTilesY);
+
+		const osgEarth::GeoExtent& extent = getProfile()->getExtent();
+		double dTileWidth = extent.width() / nTilesX;
+		double dTileHeight = extent.height() / nTilesY;
+		double dWest = extent.xMin() + nFirstColumn * dTileWidth;
+		double dNorth = extent.yMax() - nFirstRow * dTileHeight;
+		osgEarth::GeoExtent tiles(getProfile()->getSRS(), dWest, dNorth - nRows * dTileHeight, dWest + nColumns * dTileWidth, dNorth);
+		getDataExtents().push_back(osgEarth::DataExtent(tiles, nLevel, nLevel));
+	}
+
+	return osgEarth::STATUS_OK;
+}
+
+osg::Image* TileArchiveSource::createImage(const osgEarth::TileKey& key, osgEarth::ProgressCallback* pProgress)
+{
+	const TileArchive::Info& info = m_archive.GetInfo();
+	if (info.nContent != TileArchive::CONTENT_IMAGE)
+		return nullptr;
+
+	unsigned int nSize = 0;
+	osg::ref_ptr<TileArchive::Window> pWindow;
+	const unsigned char* pData = m_archive.GetTile(key.getLevelOfDetail(), key.getTileX(), key.getTileY(), nSize, pWindow);
+	if (!pData)
+		return nullptr;
+
+	if (info.strFormat == "rgba")
+	{
+		unsigned int nTileSize = info.nTileSize;
+		if (nSize != nTileSize * nTileSize * 4)
+			return nullptr;
+
+		//Ψһһο: osgEarthܾ͵޸ͼ,ͼҲӳ䴰ڻó
+		osg::Image* pImage = new osg::Image;
+		pImage->allocateImage(nTileSize, nTileSize, 1, GL_RGBA, GL_UNSIGNED_BYTE);
+		pImage->setInternalTextureFormat(GL_RGBA8);
+		memcpy(pImage->data(), pData, nSize);
+		return pImage;
+	}
+
+	if (!m_pReader.valid())
+		return nullptr;
+
+	MemoryStreamBuf buf(pData, nSize);
+	std::istream stream(&buf);
+	osgDB::ReaderWriter::ReadResult result = m_pReader->readImage(stream);
+	return result.success() ? result.takeImage() : nullptr;
+}
+
+osg::HeightField* TileArchiveSource::createHeightField(const osgEarth::TileKey& key, osgEarth::ProgressCallback* pProgress)
+{
+	const TileArchive::Info& info = m_archive.GetInfo();
+	if (info.nContent != TileArchive::CONTENT_ELEVATION || info.strFormat != "f32")
+		return nullptr;
+
+	unsigned int nSize = 0;
+	osg::ref_ptr<TileArchive::Window> pWindow;
+	const unsigned char* pData = m_archive.GetTile(key.getLevelOfDetail(), key.getTileX(), key.getTileY(), nSize, pWindow);
+	unsigned int nTileSize = info.nTileSize;
+	if (!pData || nSize != nTileSize * nTileSize * sizeof(float))
+		return nullptr;
+
+	osg::HeightField* pHeightField = new osg::HeightField;
+	pHeightField->allocate(nTileSize, nTileSize);
+	memcpy(&pHeightField->getHeightList()[0], pData, nSize);
+	return pHeightField;
+}
+
+osgEarth::CachePolicy TileArchiveSource::getCachePolicyHint(const osgEarth::Profile* pTargetProfile) const
+{
+	//ͶӰƬֵû
+	if (!pTargetProfile || pTargetProfile->isHorizEquivalentTo(getProfile()))
+		return osgEarth::CachePolicy::NO_CACHE;
+	return osgEarth::CachePolicy::DEFAULT;
+}
@@ -0,0 +1,49 @@
+#ifndef TILEARCHIVESOURCE_H
+#define TILEARCHIVESOURCE_H
+
+#include "TileArchive.h"
+
+#include <osgEarth/TileSource>
+
+/**
+* osgEarth tile source over a TileArchive, for an ImageLayer or an
+* ElevationLayer depending on the archive content.
+*
+* Tiles are taken from the archive's mapped windows without a read: png and
+* jpg tiles are decoded straight from the mapping, f32 tiles are copied
+* once into the height field. rgba tiles are copied once into an image that
+* owns its data, since osgEarth may process images in place and an image
+* can outlive the window it came from.
+*/
+class TileArchiveSource : public osgEarth::TileSource
+{
+public:
+
+	TileArchiveSource(const QString& strFile);
+
+	bool IsOpen() const { return m_archive.IsOpen(); }
+
+	bool IsElevation() const { return m_archive.GetInfo().nContent == TileArchive::CONTENT_ELEVATION; }
+
+	const TileArchive& GetArchive() const { return m_archive; }
+
+	virtual osgEarth::Status initialize(const osgDB::Options* pDbOptions) override;
+
+	virtual osg::Image* createImage(const osgEarth::TileKey& key, osgEarth::ProgressCallback* pProgress) override;
+
+	virtual osg::HeightField* createHeightField(const osgEarth::TileKey& key, osgEarth::ProgressCallback* pProgress) override;
+
+	//the archive is a local mapped file, no need to go through the cache
+	virtual osgEarth::CachePolicy getCachePolicyHint(const osgEarth::Profile* pTargetProfile) const override;
+
+protected:
+
+	virtual ~TileArchiveSource();
+
+private:
+
+	TileArchive m_archive;
+	osg::ref_ptr<osgDB::ReaderWriter> m_pReader;
+};
+
+#endif // TILEARCHIVESOURCE_H
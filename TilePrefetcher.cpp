@@ -0,0 +1,246 @@
+#include "TilePrefetcher.h"
+#include "Metrics.h"
+
+#include <osgEarth/ImageLayer>
+#include <osgEarth/ElevationLayer>
+#include <osgEarth/TileKey>
+#include <OpenThreads/ScopedLock>
+
+#include <algorithm>
+#include <math.h>
+
+//ÿγȵ
+static const double s_dMetersPerDegree = 6371000.0 * osg::PI / 180.0;
+
+//osgEarthĬmin_tile_range_factorΪ6,Ƭ뾶ԼΪ߳0.7,С֮ʱϸ
+static const double s_dRangeFactor = 6.0 * 0.7;
+
+//ҰϸһƬǵĴ°뾶,ı
+static const double s_dViewRadius = 0.6;
+
+static const unsigned int s_nMaxLevel = 19;
+
+//סԤȡƬ,ͳƺȥ
+static const size_t s_nMaxDone = 4096;
+
+TilePrefetcher::TilePrefetcher(const osgEarth::Map* pMap, unsigned int nThreads, double dHorizon, double dStep)
+	: m_pMap(pMap)
+	, m_pProfile(pMap->getProfile())
+	, m_dHorizon(dHorizon)
+	, m_dStep(dStep)
+	, m_bEnabled(pMap->getCache() != nullptr)
+	, m_nVisibleLevel(0)
+	, m_nFetched(0)
+	, m_bQuit(false)
+{
+	//Ԥȡ߳ȼݿҳ߳,͵ǰҰԴ
+	for (unsigned int i = 0; i < std::max(nThreads, 1u); i ++)
+	{
+		Worker* pWorker = new Worker(this);
+		pWorker->setSchedulePriority(OpenThreads::Thread::THREAD_PRIORITY_LOW);
+		m_vecWorkers.push_back(pWorker);
+		pWorker->start();
+	}
+}
+
+TilePrefetcher::~TilePrefetcher()
+{
+	{
+		OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+		m_bQuit = true;
+		m_condition.broadcast();
+	}
+
+	for (unsigned int i = 0; i < m_vecWorkers.size(); i ++)
+	{
+		m_vecWorkers[i]->join();
+		delete m_vecWorkers[i];
+	}
+}
+
+unsigned long long TilePrefetcher::PackKey(unsigned int nLevel, unsigned int x, unsigned int y)
+{
+	return ((unsigned long long)nLevel << 58) | ((unsigned long long)y << 29) | x;
+}
+
+unsigned int TilePrefetcher::GetLevelForRange(double dRange) const
+{
+	double dWidth, dHeight;
+	m_pProfile->getTileDimensions(0, dWidth, dHeight);
+
+	//ʾǱ߳ /ϵ һ
+	double dLevel = ceil(log(dHeight * s_dMetersPerDegree * s_dRangeFactor / std::max(dRange, 1.0)) / log(2.0));
+	return (unsigned int)osg::clampBetween(dLevel, 0.0, (double)s_nMaxLevel);
+}
+
+void TilePrefetcher::CollectTiles(double dLon, double dLat, double dRadius, unsigned int nLevel, std::vector<unsigned long long>& vecKeys) const
+{
+	double dRadiusLat = dRadius / s_dMetersPerDegree;
+	double dRadiusLon = std::min(dRadiusLat / std::max(cos(osg::DegreesToRadians(dLat)), 0.01), 180.0);
+
+	double dWest = dLon - dRadiusLon;
+	double dEast = dLon + dRadiusLon;
+	if (dWest < -180.0)
+		dWest += 360.0;
+	if (dEast > 180.0)
+		dEast -= 360.0;
+
+	//180Ⱦʱwesteast,GeoExtentֳ
+	osgEarth::GeoExtent extent(osgEarth::SpatialReference::get("wgs84"), dWest
+		, std::max(dLat - dRadiusLat, -90.0), dEast, std::min(dLat + dRadiusLat, 90.0));
+
+	std::vector<osgEarth::TileKey> vecTiles;
+	m_pProfile->getIntersectingTiles(extent, nLevel, vecTiles);
+	for (size_t i = 0; i < vecTiles.size(); i ++)
+		vecKeys.push_back(PackKey(vecTiles[i].getLOD(), vecTiles[i].getTileX(), vecTiles[i].getTileY()));
+}
+
+void TilePrefetcher::Update(double dLon, double dLat, double dHeading, double dVelocity, double dRange)
+{
+	if (!m_bEnabled)
+		return;
+
+	unsigned int nLevel = GetLevelForRange(dRange);
+	double dRadius = dRange * s_dViewRadius;
+
+	//½ҰƬǷѾԤȡ;տʼ˲㼶ʱͳ,ǲǷɵ
+	m_vecVisible.clear();
+	CollectTiles(dLon, dLat, dRadius, nLevel, m_vecVisible);
+	bool bCount = !m_setVisible.empty() && nLevel == m_nVisibleLevel;
+	if (bCount)
+	{
+		OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+		for (size_t i = 0; i < m_vecVisible.size(); i ++)
+		{
+			if (m_setVisible.find(m_vecVisible[i]) != m_setVisible.end())
+				continue;
+
+			//ֻд˻Ƭҳֱ̲߳Ӷ
+			std::unordered_map<unsigned long long, bool>::const_iterator itr = m_mapDone.find(m_vecVisible[i]);
+			Metrics::Instance()->CountPrefetch(itr != m_mapDone.end() && itr->second);
+		}
+	}
+	m_setVisible.clear();
+	m_setVisible.insert(m_vecVisible.begin(), m_vecVisible.end());
+	m_nVisibleLevel = nLevel;
+
+	//غƽ,ȸ󱾼,ԽҰԽǰ
+	double dNorth = dVelocity * cos(osg::DegreesToRadians(dHeading));
+	double dEast = dVelocity * sin(osg::DegreesToRadians(dHeading));
+
+	m_vecPrediction.clear();
+	m_setListed.clear();
+	std::vector<unsigned long long> vecKeys;
+	for (double t = m_dStep; t <= m_dHorizon + 1e-6; t += m_dStep)
+	{
+		double dLatAhead = osg::clampBetween(dLat + dNorth * t / s_dMetersPerDegree, -90.0, 90.0);
+		double dLonAhead = dLon + dEast * t / (s_dMetersPerDegree * std::max(cos(osg::DegreesToRadians(dLatAhead)), 1e-6));
+		dLonAhead = fmod(dLonAhead + 540.0, 360.0) - 180.0;
+
+		vecKeys.clear();
+		if (nLevel > 0)
+			CollectTiles(dLonAhead, dLatAhead, dRadius, nLevel - 1, vecKeys);
+		CollectTiles(dLonAhead, dLatAhead, dRadius, nLevel, vecKeys);
+
+		for (size_t i = 0; i < vecKeys.size(); i ++)
+		{
+			if (m_setVisible.find(vecKeys[i]) == m_setVisible.end() && m_setListed.insert(vecKeys[i]).second)
+				m_vecPrediction.push_back(vecKeys[i]);
+		}
+	}
+
+	//µԤ滻ûȡ
+	OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+	m_dequeQueue.clear();
+	for (size_t i = 0; i < m_vecPrediction.size(); i ++)
+	{
+		if (m_mapDone.find(m_vecPrediction[i]) == m_mapDone.end())
+			m_dequeQueue.push_back(m_vecPrediction[i]);
+	}
+
+	if (!m_dequeQueue.empty())
+		m_condition.broadcast();
+}
+
+void TilePrefetcher::SetEnabled(bool bEnabled)
+{
+	//ûлʱȡƬûеط
+	m_bEnabled = bEnabled && m_pMap->getCache() != nullptr;
+	if (m_bEnabled)
+		return;
+
+	m_setVisible.clear();
+	OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+	m_dequeQueue.clear();
+}
+
+unsigned int TilePrefetcher::GetNumQueued() const
+{
+	OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+	return m_dequeQueue.size();
+}
+
+unsigned long long TilePrefetcher::GetNumFetched() const
+{
+	OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+	return m_nFetched;
+}
+
+bool TilePrefetcher::Fetch(unsigned long long nKey)
+{
+	osgEarth::TileKey key((unsigned int)(nKey >> 58), (unsigned int)(nKey & 0x1fffffff), (unsigned int)((nKey >> 29) & 0x1fffffff), m_pProfile.get());
+
+	//ͼԼĻ½,ﲻ;ûлͼȡҲȡ,
+	//ֱӵImageLayer::createImage,ԭʼƬ,ѹһ
+	bool bCached = false;
+	osgEarth::ImageLayerVector vecImageLayers;
+	m_pMap->getImageLayers(vecImageLayers);
+	for (size_t i = 0; i < vecImageLayers.size(); i ++)
+	{
+		if (vecImageLayers[i]->getEnabled() && vecImageLayers[i]->getCacheBin(m_pProfile.get()))
+			bCached = vecImageLayers[i]->osgEarth::ImageLayer::createImage(key).valid() || bCached;
+	}
+
+	osgEarth::ElevationLayerVector vecElevationLayers;
+	m_pMap->getElevationLayers(vecElevationLayers);
+	for (size_t i = 0; i < vecElevationLayers.size(); i ++)
+	{
+		if (vecElevationLayers[i]->getEnabled() && vecElevationLayers[i]->getCacheBin(m_pProfile.get()))
+			bCached = vecElevationLayers[i]->createHeightField(key).valid() || bCached;
+	}
+
+	return bCached;
+}
+
+void TilePrefetcher::Worker::run()
+{
+	for (;;)
+	{
+		unsigned long long nKey;
+		{
+			OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_pPrefetcher->m_mutex);
+			while (!m_pPrefetcher->m_bQuit && m_pPrefetcher->m_dequeQueue.empty())
+				m_pPrefetcher->m_condition.wait(&m_pPrefetcher->m_mutex);
+
+			if (m_pPrefetcher->m_bQuit)
+				return;
+
+			nKey = m_pPrefetcher->m_dequeQueue.front();
+			m_pPrefetcher->m_dequeQueue.pop_front();
+		}
+
+		bool bCached = m_pPrefetcher->Fetch(nKey);
+
+		OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_pPrefetcher->m_mutex);
+		m_pPrefetcher->m_nFetched ++;
+		if (m_pPrefetcher->m_mapDone.insert(std::make_pair(nKey, bCached)).second)
+		{
+			m_pPrefetcher->m_dequeDone.push_back(nKey);
+			if (m_pPrefetcher->m_dequeDone.size() > s_nMaxDone)
+			{
+				m_pPrefetcher->m_mapDone.erase(m_pPrefetcher->m_dequeDone.front());
+				m_pPrefetcher->m_dequeDone.pop_front();
+			}
+		}
+	}
+}
@@ -0,0 +1,108 @@
+#ifndef TILEPREFETCHER_H
+#define TILEPREFETCHER_H
+
+#include <osgEarth/Map>
+#include <osgEarth/Profile>
+
+#include <OpenThreads/Condition>
+#include <OpenThreads/Mutex>
+#include <OpenThreads/Thread>
+
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/**
+* Loads the terrain and imagery tiles the followed aircraft is about to fly
+* over before the view gets there.
+*
+* From the position, heading and ground speed of the followed track the
+* focal point is predicted every dStep seconds over the horizon. Around each
+* predicted point the tiles of the level the terrain engine will show at the
+* current camera range, and of its parent level, are listed soonest first;
+* this list replaces whatever was still queued, so the queue always follows
+* the latest prediction. Low priority worker threads take the tiles from the
+* queue and create them through every image and elevation layer of the map
+* that has a cache bin, which leaves them in the cache for the database
+* pager to find. Without a map cache the results would only be thrown away,
+* so the prefetcher stays disabled then.
+*
+* Each Update also counts the tiles entering the current view in Metrics: a
+* hit if a prefetch wrote the tile to the cache of at least one layer, so the
+* pager reads it from there, and a miss otherwise.
+*/
+class TilePrefetcher
+{
+public:
+
+	TilePrefetcher(const osgEarth::Map* pMap, unsigned int nThreads = 1, double dHorizon = 10.0, double dStep = 2.0);
+	~TilePrefetcher();
+
+	//called with every new position of the followed track; dRange is the camera range in meters
+	void Update(double dLon, double dLat, double dHeading, double dVelocity, double dRange);
+
+	//has no effect while the map has no cache
+	void SetEnabled(bool bEnabled);
+
+	bool IsEnabled() const { return m_bEnabled; }
+
+	//level the terrain engine shows around the focal point at camera range dRange
+	unsigned int GetLevelForRange(double dRange) const;
+
+	unsigned int GetNumQueued() const;
+
+	//tiles created by the workers since the start
+	unsigned long long GetNumFetched() const;
+
+private:
+
+	class Worker : public OpenThreads::Thread
+	{
+	public:
+
+		Worker(TilePrefetcher* pPrefetcher) : m_pPrefetcher(pPrefetcher) {}
+
+		virtual void run() override;
+
+	private:
+
+		TilePrefetcher* m_pPrefetcher;
+	};
+
+	//level, x and y packed into one number
+	static unsigned long long PackKey(unsigned int nLevel, unsigned int x, unsigned int y);
+
+	//tiles of nLevel covering dRadius meters around (dLon, dLat), appended to vecKeys
+	void CollectTiles(double dLon, double dLat, double dRadius, unsigned int nLevel, std::vector<unsigned long long>& vecKeys) const;
+
+	//true if at least one layer wrote the tile to its cache
+	bool Fetch(unsigned long long nKey);
+
+	osg::ref_ptr<const osgEarth::Map> m_pMap;
+	osg::ref_ptr<const osgEarth::Profile> m_pProfile;
+	double m_dHorizon;
+	double m_dStep;
+	bool m_bEnabled;
+
+	//caller thread only
+	std::vector<unsigned long long> m_vecPrediction;
+	std::unordered_set<unsigned long long> m_setListed;
+	std::unordered_set<unsigned long long> m_setVisible;
+	std::vector<unsigned long long> m_vecVisible;
+	unsigned int m_nVisibleLevel;
+
+	//shared with the workers, guarded by m_mutex
+	mutable OpenThreads::Mutex m_mutex;
+	OpenThreads::Condition m_condition;
+	std::deque<unsigned long long> m_dequeQueue;
+	//tiles fetched recently and whether they reached a cache
+	std::unordered_map<unsigned long long, bool> m_mapDone;
+	std::deque<unsigned long long> m_dequeDone;
+	unsigned long long m_nFetched;
+	bool m_bQuit;
+
+	std::vector<Worker*> m_vecWorkers;
+};
+
+#endif // TILEPREFETCHER_H
@@ -0,0 +1,208 @@
+#include "Trace.h"
+
+#include <osg/NodeCallback>
+#include <osg/Camera>
+#include <osgViewer/Viewer>
+
+#include <OpenThreads/Mutex>
+#include <OpenThreads/ScopedLock>
+
+#include <atomic>
+#include <vector>
+#include <stdio.h>
+
+#ifdef _MSC_VER
+#define RM_THREAD_LOCAL __declspec(thread)
+#else
+#define RM_THREAD_LOCAL __thread
+#endif
+
+namespace
+{
+	//ÿ̵߳ĻλС
+	enum { RING_SIZE = 16384 };
+
+	struct TraceEvent
+	{
+		const char* pName;
+		osg::Timer_t tickStart;
+		osg::Timer_t tickEnd;
+	};
+
+	struct TraceRing
+	{
+		unsigned int nThreadId;
+
+		//total number of zones written, the slot is nHead % RING_SIZE
+		std::atomic<unsigned int> nHead;
+		TraceEvent events[RING_SIZE];
+	};
+
+	//rings are registered once per thread and never freed, so a dump can always read them
+	OpenThreads::Mutex s_mutexRings;
+	std::vector<TraceRing*> s_vecRings;
+
+	RM_THREAD_LOCAL TraceRing* s_pRing = nullptr;
+
+	TraceRing* CreateRing()
+	{
+		TraceRing* pRing = new TraceRing;
+		pRing->nHead.store(0);
+
+		OpenThreads::ScopedLock<OpenThreads::Mutex> lock(s_mutexRings);
+		pRing->nThreadId = s_vecRings.size() + 1;
+		s_vecRings.push_back(pRing);
+		return pRing;
+	}
+
+	class TraceUpdateCallback : public osg::NodeCallback
+	{
+	public:
+
+		virtual void operator()(osg::Node* node, osg::NodeVisitor* nv)
+		{
+			TraceZone zone("viewer update");
+			traverse(node, nv);
+		}
+	};
+
+	class TraceCullCallback : public osg::NodeCallback
+	{
+	public:
+
+		virtual void operator()(osg::Node* node, osg::NodeVisitor* nv)
+		{
+			TraceZone zone("viewer cull");
+			traverse(node, nv);
+		}
+	};
+
+	//the draw zone spans from the pre to the post draw callback of the camera;
+	//the final draw callback is left to the screen capture handler
+	class TraceDrawCallback : public osg::Camera::DrawCallback
+	{
+	public:
+
+		TraceDrawCallback(bool bStart, osg::Timer_t* pTickStart)
+			: m_bStart(bStart)
+			, m_pTickStart(pTickStart)
+		{
+		}
+
+		virtual void operator()(osg::RenderInfo& renderInfo) const
+		{
+			if (m_bStart)
+				*m_pTickStart = osg::Timer::instance()->tick();
+			else if (*m_pTickStart != 0)
+				TraceRecord("viewer draw", *m_pTickStart, osg::Timer::instance()->tick());
+		}
+
+	private:
+
+		bool m_bStart;
+		osg::Timer_t* m_pTickStart;
+	};
+
+	osg::Timer_t s_tickDrawStart = 0;
+}
+
+void TraceRecord(const char* pName, osg::Timer_t tickStart, osg::Timer_t tickEnd)
+{
+	TraceRing* pRing = s_pRing;
+	if (!pRing)
+	{
+		pRing = CreateRing();
+		s_pRing = pRing;
+	}
+
+	//ֻб߳д,ʱrelease֤߿¼
+	unsigned int nHead = pRing->nHead.load(std::memory_order_relaxed);
+	TraceEvent& event = pRing->events[nHead % RING_SIZE];
+	event.pName = pName;
+	event.tickStart = tickStart;
+	event.tickEnd = tickEnd;
+	pRing->nHead.store(nHead + 1, std::memory_order_release);
+}
+
+void TraceInstallViewer(osgViewer::Viewer* pViewer)
+{
+	osg::Camera* pCamera = pViewer->getCamera();
+	pCamera->addCullCallback(new TraceCullCallback);
+	pCamera->setPreDrawCallback(new TraceDrawCallback(true, &s_tickDrawStart));
+	pCamera->setPostDrawCallback(new TraceDrawCallback(false, &s_tickDrawStart));
+
+	if (pViewer->getSceneData())
+		pViewer->getSceneData()->addUpdateCallback(new TraceUpdateCallback);
+}
+
+static void AppendEscaped(std::string& strOut, const char* pText)
+{
+	for (; *pText; pText ++)
+	{
+		if (*pText == '"' || *pText == '\\')
+			strOut += '\\';
+		strOut += *pText;
+	}
+}
+
+bool TraceDump(const std::string& strFileName, double dSeconds)
+{
+	osg::Timer* pTimer = osg::Timer::instance();
+	osg::Timer_t tickNow = pTimer->tick();
+
+	std::vector<TraceRing*> vecRings;
+	{
+		OpenThreads::ScopedLock<OpenThreads::Mutex> lock(s_mutexRings);
+		vecRings = s_vecRings;
+	}
+
+	std::string strOut = "{\"traceEvents\":[\n";
+	bool bFirst = true;
+	char szLine[256];
+
+	for (unsigned int i = 0; i < vecRings.size(); i ++)
+	{
+		TraceRing* pRing = vecRings[i];
+
+		sprintf(szLine, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}",
+			bFirst ? "" : ",\n", pRing->nThreadId, pRing->nThreadId);
+		strOut += szLine;
+		bFirst = false;
+
+		//ȿ,ٶڼܱǵ¼
+		unsigned int nHead = pRing->nHead.load(std::memory_order_acquire);
+		unsigned int nCount = nHead < RING_SIZE ? nHead : RING_SIZE;
+		std::vector<TraceEvent> vecEvents(nCount);
+		for (unsigned int n = 0; n < nCount; n ++)
+			vecEvents[n] = pRing->events[(nHead - nCount + n) % RING_SIZE];
+
+		//ȻЧ֮¼ſ,дһҲҪų
+		unsigned int nHeadAfter = pRing->nHead.load(std::memory_order_acquire);
+		long long nFirstValid = (long long)nHeadAfter - RING_SIZE + 1;
+		long long nFirstCopied = (long long)nHead - nCount;
+		unsigned int nFirst = nFirstValid > nFirstCopied ? (unsigned int)osg::minimum(nFirstValid - nFirstCopied, (long long)nCount) : 0;
+
+		for (unsigned int n = nFirst; n < nCount; n ++)
+		{
+			const TraceEvent& event = vecEvents[n];
+			if (pTimer->delta_s(event.tickEnd, tickNow) > dSeconds)
+				continue;
+
+			strOut += ",\n{\"name\":\"";
+			AppendEscaped(strOut, event.pName);
+			sprintf(szLine, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+				pRing->nThreadId, pTimer->delta_u(pTimer->getStartTick(), event.tickStart), pTimer->delta_u(event.tickStart, event.tickEnd));
+			strOut += szLine;
+		}
+	}
+
+	strOut += "\n]}\n";
+
+	FILE* pFile = fopen(strFileName.c_str(), "wb");
+	if (!pFile)
+		return false;
+
+	bool bRes = fwrite(strOut.data(), 1, strOut.size(), pFile) == strOut.size();
+	fclose(pFile);
+	return bRes;
+}
@@ -0,0 +1,62 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <osg/Timer>
+#include <string>
+
+namespace osgViewer { class Viewer; }
+
+/**
+* Scoped-zone tracer for finding frame spikes.
+*
+* RM_TRACE_ZONE("name") records the time spent until the end of the enclosing
+* scope into a ring buffer owned by the calling thread; the name must be a
+* string literal. Writing a zone takes no lock. TraceDump() writes the zones
+* of the last seconds of every thread as Chrome trace-event JSON, which
+* chrome://tracing and Perfetto open directly.
+*
+* Without ROUTEMONITOR_TRACE the macro expands to nothing.
+*/
+
+//records one finished zone into the calling thread's ring
+void TraceRecord(const char* pName, osg::Timer_t tickStart, osg::Timer_t tickEnd);
+
+//wraps update, cull and draw of the viewer's master camera into zones
+void TraceInstallViewer(osgViewer::Viewer* pViewer);
+
+//writes the zones that ended within the last dSeconds, false if the file can't be written
+bool TraceDump(const std::string& strFileName, double dSeconds);
+
+class TraceZone
+{
+public:
+
+	explicit TraceZone(const char* pName)
+		: m_pName(pName)
+		, m_tickStart(osg::Timer::instance()->tick())
+	{
+	}
+
+	~TraceZone()
+	{
+		TraceRecord(m_pName, m_tickStart, osg::Timer::instance()->tick());
+	}
+
+private:
+
+	TraceZone(const TraceZone&);
+	TraceZone& operator=(const TraceZone&);
+
+	const char* m_pName;
+	osg::Timer_t m_tickStart;
+};
+
+#ifdef ROUTEMONITOR_TRACE
+#define RM_TRACE_CONCAT_IMPL(a, b) a##b
+#define RM_TRACE_CONCAT(a, b) RM_TRACE_CONCAT_IMPL(a, b)
+#define RM_TRACE_ZONE(name) TraceZone RM_TRACE_CONCAT(traceZone, __LINE__)(name)
+#else
+#define RM_TRACE_ZONE(name)
+#endif
+
+#endif // TRACE_H
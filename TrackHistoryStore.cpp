@@ -0,0 +1,543 @@
+#include "TrackHistoryStore.h"
+#include "Metrics.h"
+
+#include <QDir>
+
+#include <OpenThreads/ScopedLock>
+
+#include <algorithm>
+#include <float.h>
+#include <string.h>
+
+//ļͷ: 4ֽڱʶ,汾,¼,
+static const int s_nHeaderSize = 16;
+static const unsigned int s_nVersion = 1;
+
+//ÿļռ: ʱ//γȸ8ֽ,߶/4ֽ
+static const int s_nPointSize = 32;
+
+//ݿ໺ôֽ
+static const qint64 s_nMaxCachedBytes = 16 * 1024 * 1024;
+
+static bool WriteHeader(QFile& file, const char* pMagic, unsigned int nRecordSize)
+{
+	char szHeader[s_nHeaderSize];
+	memset(szHeader, 0, sizeof(szHeader));
+	memcpy(szHeader, pMagic, 4);
+	memcpy(szHeader + 4, &s_nVersion, 4);
+	memcpy(szHeader + 8, &nRecordSize, 4);
+	return file.write(szHeader, sizeof(szHeader)) == sizeof(szHeader);
+}
+
+static bool CheckHeader(QFile& file, const char* pMagic, unsigned int nRecordSize)
+{
+	char szHeader[s_nHeaderSize];
+	if (file.read(szHeader, sizeof(szHeader)) != sizeof(szHeader))
+		return false;
+
+	unsigned int nVersion, nFileRecordSize;
+	memcpy(&nVersion, szHeader + 4, 4);
+	memcpy(&nFileRecordSize, szHeader + 8, 4);
+	return memcmp(szHeader, pMagic, 4) == 0 && nVersion == s_nVersion && nFileRecordSize == nRecordSize;
+}
+
+TrackHistoryStore::TrackHistoryStore()
+{
+	m_nDataSize = 0;
+	m_nCachedBytes = 0;
+	m_dTimeMin = DBL_MAX;
+	m_dTimeMax = -DBL_MAX;
+}
+
+TrackHistoryStore::~TrackHistoryStore()
+{
+	Close();
+}
+
+bool TrackHistoryStore::Open(const QString& strDir)
+{
+	Close();
+
+	OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+
+	QDir().mkpath(strDir);
+	m_fileIndex.setFileName(strDir + "/history.idx");
+	m_fileData.setFileName(strDir + "/history.dat");
+	if (!m_fileIndex.open(QIODevice::ReadWrite) || !m_fileData.open(QIODevice::ReadWrite))
+	{
+		m_fileIndex.close();
+		m_fileData.close();
+		return false;
+	}
+
+	bool bOk;
+	if (m_fileIndex.size() == 0 && m_fileData.size() == 0)
+		bOk = WriteHeader(m_fileIndex, "RMTI", sizeof(ChunkRecord)) && WriteHeader(m_fileData, "RMTD", s_nPointSize);
+	else
+		bOk = CheckHeader(m_fileIndex, "RMTI", sizeof(ChunkRecord)) && CheckHeader(m_fileData, "RMTD", s_nPointSize);
+
+	if (!bOk)
+	{
+		m_fileIndex.close();
+		m_fileData.close();
+		return false;
+	}
+
+	m_fileIndex.flush();
+	m_fileData.flush();
+
+	//ڴ;ʱдһļ¼ûݿ,ӵһЧ¼ʼص
+	qint64 nDataFileSize = m_fileData.size();
+	unsigned int nRecords = (unsigned int)((m_fileIndex.size() - s_nHeaderSize) / sizeof(ChunkRecord));
+	m_nDataSize = s_nHeaderSize;
+	m_vecRecords.resize(nRecords);
+
+	qint64 nIndexBytes = (qint64)nRecords * sizeof(ChunkRecord);
+	if (nRecords > 0 && (!m_fileIndex.seek(s_nHeaderSize) || m_fileIndex.read(reinterpret_cast<char*>(&m_vecRecords[0]), nIndexBytes) != nIndexBytes))
+	{
+		m_vecRecords.clear();
+		m_fileIndex.close();
+		m_fileData.close();
+		return false;
+	}
+
+	unsigned int nValid = 0;
+	for (; nValid < nRecords; nValid ++)
+	{
+		const ChunkRecord& record = m_vecRecords[nValid];
+		qint64 nEnd = record.nOffset + (qint64)record.nCount * s_nPointSize;
+		if (record.nOffset != m_nDataSize || record.nCount == 0 || record.nCount > CHUNK_POINTS || nEnd > nDataFileSize)
+			break;
+
+		m_nDataSize = nEnd;
+	}
+
+	m_vecRecords.resize(nValid);
+	m_fileIndex.resize(s_nHeaderSize + (qint64)nValid * sizeof(ChunkRecord));
+	m_fileData.resize(m_nDataSize);
+
+	for (unsigned int i = 0; i < m_vecRecords.size(); i ++)
+		IndexRecord(i, m_vecRecords[i]);
+
+	return true;
+}
+
+void TrackHistoryStore::Close()
+{
+	Flush();
+
+	OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+
+	m_fileIndex.close();
+	m_fileData.close();
+
+	m_vecRecords.clear();
+	m_nDataSize = 0;
+	m_dTimeMin = DBL_MAX;
+	m_dTimeMax = -DBL_MAX;
+	m_mapTrackRecords.clear();
+	m_mapBuckets.clear();
+	m_mapPending.clear();
+	m_mapChunks.clear();
+	m_dequeChunks.clear();
+	m_nCachedBytes = 0;
+}
+
+void TrackHistoryStore::Append(unsigned int nId, double dTime, double dLon, double dLat, double dAlt, double dHeading)
+{
+	OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+
+	if (!m_fileIndex.isOpen())
+		return;
+
+	//дʧʱڻ,һ㵽ʱ
+	Pending& pending = m_mapPending[nId];
+	while (!pending.vecTime.empty() && (pending.vecTime.size() >= CHUNK_POINTS || dTime - pending.vecTime[0] >= CHUNK_SECONDS))
+	{
+		if (!WriteChunk(nId, pending))
+			break;
+	}
+
+	m_dTimeMin = std::min(m_dTimeMin, dTime);
+	m_dTimeMax = std::max(m_dTimeMax, dTime);
+
+	pending.vecTime.push_back(dTime);
+	pending.vecLon.push_back(dLon);
+	pending.vecLat.push_back(dLat);
+	pending.vecAlt.push_back((float)dAlt);
+	pending.vecHeading.push_back((float)dHeading);
+}
+
+void TrackHistoryStore::Flush()
+{
+	OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+
+	if (!m_fileIndex.isOpen())
+		return;
+
+	for (std::unordered_map<unsigned int, Pending>::iterator it = m_mapPending.begin(); it != m_mapPending.end(); )
+	{
+		while (!it->second.vecTime.empty())
+		{
+			if (!WriteChunk(it->first, it->second))
+				break;
+		}
+
+		if (it->second.vecTime.empty())
+			it = m_mapPending.erase(it);
+		else
+			++ it;
+	}
+}
+
+bool TrackHistoryStore::WriteChunk(unsigned int nId, Pending& pending)
+{
+	//дʧܺ󻺳ĵܳһ,ÿֻдͷһɵĲ
+	unsigned int nCount = 1;
+	while (nCount < pending.vecTime.size() && nCount < CHUNK_POINTS && pending.vecTime[nCount] - pending.vecTime[0] < CHUNK_SECONDS)
+		nCount ++;
+
+	ChunkRecord record;
+	memset(&record, 0, sizeof(record));
+	record.nId = nId;
+	record.nCount = nCount;
+	record.dTimeMin = record.dTimeMax = pending.vecTime[0];
+	record.dLonMin = record.dLonMax = pending.vecLon[0];
+	record.dLatMin = record.dLatMax = pending.vecLat[0];
+	record.nOffset = m_nDataSize;
+
+	for (unsigned int i = 1; i < nCount; i ++)
+	{
+		record.dTimeMin = std::min(record.dTimeMin, pending.vecTime[i]);
+		record.dTimeMax = std::max(record.dTimeMax, pending.vecTime[i]);
+		record.dLonMin = std::min(record.dLonMin, pending.vecLon[i]);
+		record.dLonMax = std::max(record.dLonMax, pending.vecLon[i]);
+		record.dLatMin = std::min(record.dLatMin, pending.vecLat[i]);
+		record.dLatMax = std::max(record.dLatMax, pending.vecLat[i]);
+	}
+
+	//д,ѯʱֻҪ˳ɨҪ
+	QByteArray arrayChunk(nCount * s_nPointSize, 0);
+	char* pData = arrayChunk.data();
+	memcpy(pData, &pending.vecTime[0], nCount * sizeof(double));
+	pData += nCount * sizeof(double);
+	memcpy(pData, &pending.vecLon[0], nCount * sizeof(double));
+	pData += nCount * sizeof(double);
+	memcpy(pData, &pending.vecLat[0], nCount * sizeof(double));
+	pData += nCount * sizeof(double);
+	memcpy(pData, &pending.vecAlt[0], nCount * sizeof(float));
+	pData += nCount * sizeof(float);
+	memcpy(pData, &pending.vecHeading[0], nCount * sizeof(float));
+
+	//дд,ʱඪһ
+	//дһʱ´δͬһλд,дʧʱҲᱻд
+	m_fileData.seek(m_nDataSize);
+	if (m_fileData.write(arrayChunk) != arrayChunk.size() || !m_fileData.flush())
+	{
+		Metrics::Instance()->CountHistoryWriteError();
+		return false;
+	}
+
+	m_fileIndex.seek(s_nHeaderSize + (qint64)m_vecRecords.size() * sizeof(ChunkRecord));
+	if (m_fileIndex.write(reinterpret_cast<const char*>(&record), sizeof(record)) != sizeof(record) || !m_fileIndex.flush())
+	{
+		Metrics::Instance()->CountHistoryWriteError();
+		return false;
+	}
+
+	m_nDataSize += arrayChunk.size();
+	m_vecRecords.push_back(record);
+	IndexRecord(m_vecRecords.size() - 1, record);
+
+	pending.vecTime.erase(pending.vecTime.begin(), pending.vecTime.begin() + nCount);
+	pending.vecLon.erase(pending.vecLon.begin(), pending.vecLon.begin() + nCount);
+	pending.vecLat.erase(pending.vecLat.begin(), pending.vecLat.begin() + nCount);
+	pending.vecAlt.erase(pending.vecAlt.begin(), pending.vecAlt.begin() + nCount);
+	pending.vecHeading.erase(pending.vecHeading.begin(), pending.vecHeading.begin() + nCount);
+	return true;
+}
+
+void TrackHistoryStore::IndexRecord(unsigned int nRecord, const ChunkRecord& record)
+{
+	m_mapTrackRecords[record.nId].push_back(nRecord);
+	m_dTimeMin = std::min(m_dTimeMin, record.dTimeMin);
+	m_dTimeMax = std::max(m_dTimeMax, record.dTimeMax);
+
+	long long nLast = Bucket(record.dTimeMax);
+	for (long long nBucket = Bucket(record.dTimeMin); nBucket <= nLast; nBucket ++)
+		m_mapBuckets[nBucket].push_back(nRecord);
+}
+
+const double* TrackHistoryStore::LoadChunk(const ChunkRecord& record)
+{
+	std::unordered_map<qint64, std::vector<double> >::const_iterator it = m_mapChunks.find(record.nOffset);
+	if (it != m_mapChunks.end())
+		return &it->second[0];
+
+	qint64 nBytes = (qint64)record.nCount * s_nPointSize;
+	while (!m_dequeChunks.empty() && m_nCachedBytes + nBytes > s_nMaxCachedBytes)
+	{
+		m_nCachedBytes -= (qint64)m_mapChunks[m_dequeChunks.front()].size() * sizeof(double);
+		m_mapChunks.erase(m_dequeChunks.front());
+		m_dequeChunks.pop_front();
+	}
+
+	//double,пֱӰ
+	std::vector<double>& vecChunk = m_mapChunks[record.nOffset];
+	vecChunk.resize(nBytes / sizeof(double));
+	if (!m_fileData.seek(record.nOffset) || m_fileData.read(reinterpret_cast<char*>(&vecChunk[0]), nBytes) != nBytes)
+	{
+		m_mapChunks.erase(record.nOffset);
+		return nullptr;
+	}
+
+	m_dequeChunks.push_back(record.nOffset);
+	m_nCachedBytes += nBytes;
+	return &vecChunk[0];
+}
+
+void TrackHistoryStore::ReadChunk(const ChunkRecord& record, double dBegin, double dEnd, const double* pBox, std::vector<Sample>& vecSamples)
+{
+	const double* pTime = LoadChunk(record);
+	if (!pTime)
+		return;
+
+	unsigned int nCount = record.nCount;
+	const double* pLon = pTime + nCount;
+	const double* pLat = pLon + nCount;
+	const float* pAlt = reinterpret_cast<const float*>(pLat + nCount);
+	const float* pHeading = pAlt + nCount;
+
+	Sample sample;
+	sample.nId = record.nId;
+	for (unsigned int i = 0; i < nCount; i ++)
+	{
+		if (pTime[i] < dBegin || pTime[i] > dEnd)
+			continue;
+
+		if (pBox && (pLon[i] < pBox[0] || pLat[i] < pBox[1] || pLon[i] > pBox[2] || pLat[i] > pBox[3]))
+			continue;
+
+		sample.dTime = pTime[i];
+		sample.dLon = pLon[i];
+		sample.dLat = pLat[i];
+		sample.dAlt = pAlt[i];
+		sample.dHeading = pHeading[i];
+		vecSamples.push_back(sample);
+	}
+}
+
+void TrackHistoryStore::ReadPending(unsigned int nId, const Pending& pending, double dBegin, double dEnd, const double* pBox, std::vector<Sample>& vecSamples) const
+{
+	Sample sample;
+	sample.nId = nId;
+	for (unsigned int i = 0; i < pending.vecTime.size(); i ++)
+	{
+		if (pending.vecTime[i] < dBegin || pending.vecTime[i] > dEnd)
+			continue;
+
+		if (pBox && (pending.vecLon[i] < pBox[0] || pending.vecLat[i] < pBox[1] || pending.vecLon[i] > pBox[2] || pending.vecLat[i] > pBox[3]))
+			continue;
+
+		sample.dTime = pending.vecTime[i];
+		sample.dLon = pending.vecLon[i];
+		sample.dLat = pending.vecLat[i];
+		sample.dAlt = pending.vecAlt[i];
+		sample.dHeading = pending.vecHeading[i];
+		vecSamples.push_back(sample);
+	}
+}
+
+unsigned int TrackHistoryStore::QueryTrack(unsigned int nId, double dBegin, double dEnd, std::vector<Sample>& vecSamples)
+{
+	OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+
+	if (!m_fileIndex.isOpen())
+		return 0;
+
+	unsigned int nStart = vecSamples.size();
+
+	std::unordered_map<unsigned int, std::vector<unsigned int> >::const_iterator itRecords = m_mapTrackRecords.find(nId);
+	if (itRecords != m_mapTrackRecords.end())
+	{
+		const std::vector<unsigned int>& vecRecords = itRecords->second;
+		for (unsigned int i = FindFirstRecord(vecRecords, dBegin); i < vecRecords.size(); i ++)
+		{
+			const ChunkRecord& record = *GetRecord(vecRecords[i]);
+			if (record.dTimeMin > dEnd)
+				break;
+
+			ReadChunk(record, dBegin, dEnd, nullptr, vecSamples);
+		}
+	}
+
+	std::unordered_map<unsigned int, Pending>::const_iterator itPending = m_mapPending.find(nId);
+	if (itPending != m_mapPending.end())
+		ReadPending(nId, itPending->second, dBegin, dEnd, nullptr, vecSamples);
+
+	return vecSamples.size() - nStart;
+}
+
+unsigned int TrackHistoryStore::QueryBox(double dBegin, double dEnd, double dLonMin, double dLatMin, double dLonMax, double dLatMax, std::vector<Sample>& vecSamples)
+{
+	OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+
+	if (!m_fileIndex.isOpen() || dBegin > dEnd)
+		return 0;
+
+	unsigned int nStart = vecSamples.size();
+	double pBox[4] = { dLonMin, dLatMin, dLonMax, dLatMax };
+
+	long long nFirst = Bucket(std::max(dBegin, -1e15));
+	long long nLast = Bucket(std::min(dEnd, 1e15));
+	if ((unsigned long long)(nLast - nFirst) >= m_mapBuckets.size())
+	{
+		//ʱ䷶Χеʱλ,ֱɨȫ
+		for (unsigned int i = 0; i < m_vecRecords.size(); i ++)
+		{
+			const ChunkRecord& record = *GetRecord(i);
+			if (record.dTimeMax >= dBegin && record.dTimeMin <= dEnd
+				&& record.dLonMax >= dLonMin && record.dLonMin <= dLonMax && record.dLatMax >= dLatMin && record.dLatMin <= dLatMax)
+			{
+				ReadChunk(record, dBegin, dEnd, pBox, vecSamples);
+			}
+		}
+	}
+	else
+	{
+		for (long long nBucket = nFirst; nBucket <= nLast; nBucket ++)
+		{
+			std::unordered_map<long long, std::vector<unsigned int> >::const_iterator it = m_mapBuckets.find(nBucket);
+			if (it == m_mapBuckets.end())
+				continue;
+
+			for (unsigned int i = 0; i < it->second.size(); i ++)
+			{
+				const ChunkRecord& record = *GetRecord(it->second[i]);
+
+				//ʱεĿֻڲѯΧڵĵһʱδһ
+				if (Bucket(std::max(record.dTimeMin, dBegin)) != nBucket)
+					continue;
+
+				if (record.dTimeMax >= dBegin && record.dTimeMin <= dEnd
+					&& record.dLonMax >= dLonMin && record.dLonMin <= dLonMax && record.dLatMax >= dLatMin && record.dLatMin <= dLatMax)
+				{
+					ReadChunk(record, dBegin, dEnd, pBox, vecSamples);
+				}
+			}
+		}
+	}
+
+	for (std::unordered_map<unsigned int, Pending>::const_iterator it = m_mapPending.begin(); it != m_mapPending.end(); ++ it)
+		ReadPending(it->first, it->second, dBegin, dEnd, pBox, vecSamples);
+
+	return vecSamples.size() - nStart;
+}
+
+void TrackHistoryStore::ReadPoint(const ChunkRecord& record, const double* pChunk, unsigned int nPoint, Sample& sample) const
+{
+	unsigned int nCount = record.nCount;
+	const double* pTime = pChunk;
+	const float* pAlt = reinterpret_cast<const float*>(pTime + 3 * nCount);
+
+	sample.nId = record.nId;
+	sample.dTime = pTime[nPoint];
+	sample.dLon = pTime[nCount + nPoint];
+	sample.dLat = pTime[2 * nCount + nPoint];
+	sample.dAlt = pAlt[nPoint];
+	sample.dHeading = pAlt[nCount + nPoint];
+}
+
+unsigned int TrackHistoryStore::FindFirstRecord(const std::vector<unsigned int>& vecRecords, double dTime) const
+{
+	unsigned int nLow = 0;
+	unsigned int nHigh = vecRecords.size();
+	while (nLow < nHigh)
+	{
+		unsigned int nMid = (nLow + nHigh) / 2;
+		if (GetRecord(vecRecords[nMid])->dTimeMax < dTime)
+			nLow = nMid + 1;
+		else
+			nHigh = nMid;
+	}
+
+	return nLow;
+}
+
+bool TrackHistoryStore::SampleAt(unsigned int nId, double dTime, Sample& sample)
+{
+	OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+
+	if (!m_fileIndex.isOpen())
+		return false;
+
+	//ûд̵ĵ,Ȳ
+	std::unordered_map<unsigned int, Pending>::const_iterator itPending = m_mapPending.find(nId);
+	if (itPending != m_mapPending.end() && !itPending->second.vecTime.empty() && itPending->second.vecTime[0] <= dTime)
+	{
+		const Pending& pending = itPending->second;
+		size_t n = std::upper_bound(pending.vecTime.begin(), pending.vecTime.end(), dTime) - pending.vecTime.begin() - 1;
+
+		sample.nId = nId;
+		sample.dTime = pending.vecTime[n];
+		sample.dLon = pending.vecLon[n];
+		sample.dLat = pending.vecLat[n];
+		sample.dAlt = pending.vecAlt[n];
+		sample.dHeading = pending.vecHeading[n];
+		return true;
+	}
+
+	std::unordered_map<unsigned int, std::vector<unsigned int> >::const_iterator itRecords = m_mapTrackRecords.find(nId);
+	if (itRecords == m_mapTrackRecords.end())
+		return false;
+
+	const std::vector<unsigned int>& vecRecords = itRecords->second;
+	unsigned int i = FindFirstRecord(vecRecords, dTime);
+	if (i < vecRecords.size() && GetRecord(vecRecords[i])->dTimeMin <= dTime)
+	{
+		const ChunkRecord& record = *GetRecord(vecRecords[i]);
+		const double* pTime = LoadChunk(record);
+		if (!pTime)
+			return false;
+
+		unsigned int n = std::upper_bound(pTime, pTime + record.nCount, dTime) - pTime - 1;
+		ReadPoint(record, pTime, n, sample);
+		return true;
+	}
+
+	//dTime֮п֮,ȡǰһһ
+	if (i == 0)
+		return false;
+
+	const ChunkRecord& record = *GetRecord(vecRecords[i - 1]);
+	const double* pChunk = LoadChunk(record);
+	if (!pChunk)
+		return false;
+
+	ReadPoint(record, pChunk, record.nCount - 1, sample);
+	return true;
+}
+
+void TrackHistoryStore::GetTrackIds(std::vector<unsigned int>& vecIds)
+{
+	OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+
+	vecIds.clear();
+	for (std::unordered_map<unsigned int, std::vector<unsigned int> >::const_iterator it = m_mapTrackRecords.begin(); it != m_mapTrackRecords.end(); ++ it)
+		vecIds.push_back(it->first);
+
+	for (std::unordered_map<unsigned int, Pending>::const_iterator it = m_mapPending.begin(); it != m_mapPending.end(); ++ it)
+	{
+		if (!it->second.vecTime.empty() && m_mapTrackRecords.find(it->first) == m_mapTrackRecords.end())
+			vecIds.push_back(it->first);
+	}
+}
+
+bool TrackHistoryStore::GetTimeRange(double& dBegin, double& dEnd)
+{
+	OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+
+	dBegin = m_dTimeMin;
+	dEnd = m_dTimeMax;
+	return m_dTimeMin <= m_dTimeMax;
+}
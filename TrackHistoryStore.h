@@ -0,0 +1,150 @@
+#ifndef TRACKHISTORYSTORE_H
+#define TRACKHISTORYSTORE_H
+
+#include <QFile>
+#include <QString>
+
+#include <OpenThreads/Mutex>
+
+#include <math.h>
+
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+/**
+* Append-only on-disk history of every track position.
+*
+* Positions are buffered per track and written as columnar chunks of at
+* most CHUNK_POINTS points (all times, then all lons, lats, alts and
+* headings) to history.dat. Every chunk gets a fixed-size record in
+* history.idx with its track, time span and bounding box. The index records
+* are kept in memory (64 bytes per chunk, a few MB per day), the data file
+* is never mapped: a query reads only the chunks it touches at their
+* offsets, through a small cache bounded in bytes, so the address space used
+* does not grow with the history. On open, the per-track record lists and a
+* coarse time bucket table are rebuilt from the index.
+*
+* A chunk never spans more than CHUNK_SECONDS, so a slow track cannot hold
+* one chunk open for days and every chunk falls into at most two time
+* buckets.
+*/
+class TrackHistoryStore
+{
+public:
+
+	enum { CHUNK_POINTS = 1024 };
+	enum { CHUNK_SECONDS = 600 };
+
+	struct Sample
+	{
+		unsigned int nId;
+		double dTime;		//seconds since the epoch
+		double dLon;
+		double dLat;
+		double dAlt;
+		double dHeading;
+	};
+
+	TrackHistoryStore();
+	~TrackHistoryStore();
+
+	//opens or creates history.idx/history.dat in strDir; a torn tail left by a crash is cut off
+	bool Open(const QString& strDir);
+
+	//writes the buffered points and closes the files
+	void Close();
+
+	bool IsOpen() const { return m_fileIndex.isOpen(); }
+
+	void Append(unsigned int nId, double dTime, double dLon, double dLat, double dAlt, double dHeading);
+
+	//writes the buffered points of every track as chunks; points whose write failed stay buffered
+	void Flush();
+
+	//points of track nId in [dBegin, dEnd] in append order; returns the number appended to vecSamples
+	//a track's chunks are binary searched by time, so its points must be appended in time order
+	unsigned int QueryTrack(unsigned int nId, double dBegin, double dEnd, std::vector<Sample>& vecSamples);
+
+	//points of every track in [dBegin, dEnd] inside the lon/lat box, grouped by track chunk
+	unsigned int QueryBox(double dBegin, double dEnd, double dLonMin, double dLatMin, double dLonMax, double dLatMax, std::vector<Sample>& vecSamples);
+
+	//last point of track nId at or before dTime, found by binary search
+	bool SampleAt(unsigned int nId, double dTime, Sample& sample);
+
+	//every track with at least one point
+	void GetTrackIds(std::vector<unsigned int>& vecIds);
+
+	//time of the oldest and newest point; false if the store is empty
+	bool GetTimeRange(double& dBegin, double& dEnd);
+
+	unsigned int GetNumChunks() const { return m_vecRecords.size(); }
+
+private:
+
+	struct ChunkRecord
+	{
+		unsigned int nId;
+		unsigned int nCount;
+		double dTimeMin;
+		double dTimeMax;
+		double dLonMin;
+		double dLonMax;
+		double dLatMin;
+		double dLatMax;
+		qint64 nOffset;
+	};
+
+	struct Pending
+	{
+		std::vector<double> vecTime;
+		std::vector<double> vecLon;
+		std::vector<double> vecLat;
+		std::vector<float> vecAlt;
+		std::vector<float> vecHeading;
+	};
+
+	//writes the leading points of pending that fit one chunk and removes them from it;
+	//on a write error pending is left as it was and false is returned
+	bool WriteChunk(unsigned int nId, Pending& pending);
+
+	void IndexRecord(unsigned int nRecord, const ChunkRecord& record);
+
+	const ChunkRecord* GetRecord(unsigned int nRecord) const { return &m_vecRecords[nRecord]; }
+
+	//columns of one chunk, read from the data file unless cached; valid until the next call
+	const double* LoadChunk(const ChunkRecord& record);
+
+	//appends the points of one chunk that pass the filter
+	void ReadChunk(const ChunkRecord& record, double dBegin, double dEnd, const double* pBox, std::vector<Sample>& vecSamples);
+
+	void ReadPending(unsigned int nId, const Pending& pending, double dBegin, double dEnd, const double* pBox, std::vector<Sample>& vecSamples) const;
+
+	void ReadPoint(const ChunkRecord& record, const double* pChunk, unsigned int nPoint, Sample& sample) const;
+
+	//first of the track's chunks that ends at or after dTime
+	unsigned int FindFirstRecord(const std::vector<unsigned int>& vecRecords, double dTime) const;
+
+	static long long Bucket(double dTime) { return (long long)floor(dTime / CHUNK_SECONDS); }
+
+	QFile m_fileIndex;
+	QFile m_fileData;
+
+	std::vector<ChunkRecord> m_vecRecords;
+	qint64 m_nDataSize;
+	double m_dTimeMin;
+	double m_dTimeMax;
+
+	std::unordered_map<unsigned int, std::vector<unsigned int> > m_mapTrackRecords;
+	std::unordered_map<long long, std::vector<unsigned int> > m_mapBuckets;
+	std::unordered_map<unsigned int, Pending> m_mapPending;
+
+	//chunks read recently, keyed by data offset and evicted oldest first
+	std::unordered_map<qint64, std::vector<double> > m_mapChunks;
+	std::deque<qint64> m_dequeChunks;
+	qint64 m_nCachedBytes;
+
+	OpenThreads::Mutex m_mutex;
+};
+
+#endif // TRACKHISTORYSTORE_H
@@ -0,0 +1,210 @@
+#include "TrackPlayback.h"
+#include "TrackHistoryStore.h"
+#include "UDPServer.h"
+#include "Trace.h"
+
+#include <osgEarth/SpatialReference>
+
+extern bool g_bPlaneMove;
+
+TrackPlayback::TrackPlayback(TrackHistoryStore* pStore, QObject *parent)
+	: QObject(parent)
+{
+	m_pStore = pStore;
+
+	m_bActive = false;
+	m_bPlaying = false;
+	m_bWasMoving = true;
+	m_dTime = 0.0;
+	m_dSpeed = 1.0;
+	m_dTrailSeconds = 600.0;
+}
+
+TrackPlayback::~TrackPlayback()
+{
+
+}
+
+void TrackPlayback::AddTrack(UDPServer* pServer)
+{
+	Track track;
+	track.pServer = pServer;
+	track.pTrail = new TrailNode(osgEarth::SpatialReference::get("wgs84")->getEllipsoid());
+	track.dTrailEnd = 0.0;
+	m_vecTracks.push_back(track);
+}
+
+bool TrackPlayback::GetTimeRange(double& dBegin, double& dEnd) const
+{
+	return m_pStore->IsOpen() && m_pStore->GetTimeRange(dBegin, dEnd);
+}
+
+bool TrackPlayback::Start()
+{
+	double dBegin, dEnd;
+	if (m_bActive || !GetTimeRange(dBegin, dEnd))
+		return false;
+
+	//պͼ¼,ֻǲˢʾ
+	m_bWasMoving = g_bPlaneMove;
+	g_bPlaneMove = false;
+
+	//ʵʱ¼,طŻԱߵһ
+	for (size_t i = 0; i < m_vecTracks.size(); i ++)
+	{
+		TrailNode* pLiveTrail = m_vecTracks[i].pServer->m_pTrail.get();
+		for (unsigned int n = 0; n < pLiveTrail->getNumParents(); n ++)
+			pLiveTrail->getParent(n)->addChild(m_vecTracks[i].pTrail.get());
+		pLiveTrail->setNodeMask(0);
+	}
+
+	m_bActive = true;
+	m_bPlaying = false;
+	Seek(dEnd);
+	return true;
+}
+
+void TrackPlayback::Stop()
+{
+	if (!m_bActive)
+		return;
+
+	m_bActive = false;
+	m_bPlaying = false;
+
+	//ʵʱһֱ׷,ֱʾ;ɻָ¼¼λ
+	double dBegin, dEnd;
+	bool bRecorded = GetTimeRange(dBegin, dEnd);
+	for (size_t i = 0; i < m_vecTracks.size(); i ++)
+	{
+		Track& track = m_vecTracks[i];
+		while (track.pTrail->getNumParents() > 0)
+			track.pTrail->getParent(0)->removeChild(track.pTrail.get());
+		track.pTrail->Clear();
+		track.pServer->m_pTrail->setNodeMask(~0u);
+
+		if (bRecorded)
+			ShowTrack(track, dEnd);
+		track.pServer->m_pPlaneNode->setNodeMask(~0u);
+	}
+
+	g_bPlaneMove = m_bWasMoving;
+}
+
+void TrackPlayback::Seek(double dTime)
+{
+	if (!m_bActive)
+		return;
+
+	RM_TRACE_ZONE("playback seek");
+
+	double dBegin, dEnd;
+	GetTimeRange(dBegin, dEnd);
+	m_dTime = osg::clampBetween(dTime, dBegin, dEnd);
+
+	for (size_t i = 0; i < m_vecTracks.size(); i ++)
+	{
+		ShowTrack(m_vecTracks[i], m_dTime);
+		RebuildTrail(m_vecTracks[i], m_dTime);
+	}
+
+	emit sigTimeChanged(m_dTime);
+}
+
+void TrackPlayback::Advance(double dElapsed)
+{
+	if (!m_bActive || !m_bPlaying || dElapsed <= 0.0)
+		return;
+
+	RM_TRACE_ZONE("playback advance");
+
+	double dBegin, dEnd;
+	GetTimeRange(dBegin, dEnd);
+
+	double dTime = m_dTime + dElapsed * m_dSpeed;
+	if (dTime >= dEnd)
+	{
+		dTime = dEnd;
+		m_bPlaying = false;
+	}
+
+	//һʱ¶λһ
+	if (dTime - m_dTime > m_dTrailSeconds)
+	{
+		Seek(dTime);
+		return;
+	}
+
+	std::vector<TrackHistoryStore::Sample> vecSamples;
+	for (size_t i = 0; i < m_vecTracks.size(); i ++)
+	{
+		Track& track = m_vecTracks[i];
+		ShowTrack(track, dTime);
+
+		vecSamples.clear();
+		m_pStore->QueryTrack(track.pServer->m_nPort, track.dTrailEnd, dTime, vecSamples);
+		for (size_t n = 0; n < vecSamples.size(); n ++)
+		{
+			if (vecSamples[n].dTime <= track.dTrailEnd)
+				continue;
+
+			track.pTrail->Append(vecSamples[n].dTime, vecSamples[n].dLon, vecSamples[n].dLat, vecSamples[n].dAlt);
+			track.dTrailEnd = vecSamples[n].dTime;
+		}
+	}
+
+	m_dTime = dTime;
+	emit sigTimeChanged(m_dTime);
+}
+
+void TrackPlayback::ShowTrack(Track& track, double dTime)
+{
+	//ʱ̻ûм¼ĺ
+	TrackHistoryStore::Sample sample;
+	osgEarth::Annotation::MyPlaceNode* pPlaceNode = track.pServer->m_pPlaneNode;
+	if (!m_pStore->SampleAt(track.pServer->m_nPort, dTime, sample))
+	{
+		pPlaceNode->setNodeMask(0);
+		return;
+	}
+
+	pPlaceNode->setNodeMask(~0u);
+	pPlaceNode->setPosition(osgEarth::GeoPoint(osgEarth::SpatialReference::get("wgs84"), osg::Vec3d(sample.dLon, sample.dLat, sample.dAlt)));
+	pPlaceNode->RotateHeading(sample.dHeading);
+}
+
+void TrackPlayback::RebuildTrail(Track& track, double dTime)
+{
+	TrailNode* pTrail = track.pTrail.get();
+	pTrail->Clear();
+	track.dTrailEnd = dTime - m_dTrailSeconds;
+
+	std::vector<TrackHistoryStore::Sample> vecSamples;
+	m_pStore->QueryTrack(track.pServer->m_nPort, dTime - m_dTrailSeconds, dTime, vecSamples);
+	for (size_t n = 0; n < vecSamples.size(); n ++)
+		pTrail->Append(vecSamples[n].dTime, vecSamples[n].dLon, vecSamples[n].dLat, vecSamples[n].dAlt);
+
+	if (!vecSamples.empty())
+		track.dTrailEnd = vecSamples.back().dTime;
+}
+
+//------------------------------------------------------------------
+
+PlaybackFrameHandler::PlaybackFrameHandler(TrackPlayback* pPlayback)
+	: m_pPlayback(pPlayback), m_dLastTime(-1.0)
+{
+
+}
+
+bool PlaybackFrameHandler::handle(const osgGA::GUIEventAdapter& ea, osgGA::GUIActionAdapter& aa)
+{
+	if (ea.getEventType() == osgGA::GUIEventAdapter::FRAME)
+	{
+		double dTime = ea.getTime();
+		if (m_dLastTime >= 0.0)
+			m_pPlayback->Advance(dTime - m_dLastTime);
+		m_dLastTime = dTime;
+	}
+
+	return false;
+}
@@ -0,0 +1,110 @@
+#ifndef TRACKPLAYBACK_H
+#define TRACKPLAYBACK_H
+
+#include <QObject>
+#include <osgGA/GUIEventHandler>
+
+#include "TrailNode.h"
+
+#include <vector>
+
+class UDPServer;
+class TrackHistoryStore;
+
+/**
+* Replays recorded traffic from the track history store.
+*
+* While active, live drawing is frozen through g_bPlaneMove (reception and
+* recording go on) and every registered track's icon is set to the playback
+* time instead. Each track draws a playback trail of its own meanwhile; the
+* live trail is hidden but keeps growing, and Stop shows it again whole. A
+* seek binary searches each track's chunks and rebuilds the playback trail
+* over the last trail window; playing forward only appends the points
+* recorded since the previous frame.
+*/
+class TrackPlayback : public QObject
+{
+	Q_OBJECT
+
+public:
+	TrackPlayback(TrackHistoryStore* pStore, QObject *parent = nullptr);
+	~TrackPlayback();
+
+	void AddTrack(UDPServer* pServer);
+
+	//seconds of history drawn as trail behind each track
+	void SetTrailSeconds(double dSeconds) { m_dTrailSeconds = dSeconds; }
+
+	//enters playback at the newest recorded time; false if nothing is recorded
+	bool Start();
+
+	//back to the live picture
+	void Stop();
+
+	bool IsActive() const { return m_bActive; }
+
+	void Seek(double dTime);
+
+	void SetPlaying(bool bPlaying) { m_bPlaying = bPlaying; }
+
+	bool IsPlaying() const { return m_bPlaying; }
+
+	//playback seconds per wall clock second
+	void SetSpeed(double dSpeed) { m_dSpeed = dSpeed; }
+
+	double GetTime() const { return m_dTime; }
+
+	bool GetTimeRange(double& dBegin, double& dEnd) const;
+
+	//called every frame with the seconds since the previous one
+	void Advance(double dElapsed);
+
+signals:
+
+	void sigTimeChanged(double dTime);
+
+private:
+
+	struct Track
+	{
+		UDPServer* pServer;
+
+		//drawn in place of the live trail while the playback is active
+		osg::ref_ptr<TrailNode> pTrail;
+
+		//time of the newest point in the trail
+		double dTrailEnd;
+	};
+
+	void ShowTrack(Track& track, double dTime);
+
+	void RebuildTrail(Track& track, double dTime);
+
+	TrackHistoryStore* m_pStore;
+	std::vector<Track> m_vecTracks;
+
+	bool m_bActive;
+	bool m_bPlaying;
+	bool m_bWasMoving;
+	double m_dTime;
+	double m_dSpeed;
+	double m_dTrailSeconds;
+};
+
+/**
+* Advances the playback from the viewer's FRAME events.
+*/
+class PlaybackFrameHandler : public osgGA::GUIEventHandler
+{
+public:
+	PlaybackFrameHandler(TrackPlayback* pPlayback);
+
+	virtual bool handle(const osgGA::GUIEventAdapter& ea, osgGA::GUIActionAdapter& aa) override;
+
+private:
+
+	TrackPlayback* m_pPlayback;
+	double m_dLastTime;
+};
+
+#endif // TRACKPLAYBACK_H
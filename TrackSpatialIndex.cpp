@@ -0,0 +1,271 @@
+#include "TrackSpatialIndex.h"
+
+#include <osg/Math>
+
+#include <algorithm>
+#include <math.h>
+
+static const double s_dEarthRadius = 6371008.8;
+
+static osg::Vec3d ToUnit(double dLon, double dLat)
+{
+	double dLonRad = osg::DegreesToRadians(dLon);
+	double dLatRad = osg::DegreesToRadians(dLat);
+	return osg::Vec3d(cos(dLatRad) * cos(dLonRad), cos(dLatRad) * sin(dLonRad), sin(dLatRad));
+}
+
+//λ֮ĵ
+static double Distance(const osg::Vec3d& a, const osg::Vec3d& b)
+{
+	return s_dEarthRadius * atan2((a ^ b).length(), a * b);
+}
+
+static bool HitCloser(const TrackSpatialIndex::Hit& a, const TrackSpatialIndex::Hit& b)
+{
+	return a.dDistance < b.dDistance;
+}
+
+TrackSpatialIndex::TrackSpatialIndex(double dCellSize)
+{
+	m_dCellSize = dCellSize;
+	m_nRows = (int)ceil(180.0 / dCellSize);
+	m_nCols = (int)ceil(360.0 / dCellSize);
+	m_vecRowCount.resize(m_nRows, 0);
+}
+
+int TrackSpatialIndex::Row(double dLat) const
+{
+	return osg::clampBetween((int)floor((dLat + 90.0) / m_dCellSize), 0, m_nRows - 1);
+}
+
+int TrackSpatialIndex::Col(double dLon) const
+{
+	int nCol = (int)floor((dLon + 180.0) / m_dCellSize) % m_nCols;
+	return nCol < 0 ? nCol + m_nCols : nCol;
+}
+
+template<typename Func>
+void TrackSpatialIndex::VisitCell(int nRow, int nCol, Func func) const
+{
+	std::unordered_map<long long, std::vector<unsigned int> >::const_iterator it = m_mapCells.find(CellKey(nRow, nCol));
+	if (it == m_mapCells.end())
+		return;
+
+	for (size_t i = 0; i < it->second.size(); i ++)
+		func(m_vecTracks[it->second[i]]);
+}
+
+TrackSpatialIndex::Hit TrackSpatialIndex::MakeHit(const Track& track, double dDistance) const
+{
+	Hit hit;
+	hit.nId = track.nId;
+	hit.dLon = track.dLon;
+	hit.dLat = track.dLat;
+	hit.dDistance = dDistance;
+	return hit;
+}
+
+void TrackSpatialIndex::Update(unsigned int nId, double dLon, double dLat)
+{
+	long long nCell = CellKey(Row(dLat), Col(dLon));
+
+	std::unordered_map<unsigned int, unsigned int>::iterator it = m_mapIds.find(nId);
+	if (it == m_mapIds.end())
+	{
+		Track track;
+		track.nId = nId;
+		track.nCell = nCell;
+
+		std::vector<unsigned int>& vecCell = m_mapCells[nCell];
+		track.nSlot = vecCell.size();
+		vecCell.push_back(m_vecTracks.size());
+		m_vecRowCount[RowOf(nCell)] ++;
+
+		m_mapIds[nId] = m_vecTracks.size();
+		m_vecTracks.push_back(track);
+		it = m_mapIds.find(nId);
+	}
+
+	Track& track = m_vecTracks[it->second];
+	track.dLon = dLon;
+	track.dLat = dLat;
+	track.unit = ToUnit(dLon, dLat);
+
+	if (track.nCell == nCell)
+		return;
+
+	//Ӿɸｻɾ,ٷŽ¸
+	std::vector<unsigned int>& vecOld = m_mapCells[track.nCell];
+	m_vecTracks[vecOld.back()].nSlot = track.nSlot;
+	vecOld[track.nSlot] = vecOld.back();
+	vecOld.pop_back();
+	if (vecOld.empty())
+		m_mapCells.erase(track.nCell);
+	m_vecRowCount[RowOf(track.nCell)] --;
+	m_vecRowCount[RowOf(nCell)] ++;
+
+	std::vector<unsigned int>& vecNew = m_mapCells[nCell];
+	track.nCell = nCell;
+	track.nSlot = vecNew.size();
+	vecNew.push_back(it->second);
+}
+
+void TrackSpatialIndex::Remove(unsigned int nId)
+{
+	std::unordered_map<unsigned int, unsigned int>::iterator it = m_mapIds.find(nId);
+	if (it == m_mapIds.end())
+		return;
+
+	unsigned int nIndex = it->second;
+	m_mapIds.erase(it);
+
+	Track& track = m_vecTracks[nIndex];
+	std::vector<unsigned int>& vecCell = m_mapCells[track.nCell];
+	m_vecTracks[vecCell.back()].nSlot = track.nSlot;
+	vecCell[track.nSlot] = vecCell.back();
+	vecCell.pop_back();
+	if (vecCell.empty())
+		m_mapCells.erase(track.nCell);
+	m_vecRowCount[RowOf(track.nCell)] --;
+
+	//һƵճλ
+	unsigned int nLast = m_vecTracks.size() - 1;
+	if (nIndex != nLast)
+	{
+		Track& last = m_vecTracks[nLast];
+		m_mapCells[last.nCell][last.nSlot] = nIndex;
+		m_mapIds[last.nId] = nIndex;
+		m_vecTracks[nIndex] = last;
+	}
+	m_vecTracks.pop_back();
+}
+
+void TrackSpatialIndex::Clear()
+{
+	m_vecTracks.clear();
+	m_mapIds.clear();
+	m_mapCells.clear();
+	m_vecRowCount.assign(m_nRows, 0);
+}
+
+unsigned int TrackSpatialIndex::QueryRadius(double dLon, double dLat, double dRadius, std::vector<Hit>& vecHits) const
+{
+	unsigned int nStart = vecHits.size();
+	osg::Vec3d center = ToUnit(dLon, dLat);
+
+	double dAngle = osg::RadiansToDegrees(dRadius / s_dEarthRadius);
+	double dLatMin = dLat - dAngle;
+	double dLatMax = dLat + dAngle;
+
+	//ȷΧγȴ뼫Ŵ,ʱȡȫ
+	int nColCount = m_nCols;
+	int nColFirst = 0;
+	double dPolar = std::max(fabs(dLatMin), fabs(dLatMax));
+	if (dPolar < 90.0)
+	{
+		double dLonSpan = osg::RadiansToDegrees(asin(std::min(1.0, sin(osg::DegreesToRadians(dAngle)) / cos(osg::DegreesToRadians(dPolar)))));
+		if (dAngle < 90.0 && dLonSpan < 180.0)
+		{
+			nColFirst = (int)floor((dLon - dLonSpan + 180.0) / m_dCellSize);
+			nColCount = std::min(m_nCols, (int)floor((dLon + dLonSpan + 180.0) / m_dCellSize) - nColFirst + 1);
+		}
+	}
+
+	int nRowLast = Row(dLatMax);
+	for (int nRow = Row(dLatMin); nRow <= nRowLast; nRow ++)
+	{
+		if (m_vecRowCount[nRow] == 0)
+			continue;
+
+		for (int i = 0; i < nColCount; i ++)
+		{
+			int nCol = ((nColFirst + i) % m_nCols + m_nCols) % m_nCols;
+			VisitCell(nRow, nCol, [&](const Track& track)
+			{
+				double dDistance = Distance(center, track.unit);
+				if (dDistance <= dRadius)
+					vecHits.push_back(MakeHit(track, dDistance));
+			});
+		}
+	}
+
+	return vecHits.size() - nStart;
+}
+
+unsigned int TrackSpatialIndex::QueryPolygon(const std::vector<osg::Vec2d>& vecPolygon, std::vector<Hit>& vecHits) const
+{
+	if (vecPolygon.size() < 3)
+		return 0;
+
+	unsigned int nStart = vecHits.size();
+
+	osg::Vec2d minimum = vecPolygon[0];
+	osg::Vec2d maximum = vecPolygon[0];
+	for (size_t i = 1; i < vecPolygon.size(); i ++)
+	{
+		minimum.x() = std::min(minimum.x(), vecPolygon[i].x());
+		minimum.y() = std::min(minimum.y(), vecPolygon[i].y());
+		maximum.x() = std::max(maximum.x(), vecPolygon[i].x());
+		maximum.y() = std::max(maximum.y(), vecPolygon[i].y());
+	}
+
+	int nRowLast = Row(maximum.y());
+	int nColFirst = (int)floor((minimum.x() + 180.0) / m_dCellSize);
+	int nColCount = std::min(m_nCols, (int)floor((maximum.x() + 180.0) / m_dCellSize) - nColFirst + 1);
+
+	for (int nRow = Row(minimum.y()); nRow <= nRowLast; nRow ++)
+	{
+		if (m_vecRowCount[nRow] == 0)
+			continue;
+
+		for (int i = 0; i < nColCount; i ++)
+		{
+			int nCol = ((nColFirst + i) % m_nCols + m_nCols) % m_nCols;
+			VisitCell(nRow, nCol, [&](const Track& track)
+			{
+				//߷
+				bool bInside = false;
+				for (size_t a = 0, b = vecPolygon.size() - 1; a < vecPolygon.size(); b = a ++)
+				{
+					const osg::Vec2d& pa = vecPolygon[a];
+					const osg::Vec2d& pb = vecPolygon[b];
+					if ((pa.y() > track.dLat) != (pb.y() > track.dLat)
+						&& track.dLon < (pb.x() - pa.x()) * (track.dLat - pa.y()) / (pb.y() - pa.y()) + pa.x())
+					{
+						bInside = !bInside;
+					}
+				}
+
+				if (bInside)
+					vecHits.push_back(MakeHit(track, 0.0));
+			});
+		}
+	}
+
+	return vecHits.size() - nStart;
+}
+
+unsigned int TrackSpatialIndex::QueryNearest(double dLon, double dLat, unsigned int nCount, std::vector<Hit>& vecHits) const
+{
+	if (nCount == 0 || m_vecTracks.empty())
+		return 0;
+
+	nCount = std::min<unsigned int>(nCount, m_vecTracks.size());
+
+	//һӴСʼ,ҵĲͰѰ뾶ӱ,뾶ڵĵ,ľǽ
+	std::vector<Hit> vecFound;
+	double dRadius = osg::DegreesToRadians(m_dCellSize) * s_dEarthRadius;
+	for (;;)
+	{
+		vecFound.clear();
+		QueryRadius(dLon, dLat, dRadius, vecFound);
+		if (vecFound.size() >= nCount)
+			break;
+
+		dRadius *= 2.0;
+	}
+
+	std::partial_sort(vecFound.begin(), vecFound.begin() + nCount, vecFound.end(), HitCloser);
+	vecHits.insert(vecHits.end(), vecFound.begin(), vecFound.begin() + nCount);
+	return nCount;
+}
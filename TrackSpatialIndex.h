@@ -0,0 +1,90 @@
+#ifndef TRACKSPATIALINDEX_H
+#define TRACKSPATIALINDEX_H
+
+#include <osg/Vec2d>
+#include <osg/Vec3d>
+
+#include <unordered_map>
+#include <vector>
+
+/**
+* Grid index over the live track positions.
+*
+* The globe is split into fixed lon/lat cells and every track is listed in
+* the cell holding its last position. An update that stays in the same cell
+* only overwrites the position; a cell change is a swap-remove plus a
+* push_back, so updates are O(1). Queries visit only the cells that can
+* hold a match, skipping rows without any track, and test distances on unit
+* vectors. Nearest queries run radius queries of doubling radius until
+* enough tracks are found.
+*
+* Not thread safe: updates and queries are expected on the same thread.
+*/
+class TrackSpatialIndex
+{
+public:
+
+	struct Hit
+	{
+		unsigned int nId;
+		double dLon;
+		double dLat;
+		double dDistance;	//meters from the query point, 0 for polygon queries
+	};
+
+	TrackSpatialIndex(double dCellSize = 0.25);
+
+	void Update(unsigned int nId, double dLon, double dLat);
+
+	void Remove(unsigned int nId);
+
+	void Clear();
+
+	unsigned int GetNumTracks() const { return m_vecTracks.size(); }
+
+	//tracks within dRadius meters of (dLon, dLat); returns the number appended to vecHits
+	unsigned int QueryRadius(double dLon, double dLat, double dRadius, std::vector<Hit>& vecHits) const;
+
+	//tracks inside the polygon given as (lon, lat) degrees, tested in the lon/lat plane
+	unsigned int QueryPolygon(const std::vector<osg::Vec2d>& vecPolygon, std::vector<Hit>& vecHits) const;
+
+	//the nCount nearest tracks, nearest first
+	unsigned int QueryNearest(double dLon, double dLat, unsigned int nCount, std::vector<Hit>& vecHits) const;
+
+private:
+
+	struct Track
+	{
+		unsigned int nId;
+		double dLon;
+		double dLat;
+		osg::Vec3d unit;
+		long long nCell;
+		unsigned int nSlot;		//position in the cell's list
+	};
+
+	int Row(double dLat) const;
+
+	int RowOf(long long nCell) const { return (int)(nCell / m_nCols); }
+
+	int Col(double dLon) const;
+
+	long long CellKey(int nRow, int nCol) const { return (long long)nRow * m_nCols + nCol; }
+
+	//calls func for every track in the cell
+	template<typename Func>
+	void VisitCell(int nRow, int nCol, Func func) const;
+
+	Hit MakeHit(const Track& track, double dDistance) const;
+
+	double m_dCellSize;
+	int m_nRows;
+	int m_nCols;
+
+	std::vector<Track> m_vecTracks;
+	std::unordered_map<unsigned int, unsigned int> m_mapIds;
+	std::unordered_map<long long, std::vector<unsigned int> > m_mapCells;
+	std::vector<unsigned int> m_vecRowCount;
+};
+
+#endif // TRACKSPATIALINDEX_H
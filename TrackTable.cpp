@@ -0,0 +1,197 @@
+#include "TrackTable.h"
+
+#include <OpenThreads/ScopedLock>
+#include <osg/Math>
+
+#include <algorithm>
+#include <math.h>
+
+static const double s_dEarthRadius = 6371008.8;
+
+//İհʱʱ,̫ʱʱû
+static const double s_dMinVelocityInterval = 0.2;
+
+//ƽʱ䳣,ﵽʱֱȡ²ֵ
+static const double s_dVelocitySmoothing = 2.0;
+
+//ٶΪ,޴
+static const double s_dMaxVelocity = 600.0;
+
+TrackTable* TrackTable::Instance()
+{
+	static TrackTable s_table;
+	return &s_table;
+}
+
+TrackTable::TrackTable()
+{
+	m_pId = new unsigned int[MAX_TRACKS];
+	m_pTime = new double[MAX_TRACKS];
+	m_pLon = new double[MAX_TRACKS];
+	m_pLat = new double[MAX_TRACKS];
+	m_pAlt = new double[MAX_TRACKS];
+	m_pHeading = new double[MAX_TRACKS];
+	m_pVelocity = new double[MAX_TRACKS];
+	m_pRefTime = new double[MAX_TRACKS];
+	m_pRefLon = new double[MAX_TRACKS];
+	m_pRefLat = new double[MAX_TRACKS];
+	m_pFlags = new unsigned int[MAX_TRACKS];
+	m_pSeq = new std::atomic<unsigned int>[MAX_TRACKS];
+
+	for (unsigned int i = 0; i < MAX_TRACKS; i ++)
+	{
+		m_pId[i] = 0;
+		m_pTime[i] = m_pLon[i] = m_pLat[i] = m_pAlt[i] = m_pHeading[i] = m_pVelocity[i] = 0.0;
+		m_pRefTime[i] = m_pRefLon[i] = m_pRefLat[i] = 0.0;
+		m_pFlags[i] = 0;
+		m_pSeq[i].store(0);
+	}
+
+	m_nRows.store(0);
+}
+
+TrackTable::~TrackTable()
+{
+	delete[] m_pId;
+	delete[] m_pTime;
+	delete[] m_pLon;
+	delete[] m_pLat;
+	delete[] m_pAlt;
+	delete[] m_pHeading;
+	delete[] m_pVelocity;
+	delete[] m_pRefTime;
+	delete[] m_pRefLon;
+	delete[] m_pRefLat;
+	delete[] m_pFlags;
+	delete[] m_pSeq;
+}
+
+int TrackTable::Register(unsigned int nId)
+{
+	OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutexRegister);
+
+	int nRow = Find(nId);
+	if (nRow >= 0)
+		return nRow;
+
+	unsigned int nRows = m_nRows.load(std::memory_order_relaxed);
+	if (nRows >= MAX_TRACKS)
+		return -1;
+
+	//дidٷ,߿ʱidһЧ
+	m_pId[nRows] = nId;
+	m_nRows.store(nRows + 1, std::memory_order_release);
+	return nRows;
+}
+
+int TrackTable::Find(unsigned int nId) const
+{
+	unsigned int nRows = GetNumRows();
+	for (unsigned int i = 0; i < nRows; i ++)
+	{
+		if (m_pId[i] == nId)
+			return i;
+	}
+
+	return -1;
+}
+
+void TrackTable::Update(int nRow, double dTime, double dLon, double dLat, double dAlt, double dHeading, unsigned int nFlags)
+{
+	//ֻбед߻޸Щֵ,ֱӶһελúͲο
+	double dVelocity = m_pVelocity[nRow];
+	if ((m_pFlags[nRow] & (FLAG_VALID | FLAG_RESTORED)) != FLAG_VALID || m_pRefTime[nRow] <= 0.0 || dTime < m_pRefTime[nRow])
+	{
+		//һġָλûʱ䵹,¿ʼ
+		dVelocity = 0.0;
+		m_pRefTime[nRow] = dTime;
+		m_pRefLon[nRow] = dLon;
+		m_pRefLat[nRow] = dLat;
+	}
+	else if (dTime - m_pRefTime[nRow] >= s_dMinVelocityInterval)
+	{
+		//Ͳο,Ǻһı,ıĲ׵ٶ
+		double dInterval = dTime - m_pRefTime[nRow];
+		double dLat1 = osg::DegreesToRadians(m_pRefLat[nRow]);
+		double dLat2 = osg::DegreesToRadians(dLat);
+		double dDeltaLat = dLat2 - dLat1;
+		double dDeltaLon = osg::DegreesToRadians(dLon - m_pRefLon[nRow]);
+		double a = sin(dDeltaLat / 2) * sin(dDeltaLat / 2) + cos(dLat1) * cos(dLat2) * sin(dDeltaLon / 2) * sin(dDeltaLon / 2);
+		double dDistance = 2.0 * s_dEarthRadius * atan2(sqrt(a), sqrt(1.0 - a));
+		double dMeasured = std::min(dDistance / dInterval, s_dMaxVelocity);
+
+		//Ȩָƽ;ûٶʱֱȡֵ
+		double dWeight = (m_pFlags[nRow] & FLAG_MEASURED) ? std::min(dInterval / s_dVelocitySmoothing, 1.0) : 1.0;
+		dVelocity += dWeight * (dMeasured - dVelocity);
+		nFlags |= FLAG_MEASURED;
+
+		m_pRefTime[nRow] = dTime;
+		m_pRefLon[nRow] = dLon;
+		m_pRefLat[nRow] = dLat;
+	}
+	else
+	{
+		nFlags |= (m_pFlags[nRow] & FLAG_MEASURED);
+	}
+
+	std::atomic<unsigned int>& seq = m_pSeq[nRow];
+	unsigned int nSeq = seq.load(std::memory_order_relaxed);
+
+	//ʾд
+	seq.store(nSeq + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	m_pTime[nRow] = dTime;
+	m_pLon[nRow] = dLon;
+	m_pLat[nRow] = dLat;
+	m_pAlt[nRow] = dAlt;
+	m_pHeading[nRow] = dHeading;
+	m_pVelocity[nRow] = dVelocity;
+	m_pFlags[nRow] = nFlags | FLAG_VALID;
+
+	seq.store(nSeq + 2, std::memory_order_release);
+}
+
+bool TrackTable::Read(int nRow, Row& row) const
+{
+	if (nRow < 0 || (unsigned int)nRow >= GetNumRows())
+		return false;
+
+	const std::atomic<unsigned int>& seq = m_pSeq[nRow];
+	for (;;)
+	{
+		unsigned int nSeq1 = seq.load(std::memory_order_acquire);
+		if (nSeq1 & 1)
+			continue;
+
+		row.nId = m_pId[nRow];
+		row.dTime = m_pTime[nRow];
+		row.dLon = m_pLon[nRow];
+		row.dLat = m_pLat[nRow];
+		row.dAlt = m_pAlt[nRow];
+		row.dHeading = m_pHeading[nRow];
+		row.dVelocity = m_pVelocity[nRow];
+		row.nFlags = m_pFlags[nRow];
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (seq.load(std::memory_order_relaxed) == nSeq1)
+			break;
+	}
+
+	return (row.nFlags & FLAG_VALID) != 0;
+}
+
+void TrackTable::Snapshot(std::vector<Row>& vecRows) const
+{
+	vecRows.clear();
+
+	unsigned int nRows = GetNumRows();
+	vecRows.reserve(nRows);
+
+	Row row;
+	for (unsigned int i = 0; i < nRows; i ++)
+	{
+		if (Read(i, row))
+			vecRows.push_back(row);
+	}
+}
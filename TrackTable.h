@@ -0,0 +1,107 @@
+#ifndef TRACKTABLE_H
+#define TRACKTABLE_H
+
+#include <atomic>
+#include <vector>
+
+#include <OpenThreads/Mutex>
+
+/**
+* Latest state of every track, shared by ingest, rendering and analytics.
+*
+* Columns are stored structure-of-arrays in fixed-size arrays, so a row
+* never moves once registered. Each row has one writer (its ingest path)
+* and is guarded by a sequence counter: the writer makes it odd while
+* updating and even again afterwards, and readers retry until they saw the
+* same even value before and after copying. Reads and writes take no lock;
+* only registering a new row does.
+*/
+class TrackTable
+{
+public:
+
+	enum { MAX_TRACKS = 4096 };
+
+	enum Flags
+	{
+		FLAG_VALID = 1,
+		FLAG_OFF_ROUTE = 2,
+
+		//last position restored from pos.ini rather than received
+		FLAG_RESTORED = 4,
+
+		//altitude follows the terrain, see UDPServer::SetTerrainClamp
+		FLAG_CLAMPED = 8,
+
+		//dVelocity holds a measured speed rather than the initial 0
+		FLAG_MEASURED = 16
+	};
+
+	struct Row
+	{
+		Row() : nId(0), dTime(0.0), dLon(0.0), dLat(0.0), dAlt(0.0), dHeading(0.0), dVelocity(0.0), nFlags(0) {}
+
+		unsigned int nId;
+		double dTime;		//seconds since the epoch
+		double dLon;
+		double dLat;
+		double dAlt;
+		double dHeading;
+
+		//ground speed in m/s, smoothed over fixes at least 0.2 s apart
+		//and clamped to 600 m/s
+		double dVelocity;
+		unsigned int nFlags;
+	};
+
+	static TrackTable* Instance();
+
+	//row of track nId, registered on first use; -1 once MAX_TRACKS rows exist
+	int Register(unsigned int nId);
+
+	//-1 if nId was never registered
+	int Find(unsigned int nId) const;
+
+	unsigned int GetNumRows() const { return m_nRows.load(std::memory_order_acquire); }
+
+	//only the owner of the row may call this; the velocity is computed here
+	//against the last fix it was measured from, not the previous datagram
+	void Update(int nRow, double dTime, double dLon, double dLat, double dAlt, double dHeading, unsigned int nFlags);
+
+	//consistent copy of one row, false if it was never written
+	bool Read(int nRow, Row& row) const;
+
+	//changes with every write of the row, for cheap change detection
+	unsigned int GetVersion(int nRow) const { return m_pSeq[nRow].load(std::memory_order_acquire); }
+
+	//consistent copy of every written row
+	void Snapshot(std::vector<Row>& vecRows) const;
+
+private:
+
+	TrackTable();
+	~TrackTable();
+
+	TrackTable(const TrackTable&);
+	TrackTable& operator=(const TrackTable&);
+
+	unsigned int* m_pId;
+	double* m_pTime;
+	double* m_pLon;
+	double* m_pLat;
+	double* m_pAlt;
+	double* m_pHeading;
+	double* m_pVelocity;
+	unsigned int* m_pFlags;
+	std::atomic<unsigned int>* m_pSeq;
+
+	//fix the velocity was last measured from, touched only by the writer
+	double* m_pRefTime;
+	double* m_pRefLon;
+	double* m_pRefLat;
+
+	std::atomic<unsigned int> m_nRows;
+	mutable OpenThreads::Mutex m_mutexRegister;
+};
+
+#endif // TRACKTABLE_H
@@ -0,0 +1,225 @@
+#include "TrailNode.h"
+
+#include <osg/Geode>
+#include <osg/LineWidth>
+#include <osgUtil/CullVisitor>
+
+TrailNode::TrailNode(const osg::EllipsoidModel* pEllipsoid)
+	: m_pEllipsoid(pEllipsoid)
+{
+	m_pColors = new osg::Vec4Array;
+	m_pColors->push_back(osg::Vec4(1.0f, 0.0f, 0.0f, 1.0f));
+
+	osg::StateSet* pStateSet = getOrCreateStateSet();
+	pStateSet->setMode(GL_LINE_STIPPLE, osg::StateAttribute::ON | osg::StateAttribute::OVERRIDE);
+	pStateSet->setAttribute(new osg::LineWidth(4.0));
+
+	ResetOpen();
+}
+
+TrailNode::~TrailNode()
+{
+}
+
+osg::Vec3d TrailNode::ToWorld(double dLon, double dLat, double dAlt) const
+{
+	osg::Vec3d world;
+	m_pEllipsoid->convertLatLongHeightToXYZ(osg::DegreesToRadians(dLat), osg::DegreesToRadians(dLon), dAlt, world.x(), world.y(), world.z());
+	return world;
+}
+
+void TrailNode::ResetOpen()
+{
+	m_pOpenVertices = new osg::Vec3Array;
+	m_pOpenPrimitive = new osg::DrawArrays(osg::PrimitiveSet::LINE_STRIP, 0, 0);
+	m_openBound.init();
+
+	//µĿſһѹһ㿪ʼ,߲
+	std::vector<CompressedTrail::Point> vecPoints;
+	if (m_trail.GetNumBlocks() > 0)
+		vecPoints.push_back(m_trail.GetBlockInfo(m_trail.GetNumBlocks() - 1).last);
+
+	m_pOpenNode = BuildNode(vecPoints, m_pOpenVertices.get(), m_pOpenPrimitive.get());
+	m_openOrigin = m_pOpenNode->getMatrix().getTrans();
+	if (!vecPoints.empty())
+		m_openBound.expandBy(m_openOrigin);
+}
+
+osg::MatrixTransform* TrailNode::BuildNode(const std::vector<CompressedTrail::Point>& vecPoints, osg::Vec3Array* pVertices, osg::DrawArrays* pPrimitive) const
+{
+	//Եһ,֤float
+	osg::Vec3d origin;
+	if (!vecPoints.empty())
+		origin = ToWorld(vecPoints[0].dLon, vecPoints[0].dLat, vecPoints[0].dAlt);
+
+	pVertices->reserve(vecPoints.size());
+	for (size_t i = 0; i < vecPoints.size(); i ++)
+		pVertices->push_back(osg::Vec3(ToWorld(vecPoints[i].dLon, vecPoints[i].dLat, vecPoints[i].dAlt) - origin));
+	pPrimitive->setCount(pVertices->size());
+
+	osg::Geometry* pGeometry = new osg::Geometry;
+	pGeometry->setUseDisplayList(false);
+	pGeometry->setUseVertexBufferObjects(true);
+	pGeometry->setDataVariance(osg::Object::DYNAMIC);
+	pGeometry->setVertexArray(pVertices);
+	pGeometry->setColorArray(m_pColors.get(), osg::Array::BIND_OVERALL);
+	pGeometry->addPrimitiveSet(pPrimitive);
+
+	osg::Geode* pGeode = new osg::Geode;
+	pGeode->addDrawable(pGeometry);
+
+	osg::MatrixTransform* pNode = new osg::MatrixTransform(osg::Matrix::translate(origin));
+	pNode->addChild(pGeode);
+	return pNode;
+}
+
+void TrailNode::Append(double dTime, double dLon, double dLat, double dAlt)
+{
+	CompressedTrail::Point point = { dTime, dLon, dLat, dAlt };
+	bool bSealed = m_trail.Append(point);
+
+	osg::Vec3d world = ToWorld(dLon, dLat, dAlt);
+	if (m_pOpenVertices->empty())
+	{
+		m_openOrigin = world;
+		m_pOpenNode->setMatrix(osg::Matrix::translate(world));
+	}
+
+	m_pOpenVertices->push_back(osg::Vec3(world - m_openOrigin));
+	m_pOpenVertices->dirty();
+	m_pOpenPrimitive->setCount(m_pOpenVertices->size());
+	m_pOpenPrimitive->dirty();
+	m_openBound.expandBy(world);
+
+	if (bSealed)
+	{
+		//ſѹ,ķΧ¿ķΧ,ȿɼʱٴѹ
+		Block block;
+		block.bound = m_openBound;
+		block.nLastFrame = 0;
+		m_dequeBlocks.push_back(block);
+
+		if (m_dequeBlocks.size() > MAX_BLOCKS)
+		{
+			m_dequeBlocks.pop_front();
+			m_trail.PopFront();
+		}
+
+		ResetOpen();
+	}
+
+	dirtyBound();
+}
+
+void TrailNode::Clear()
+{
+	m_trail.Clear();
+	m_dequeBlocks.clear();
+	ResetOpen();
+	dirtyBound();
+}
+
+void TrailNode::SetOffRoute(bool bOffRoute)
+{
+	osg::Vec4 color = bOffRoute ? osg::Vec4(1.0f, 1.0f, 0.0f, 1.0f) : osg::Vec4(1.0f, 0.0f, 0.0f, 1.0f);
+	if ((*m_pColors)[0] == color)
+		return;
+
+	(*m_pColors)[0] = color;
+	m_pColors->dirty();
+}
+
+unsigned int TrailNode::GetNumDecodedBlocks() const
+{
+	unsigned int nCount = 0;
+	for (size_t i = 0; i < m_dequeBlocks.size(); i ++)
+	{
+		if (m_dequeBlocks[i].pNode.valid())
+			nCount ++;
+	}
+
+	return nCount;
+}
+
+size_t TrailNode::GetMemoryBytes() const
+{
+	size_t nBytes = m_trail.GetMemoryBytes() + m_dequeBlocks.size() * sizeof(Block);
+	nBytes += m_pOpenVertices->capacity() * sizeof(osg::Vec3);
+
+	for (size_t i = 0; i < m_dequeBlocks.size(); i ++)
+	{
+		if (m_dequeBlocks[i].pNode.valid())
+			nBytes += (CompressedTrail::BLOCK_POINTS + 1) * sizeof(osg::Vec3);
+	}
+
+	return nBytes;
+}
+
+void TrailNode::traverse(osg::NodeVisitor& nv)
+{
+	osgUtil::CullVisitor* pCullVisitor = dynamic_cast<osgUtil::CullVisitor*>(&nv);
+	if (!pCullVisitor)
+	{
+		osg::Group::traverse(nv);
+		return;
+	}
+
+	unsigned int nFrame = nv.getFrameStamp() ? nv.getFrameStamp()->getFrameNumber() : 0;
+	unsigned int nBuilds = 0;
+
+	std::vector<CompressedTrail::Point> vecPoints;
+	for (unsigned int i = 0; i < m_dequeBlocks.size(); i ++)
+	{
+		Block& block = m_dequeBlocks[i];
+		if (pCullVisitor->isCulled(block.bound))
+		{
+			if (block.pNode.valid() && nFrame - block.nLastFrame > EVICT_FRAMES)
+				block.pNode = nullptr;
+			continue;
+		}
+
+		if (!block.pNode.valid())
+		{
+			if (nBuilds >= MAX_BUILDS_PER_FRAME)
+				continue;
+
+			vecPoints.clear();
+			if (i > 0)
+				vecPoints.push_back(m_trail.GetBlockInfo(i - 1).last);
+			m_trail.DecodeBlock(i, vecPoints);
+
+			block.pNode = BuildNode(vecPoints, new osg::Vec3Array, new osg::DrawArrays(osg::PrimitiveSet::LINE_STRIP, 0, 0));
+			nBuilds ++;
+		}
+
+		block.nLastFrame = nFrame;
+		block.pNode->accept(nv);
+	}
+
+	if (m_pOpenVertices->size() > 1)
+		m_pOpenNode->accept(nv);
+
+	osg::Group::traverse(nv);
+}
+
+osg::BoundingSphere TrailNode::computeBound() const
+{
+	osg::BoundingSphere bound = osg::Group::computeBound();
+	for (size_t i = 0; i < m_dequeBlocks.size(); i ++)
+		bound.expandBy(m_dequeBlocks[i].bound);
+	bound.expandBy(m_openBound);
+
+	return bound;
+}
+
+void TrailNode::releaseGLObjects(osg::State* pState) const
+{
+	osg::Group::releaseGLObjects(pState);
+
+	for (size_t i = 0; i < m_dequeBlocks.size(); i ++)
+	{
+		if (m_dequeBlocks[i].pNode.valid())
+			m_dequeBlocks[i].pNode->releaseGLObjects(pState);
+	}
+	m_pOpenNode->releaseGLObjects(pState);
+}
@@ -0,0 +1,86 @@
+#ifndef TRAILNODE_H
+#define TRAILNODE_H
+
+#include <osg/Group>
+#include <osg/Geometry>
+#include <osg/MatrixTransform>
+#include <osg/EllipsoidModel>
+
+#include <deque>
+
+#include "CompressedTrail.h"
+
+/**
+* Draws the trail of one track from its compressed history.
+*
+* Only the open block, the newest points, is kept as vertices all the time;
+* it is extended in place for every new point. A compressed block gets a
+* geometry only when the cull traversal finds its bounding sphere in view,
+* at most MAX_BUILDS_PER_FRAME per frame, and loses it again after
+* EVICT_FRAMES frames out of view. The blocks are not children of the
+* node, they are only visited during culling.
+*/
+class TrailNode : public osg::Group
+{
+public:
+
+	enum { MAX_BLOCKS = 4096 };
+	enum { MAX_BUILDS_PER_FRAME = 16 };
+	enum { EVICT_FRAMES = 120 };
+
+	TrailNode(const osg::EllipsoidModel* pEllipsoid);
+
+	void Append(double dTime, double dLon, double dLat, double dAlt);
+
+	void Clear();
+
+	//yellow instead of red while the track is off its route
+	void SetOffRoute(bool bOffRoute);
+
+	const CompressedTrail& GetTrail() const { return m_trail; }
+
+	unsigned int GetNumDecodedBlocks() const;
+
+	//compressed history plus the vertices currently built
+	size_t GetMemoryBytes() const;
+
+	virtual void traverse(osg::NodeVisitor& nv) override;
+
+	virtual osg::BoundingSphere computeBound() const override;
+
+	virtual void releaseGLObjects(osg::State* pState = 0) const override;
+
+protected:
+
+	virtual ~TrailNode();
+
+private:
+
+	struct Block
+	{
+		osg::BoundingSphere bound;
+		osg::ref_ptr<osg::MatrixTransform> pNode;
+		unsigned int nLastFrame;
+	};
+
+	osg::Vec3d ToWorld(double dLon, double dLat, double dAlt) const;
+
+	//line strip of vecPoints relative to the first one
+	osg::MatrixTransform* BuildNode(const std::vector<CompressedTrail::Point>& vecPoints, osg::Vec3Array* pVertices, osg::DrawArrays* pPrimitive) const;
+
+	void ResetOpen();
+
+	osg::ref_ptr<const osg::EllipsoidModel> m_pEllipsoid;
+	CompressedTrail m_trail;
+	std::deque<Block> m_dequeBlocks;
+
+	osg::ref_ptr<osg::MatrixTransform> m_pOpenNode;
+	osg::ref_ptr<osg::Vec3Array> m_pOpenVertices;
+	osg::ref_ptr<osg::DrawArrays> m_pOpenPrimitive;
+	osg::Vec3d m_openOrigin;
+	osg::BoundingSphere m_openBound;
+
+	osg::ref_ptr<osg::Vec4Array> m_pColors;
+};
+
+#endif // TRAILNODE_H
@@ -1,34 +1,58 @@
-#include "udpserver.h"
+#include "UDPServer.h"
 #include "GPSPosEvent.h"
 #include "osgEarth/SpatialReference"
 #include "osgEarthUtil/EarthManipulator"
-#include <osg/LineStipple>
-#include <osg/LineWidth>
+#include <osg/Timer>
+#include "Trace.h"
+#include "TrackTable.h"
+#include "TrackHistoryStore.h"
+#include "TrackSpatialIndex.h"
+#include "Geofence.h"
+#include "ElevationCache.h"
+#include "TilePrefetcher.h"
 
 using namespace osgEarth;
 using namespace osgEarth::Symbology;
 using namespace osgEarth::Util;
 
-extern osg::Node* g_earthNode;
+extern RouteConformance* g_pRouteConformance;
 
-double g_dPlanePosLon = 0.0;
-double g_dPlanePosLat = 0.0;
-double g_dPlanePosAngle = 0.0;
+bool g_bPlaneMove = true;
 
-double g_dTargetPosLon = 0.0;
-double g_dTargetPosLat = 0.0;
+//ʷ,δʱ¼
+TrackHistoryStore* g_pTrackHistory = nullptr;
 
-bool g_bPlaneMove = true;
+//ʵʱĿռ,ͷѯĿ
+TrackSpatialIndex* g_pTrackIndex = nullptr;
+
+//,ûмκνʱΪ
+Geofence* g_pGeofence = nullptr;
+
+//غõĵθ߶Ȼ
+ElevationCache* g_pElevationCache = nullptr;
+
+//ɻʱԤȡǰƬ
+TilePrefetcher* g_pTilePrefetcher = nullptr;
 
-UDPServer::UDPServer(osg::Geode* pGeode, int nPort
+UDPServer::UDPServer(osg::Group* pTrailParent, int nPort
 	, osgViewer::ViewerBase* pViewer, osgEarth::Annotation::MyPlaceNode* pLocalGeometryNode, QObject *parent)
-	: QObject(parent), m_dLon(dLon), m_dLat(dLat), m_dAngle(dAngle)
+	: QObject(parent)
 {
 	m_pViewer = pViewer;
 	m_pPlaneNode = pLocalGeometryNode;
 	m_nPort = nPort;
 
-	m_pGeodePath = pGeode;
+	m_pTrail = new TrailNode(osgEarth::SpatialReference::get("wgs84")->getEllipsoid());
+	pTrailParent->addChild(m_pTrail.get());
+	m_bOffRoute = false;
+	m_pMetrics = Metrics::Instance()->RegisterPort(nPort);
+	m_nTrackRow = TrackTable::Instance()->Register(nPort);
+
+	//δʱúĸ߶,Ĭ10000
+	TrackTable::Row row;
+	m_dAltitude = TrackTable::Instance()->Read(m_nTrackRow, row) ? row.dAlt : 10000.0;
+	m_bClampToTerrain = false;
+	m_dHeightAboveTerrain = 0.0;
 
 	receiver = new QUdpSocket(this);
 	receiver->bind(QHostAddress::LocalHost, nPort);
@@ -40,48 +64,94 @@ UDPServer::~UDPServer()
 
 }
 
+void UDPServer::SetTerrainClamp(bool bClamp, double dHeightAboveTerrain)
+{
+	m_bClampToTerrain = bClamp;
+	m_dHeightAboveTerrain = dHeightAboveTerrain;
+}
+
 void UDPServer::readPendingDatagrams()
 {
-	osg::ref_ptr<osgEarth::MapNode> mapNode = osgEarth::MapNode::findMapNode(g_earthNode);
+	RM_TRACE_ZONE("readPendingDatagrams");
+
 	SpatialReference* pwgs84 = osgEarth::SpatialReference::get("wgs84");
-	const SpatialReference* mapSRS = mapNode->getMapSRS();
 
 	while (receiver->hasPendingDatagrams()) {
 		QByteArray datagram;
 		datagram.resize(receiver->pendingDatagramSize());
-		receiver->readDatagram(datagram.data(), datagram.size());
+		qint64 nSize = receiver->readDatagram(datagram.data(), datagram.size());
 		//ݽdatagram
 		/* readDatagram ԭ
 		qint64 readDatagram(char *data,qint64 maxSize,QHostAddress *address=0,quint16 *port=0)
 		*/
 
-		int nSize = datagram.size();
+		osg::Timer_t tickStart = osg::Timer::instance()->tick();
+		m_pMetrics->nReceived.fetch_add(1, std::memory_order_relaxed);
+
 		double dLon, dLat, dAngle;
-		memcpy(&dLon, datagram.data() + 1, 8);
-		memcpy(&dLat, datagram.data() + 9, 8);
-		memcpy(&dAngle, datagram.data() + 17, 8);
+		if (!DecodePosDatagram(datagram.data(), nSize, dLon, dLat, dAngle))
+		{
+			m_pMetrics->nDropped.fetch_add(1, std::memory_order_relaxed);
+			continue;
+		}
+
+		if (g_pRouteConformance)
+		{
+			RouteConformance::Result result;
+			if (g_pRouteConformance->Update(m_nPort, dLon, dLat, result))
+			{
+				m_bOffRoute = g_pRouteConformance->IsAlert(m_nPort);
+				emit sigConformanceChanged(m_nPort, m_bOffRoute, result.dCrossTrack);
+			}
+		}
+
+		if (g_pGeofence)
+		{
+			std::vector<Geofence::Event> vecEvents;
+			g_pGeofence->Update(m_nPort, dLon, dLat, vecEvents);
+			for (size_t i = 0; i < vecEvents.size(); i ++)
+				emit sigGeofenceChanged(m_nPort, QString::fromUtf8(g_pGeofence->GetName(vecEvents[i].nFenceId).c_str()), vecEvents[i].bEnter);
+		}
 
-		if (m_verticesPlanePath == nullptr)
+		//θ߶Ȼûȡʱһεĸ߶,һȡ
+		if (m_bClampToTerrain && g_pElevationCache)
 		{
-			m_verticesPlanePath = new osg::Vec3dArray();
+			double dHeight;
+			if (g_pElevationCache->GetElevation(dLon, dLat, dHeight))
+				m_dAltitude = dHeight + m_dHeightAboveTerrain;
 		}
 
-		if (m_verticesPlanePath->size() > 10000)
+		double dTime = QDateTime::currentMSecsSinceEpoch() / 1000.0;
+		if (m_nTrackRow >= 0)
 		{
-			m_verticesPlanePath->clear();
+			TrackTable::Instance()->Update(m_nTrackRow, dTime, dLon, dLat, m_dAltitude, dAngle
+				, (m_bOffRoute ? TrackTable::FLAG_OFF_ROUTE : 0) | (m_bClampToTerrain ? TrackTable::FLAG_CLAMPED : 0));
 		}
 
-		osg::Vec3d startline(dLon, dLat, 10000.0);
-		osg::Vec3d startWorld;
-		pwgs84->transform(startline, mapSRS, startWorld);
+		if (g_pTrackHistory)
+			g_pTrackHistory->Append(m_nPort, dTime, dLon, dLat, m_dAltitude, dAngle);
+
+		if (g_pTrackIndex)
+			g_pTrackIndex->Update(m_nPort, dLon, dLat);
 
-		m_verticesPlanePath->push_back(startWorld);
+		m_pMetrics->nDecoded.fetch_add(1, std::memory_order_relaxed);
+		m_pMetrics->decodeLatency.Observe(osg::Timer::instance()->delta_s(tickStart, osg::Timer::instance()->tick()));
+
+		{
+			RM_TRACE_ZONE("trail append");
+
+			//ͣʱճ¼,ֹֻͣɻӵĸ
+			m_pTrail->SetOffRoute(m_bOffRoute);
+			m_pTrail->Append(dTime, dLon, dLat, m_dAltitude);
+		}
 
 		if (!g_bPlaneMove)
 			return;
 
 		if (m_nPort == 6665)
 		{
+			RM_TRACE_ZONE("setViewpoint");
+
 			osgViewer::Viewer* pViewer = dynamic_cast<osgViewer::Viewer*>(m_pViewer);
 			osgGA::CameraManipulator* pCameraManipulator = pViewer->getCameraManipulator();
 			osgEarth::Util::EarthManipulator* pEarthManipulator = dynamic_cast<osgEarth::Util::EarthManipulator*>(pCameraManipulator);
@@ -98,41 +168,13 @@ void UDPServer::readPendingDatagrams()
 			//pEarthManipulator->setViewpoint(viewPoint);
 			pEarthManipulator->setViewpoint(osgEarth::Viewpoint("New Tork", dLon, dLat, geoPoint.z(), dHeading, dPitch, dRange));
 
-			m_pPlaneNode->RotateHeading(dAngle);
-		}
-
-		m_pPlaneNode->setPosition(osgEarth::GeoPoint(pwgs84, osg::Vec3d(dLon, dLat, 2000.0)));
+			TrackTable::Row row;
+			if (g_pTilePrefetcher && m_nTrackRow >= 0 && TrackTable::Instance()->Read(m_nTrackRow, row))
+				g_pTilePrefetcher->Update(dLon, dLat, dAngle, row.dVelocity, dRange);
 
-		int nCount = m_pGeodePath->getNumDrawables();
-		if (nCount > 0)
-		{
-			m_pGeodePath->removeDrawables(0);
+			m_pPlaneNode->RotateHeading(dAngle);
 		}
 
-		osg::ref_ptr<osg::Geometry> linesGeom = new osg::Geometry();
-		// pass the created vertex array to the points geometry object.
-		linesGeom->setVertexArray(m_verticesPlanePath);
-
-		// set the colors as before, plus using the above
-		osg::ref_ptr<osg::Vec4Array> colors = new osg::Vec4Array;
-		colors->push_back(osg::Vec4(1.0f, 0.0f, 0.0f, 1.0f));
-		linesGeom->setColorArray(colors);
-		linesGeom->setColorBinding(osg::Geometry::BIND_OVERALL);
-
-		// set the normal in the same way color.
-		osg::ref_ptr<osg::Vec3Array> normals = new osg::Vec3Array;
-		normals->push_back(osg::Vec3(0.0f, -1.0f, 0.0f));
-		linesGeom->setNormalArray(normals);
-		linesGeom->setNormalBinding(osg::Geometry::BIND_OVERALL);
-
-		// This time we simply use primitive, and hardwire the number of coords to use 
-		// since we know up front,
-		linesGeom->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::LINE_STRIP, 0, m_verticesPlanePath->size()));
-		linesGeom->getOrCreateStateSet()->setMode(GL_LINE_STIPPLE, osg::StateAttribute::ON | osg::StateAttribute::OVERRIDE);
-
- 		//linesGeom->getOrCreateStateSet()->setAttribute(new osg::LineStipple(2, 0x00FF));
- 		linesGeom->getOrCreateStateSet()->setAttribute(new osg::LineWidth(4.0));
-
-		m_pGeodePath->addDrawable(linesGeom);
+		m_pPlaneNode->setPosition(osgEarth::GeoPoint(pwgs84, osg::Vec3d(dLon, dLat, m_dAltitude)));
 	}
-}
\ No newline at end of file
+}
@@ -7,13 +7,16 @@
 #include <osgEarthAnnotation/LocalGeometryNode>
 #include <osgEarthAnnotation/PlaceNode>
 #include "MyPlaceNode.h"
+#include "RouteConformance.h"
+#include "Metrics.h"
+#include "TrailNode.h"
 
 class UDPServer : public QObject
 {
 	Q_OBJECT
 
 public:
-	UDPServer(osg::Geode* pGeode, int nPort
+	UDPServer(osg::Group* pTrailParent, int nPort
 		, osgViewer::ViewerBase*, osgEarth::Annotation::MyPlaceNode*, QObject *parent = nullptr);
 	~UDPServer();
 
@@ -23,11 +26,28 @@ public:
 
 	osgEarth::Annotation::MyPlaceNode* m_pPlaneNode;
 
-	osg::ref_ptr<osg::Vec3dArray> m_verticesPlanePath;
-
 	int m_nPort;
 
-	osg::Geode* m_pGeodePath;
+	//compressed trail of the received positions, added under pTrailParent
+	osg::ref_ptr<TrailNode> m_pTrail;
+
+	//position left the route corridor, drawn with a yellow trail
+	bool m_bOffRoute;
+
+	//received/decoded/dropped counters of this port, shared with the stats HUD and the metrics endpoint
+	Metrics::PortMetrics* m_pMetrics;
+
+	//row of this port in TrackTable, -1 if the table is full
+	int m_nTrackRow;
+
+	//altitude given to the icon, the trail and the track table; follows the terrain when clamped
+	double m_dAltitude;
+
+	bool m_bClampToTerrain;
+	double m_dHeightAboveTerrain;
+
+	//place the track dHeightAboveTerrain meters above the terrain instead of at its fixed altitude
+	void SetTerrainClamp(bool bClamp, double dHeightAboveTerrain = 0.0);
 
 	//źŲ
 private slots:
@@ -37,6 +57,11 @@ signals:
 
 	void sigPosChanged(double dLon, double dLat);
 
+	void sigConformanceChanged(int nPort, bool bAlert, double dCrossTrack);
+
+	//the track entered (bEnter) or left the restricted area strFence
+	void sigGeofenceChanged(int nPort, const QString& strFence, bool bEnter);
+
 private:
 
 };
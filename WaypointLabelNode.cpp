@@ -0,0 +1,327 @@
+#include "WaypointLabelNode.h"
+#include <osg/Geode>
+#include <osgUtil/CullVisitor>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	const double s_dFadeTime = 0.3;
+}
+
+WaypointLabelNode::WaypointLabelNode(const osg::EllipsoidModel* pEllipsoid, double dAltitude)
+	: m_pEllipsoid(pEllipsoid), m_dAltitude(dAltitude), m_fCharacterSize(30.0f)
+	, m_nNextLineId(1), m_bDirty(false), m_nVisibleLabels(0), m_dLastTime(-1.0)
+	, m_fCellSize(64.0f), m_fGridX(0.0f), m_fGridY(0.0f), m_nGridWidth(0), m_nGridHeight(0)
+{
+	for (unsigned int i = 0; i < MAX_LABELS; i++)
+	{
+		osgText::Text* pText = new osgText::Text;
+		pText->setDataVariance(osg::Object::DYNAMIC);
+		pText->setAutoRotateToScreen(true);
+		pText->setCharacterSizeMode(osgText::Text::SCREEN_COORDS);
+		pText->setCharacterSize(m_fCharacterSize);
+		pText->setAlignment(osgText::Text::CENTER_CENTER);
+		pText->setBackdropType(osgText::Text::OUTLINE);
+		pText->setColor(osg::Vec4(0.0f, 1.0f, 0.0f, 0.0f));
+		pText->setBackdropColor(osg::Vec4(1.0f, 1.0f, 0.0f, 0.0f));
+
+		osg::Geode* pGeode = new osg::Geode;
+		pGeode->addDrawable(pText);
+
+		osg::MatrixTransform* pNode = new osg::MatrixTransform;
+		pNode->setNodeMask(0);
+		pNode->addChild(pGeode);
+		addChild(pNode);
+
+		m_vecSlotNodes.push_back(pNode);
+		m_vecSlots.push_back(pText);
+		m_vecFreeSlots.push_back(MAX_LABELS - 1 - i);
+	}
+
+	osg::StateSet* stateset = getOrCreateStateSet();
+	stateset->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
+	stateset->setMode(GL_DEPTH_TEST, osg::StateAttribute::OFF);
+	stateset->setRenderBinDetails(100, "RenderBin");
+}
+
+WaypointLabelNode::~WaypointLabelNode()
+{
+
+}
+
+unsigned int WaypointLabelNode::AddLine(const std::vector<osg::Vec2d>& vecLonLat, const std::vector<std::string>& vecNames)
+{
+	for (size_t i = 0; i < vecLonLat.size() && i < vecNames.size(); i++)
+	{
+		Label label;
+		double dLat = osg::DegreesToRadians(vecLonLat[i].y());
+		double dLon = osg::DegreesToRadians(vecLonLat[i].x());
+		m_pEllipsoid->convertLatLongHeightToXYZ(dLat, dLon, m_dAltitude, label.world.x(), label.world.y(), label.world.z());
+		label.normal = m_pEllipsoid->computeLocalUpVector(label.world.x(), label.world.y(), label.world.z());
+		label.strText = vecNames[i];
+		label.nLineId = m_nNextLineId;
+		label.nPriority = (i == 0 || i + 1 == vecLonLat.size()) ? PRIORITY_ENDPOINT : PRIORITY_WAYPOINT;
+		label.fAlpha = 0.0f;
+		label.nSlot = -1;
+
+		m_vecLabels.push_back(label);
+	}
+
+	m_bDirty = true;
+	return m_nNextLineId++;
+}
+
+void WaypointLabelNode::RemoveLine(unsigned int nLineId)
+{
+	size_t nKept = 0;
+	for (size_t i = 0; i < m_vecLabels.size(); i++)
+	{
+		if (m_vecLabels[i].nLineId == nLineId)
+		{
+			ReleaseSlot(m_vecLabels[i]);
+			continue;
+		}
+
+		m_vecLabels[nKept++] = m_vecLabels[i];
+	}
+
+	if (nKept != m_vecLabels.size())
+	{
+		m_vecLabels.resize(nKept);
+		m_bDirty = true;
+	}
+}
+
+void WaypointLabelNode::Clear()
+{
+	for (size_t i = 0; i < m_vecLabels.size(); i++)
+	{
+		ReleaseSlot(m_vecLabels[i]);
+	}
+
+	m_vecLabels.clear();
+	m_bDirty = true;
+}
+
+void WaypointLabelNode::Update()
+{
+	if (!m_bDirty)
+		return;
+
+	m_bDirty = false;
+
+	m_vecOrder.resize(m_vecLabels.size());
+	for (size_t i = 0; i < m_vecOrder.size(); i++)
+	{
+		m_vecOrder[i] = i;
+	}
+
+	//stable, so labels of equal priority keep their file order from frame to frame
+	const std::vector<Label>& vecLabels = m_vecLabels;
+	std::stable_sort(m_vecOrder.begin(), m_vecOrder.end(), [&vecLabels](unsigned int a, unsigned int b)
+	{
+		return vecLabels[a].nPriority < vecLabels[b].nPriority;
+	});
+}
+
+void WaypointLabelNode::SetCharacterSize(float fSize)
+{
+	m_fCharacterSize = fSize;
+	for (size_t i = 0; i < m_vecSlots.size(); i++)
+	{
+		m_vecSlots[i]->setCharacterSize(fSize);
+	}
+}
+
+void WaypointLabelNode::traverse(osg::NodeVisitor& nv)
+{
+	if (nv.getVisitorType() == osg::NodeVisitor::CULL_VISITOR)
+		Cull(nv);
+
+	osg::Group::traverse(nv);
+}
+
+void WaypointLabelNode::Cull(osg::NodeVisitor& nv)
+{
+	osgUtil::CullVisitor* cv = dynamic_cast<osgUtil::CullVisitor*>(&nv);
+	if (cv == nullptr || cv->getViewport() == nullptr)
+		return;
+
+	//labels removed since the last Update() would leave stale indices in m_vecOrder
+	Update();
+
+	double dTime = nv.getFrameStamp() ? nv.getFrameStamp()->getReferenceTime() : 0.0;
+	float fFadeStep = 1.0f;
+	if (m_dLastTime >= 0.0)
+		fFadeStep = (float)osg::clampBetween((dTime - m_dLastTime) / s_dFadeTime, 0.0, 1.0);
+	m_dLastTime = dTime;
+
+	const osg::Viewport* pViewport = cv->getViewport();
+	const osg::Matrix& mvpw = *cv->getMVPW();
+	osg::Vec3d eye = nv.getEyePoint();
+
+	//reset the grid hash, touching only the cells used last frame; the rectangles are in
+	//window coordinates, so the cells are counted from the viewport corner
+	m_fGridX = (float)pViewport->x();
+	m_fGridY = (float)pViewport->y();
+	int nGridWidth = (int)(pViewport->width() / m_fCellSize) + 1;
+	int nGridHeight = (int)(pViewport->height() / m_fCellSize) + 1;
+	if (nGridWidth != m_nGridWidth || nGridHeight != m_nGridHeight)
+	{
+		m_nGridWidth = nGridWidth;
+		m_nGridHeight = nGridHeight;
+		m_vecGrid.assign(m_nGridWidth * m_nGridHeight, std::vector<unsigned int>());
+		m_vecTouchedCells.clear();
+	}
+
+	for (size_t i = 0; i < m_vecTouchedCells.size(); i++)
+	{
+		m_vecGrid[m_vecTouchedCells[i]].clear();
+	}
+	m_vecTouchedCells.clear();
+	m_vecAccepted.clear();
+
+	unsigned int nAccepted = 0;
+	unsigned int nNewLabels = 0;
+	float fHeight = m_fCharacterSize + 4.0f;
+
+	for (size_t n = 0; n < m_vecOrder.size(); n++)
+	{
+		Label& label = m_vecLabels[m_vecOrder[n]];
+
+		bool bWanted = false;
+
+		//behind the horizon?
+		if ((eye - label.world) * label.normal > 0.0 && nAccepted < MAX_LABELS)
+		{
+			osg::Vec4d clip = osg::Vec4d(label.world, 1.0) * mvpw;
+			if (clip.w() > 0.0)
+			{
+				float x = (float)(clip.x() / clip.w());
+				float y = (float)(clip.y() / clip.w());
+				float fWidth = label.strText.size() * m_fCharacterSize * 0.6f + 4.0f;
+
+				Rect rect = { x - fWidth * 0.5f, y - fHeight * 0.5f, x + fWidth * 0.5f, y + fHeight * 0.5f };
+
+				bool bOnScreen = rect.x1 > pViewport->x() && rect.x0 < pViewport->x() + pViewport->width()
+					&& rect.y1 > pViewport->y() && rect.y0 < pViewport->y() + pViewport->height();
+
+				if (bOnScreen && !Overlaps(rect) && (label.nSlot >= 0 || nNewLabels < MAX_NEW_LABELS_PER_FRAME))
+				{
+					//a label that gets no text slot is not drawn, so it must not keep its neighbours out of the grid
+					bool bHadSlot = label.nSlot >= 0;
+					if (bHadSlot || AcquireSlot(label) >= 0)
+					{
+						if (!bHadSlot)
+							nNewLabels++;
+
+						Insert(rect);
+						nAccepted++;
+						bWanted = true;
+					}
+				}
+			}
+		}
+
+		if (bWanted)
+		{
+			label.fAlpha = std::min(1.0f, label.fAlpha + fFadeStep);
+		}
+		else if (label.nSlot >= 0)
+		{
+			label.fAlpha = std::max(0.0f, label.fAlpha - fFadeStep);
+			if (label.fAlpha <= 0.0f)
+			{
+				ReleaseSlot(label);
+				continue;
+			}
+		}
+		else
+		{
+			continue;
+		}
+
+		osgText::Text* pText = m_vecSlots[label.nSlot].get();
+		pText->setColor(osg::Vec4(0.0f, 1.0f, 0.0f, label.fAlpha));
+		pText->setBackdropColor(osg::Vec4(1.0f, 1.0f, 0.0f, label.fAlpha));
+	}
+
+	m_nVisibleLabels = nAccepted;
+}
+
+bool WaypointLabelNode::Overlaps(const Rect& rect) const
+{
+	int cx0 = std::max(0, (int)floor((rect.x0 - m_fGridX) / m_fCellSize));
+	int cy0 = std::max(0, (int)floor((rect.y0 - m_fGridY) / m_fCellSize));
+	int cx1 = std::min(m_nGridWidth - 1, (int)floor((rect.x1 - m_fGridX) / m_fCellSize));
+	int cy1 = std::min(m_nGridHeight - 1, (int)floor((rect.y1 - m_fGridY) / m_fCellSize));
+
+	for (int cy = cy0; cy <= cy1; cy++)
+	{
+		for (int cx = cx0; cx <= cx1; cx++)
+		{
+			const std::vector<unsigned int>& vecCell = m_vecGrid[cy * m_nGridWidth + cx];
+			for (size_t i = 0; i < vecCell.size(); i++)
+			{
+				const Rect& other = m_vecAccepted[vecCell[i]];
+				if (rect.x0 < other.x1 && other.x0 < rect.x1 && rect.y0 < other.y1 && other.y0 < rect.y1)
+					return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+void WaypointLabelNode::Insert(const Rect& rect)
+{
+	unsigned int nIndex = m_vecAccepted.size();
+	m_vecAccepted.push_back(rect);
+
+	int cx0 = std::max(0, (int)floor((rect.x0 - m_fGridX) / m_fCellSize));
+	int cy0 = std::max(0, (int)floor((rect.y0 - m_fGridY) / m_fCellSize));
+	int cx1 = std::min(m_nGridWidth - 1, (int)floor((rect.x1 - m_fGridX) / m_fCellSize));
+	int cy1 = std::min(m_nGridHeight - 1, (int)floor((rect.y1 - m_fGridY) / m_fCellSize));
+
+	for (int cy = cy0; cy <= cy1; cy++)
+	{
+		for (int cx = cx0; cx <= cx1; cx++)
+		{
+			unsigned int nCell = cy * m_nGridWidth + cx;
+			if (m_vecGrid[nCell].empty())
+				m_vecTouchedCells.push_back(nCell);
+			m_vecGrid[nCell].push_back(nIndex);
+		}
+	}
+}
+
+int WaypointLabelNode::AcquireSlot(Label& label)
+{
+	if (m_vecFreeSlots.empty())
+		return -1;
+
+	label.nSlot = m_vecFreeSlots.back();
+	m_vecFreeSlots.pop_back();
+
+	//the text stays at the origin, the world position goes into the double precision matrix
+	m_vecSlotNodes[label.nSlot]->setMatrix(osg::Matrix::translate(label.world));
+	m_vecSlotNodes[label.nSlot]->setNodeMask(~0u);
+
+	osgText::Text* pText = m_vecSlots[label.nSlot].get();
+	pText->setText(label.strText);
+
+	return label.nSlot;
+}
+
+void WaypointLabelNode::ReleaseSlot(Label& label)
+{
+	if (label.nSlot < 0)
+		return;
+
+	m_vecSlotNodes[label.nSlot]->setNodeMask(0);
+	m_vecFreeSlots.push_back(label.nSlot);
+	label.nSlot = -1;
+	label.fAlpha = 0.0f;
+}
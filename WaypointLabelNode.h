@@ -0,0 +1,119 @@
+#ifndef WAYPOINTLABELNODE_H
+#define WAYPOINTLABELNODE_H
+
+#include <osg/Group>
+#include <osg/MatrixTransform>
+#include <osg/EllipsoidModel>
+#include <osgText/Text>
+
+#include <string>
+#include <vector>
+
+/**
+* Declutters the waypoint labels of a route layer.
+*
+* Every cull traversal the labels are projected to the screen in priority
+* order (route endpoints first, then intermediate waypoints) and a label is
+* only accepted when its screen rectangle does not overlap an already
+* accepted one, which is checked against a screen-space grid hash. Accepted
+* labels fade in, rejected ones fade out.
+*
+* Drawing goes through a fixed pool of MAX_LABELS text drawables, and at
+* most MAX_NEW_LABELS_PER_FRAME labels get a new text laid out per frame, so
+* the label cost per frame is bounded whatever the number of waypoints. Each
+* text sits at the origin of its own transform, which is moved to the label,
+* so the float vertex positions stay small.
+*/
+class WaypointLabelNode : public osg::Group
+{
+public:
+
+	enum { MAX_LABELS = 256 };
+	enum { MAX_NEW_LABELS_PER_FRAME = 32 };
+
+	enum Priority
+	{
+		PRIORITY_ENDPOINT = 0,
+		PRIORITY_WAYPOINT = 1
+	};
+
+	WaypointLabelNode(const osg::EllipsoidModel* pEllipsoid, double dAltitude = 1000.0);
+
+	//add the labels of one route; vecNames holds one name per waypoint
+	unsigned int AddLine(const std::vector<osg::Vec2d>& vecLonLat, const std::vector<std::string>& vecNames);
+
+	void RemoveLine(unsigned int nLineId);
+
+	void Clear();
+
+	//re-sort the labels if lines were added or removed
+	void Update();
+
+	void SetCharacterSize(float fSize);
+
+	unsigned int GetNumLabels() const { return m_vecLabels.size(); }
+
+	unsigned int GetNumVisibleLabels() const { return m_nVisibleLabels; }
+
+	virtual void traverse(osg::NodeVisitor& nv) override;
+
+protected:
+
+	virtual ~WaypointLabelNode();
+
+private:
+
+	struct Label
+	{
+		osg::Vec3d world;
+		osg::Vec3d normal;
+		std::string strText;
+		unsigned int nLineId;
+		int nPriority;
+		float fAlpha;
+		int nSlot;
+	};
+
+	struct Rect
+	{
+		float x0, y0, x1, y1;
+	};
+
+	void Cull(osg::NodeVisitor& nv);
+
+	bool Overlaps(const Rect& rect) const;
+
+	void Insert(const Rect& rect);
+
+	int AcquireSlot(Label& label);
+
+	void ReleaseSlot(Label& label);
+
+	osg::ref_ptr<const osg::EllipsoidModel> m_pEllipsoid;
+	double m_dAltitude;
+	float m_fCharacterSize;
+
+	std::vector<Label> m_vecLabels;
+	std::vector<unsigned int> m_vecOrder;
+	unsigned int m_nNextLineId;
+	bool m_bDirty;
+	unsigned int m_nVisibleLabels;
+	double m_dLastTime;
+
+	//screen-space grid hash of the accepted rectangles, relative to the viewport origin
+	float m_fCellSize;
+	float m_fGridX;
+	float m_fGridY;
+	int m_nGridWidth;
+	int m_nGridHeight;
+	std::vector<std::vector<unsigned int> > m_vecGrid;
+	std::vector<unsigned int> m_vecTouchedCells;
+	std::vector<Rect> m_vecAccepted;
+
+	//one transform per slot, its node mask is 0 while the slot is free
+	std::vector<osg::ref_ptr<osg::MatrixTransform> > m_vecSlotNodes;
+	std::vector<osg::ref_ptr<osgText::Text> > m_vecSlots;
+	std::vector<unsigned int> m_vecFreeSlots;
+};
+
+#endif // WAYPOINTLABELNODE_H
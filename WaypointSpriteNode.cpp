@@ -0,0 +1,159 @@
+#include "WaypointSpriteNode.h"
+#include <osg/Depth>
+#include <osg/BlendFunc>
+#include <osg/Point>
+#include <osg/PointSprite>
+#include <osg/Texture2D>
+#include <osgDB/ReadFile>
+
+osg::StateSet* makeStateSet(float size)
+{
+	osg::StateSet *set = new osg::StateSet();
+
+	/// Setup cool blending
+	set->setMode(GL_BLEND, osg::StateAttribute::ON);
+	osg::BlendFunc *fn = new osg::BlendFunc();
+	fn->setFunction(osg::BlendFunc::SRC_ALPHA, osg::BlendFunc::DST_ALPHA);
+	set->setAttributeAndModes(fn, osg::StateAttribute::ON);
+
+	/// Setup the point sprites
+	osg::PointSprite *sprite = new osg::PointSprite();
+	set->setTextureAttributeAndModes(0, sprite, osg::StateAttribute::ON);
+
+	/// Give some size to the points to be able to see the sprite
+	osg::Point *point = new osg::Point();
+	point->setSize(size);
+	set->setAttribute(point);
+
+	/// Disable depth test to avoid sort problems and Lighting
+	set->setMode(GL_DEPTH_TEST, osg::StateAttribute::OFF);
+	set->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
+
+	/// The texture for the sprites, loaded once and shared by every sprite state set
+	static osg::ref_ptr<osg::Texture2D> s_spriteTexture;
+	if (!s_spriteTexture.valid())
+	{
+		s_spriteTexture = new osg::Texture2D();
+		s_spriteTexture->setImage(osgDB::readImageFile("C:/OSG_OSGEarth/OpenSceneGraph-Data/Images/particle.rgb"));
+	}
+	set->setTextureAttributeAndModes(0, s_spriteTexture.get(), osg::StateAttribute::ON);
+
+	return set;
+}
+
+WaypointSpriteNode::WaypointSpriteNode(const osg::EllipsoidModel* pEllipsoid, double dAltitude)
+	: m_pEllipsoid(pEllipsoid), m_dAltitude(dAltitude), m_nNextLineId(1), m_bDirty(false)
+	, m_endpointColor(1.0f, 0.0f, 0.0f, 1.0f), m_waypointColor(1.0f, 1.0f, 0.0f, 1.0f)
+{
+	m_pGeometry = new osg::Geometry;
+	m_pGeometry->setUseDisplayList(false);
+	m_pGeometry->setUseVertexBufferObjects(true);
+	m_pGeometry->setVertexArray(new osg::Vec3Array);
+	m_pGeometry->setColorArray(new osg::Vec4Array, osg::Array::BIND_PER_VERTEX);
+	m_pGeometry->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::POINTS, 0, 0));
+
+	m_pGeode = new osg::Geode;
+	m_pGeode->addDrawable(m_pGeometry.get());
+	m_pGeode->setStateSet(GetSharedStateSet());
+	addChild(m_pGeode.get());
+}
+
+WaypointSpriteNode::~WaypointSpriteNode()
+{
+
+}
+
+osg::StateSet* WaypointSpriteNode::GetSharedStateSet()
+{
+	static osg::ref_ptr<osg::StateSet> s_stateSet;
+	if (!s_stateSet.valid())
+	{
+		s_stateSet = makeStateSet(12.0f);
+
+		//makeStateSet switches the depth test off, which would show waypoints through
+		//the globe; test against the terrain but do not write, so sprites never hide each other
+		s_stateSet->setAttributeAndModes(new osg::Depth(osg::Depth::LESS, 0.0, 1.0, false), osg::StateAttribute::ON);
+	}
+
+	return s_stateSet.get();
+}
+
+unsigned int WaypointSpriteNode::AddLine(const std::vector<osg::Vec2d>& vecLonLat)
+{
+	std::vector<osg::Vec3d>& vecWorld = m_mapLines[m_nNextLineId];
+	vecWorld.resize(vecLonLat.size());
+
+	for (size_t i = 0; i < vecLonLat.size(); i++)
+	{
+		m_pEllipsoid->convertLatLongHeightToXYZ(osg::DegreesToRadians(vecLonLat[i].y()), osg::DegreesToRadians(vecLonLat[i].x()), m_dAltitude,
+			vecWorld[i].x(), vecWorld[i].y(), vecWorld[i].z());
+	}
+
+	m_bDirty = true;
+	return m_nNextLineId++;
+}
+
+void WaypointSpriteNode::RemoveLine(unsigned int nLineId)
+{
+	if (m_mapLines.erase(nLineId) > 0)
+		m_bDirty = true;
+}
+
+void WaypointSpriteNode::Clear()
+{
+	m_mapLines.clear();
+	m_bDirty = true;
+}
+
+void WaypointSpriteNode::SetColors(const osg::Vec4& endpointColor, const osg::Vec4& waypointColor)
+{
+	m_endpointColor = endpointColor;
+	m_waypointColor = waypointColor;
+	m_bDirty = true;
+}
+
+unsigned int WaypointSpriteNode::GetNumPoints() const
+{
+	return m_pGeometry->getVertexArray()->getNumElements();
+}
+
+void WaypointSpriteNode::Update()
+{
+	if (!m_bDirty)
+		return;
+
+	m_bDirty = false;
+
+	osg::Vec3Array* pVertices = static_cast<osg::Vec3Array*>(m_pGeometry->getVertexArray());
+	osg::Vec4Array* pColors = static_cast<osg::Vec4Array*>(m_pGeometry->getColorArray());
+	pVertices->clear();
+	pColors->clear();
+
+	if (!m_mapLines.empty())
+	{
+		//vertices are stored relative to the first waypoint to keep float precision
+		osg::Vec3d origin = m_mapLines.begin()->second.empty() ? osg::Vec3d() : m_mapLines.begin()->second.front();
+
+		for (std::map<unsigned int, std::vector<osg::Vec3d> >::const_iterator itr = m_mapLines.begin(); itr != m_mapLines.end(); itr++)
+		{
+			const std::vector<osg::Vec3d>& vecWorld = itr->second;
+			for (size_t i = 0; i < vecWorld.size(); i++)
+			{
+				bool bEndpoint = (i == 0 || i + 1 == vecWorld.size());
+				pVertices->push_back(osg::Vec3(vecWorld[i] - origin));
+				pColors->push_back(bEndpoint ? m_endpointColor : m_waypointColor);
+			}
+		}
+
+		setMatrix(osg::Matrix::translate(origin));
+	}
+
+	pVertices->dirty();
+	pColors->dirty();
+
+	osg::DrawArrays* pDrawArrays = static_cast<osg::DrawArrays*>(m_pGeometry->getPrimitiveSet(0));
+	pDrawArrays->setCount(pVertices->size());
+	pDrawArrays->dirty();
+
+	m_pGeometry->dirtyBound();
+}
@@ -0,0 +1,64 @@
+#ifndef WAYPOINTSPRITENODE_H
+#define WAYPOINTSPRITENODE_H
+
+#include <osg/MatrixTransform>
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/EllipsoidModel>
+
+#include <map>
+#include <vector>
+
+/**
+* Draws every waypoint of a route layer as one point sprite geometry, so a
+* layer costs a single draw call whatever its size. The sprite texture and
+* state set are shared by all layers; the first and last waypoint of each
+* route get the endpoint color, the others the waypoint color.
+*/
+class WaypointSpriteNode : public osg::MatrixTransform
+{
+public:
+
+	WaypointSpriteNode(const osg::EllipsoidModel* pEllipsoid, double dAltitude = 1000.0);
+
+	//add the waypoints of one route as (lon, lat) degrees; the scene changes on the next Update()
+	unsigned int AddLine(const std::vector<osg::Vec2d>& vecLonLat);
+
+	void RemoveLine(unsigned int nLineId);
+
+	void Clear();
+
+	//rebuild the point arrays if lines were added or removed
+	void Update();
+
+	void SetColors(const osg::Vec4& endpointColor, const osg::Vec4& waypointColor);
+
+	unsigned int GetNumPoints() const;
+
+protected:
+
+	virtual ~WaypointSpriteNode();
+
+private:
+
+	static osg::StateSet* GetSharedStateSet();
+
+	osg::ref_ptr<const osg::EllipsoidModel> m_pEllipsoid;
+	double m_dAltitude;
+
+	//world positions of each route's waypoints, keyed by line id
+	std::map<unsigned int, std::vector<osg::Vec3d> > m_mapLines;
+	unsigned int m_nNextLineId;
+	bool m_bDirty;
+
+	osg::Vec4 m_endpointColor;
+	osg::Vec4 m_waypointColor;
+
+	osg::ref_ptr<osg::Geode> m_pGeode;
+	osg::ref_ptr<osg::Geometry> m_pGeometry;
+};
+
+//blended point sprite state with the shared particle texture, depth test off
+osg::StateSet* makeStateSet(float size);
+
+#endif // WAYPOINTSPRITENODE_H
@@ -0,0 +1,113 @@
+#include "WorkerPool.h"
+
+#include <OpenThreads/ScopedLock>
+
+WorkerPool::WorkerPool(unsigned int nThreads)
+	: m_nGeneration(0)
+	, m_nBusy(0)
+	, m_bQuit(false)
+	, m_pFunc(nullptr)
+	, m_nCount(0)
+	, m_nGrain(1)
+	, m_nNext(0)
+{
+	if (nThreads == 0)
+	{
+		int nProcessors = OpenThreads::GetNumberOfProcessors();
+		nThreads = nProcessors > 1 ? nProcessors - 1 : 0;
+	}
+
+	for (unsigned int i = 0; i < nThreads; i ++)
+	{
+		Worker* pWorker = new Worker(this, i + 1);
+		m_vecThreads.push_back(pWorker);
+		pWorker->start();
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+		m_bQuit = true;
+		m_conditionStart.broadcast();
+	}
+
+	for (unsigned int i = 0; i < m_vecThreads.size(); i ++)
+	{
+		m_vecThreads[i]->join();
+		delete m_vecThreads[i];
+	}
+}
+
+void WorkerPool::Worker::run()
+{
+	unsigned int nGeneration = 0;
+	for (;;)
+	{
+		{
+			OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_pPool->m_mutex);
+			while (!m_pPool->m_bQuit && m_pPool->m_nGeneration == nGeneration)
+				m_pPool->m_conditionStart.wait(&m_pPool->m_mutex);
+
+			if (m_pPool->m_bQuit)
+				return;
+
+			nGeneration = m_pPool->m_nGeneration;
+		}
+
+		m_pPool->Work(m_nWorker);
+
+		OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_pPool->m_mutex);
+		if (-- m_pPool->m_nBusy == 0)
+			m_pPool->m_conditionDone.signal();
+	}
+}
+
+void WorkerPool::Work(unsigned int nWorker)
+{
+	for (;;)
+	{
+		unsigned int nBegin = m_nNext.fetch_add(m_nGrain, std::memory_order_relaxed);
+		if (nBegin >= m_nCount)
+			break;
+
+		unsigned int nEnd = nBegin + m_nGrain < m_nCount ? nBegin + m_nGrain : m_nCount;
+		(*m_pFunc)(nBegin, nEnd, nWorker);
+	}
+}
+
+void WorkerPool::ParallelFor(unsigned int nCount, unsigned int nGrain, const Func& func)
+{
+	if (nCount == 0)
+		return;
+
+	if (nGrain == 0)
+		nGrain = 1;
+
+	//ֵû߳ʱֱڵ߳
+	if (m_vecThreads.empty() || nCount <= nGrain)
+	{
+		func(0, nCount, 0);
+		return;
+	}
+
+	{
+		OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+		m_pFunc = &func;
+		m_nCount = nCount;
+		m_nGrain = nGrain;
+		m_nNext.store(0, std::memory_order_relaxed);
+		m_nBusy = m_vecThreads.size();
+		m_nGeneration ++;
+		m_conditionStart.broadcast();
+	}
+
+	Work(0);
+
+	OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+	while (m_nBusy > 0)
+		m_conditionDone.wait(&m_mutex);
+
+	m_pFunc = nullptr;
+}
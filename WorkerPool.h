@@ -0,0 +1,76 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <atomic>
+#include <functional>
+#include <vector>
+
+#include <OpenThreads/Condition>
+#include <OpenThreads/Mutex>
+#include <OpenThreads/Thread>
+
+/**
+* Fixed set of worker threads for data-parallel loops.
+*
+* ParallelFor hands out [nBegin, nEnd) ranges of nGrain items from a shared
+* counter, so uneven items balance themselves, and the calling thread works
+* on the loop too before it waits for the others. Each call passes the
+* worker number, 0 for the caller, so the loop body can write into
+* per-worker buffers without locking.
+*
+* One loop at a time: ParallelFor must not be called from two threads at
+* once or from inside a loop body.
+*/
+class WorkerPool
+{
+public:
+
+	typedef std::function<void(unsigned int nBegin, unsigned int nEnd, unsigned int nWorker)> Func;
+
+	//0 starts one thread per processor besides the caller
+	WorkerPool(unsigned int nThreads = 0);
+	~WorkerPool();
+
+	//threads plus the caller
+	unsigned int GetNumWorkers() const { return m_vecThreads.size() + 1; }
+
+	void ParallelFor(unsigned int nCount, unsigned int nGrain, const Func& func);
+
+private:
+
+	class Worker : public OpenThreads::Thread
+	{
+	public:
+
+		Worker(WorkerPool* pPool, unsigned int nWorker) : m_pPool(pPool), m_nWorker(nWorker) {}
+
+		virtual void run() override;
+
+	private:
+
+		WorkerPool* m_pPool;
+		unsigned int m_nWorker;
+	};
+
+	void Work(unsigned int nWorker);
+
+	WorkerPool(const WorkerPool&);
+	WorkerPool& operator=(const WorkerPool&);
+
+	std::vector<Worker*> m_vecThreads;
+
+	OpenThreads::Mutex m_mutex;
+	OpenThreads::Condition m_conditionStart;
+	OpenThreads::Condition m_conditionDone;
+	unsigned int m_nGeneration;
+	unsigned int m_nBusy;
+	bool m_bQuit;
+
+	//the current loop, only valid while m_nBusy is not 0
+	const Func* m_pFunc;
+	unsigned int m_nCount;
+	unsigned int m_nGrain;
+	std::atomic<unsigned int> m_nNext;
+};
+
+#endif // WORKERPOOL_H
@@ -0,0 +1,598 @@
+#include "Benchmark.h"
+
+#include "../GPSPosEvent.h"
+#include "../UDPServer.h"
+#include "../Aero2Shp.h"
+#include "../MyPlaceNode.h"
+#include "../ScaleBarRefresh.h"
+#include "../RouteConformance.h"
+#include "../TrackHistoryStore.h"
+#include "../TrackSpatialIndex.h"
+#include "../ConflictProbe.h"
+#include "../Geofence.h"
+#include "../CorridorSeeder.h"
+#include "../GeoTiffPrep.h"
+#include "../TextureCompressor.h"
+#include "../WorkerPool.h"
+#include "../TrailNode.h"
+
+#include <osg/Geometry>
+#include <osg/Math>
+#include <osgText/Text>
+#include <osgEarth/Map>
+#include <osgEarth/MapNode>
+#include <osgEarth/SpatialReference>
+#include <osgEarth/ImageLayer>
+#include <osgEarth/Registry>
+#include <osgEarthDrivers/gdal/GDALOptions>
+
+#include "gdal_priv.h"
+#include "ogr_spatialref.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QTextStream>
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace osgEarth;
+using namespace osgEarth::Annotation;
+
+//Ӧóﶨȫֱ,׼Լṩ
+osg::Node* g_earthNode = nullptr;
+RouteConformance* g_pRouteConformance = nullptr;
+osgEarth::MapNode* g_MapNode = nullptr;
+osg::Geometry* g_GeoScaleLine = nullptr;
+osgText::Text* g_pText = nullptr;
+
+//һļ: nLines,ÿnPoints,зָ
+static bool WriteAeroFile(const QString& strFile, int nLines, int nPoints)
+{
+	QFile file(strFile);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+		return false;
+
+	QTextStream stream(&file);
+	for (int i = 0; i < nLines; i ++)
+	{
+		for (int j = 0; j < nPoints; j ++)
+			stream << QString::number(20.0 + i * 0.1, 'f', 6) << "," << QString::number(100.0 + j * 0.2, 'f', 6) << "\n";
+		stream << "\n";
+	}
+
+	return true;
+}
+
+//һ桢ûнRGBӰ,Ƕ100102ȡγ2022
+static bool WriteStripTiff(const QString& strFile, int nSize)
+{
+	GDALAllRegister();
+	GDALDatasetH hDataset = GDALCreate(GDALGetDriverByName("GTiff"), strFile.toUtf8().data(), nSize, nSize, 3, GDT_Byte, nullptr);
+	if (!hDataset)
+		return false;
+
+	double pTransform[6] = { 100.0, 2.0 / nSize, 0.0, 22.0, 0.0, -2.0 / nSize };
+	GDALSetGeoTransform(hDataset, pTransform);
+
+	OGRSpatialReference wgs84;
+	wgs84.SetWellKnownGeogCS("WGS84");
+	char* pWkt = nullptr;
+	wgs84.exportToWkt(&pWkt);
+	GDALSetProjection(hDataset, pWkt);
+	CPLFree(pWkt);
+
+	std::vector<unsigned char> vecRow(nSize);
+	bool bOk = true;
+	for (int nBand = 1; nBand <= 3 && bOk; nBand ++)
+	{
+		for (int y = 0; y < nSize && bOk; y ++)
+		{
+			for (int x = 0; x < nSize; x ++)
+				vecRow[x] = (unsigned char)((x * nBand + y * 3) ^ (x >> 4));
+			bOk = GDALRasterIO(GDALGetRasterBand(hDataset, nBand), GF_Write, 0, y, nSize, 1, &vecRow[0], nSize, 1, GDT_Byte, 0, 0) == CE_None;
+		}
+	}
+
+	GDALClose(hDataset);
+	return bOk;
+}
+
+static osgEarth::ImageLayer* CreateGdalLayer(const QString& strFile)
+{
+	osgEarth::Drivers::GDALOptions gdal;
+	gdal.url() = osgEarth::URI(strFile.toUtf8().data());
+	osgEarth::ImageLayer* pLayer = new osgEarth::ImageLayer(osgEarth::ImageLayerOptions(strFile.toUtf8().data(), gdal));
+	pLayer->setTargetProfileHint(osgEarth::Registry::instance()->getGlobalGeodeticProfile());
+	return pLayer;
+}
+
+static osg::Geometry* CreateScaleLine()
+{
+	osg::Geometry* pGeometry = new osg::Geometry;
+	pGeometry->setVertexArray(new osg::Vec3dArray(7));
+	pGeometry->setUseDisplayList(false);
+	pGeometry->setUseVertexBufferObjects(true);
+	pGeometry->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::LINE_STRIP, 0, 7));
+	return pGeometry;
+}
+
+static void PrintUsage()
+{
+	printf("usage: routemonitor_bench [--filter name] [--min-time seconds] [--runs n] [--json file]\n");
+}
+
+int main(int argc, char** argv)
+{
+	QCoreApplication app(argc, argv);
+
+	std::string strFilter;
+	std::string strJsonFile;
+	Benchmark benchmark;
+
+	for (int i = 1; i < argc; i ++)
+	{
+		if (!strcmp(argv[i], "--filter") && i + 1 < argc)
+			strFilter = argv[++i];
+		else if (!strcmp(argv[i], "--min-time") && i + 1 < argc)
+			benchmark.SetMinTime(atof(argv[++i]));
+		else if (!strcmp(argv[i], "--runs") && i + 1 < argc)
+			benchmark.SetRuns(atoi(argv[++i]));
+		else if (!strcmp(argv[i], "--json") && i + 1 < argc)
+			strJsonFile = argv[++i];
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	osg::ref_ptr<MapNode> mapNode = new MapNode(new Map());
+	g_earthNode = mapNode.get();
+	g_MapNode = mapNode.get();
+
+	const SpatialReference* pwgs84 = SpatialReference::get("wgs84");
+	const SpatialReference* mapSRS = mapNode->getMapSRS();
+
+	//Ľ
+	char datagram[25];
+	memset(datagram, 0, sizeof(datagram));
+	double pValues[3] = { 116.39, 39.91, 45.0 };
+	memcpy(datagram + 1, pValues, sizeof(pValues));
+
+	benchmark.Add("datagram_decode", [&datagram](unsigned int nIterations)
+	{
+		double dLon, dLat, dAngle;
+		for (unsigned int i = 0; i < nIterations; i ++)
+		{
+			datagram[1] = (char)i;
+			if (DecodePosDatagram(datagram, sizeof(datagram), dLon, dLat, dAngle))
+				BenchKeep(dLon);
+		}
+	});
+
+	//γȵͼ,readPendingDatagramsͬĵ
+	benchmark.Add("srs_transform", [pwgs84, mapSRS](unsigned int nIterations)
+	{
+		osg::Vec3d world;
+		for (unsigned int i = 0; i < nIterations; i ++)
+		{
+			pwgs84->transform(osg::Vec3d(100.0 + (i & 1023) * 0.01, 30.0, 10000.0), mapSRS, world);
+			BenchKeep(world.x());
+		}
+	});
+
+	//׷һ,ѹ˵Ŀ͸¿ſĶ
+	osg::ref_ptr<TrailNode> trailNode = new TrailNode(pwgs84->getEllipsoid());
+
+	benchmark.Add("trail_append", [trailNode](unsigned int nIterations)
+	{
+		for (unsigned int i = 0; i < nIterations; i ++)
+		{
+			if (trailNode->GetTrail().GetNumBlocks() >= TrailNode::MAX_BLOCKS)
+				trailNode->Clear();
+			trailNode->Append(1e9 + i * 0.25, 100.0 + (i & 65535) * 3e-4, 30.0 + (i & 65535) * 2e-4, 10000.0);
+		}
+	});
+
+	//ѹһ(256),4Hzֱߵĺ
+	CompressedTrail compressedTrail;
+	for (unsigned int i = 0; i < 100000; i ++)
+	{
+		CompressedTrail::Point point = { 1e9 + i * 0.25, 100.0 + i * 3e-4, 30.0 + i * 2e-4, 10000.0 };
+		compressedTrail.Append(point);
+	}
+	printf("trail: %u points, %.2f bytes per point compressed, %u bytes per point as ECEF Vec3d\n",
+		compressedTrail.GetNumPoints(), (double)compressedTrail.GetMemoryBytes() / compressedTrail.GetNumPoints(), (unsigned int)sizeof(osg::Vec3d));
+
+	benchmark.Add("trail_decode_block", [&compressedTrail](unsigned int nIterations)
+	{
+		std::vector<CompressedTrail::Point> vecPoints;
+		vecPoints.reserve(CompressedTrail::BLOCK_POINTS);
+		for (unsigned int i = 0; i < nIterations; i ++)
+		{
+			vecPoints.clear();
+			compressedTrail.DecodeBlock(i % compressedTrail.GetNumBlocks(), vecPoints);
+			BenchKeep(vecPoints.back().dLon);
+		}
+	});
+
+	osg::ref_ptr<MyPlaceNode> placeNode = new MyPlaceNode(mapNode.get(), GeoPoint(pwgs84, 100.0, 30.0, 2000.0), "", Style());
+
+	benchmark.Add("rotate_heading", [placeNode](unsigned int nIterations)
+	{
+		for (unsigned int i = 0; i < nIterations; i ++)
+			placeNode->RotateHeading(i % 360);
+	});
+
+	QString strTempDir = QDir::tempPath() + "/routemonitor_bench";
+	QDir().mkpath(strTempDir);
+	QString strAeroFile = strTempDir + "/routes.dat";
+	if (!WriteAeroFile(strAeroFile, 100, 50))
+	{
+		printf("cannot write %s\n", strAeroFile.toLocal8Bit().data());
+		return 1;
+	}
+
+	benchmark.Add("aero_parse", [strAeroFile](unsigned int nIterations)
+	{
+		for (unsigned int i = 0; i < nIterations; i ++)
+		{
+			QList<QList<ptd> > listLines;
+			Aero2Shp::ReadFile(strAeroFile, listLines);
+			BenchKeep(listLines.size());
+		}
+	});
+
+	benchmark.Add("aero_translate", [strAeroFile, strTempDir](unsigned int nIterations)
+	{
+		for (unsigned int i = 0; i < nIterations; i ++)
+		{
+			QStringList listShp;
+			listShp << strTempDir + QString("/line%1.shp").arg(i & 1) << strTempDir + QString("/point%1.shp").arg(i & 1);
+			for (int n = 0; n < listShp.size(); n ++)
+			{
+				QString strBase = listShp[n].left(listShp[n].size() - 4);
+				QFile::remove(strBase + ".shp");
+				QFile::remove(strBase + ".shx");
+				QFile::remove(strBase + ".dbf");
+				QFile::remove(strBase + ".prj");
+			}
+
+			Aero2Shp::TranslateFile(strAeroFile, listShp);
+		}
+	});
+
+	//: ÿб仯,¼
+	osg::ref_ptr<osg::Geometry> scaleLine = CreateScaleLine();
+	osg::ref_ptr<osgText::Text> scaleText = new osgText::Text;
+	g_GeoScaleLine = scaleLine.get();
+	g_pText = scaleText.get();
+
+	osg::ref_ptr<osg::Camera> camera = new osg::Camera;
+	camera->setViewport(0, 0, 1280, 800);
+	camera->setProjectionMatrixAsPerspective(30.0, 1280.0 / 800.0, 1000.0, 1e8);
+
+	ScaleBarRefresh scaleBarRefresh;
+	const osg::EllipsoidModel* pEllipsoid = mapSRS->getEllipsoid();
+
+	benchmark.Add("scale_bar", [&scaleBarRefresh, camera, pEllipsoid](unsigned int nIterations)
+	{
+		for (unsigned int i = 0; i < nIterations; i ++)
+		{
+			double dX, dY, dZ;
+			pEllipsoid->convertLatLongHeightToXYZ(osg::DegreesToRadians(30.0), osg::DegreesToRadians(100.0 + (i & 255) * 0.01), 2e6 + i % 7, dX, dY, dZ);
+			osg::Matrixd matView = osg::Matrixd::lookAt(osg::Vec3d(dX, dY, dZ), osg::Vec3d(0.0, 0.0, 0.0), osg::Vec3d(0.0, 0.0, 1.0));
+			scaleBarRefresh.Update(matView, camera.get());
+		}
+	});
+
+	//ʷ: 10001Сʱ1Hz,׷ӺͰʱ/ѯ
+	TrackHistoryStore trackHistory;
+	QDir(strTempDir + "/history").removeRecursively();
+	if (!trackHistory.Open(strTempDir + "/history"))
+	{
+		printf("cannot open %s/history\n", strTempDir.toLocal8Bit().data());
+		return 1;
+	}
+
+	for (int t = 0; t < 3600; t ++)
+	{
+		for (unsigned int nId = 0; nId < 1000; nId ++)
+			trackHistory.Append(nId, 1e9 + t, 100.0 + nId * 0.01 + t * 1e-4, 30.0 + t * 1e-4, 10000.0, 90.0);
+	}
+	trackHistory.Flush();
+
+	benchmark.Add("history_append", [&trackHistory](unsigned int nIterations)
+	{
+		for (unsigned int i = 0; i < nIterations; i ++)
+			trackHistory.Append(2000 + (i & 1023), 2e9 + (i >> 10), 100.0, 30.0, 10000.0, 90.0);
+	});
+
+	benchmark.Add("history_query_track", [&trackHistory](unsigned int nIterations)
+	{
+		std::vector<TrackHistoryStore::Sample> vecSamples;
+		for (unsigned int i = 0; i < nIterations; i ++)
+		{
+			vecSamples.clear();
+			BenchKeep(trackHistory.QueryTrack(i % 1000, 1e9 + 600.0, 1e9 + 1200.0, vecSamples));
+		}
+	});
+
+	//طŶλ: 1000һĳʱ̵λ
+	benchmark.Add("history_seek_1000_tracks", [&trackHistory](unsigned int nIterations)
+	{
+		TrackHistoryStore::Sample sample;
+		for (unsigned int i = 0; i < nIterations; i ++)
+		{
+			double dTime = 1e9 + (i * 7919) % 3600 + 0.5;
+			for (unsigned int nId = 0; nId < 1000; nId ++)
+			{
+				if (trackHistory.SampleAt(nId, dTime, sample))
+					BenchKeep(sample.dLon);
+			}
+		}
+	});
+
+	//طŶλͬؽ,TrackPlayback::Seekһÿػ10
+	std::vector<osg::ref_ptr<TrailNode> > vecSeekTrails;
+	for (unsigned int nId = 0; nId < 1000; nId ++)
+		vecSeekTrails.push_back(new TrailNode(pwgs84->getEllipsoid()));
+
+	benchmark.Add("history_seek_1000_tracks_with_trails", [&trackHistory, &vecSeekTrails](unsigned int nIterations)
+	{
+		TrackHistoryStore::Sample sample;
+		std::vector<TrackHistoryStore::Sample> vecSamples;
+		for (unsigned int i = 0; i < nIterations; i ++)
+		{
+			double dTime = 1e9 + (i * 7919) % 3600 + 0.5;
+			for (unsigned int nId = 0; nId < 1000; nId ++)
+			{
+				if (trackHistory.SampleAt(nId, dTime, sample))
+					BenchKeep(sample.dLon);
+
+				TrailNode* pTrail = vecSeekTrails[nId].get();
+				pTrail->Clear();
+				vecSamples.clear();
+				trackHistory.QueryTrack(nId, dTime - 600.0, dTime, vecSamples);
+				for (size_t n = 0; n < vecSamples.size(); n ++)
+					pTrail->Append(vecSamples[n].dTime, vecSamples[n].dLon, vecSamples[n].dLat, vecSamples[n].dAlt);
+			}
+		}
+	});
+
+	benchmark.Add("history_query_box", [&trackHistory](unsigned int nIterations)
+	{
+		std::vector<TrackHistoryStore::Sample> vecSamples;
+		for (unsigned int i = 0; i < nIterations; i ++)
+		{
+			vecSamples.clear();
+			BenchKeep(trackHistory.QueryBox(1e9 + 1000.0, 1e9 + 1100.0, 100.0, 30.0, 101.0, 31.0, vecSamples));
+		}
+	});
+
+	//ռ: 5ֲڶϿ
+	TrackSpatialIndex trackIndex;
+	for (unsigned int nId = 0; nId < 50000; nId ++)
+		trackIndex.Update(nId, 90.0 + (nId * 7919 % 40000) * 1e-3, 15.0 + (nId * 104729 % 30000) * 1e-3);
+
+	benchmark.Add("spatial_update", [&trackIndex](unsigned int nIterations)
+	{
+		for (unsigned int i = 0; i < nIterations; i ++)
+		{
+			unsigned int nId = i % 50000;
+			trackIndex.Update(nId, 90.0 + (nId * 7919 % 40000) * 1e-3 + (i & 255) * 1e-3, 15.0 + (nId * 104729 % 30000) * 1e-3);
+		}
+	});
+
+	benchmark.Add("spatial_radius_20nm", [&trackIndex](unsigned int nIterations)
+	{
+		std::vector<TrackSpatialIndex::Hit> vecHits;
+		for (unsigned int i = 0; i < nIterations; i ++)
+		{
+			vecHits.clear();
+			BenchKeep(trackIndex.QueryRadius(95.0 + (i % 300) * 0.1, 20.0 + (i % 200) * 0.1, 20.0 * 1852.0, vecHits));
+		}
+	});
+
+	benchmark.Add("spatial_nearest_5", [&trackIndex](unsigned int nIterations)
+	{
+		std::vector<TrackSpatialIndex::Hit> vecHits;
+		for (unsigned int i = 0; i < nIterations; i ++)
+		{
+			vecHits.clear();
+			BenchKeep(trackIndex.QueryNearest(95.0 + (i % 300) * 0.1, 20.0 + (i % 200) * 0.1, 5, vecHits));
+		}
+	});
+
+	//ͻ̽: 1,8߶Ȳ,
+	std::vector<TrackTable::Row> vecConflictRows(10000);
+	for (unsigned int i = 0; i < vecConflictRows.size(); i ++)
+	{
+		TrackTable::Row& row = vecConflictRows[i];
+		row.nId = i;
+		row.dTime = 1e9 - (i % 5);
+		row.dLon = 90.0 + (i * 7919 % 40000) * 1e-3;
+		row.dLat = 15.0 + (i * 104729 % 30000) * 1e-3;
+		row.dAlt = 9000.0 + (i % 8) * 300.0;
+		row.dHeading = (i * 37 % 360);
+		row.dVelocity = 200.0 + (i % 50);
+		row.nFlags = TrackTable::FLAG_VALID;
+	}
+
+	WorkerPool workerPool;
+	benchmark.Add("conflict_probe_10k", [&vecConflictRows, &workerPool](unsigned int nIterations)
+	{
+		ConflictProbe probe(&workerPool);
+		std::vector<ConflictProbe::Conflict> vecConflicts;
+		for (unsigned int i = 0; i < nIterations; i ++)
+			BenchKeep(probe.Run(vecConflictRows, 1e9, vecConflicts));
+	});
+
+	benchmark.Add("conflict_probe_10k_1thread", [&vecConflictRows](unsigned int nIterations)
+	{
+		ConflictProbe probe;
+		std::vector<ConflictProbe::Conflict> vecConflicts;
+		for (unsigned int i = 0; i < nIterations; i ++)
+			BenchKeep(probe.Run(vecConflictRows, 1e9, vecConflicts));
+	});
+
+	//: 300064,5000
+	Geofence geofence;
+	for (unsigned int nFence = 0; nFence < 3000; nFence ++)
+	{
+		double dCenterLon = 90.0 + (nFence * 7919 % 40000) * 1e-3;
+		double dCenterLat = 15.0 + (nFence * 104729 % 30000) * 1e-3;
+		double dRadius = 0.05 + (nFence % 13) * 0.04;
+
+		std::vector<std::vector<osg::Vec2d> > vecRings(1);
+		for (int i = 0; i < 64; i ++)
+		{
+			double dAngle = osg::PI * 2.0 * i / 64;
+			double dScale = (i & 1) ? 0.8 : 1.0;
+			vecRings[0].push_back(osg::Vec2d(dCenterLon + dRadius * dScale * cos(dAngle), dCenterLat + dRadius * dScale * sin(dAngle)));
+		}
+		geofence.AddFence("bench", vecRings);
+	}
+
+	benchmark.Add("geofence_update", [&geofence](unsigned int nIterations)
+	{
+		std::vector<Geofence::Event> vecEvents;
+		for (unsigned int i = 0; i < nIterations; i ++)
+		{
+			unsigned int nId = i % 5000;
+			vecEvents.clear();
+			BenchKeep(geofence.Update(nId, 90.0 + (nId * 7919 % 40000) * 1e-3 + (i / 5000 % 1000) * 2e-3, 15.0 + (nId * 104729 % 30000) * 1e-3, vecEvents));
+		}
+	});
+
+	//·Ԥ: 3,ȫγ,20
+	std::vector<std::vector<osg::Vec2d> > vecSeedLines(3);
+	for (int i = 0; i < 3; i ++)
+	{
+		for (int j = 0; j < 20; j ++)
+			vecSeedLines[i].push_back(osg::Vec2d(100.0 + j * 1.0, 20.0 + i * 5.0 + (j % 3) * 0.5));
+	}
+
+	CorridorSeeder::Grid seedGrid = { true, -180.0, -90.0, 180.0, 90.0, 2, 1 };
+	benchmark.Add("corridor_rasterize_l0_14", [&vecSeedLines, seedGrid](unsigned int nIterations)
+	{
+		for (unsigned int i = 0; i < nIterations; i ++)
+		{
+			CorridorSeeder seeder(seedGrid, CorridorSeeder::SeedFunc());
+			seeder.SetBuffer(20000.0);
+			seeder.SetLevels(0, 14);
+			for (size_t j = 0; j < vecSeedLines.size(); j ++)
+				seeder.AddLine(vecSeedLines[j]);
+			BenchKeep(seeder.CountTiles());
+		}
+	});
+
+	//ļƬ: ÿƬдһСļ,һε08
+	QString strSeedDir = strTempDir + "/seed";
+	QDir().mkpath(strSeedDir);
+	benchmark.Add("corridor_seed_local_l0_8", [&vecSeedLines, seedGrid, strSeedDir](unsigned int nIterations)
+	{
+		std::vector<char> vecTile(4096, 'x');
+		for (unsigned int i = 0; i < nIterations; i ++)
+		{
+			CorridorSeeder seeder(seedGrid, [&vecTile, strSeedDir](unsigned int nLevel, unsigned int x, unsigned int y) -> bool
+			{
+				QFile file(strSeedDir + QString("/%1_%2_%3.bin").arg(nLevel).arg(x).arg(y));
+				return file.open(QIODevice::WriteOnly) && file.write(&vecTile[0], vecTile.size()) == (qint64)vecTile.size();
+			});
+			seeder.SetBuffer(20000.0);
+			seeder.SetLevels(0, 8);
+			for (size_t j = 0; j < vecSeedLines.size(); j ++)
+				seeder.AddLine(vecSeedLines[j]);
+
+			seeder.Start();
+			while (seeder.IsRunning())
+				OpenThreads::Thread::microSleep(1000);
+			BenchKeep(seeder.GetNumDone());
+		}
+	});
+
+	//GDALͼƬ: 4096ӰԤķֿ汾,ȡԭʼֱ664Ƭ
+	QString strRawTiff = strTempDir + "/raster.tif";
+	std::vector<osgEarth::TileKey> vecRasterKeys;
+	osg::ref_ptr<osgEarth::ImageLayer> rawLayer;
+	osg::ref_ptr<osgEarth::ImageLayer> preparedLayer;
+	QString strPrepError;
+	if (WriteStripTiff(strRawTiff, 4096)
+		&& GeoTiffPrep::Prepare(strRawTiff, GeoTiffPrep::GetPreparedName(strRawTiff), GeoTiffPrep::Options(), strPrepError))
+	{
+		GeoTiffPrep::CollectSampleKeys(strRawTiff, 64, vecRasterKeys);
+		rawLayer = CreateGdalLayer(strRawTiff);
+		preparedLayer = CreateGdalLayer(GeoTiffPrep::GetPreparedName(strRawTiff));
+	}
+
+	if (!vecRasterKeys.empty() && rawLayer->getTileSource() && preparedLayer->getTileSource())
+	{
+		benchmark.Add("geotiff_tile_raw", [rawLayer, &vecRasterKeys](unsigned int nIterations)
+		{
+			for (unsigned int i = 0; i < nIterations; i ++)
+				BenchKeep(rawLayer->createImage(vecRasterKeys[i % vecRasterKeys.size()]).valid());
+		});
+
+		benchmark.Add("geotiff_tile_prepared", [preparedLayer, &vecRasterKeys](unsigned int nIterations)
+		{
+			for (unsigned int i = 0; i < nIterations; i ++)
+				BenchKeep(preparedLayer->createImage(vecRasterKeys[i % vecRasterKeys.size()]).valid());
+		});
+	}
+	else
+		printf("geotiff cases skipped: cannot prepare %s\n", strRawTiff.toLocal8Bit().data());
+
+	//һ256ӰƬͬȫmipmapѹBC1BC3,ÿƬӵӳ
+	osg::ref_ptr<osg::Image> tileImage = new osg::Image;
+	tileImage->allocateImage(256, 256, 1, GL_RGBA, GL_UNSIGNED_BYTE);
+	for (int y = 0; y < 256; y ++)
+	{
+		unsigned char* pRow = tileImage->data(0, y);
+		for (int x = 0; x < 256; x ++)
+		{
+			pRow[x * 4] = (unsigned char)(128 + 100 * sin(x * 0.05) + (x * y * 7919 % 16));
+			pRow[x * 4 + 1] = (unsigned char)(y * 0.9 + (x * 104729 % 8));
+			pRow[x * 4 + 2] = (unsigned char)((x + y) / 3);
+			pRow[x * 4 + 3] = 255;
+		}
+	}
+
+	benchmark.Add("texture_compress_bc1_256", [tileImage](unsigned int nIterations)
+	{
+		for (unsigned int i = 0; i < nIterations; i ++)
+		{
+			osg::ref_ptr<osg::Image> compressed = TextureCompressor::Compress(tileImage.get(), TextureCompressor::FORMAT_BC1);
+			BenchKeep(compressed->getTotalSizeInBytesIncludingMipmaps());
+		}
+	});
+
+	benchmark.Add("texture_compress_bc3_256", [tileImage](unsigned int nIterations)
+	{
+		for (unsigned int i = 0; i < nIterations; i ++)
+		{
+			osg::ref_ptr<osg::Image> compressed = TextureCompressor::Compress(tileImage.get(), TextureCompressor::FORMAT_BC3);
+			BenchKeep(compressed->getTotalSizeInBytesIncludingMipmaps());
+		}
+	});
+
+	benchmark.Run(strFilter);
+
+	if (!strJsonFile.empty())
+	{
+		FILE* pFile = fopen(strJsonFile.c_str(), "wb");
+		if (!pFile)
+		{
+			printf("cannot write %s\n", strJsonFile.c_str());
+			return 1;
+		}
+
+		std::string strJson = benchmark.ToJson();
+		fwrite(strJson.data(), 1, strJson.size(), pFile);
+		fclose(pFile);
+	}
+
+	return 0;
+}
@@ -0,0 +1,95 @@
+#include "Benchmark.h"
+
+#include <osg/Timer>
+
+#include <algorithm>
+#include <stdio.h>
+
+static volatile double s_dSink = 0.0;
+
+void BenchKeep(double dValue)
+{
+	s_dSink = s_dSink + dValue;
+}
+
+Benchmark::Benchmark()
+	: m_dMinTime(0.2)
+	, m_nRuns(5)
+{
+
+}
+
+void Benchmark::Add(const std::string& strName, Func func)
+{
+	Case benchCase;
+	benchCase.strName = strName;
+	benchCase.func = func;
+	m_vecCases.push_back(benchCase);
+}
+
+void Benchmark::Run(const std::string& strFilter)
+{
+	osg::Timer* pTimer = osg::Timer::instance();
+
+	printf("%-24s %12s %14s %14s\n", "benchmark", "iterations", "median ns/op", "min ns/op");
+
+	for (unsigned int i = 0; i < m_vecCases.size(); i ++)
+	{
+		const Case& benchCase = m_vecCases[i];
+		if (!strFilter.empty() && benchCase.strName.find(strFilter) == std::string::npos)
+			continue;
+
+		//,ֱдﵽʱ
+		unsigned int nIterations = 1;
+		for (;;)
+		{
+			osg::Timer_t tickStart = pTimer->tick();
+			benchCase.func(nIterations);
+			double dSeconds = pTimer->delta_s(tickStart, pTimer->tick());
+
+			if (dSeconds >= m_dMinTime || nIterations >= (1u << 30))
+				break;
+
+			nIterations *= 2;
+		}
+
+		std::vector<double> vecNs(m_nRuns);
+		for (unsigned int n = 0; n < m_nRuns; n ++)
+		{
+			osg::Timer_t tickStart = pTimer->tick();
+			benchCase.func(nIterations);
+			vecNs[n] = pTimer->delta_n(tickStart, pTimer->tick()) / nIterations;
+		}
+
+		std::sort(vecNs.begin(), vecNs.end());
+
+		Result result;
+		result.strName = benchCase.strName;
+		result.nIterations = nIterations;
+		result.nRuns = m_nRuns;
+		result.dMedianNs = vecNs[m_nRuns / 2];
+		result.dMinNs = vecNs[0];
+		m_vecResults.push_back(result);
+
+		printf("%-24s %12u %14.1f %14.1f\n", result.strName.c_str(), result.nIterations, result.dMedianNs, result.dMinNs);
+		fflush(stdout);
+	}
+}
+
+std::string Benchmark::ToJson() const
+{
+	std::string strOut = "{\n  \"benchmarks\": [\n";
+	char szLine[512];
+
+	for (unsigned int i = 0; i < m_vecResults.size(); i ++)
+	{
+		const Result& result = m_vecResults[i];
+		sprintf(szLine, "    {\"name\": \"%s\", \"iterations\": %u, \"runs\": %u, \"median_ns\": %.3f, \"min_ns\": %.3f}%s\n",
+			result.strName.c_str(), result.nIterations, result.nRuns, result.dMedianNs, result.dMinNs,
+			i + 1 < m_vecResults.size() ? "," : "");
+		strOut += szLine;
+	}
+
+	strOut += "  ]\n}\n";
+	return strOut;
+}
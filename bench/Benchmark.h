@@ -0,0 +1,64 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+* Tiny timing harness for the routemonitor_bench executable.
+*
+* Each case is a function running its operation nIterations times. The
+* iteration count is doubled until one run takes at least the minimum time,
+* then several runs are timed and the median and fastest time per operation
+* are reported, as a table on stdout and optionally as JSON for regression
+* gates.
+*/
+class Benchmark
+{
+public:
+
+	typedef std::function<void(unsigned int nIterations)> Func;
+
+	struct Result
+	{
+		std::string strName;
+		unsigned int nIterations;
+		unsigned int nRuns;
+		double dMedianNs;
+		double dMinNs;
+	};
+
+	Benchmark();
+
+	void Add(const std::string& strName, Func func);
+
+	void SetMinTime(double dSeconds) { m_dMinTime = dSeconds; }
+
+	void SetRuns(unsigned int nRuns) { m_nRuns = nRuns; }
+
+	//runs the cases whose name contains strFilter, all if empty
+	void Run(const std::string& strFilter);
+
+	const std::vector<Result>& GetResults() const { return m_vecResults; }
+
+	std::string ToJson() const;
+
+private:
+
+	struct Case
+	{
+		std::string strName;
+		Func func;
+	};
+
+	std::vector<Case> m_vecCases;
+	std::vector<Result> m_vecResults;
+	double m_dMinTime;
+	unsigned int m_nRuns;
+};
+
+//keeps the compiler from dropping a computed value
+void BenchKeep(double dValue);
+
+#endif // BENCHMARK_H
@@ -0,0 +1,806 @@
+#include "../ConflictProbe.h"
+#include "../Geofence.h"
+#include "../TextureCompressor.h"
+#include "../TrackSpatialIndex.h"
+#include "../WorkerPool.h"
+
+#include <osg/Math>
+#include <osg/Texture>
+
+#include <algorithm>
+#include <map>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+//ʧܵ,Ϊ0ʱ1
+static unsigned int s_nFailures = 0;
+
+static void Fail(const char* pFormat, ...)
+{
+	va_list args;
+	va_start(args, pFormat);
+	printf("  FAIL ");
+	vprintf(pFormat, args);
+	printf("\n");
+	va_end(args);
+	s_nFailures ++;
+}
+
+//̶ӵͬ,ÿͬ
+static unsigned int s_nRandom = 12345;
+
+static double Random(double dMin, double dMax)
+{
+	s_nRandom = s_nRandom * 1103515245 + 12345;
+	return dMin + (dMax - dMin) * ((s_nRandom >> 8) & 0xffffff) / (double)0xffffff;
+}
+
+//ʸʽ,ͱ㷨ͬ
+static double ReferenceDistance(double dLon0, double dLat0, double dLon1, double dLat1)
+{
+	double dSinLat = sin(osg::DegreesToRadians(dLat1 - dLat0) * 0.5);
+	double dSinLon = sin(osg::DegreesToRadians(dLon1 - dLon0) * 0.5);
+	double h = dSinLat * dSinLat + cos(osg::DegreesToRadians(dLat0)) * cos(osg::DegreesToRadians(dLat1)) * dSinLon * dSinLon;
+	return 2.0 * 6371008.8 * asin(std::min(1.0, sqrt(h)));
+}
+
+//nWidth x nHeightһ,ֻȡͼΧڵ
+static void DecodeLevel(const unsigned char* pData, unsigned int nWidth, unsigned int nHeight, TextureCompressor::Format nFormat, std::vector<unsigned char>& vecRgba)
+{
+	unsigned int nBlockBytes = nFormat == TextureCompressor::FORMAT_BC3 ? 16 : 8;
+	unsigned int nBlocksX = (nWidth + 3) / 4;
+	unsigned int nBlocksY = (nHeight + 3) / 4;
+	vecRgba.assign(nWidth * nHeight * 4, 0);
+
+	unsigned char pBlock[64];
+	for (unsigned int by = 0; by < nBlocksY; by ++)
+	{
+		for (unsigned int bx = 0; bx < nBlocksX; bx ++)
+		{
+			TextureCompressor::DecodeBlock(pData + (by * nBlocksX + bx) * nBlockBytes, nFormat, pBlock);
+			for (unsigned int y = 0; y < 4 && by * 4 + y < nHeight; y ++)
+			{
+				for (unsigned int x = 0; x < 4 && bx * 4 + x < nWidth; x ++)
+					memcpy(&vecRgba[((by * 4 + y) * nWidth + bx * 4 + x) * 4], pBlock + (y * 4 + x) * 4, 4);
+			}
+		}
+	}
+}
+
+//nChannelsΪ3ʱֻȽɫ
+static double Psnr(const unsigned char* pA, const unsigned char* pB, unsigned int nPixels, unsigned int nChannels)
+{
+	double dSum = 0.0;
+	for (unsigned int i = 0; i < nPixels; i ++)
+	{
+		for (unsigned int c = 0; c < nChannels; c ++)
+		{
+			double d = (double)pA[i * 4 + c] - pB[i * 4 + c];
+			dSum += d * d;
+		}
+	}
+
+	double dMse = dSum / ((double)nPixels * nChannels);
+	return dMse > 0.0 ? 10.0 * log10(255.0 * 255.0 / dMse) : 99.0;
+}
+
+//ͻ׼ͬĺϳӰ,ĵɫƵ,BC3ʱһ͸Ƚ
+static void MakeTile(unsigned int nWidth, unsigned int nHeight, unsigned int nStride, bool bAlpha, std::vector<unsigned char>& vecRgba)
+{
+	vecRgba.assign(nStride * nHeight, 0);
+	for (unsigned int y = 0; y < nHeight; y ++)
+	{
+		unsigned char* pRow = &vecRgba[y * nStride];
+		for (unsigned int x = 0; x < nWidth; x ++)
+		{
+			pRow[x * 4] = (unsigned char)(128 + 100 * sin(x * 0.05) + (x * y * 7919 % 16));
+			pRow[x * 4 + 1] = (unsigned char)(y * 0.9 + (x * 104729 % 8));
+			pRow[x * 4 + 2] = (unsigned char)((x + y) / 3);
+			pRow[x * 4 + 3] = bAlpha ? (unsigned char)(x * 255 / std::max(nWidth - 1, 1u)) : 255;
+		}
+	}
+}
+
+//ٽ,ɫ͸ȵPSNR
+static void CheckRoundTrip(unsigned int nWidth, unsigned int nHeight, TextureCompressor::Format nFormat, double dMinPsnr)
+{
+	bool bAlpha = nFormat == TextureCompressor::FORMAT_BC3;
+	unsigned int nStride = nWidth * 4 + 12;
+	std::vector<unsigned char> vecSource;
+	MakeTile(nWidth, nHeight, nStride, bAlpha, vecSource);
+
+	std::vector<unsigned char> vecData;
+	TextureCompressor::EncodeLevel(&vecSource[0], nWidth, nHeight, nStride, nFormat, vecData);
+	unsigned int nBlockBytes = bAlpha ? 16 : 8;
+	if (vecData.size() != ((nWidth + 3) / 4) * ((nHeight + 3) / 4) * nBlockBytes)
+	{
+		Fail("%ux%u %s: %u bytes encoded", nWidth, nHeight, bAlpha ? "BC3" : "BC1", (unsigned int)vecData.size());
+		return;
+	}
+
+	//ȥβٱȽ
+	std::vector<unsigned char> vecPacked(nWidth * nHeight * 4);
+	for (unsigned int y = 0; y < nHeight; y ++)
+		memcpy(&vecPacked[y * nWidth * 4], &vecSource[y * nStride], nWidth * 4);
+
+	std::vector<unsigned char> vecDecoded;
+	DecodeLevel(&vecData[0], nWidth, nHeight, nFormat, vecDecoded);
+
+	double dColor = Psnr(&vecPacked[0], &vecDecoded[0], nWidth * nHeight, 3);
+	printf("  %ux%u %s: color %.2f dB", nWidth, nHeight, bAlpha ? "BC3" : "BC1", dColor);
+	if (dColor < dMinPsnr)
+		Fail("%ux%u color PSNR %.2f dB below %.2f", nWidth, nHeight, dColor, dMinPsnr);
+
+	//BC1͸,͸ȱȫ255
+	double dAlpha = 99.0;
+	for (unsigned int i = 0; i < nWidth * nHeight; i ++)
+	{
+		if (!bAlpha && vecDecoded[i * 4 + 3] != 255)
+		{
+			Fail("%ux%u BC1 texel %u decoded with alpha %u", nWidth, nHeight, i, vecDecoded[i * 4 + 3]);
+			break;
+		}
+	}
+	if (bAlpha)
+	{
+		std::vector<unsigned char> vecSourceAlpha(nWidth * nHeight * 4);
+		std::vector<unsigned char> vecDecodedAlpha(nWidth * nHeight * 4);
+		for (unsigned int i = 0; i < nWidth * nHeight; i ++)
+		{
+			vecSourceAlpha[i * 4] = vecPacked[i * 4 + 3];
+			vecDecodedAlpha[i * 4] = vecDecoded[i * 4 + 3];
+		}
+		dAlpha = Psnr(&vecSourceAlpha[0], &vecDecodedAlpha[0], nWidth * nHeight, 1);
+		printf(", alpha %.2f dB", dAlpha);
+		if (dAlpha < dMinPsnr)
+			Fail("%ux%u alpha PSNR %.2f dB below %.2f", nWidth, nHeight, dAlpha, dMinPsnr);
+	}
+	printf("\n");
+}
+
+static void CheckTextureCompressor()
+{
+	//256Ƭ,Լ߲4ıʱԵظһһ;ǰԼ42 dB
+	CheckRoundTrip(256, 256, TextureCompressor::FORMAT_BC1, 38.0);
+	CheckRoundTrip(256, 256, TextureCompressor::FORMAT_BC3, 38.0);
+	CheckRoundTrip(13, 7, TextureCompressor::FORMAT_BC1, 38.0);
+	CheckRoundTrip(13, 7, TextureCompressor::FORMAT_BC3, 38.0);
+	CheckRoundTrip(1, 1, TextureCompressor::FORMAT_BC1, 38.0);
+
+	//3е͸0127255,мһֻ䵽8ֵĳһ,18
+	CheckRoundTrip(3, 5, TextureCompressor::FORMAT_BC3, 27.0);
+
+	//ɫ: c0c1,BC13ɫģʽ,0ǲ͸c0
+	unsigned char pBlock[64];
+	unsigned char pEncoded[16];
+	unsigned char pDecoded[64];
+	for (int i = 0; i < 16; i ++)
+	{
+		pBlock[i * 4] = 200;
+		pBlock[i * 4 + 1] = 100;
+		pBlock[i * 4 + 2] = 50;
+		pBlock[i * 4 + 3] = 255;
+	}
+
+	for (int nPass = 0; nPass < 2; nPass ++)
+	{
+		TextureCompressor::Format nFormat = nPass ? TextureCompressor::FORMAT_BC3 : TextureCompressor::FORMAT_BC1;
+		if (nFormat == TextureCompressor::FORMAT_BC3)
+			TextureCompressor::EncodeBlockBC3(pBlock, pEncoded);
+		else
+			TextureCompressor::EncodeBlockBC1(pBlock, pEncoded);
+
+		const unsigned char* pColors = nPass ? pEncoded + 8 : pEncoded;
+		if (pColors[0] != pColors[2] || pColors[1] != pColors[3])
+			Fail("solid block %s: endpoints differ", nPass ? "BC3" : "BC1");
+
+		TextureCompressor::DecodeBlock(pEncoded, nFormat, pDecoded);
+		for (int i = 0; i < 16; i ++)
+		{
+			//565: 4,̲2
+			if (abs(pDecoded[i * 4] - 200) > 4 || abs(pDecoded[i * 4 + 1] - 100) > 2 || abs(pDecoded[i * 4 + 2] - 50) > 4 || pDecoded[i * 4 + 3] != 255)
+			{
+				Fail("solid block %s: texel %d decoded as %u,%u,%u,%u", nPass ? "BC3" : "BC1", i, pDecoded[i * 4], pDecoded[i * 4 + 1], pDecoded[i * 4 + 2], pDecoded[i * 4 + 3]);
+				break;
+			}
+		}
+	}
+
+	//ȫ͸: BC3͸ȱ뾫ȷԭΪ0,ɫ
+	for (int i = 0; i < 16; i ++)
+	{
+		pBlock[i * 4] = (unsigned char)(i * 16);
+		pBlock[i * 4 + 1] = (unsigned char)(255 - i * 16);
+		pBlock[i * 4 + 2] = (unsigned char)(i * 7);
+		pBlock[i * 4 + 3] = 0;
+	}
+	TextureCompressor::EncodeBlockBC3(pBlock, pEncoded);
+	TextureCompressor::DecodeBlock(pEncoded, TextureCompressor::FORMAT_BC3, pDecoded);
+	for (int i = 0; i < 16; i ++)
+	{
+		if (pDecoded[i * 4 + 3] != 0)
+		{
+			Fail("transparent block: texel %d decoded with alpha %u", i, pDecoded[i * 4 + 3]);
+			break;
+		}
+	}
+
+	//͸Ͳ͸,˵뾫ȷԭ
+	for (int i = 0; i < 16; i ++)
+		pBlock[i * 4 + 3] = (i & 1) ? 255 : 0;
+	TextureCompressor::EncodeBlockBC3(pBlock, pEncoded);
+	TextureCompressor::DecodeBlock(pEncoded, TextureCompressor::FORMAT_BC3, pDecoded);
+	for (int i = 0; i < 16; i ++)
+	{
+		if (pDecoded[i * 4 + 3] != pBlock[i * 4 + 3])
+		{
+			Fail("cutout block: texel %d decoded with alpha %u", i, pDecoded[i * 4 + 3]);
+			break;
+		}
+	}
+
+	//Compress: AUTO͸ѡʽ,0EncodeLevelһ,13x76x33x11x1mipmap
+	for (int nPass = 0; nPass < 2; nPass ++)
+	{
+		bool bAlpha = nPass == 1;
+		std::vector<unsigned char> vecSource;
+		MakeTile(13, 7, 13 * 4, bAlpha, vecSource);
+
+		osg::ref_ptr<osg::Image> image = new osg::Image;
+		image->allocateImage(13, 7, 1, GL_RGBA, GL_UNSIGNED_BYTE);
+		for (unsigned int y = 0; y < 7; y ++)
+			memcpy(image->data(0, y), &vecSource[y * 13 * 4], 13 * 4);
+
+		osg::ref_ptr<osg::Image> compressed = TextureCompressor::Compress(image.get(), TextureCompressor::FORMAT_AUTO);
+		if (!compressed.valid())
+		{
+			Fail("compress 13x7 %s: no image", bAlpha ? "translucent" : "opaque");
+			continue;
+		}
+
+		TextureCompressor::Format nFormat = bAlpha ? TextureCompressor::FORMAT_BC3 : TextureCompressor::FORMAT_BC1;
+		GLenum nExpected = bAlpha ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		if (compressed->getPixelFormat() != nExpected)
+			Fail("compress 13x7 %s: pixel format 0x%x", bAlpha ? "translucent" : "opaque", compressed->getPixelFormat());
+		if (compressed->getNumMipmapLevels() != 4)
+			Fail("compress 13x7: %u mipmap levels", compressed->getNumMipmapLevels());
+
+		std::vector<unsigned char> vecData;
+		TextureCompressor::EncodeLevel(&vecSource[0], 13, 7, 13 * 4, nFormat, vecData);
+		if (compressed->getNumMipmapLevels() > 1 && (compressed->getMipmapOffset(1) != vecData.size() || memcmp(compressed->data(), &vecData[0], vecData.size())))
+			Fail("compress 13x7 %s: level 0 differs from EncodeLevel", bAlpha ? "translucent" : "opaque");
+	}
+}
+
+//߷,QueryPolygonͬĹ
+static bool ReferenceInside(const std::vector<osg::Vec2d>& vecPolygon, double dx, double dy)
+{
+	bool bInside = false;
+	for (size_t a = 0, b = vecPolygon.size() - 1; a < vecPolygon.size(); b = a ++)
+	{
+		const osg::Vec2d& pa = vecPolygon[a];
+		const osg::Vec2d& pb = vecPolygon[b];
+		if ((pa.y() > dy) != (pb.y() > dy) && dx < (pb.x() - pa.x()) * (dy - pa.y()) / (pb.y() - pa.y()) + pa.x())
+			bInside = !bInside;
+	}
+	return bInside;
+}
+
+//뾶ѯѯȽϵĽһ,뾶1׵ĺֽ
+static void CheckSpatialQueries(const TrackSpatialIndex& index, const std::map<unsigned int, osg::Vec2d>& mapTracks, double dLon, double dLat, double dRadius)
+{
+	std::vector<TrackSpatialIndex::Hit> vecHits;
+	index.QueryRadius(dLon, dLat, dRadius, vecHits);
+
+	std::map<unsigned int, unsigned int> mapHits;
+	for (size_t i = 0; i < vecHits.size(); i ++)
+	{
+		if (mapHits[vecHits[i].nId] ++)
+			Fail("radius (%.4f, %.4f) %.0f m: track %u returned twice", dLon, dLat, dRadius, vecHits[i].nId);
+	}
+
+	std::vector<double> vecDistances;
+	for (std::map<unsigned int, osg::Vec2d>::const_iterator it = mapTracks.begin(); it != mapTracks.end(); ++ it)
+	{
+		double dDistance = ReferenceDistance(dLon, dLat, it->second.x(), it->second.y());
+		vecDistances.push_back(dDistance);
+		if (fabs(dDistance - dRadius) < 1e-3)
+			continue;
+
+		if ((dDistance < dRadius) != (mapHits.find(it->first) != mapHits.end()))
+		{
+			Fail("radius (%.4f, %.4f) %.0f m: track %u at (%.4f, %.4f), %.1f m away, %s", dLon, dLat, dRadius, it->first
+				, it->second.x(), it->second.y(), dDistance, dDistance < dRadius ? "missed" : "returned");
+			return;
+		}
+	}
+
+	unsigned int nCount = 5;
+	vecHits.clear();
+	index.QueryNearest(dLon, dLat, nCount, vecHits);
+	std::sort(vecDistances.begin(), vecDistances.end());
+	nCount = std::min<unsigned int>(nCount, vecDistances.size());
+	if (vecHits.size() != nCount)
+	{
+		Fail("nearest (%.4f, %.4f): %u hits", dLon, dLat, (unsigned int)vecHits.size());
+		return;
+	}
+	for (unsigned int i = 0; i < nCount; i ++)
+	{
+		if (fabs(vecHits[i].dDistance - vecDistances[i]) > 1e-3)
+		{
+			Fail("nearest (%.4f, %.4f): hit %u at %.3f m, expected %.3f m", dLon, dLat, i, vecHits[i].dDistance, vecDistances[i]);
+			return;
+		}
+	}
+}
+
+static void CheckTrackSpatialIndex()
+{
+	//ֲĺ,սࡢ͸ӱ߽ϸһ
+	TrackSpatialIndex index;
+	std::map<unsigned int, osg::Vec2d> mapTracks;
+	for (unsigned int nId = 0; nId < 6000; nId ++)
+	{
+		osg::Vec2d position(Random(-180.0, 180.0), Random(-90.0, 90.0));
+		switch (nId % 6)
+		{
+		case 1:
+			position.x() = Random(0.0, 1.0) < 0.5 ? Random(179.0, 180.0) : Random(-180.0, -179.0);
+			break;
+		case 2:
+			position.y() = Random(0.0, 1.0) < 0.5 ? Random(88.0, 90.0) : Random(-90.0, -88.0);
+			break;
+		case 3:
+			position.set(floor(Random(-720.0, 720.0)) * 0.25, floor(Random(-360.0, 360.0)) * 0.25);
+			break;
+		}
+		if (nId % 500 == 0)
+			position.set(nId % 1000 ? 180.0 : -180.0, nId % 1500 ? 90.0 : -90.0);
+
+		index.Update(nId, position.x(), position.y());
+		mapTracks[nId] = position;
+	}
+
+	//Ųһֿ,ɾһ,ӱά
+	for (unsigned int i = 0; i < 20000; i ++)
+	{
+		unsigned int nId = (unsigned int)Random(0.0, 5999.0);
+		std::map<unsigned int, osg::Vec2d>::iterator it = mapTracks.find(nId);
+		if (it == mapTracks.end())
+			continue;
+
+		if (i % 50 == 0)
+		{
+			index.Remove(nId);
+			mapTracks.erase(it);
+			continue;
+		}
+
+		osg::Vec2d& position = it->second;
+		position.x() += Random(-0.6, 0.6);
+		position.y() = osg::clampBetween(position.y() + Random(-0.6, 0.6), -90.0, 90.0);
+		if (position.x() >= 180.0)
+			position.x() -= 360.0;
+		if (position.x() < -180.0)
+			position.x() += 360.0;
+		index.Update(nId, position.x(), position.y());
+	}
+
+	if (index.GetNumTracks() != mapTracks.size())
+		Fail("%u tracks in the index, %u expected", index.GetNumTracks(), (unsigned int)mapTracks.size());
+
+	//սߡͼϵĲѯ,뾶1ﵽ
+	const double pRadii[] = { 1000.0, 50000.0, 500000.0, 3000000.0, 25000000.0 };
+	const double pCenters[][2] = { { 180.0, 0.0 }, { -180.0, 45.0 }, { 179.99, -60.0 }, { 0.0, 90.0 }, { 123.0, -90.0 }, { 45.0, 89.9 }, { -170.0, -89.5 }, { 0.0, 0.0 } };
+	for (unsigned int c = 0; c < sizeof(pCenters) / sizeof(pCenters[0]); c ++)
+	{
+		for (unsigned int r = 0; r < sizeof(pRadii) / sizeof(pRadii[0]); r ++)
+			CheckSpatialQueries(index, mapTracks, pCenters[c][0], pCenters[c][1], pRadii[r]);
+	}
+	for (unsigned int i = 0; i < 200; i ++)
+		CheckSpatialQueries(index, mapTracks, Random(-180.0, 180.0), Random(-90.0, 90.0), Random(1000.0, 2000000.0));
+
+	//,ڸӱ߽
+	std::vector<std::vector<osg::Vec2d> > vecPolygons(3);
+	vecPolygons[0].push_back(osg::Vec2d(100.0, 20.0));
+	vecPolygons[0].push_back(osg::Vec2d(110.0, 20.0));
+	vecPolygons[0].push_back(osg::Vec2d(105.0, 30.0));
+	vecPolygons[1].push_back(osg::Vec2d(170.0, 80.0));
+	vecPolygons[1].push_back(osg::Vec2d(180.0, 80.0));
+	vecPolygons[1].push_back(osg::Vec2d(180.0, 90.0));
+	vecPolygons[1].push_back(osg::Vec2d(170.0, 90.0));
+	for (int i = 0; i < 24; i ++)
+	{
+		double dAngle = osg::PI * 2.0 * i / 24;
+		vecPolygons[2].push_back(osg::Vec2d(-30.0 + ((i & 1) ? 5.0 : 10.0) * cos(dAngle), -40.0 + ((i & 1) ? 5.0 : 10.0) * sin(dAngle)));
+	}
+
+	for (size_t p = 0; p < vecPolygons.size(); p ++)
+	{
+		std::vector<TrackSpatialIndex::Hit> vecHits;
+		index.QueryPolygon(vecPolygons[p], vecHits);
+
+		std::map<unsigned int, unsigned int> mapHits;
+		for (size_t i = 0; i < vecHits.size(); i ++)
+			mapHits[vecHits[i].nId] ++;
+
+		unsigned int nExpected = 0;
+		for (std::map<unsigned int, osg::Vec2d>::const_iterator it = mapTracks.begin(); it != mapTracks.end(); ++ it)
+		{
+			bool bInside = ReferenceInside(vecPolygons[p], it->second.x(), it->second.y());
+			nExpected += bInside;
+			std::map<unsigned int, unsigned int>::const_iterator itHit = mapHits.find(it->first);
+			if (bInside != (itHit != mapHits.end()) || (bInside && itHit->second != 1))
+			{
+				Fail("polygon %u: track %u at (%.4f, %.4f) %s", (unsigned int)p, it->first, it->second.x(), it->second.y(), bInside ? "missed or repeated" : "returned");
+				break;
+			}
+		}
+		printf("  polygon %u: %u tracks inside\n", (unsigned int)p, nExpected);
+	}
+}
+
+//Լ,ConflictProbeͬƽģ,ǵǰʱ̵
+static void ReferenceConflicts(const std::vector<TrackTable::Row>& vecRows, double dNow, const ConflictProbe& probe, std::map<std::pair<unsigned int, unsigned int>, double>& mapConflicts)
+{
+	const double dMetersPerDegree = 6371000.0 * osg::PI / 180.0;
+	double dSeparation = probe.GetSeparation();
+	double dLookAhead = probe.GetLookAhead();
+
+	mapConflicts.clear();
+	for (unsigned int i = 0; i < vecRows.size(); i ++)
+	{
+		const TrackTable::Row& a = vecRows[i];
+		if (!(a.nFlags & TrackTable::FLAG_VALID) || a.dTime != dNow)
+			continue;
+
+		for (unsigned int j = i + 1; j < vecRows.size(); j ++)
+		{
+			const TrackTable::Row& b = vecRows[j];
+			if (!(b.nFlags & TrackTable::FLAG_VALID) || b.dTime != dNow || fabs(b.dAlt - a.dAlt) >= 304.8)
+				continue;
+
+			double dLon = b.dLon - a.dLon;
+			if (dLon > 180.0)
+				dLon -= 360.0;
+			if (dLon < -180.0)
+				dLon += 360.0;
+
+			double dCos = (cos(osg::DegreesToRadians(a.dLat)) + cos(osg::DegreesToRadians(b.dLat))) * 0.5;
+			double dx = dLon * dMetersPerDegree * dCos;
+			double dy = (b.dLat - a.dLat) * dMetersPerDegree;
+			double wx = b.dVelocity * sin(osg::DegreesToRadians(b.dHeading)) - a.dVelocity * sin(osg::DegreesToRadians(a.dHeading));
+			double wy = b.dVelocity * cos(osg::DegreesToRadians(b.dHeading)) - a.dVelocity * cos(osg::DegreesToRadians(a.dHeading));
+			double w2 = wx * wx + wy * wy;
+			double dTime = w2 > 1e-9 ? osg::clampBetween(-(dx * wx + dy * wy) / w2, 0.0, dLookAhead) : 0.0;
+			double dMiss = sqrt((dx + wx * dTime) * (dx + wx * dTime) + (dy + wy * dTime) * (dy + wy * dTime));
+			if (dMiss < dSeparation)
+				mapConflicts[std::make_pair(i, j)] = dMiss;
+		}
+	}
+}
+
+//ÿԳͻֻһ,ԼĽͬ;1׵ֽ
+static void CheckConflicts(const char* pName, ConflictProbe& probe, const std::vector<TrackTable::Row>& vecRows, double dNow)
+{
+	std::map<std::pair<unsigned int, unsigned int>, double> mapExpected;
+	ReferenceConflicts(vecRows, dNow, probe, mapExpected);
+
+	std::vector<ConflictProbe::Conflict> vecConflicts;
+	probe.Run(vecRows, dNow, vecConflicts);
+
+	std::map<std::pair<unsigned int, unsigned int>, double> mapFound;
+	for (size_t i = 0; i < vecConflicts.size(); i ++)
+	{
+		const ConflictProbe::Conflict& conflict = vecConflicts[i];
+		std::pair<unsigned int, unsigned int> pair(std::min(conflict.nIndexA, conflict.nIndexB), std::max(conflict.nIndexA, conflict.nIndexB));
+		if (pair.first == pair.second || mapFound.find(pair) != mapFound.end())
+			Fail("%s: pair %u-%u reported twice", pName, pair.first, pair.second);
+		mapFound[pair] = conflict.dMiss;
+
+		if (i > 0 && vecConflicts[i - 1].dTime > conflict.dTime)
+			Fail("%s: conflicts not sorted by time at %u", pName, (unsigned int)i);
+	}
+
+	unsigned int nMismatches = 0;
+	std::map<std::pair<unsigned int, unsigned int>, double>::const_iterator it;
+	for (it = mapExpected.begin(); it != mapExpected.end(); ++ it)
+	{
+		std::map<std::pair<unsigned int, unsigned int>, double>::const_iterator itFound = mapFound.find(it->first);
+		if (itFound == mapFound.end() ? it->second < probe.GetSeparation() - 1e-3 : fabs(itFound->second - it->second) > 1e-3)
+		{
+			const TrackTable::Row& a = vecRows[it->first.first];
+			const TrackTable::Row& b = vecRows[it->first.second];
+			if (nMismatches ++ < 5)
+			{
+				Fail("%s: pair %u-%u at (%.4f, %.4f) and (%.4f, %.4f), miss %.1f m, %s", pName, it->first.first, it->first.second
+					, a.dLon, a.dLat, b.dLon, b.dLat, it->second, itFound == mapFound.end() ? "missed" : "with a different miss distance");
+			}
+		}
+	}
+	for (it = mapFound.begin(); it != mapFound.end(); ++ it)
+	{
+		if (mapExpected.find(it->first) == mapExpected.end() && it->second < probe.GetSeparation() - 1e-3 && nMismatches ++ < 5)
+			Fail("%s: pair %u-%u reported, miss %.1f m", pName, it->first.first, it->first.second, it->second);
+	}
+
+	printf("  %s: %u conflicts, %llu pairs tested\n", pName, (unsigned int)mapExpected.size(), probe.GetNumPairsTested());
+}
+
+static void CheckConflictProbe()
+{
+	//ŵĺսߺ͸ӱ߽,ĺȲܴʱȻܽ,Ч͹ڵ
+	const double dNow = 1e9;
+	std::vector<TrackTable::Row> vecRows(4000);
+	for (unsigned int i = 0; i < vecRows.size(); i ++)
+	{
+		TrackTable::Row& row = vecRows[i];
+		row.nId = i;
+		row.dTime = dNow;
+		row.dAlt = 9000.0 + (i % 3) * 150.0;
+		row.dHeading = Random(0.0, 360.0);
+		row.dVelocity = Random(100.0, 300.0);
+		row.nFlags = TrackTable::FLAG_VALID;
+		switch (i % 4)
+		{
+		case 0:
+			row.dLon = Random(-180.0, 180.0);
+			row.dLat = Random(-80.0, 80.0);
+			break;
+		case 1:
+			row.dLon = Random(0.0, 1.0) < 0.5 ? Random(179.5, 180.0) : Random(-180.0, -179.5);
+			row.dLat = Random(-1.0, 1.0);
+			break;
+		case 2:
+			row.dLon = Random(-180.0, 180.0);
+			row.dLat = Random(0.0, 1.0) < 0.5 ? Random(89.8, 90.0) : Random(-90.0, -89.8);
+			break;
+		default:
+			row.dLon = Random(100.0, 102.0);
+			row.dLat = Random(30.0, 32.0);
+			break;
+		}
+
+		if (i % 97 == 0)
+			row.nFlags = 0;
+		if (i % 101 == 0)
+			row.dTime = dNow - 100.0;
+	}
+
+	ConflictProbe probe;
+	CheckConflicts("default grid", probe, vecRows, dNow);
+
+	WorkerPool workerPool(3);
+	ConflictProbe poolProbe(&workerPool);
+	CheckConflicts("worker pool", poolProbe, vecRows, dNow);
+
+	//Ԥʱܳʱֻһ,лظ
+	probe.SetLookAhead(20000.0);
+	CheckConflicts("one or two columns", probe, vecRows, dNow);
+
+	//ֻγȵĺʱӰγ,ȸӱխ
+	std::vector<TrackTable::Row> vecMidRows;
+	for (unsigned int i = 0; i < vecRows.size(); i ++)
+	{
+		if (fabs(vecRows[i].dLat) < 45.0)
+			vecMidRows.push_back(vecRows[i]);
+	}
+	probe.SetLookAhead(120.0);
+	CheckConflicts("mid latitudes", probe, vecMidRows, dNow);
+}
+
+//лб߷,Geofenceİ뿪ͬ: ±ߺϵĵ,ϱߺұϵĵ
+static bool ReferenceInside(const std::vector<std::vector<osg::Vec2d> >& vecRings, double dx, double dy)
+{
+	bool bInside = false;
+	for (size_t r = 0; r < vecRings.size(); r ++)
+	{
+		const std::vector<osg::Vec2d>& vecRing = vecRings[r];
+		for (size_t a = 0, b = vecRing.size() - 1; a < vecRing.size(); b = a ++)
+		{
+			const osg::Vec2d& pa = vecRing[a];
+			const osg::Vec2d& pb = vecRing[b];
+			if ((pb.y() > dy) != (pa.y() > dy) && dx < pb.x() + (dy - pb.y()) * (pa.x() - pb.x()) / (pa.y() - pb.y()))
+				bInside = !bInside;
+		}
+	}
+	return bInside;
+}
+
+static void CheckGeofence()
+{
+	std::vector<std::vector<std::vector<osg::Vec2d> > > vecFences;
+
+	//1ȸӱ߽ϵľ,Լһߵ
+	const double pRects[][4] = { { 100.0, 30.0, 102.0, 31.0 }, { 102.0, 30.0, 103.5, 31.0 }, { -1.0, -1.0, 1.0, 1.0 }, { 179.0, 89.0, 180.0, 90.0 } };
+	for (unsigned int i = 0; i < sizeof(pRects) / sizeof(pRects[0]); i ++)
+	{
+		std::vector<std::vector<osg::Vec2d> > vecRings(1);
+		vecRings[0].push_back(osg::Vec2d(pRects[i][0], pRects[i][1]));
+		vecRings[0].push_back(osg::Vec2d(pRects[i][2], pRects[i][1]));
+		vecRings[0].push_back(osg::Vec2d(pRects[i][2], pRects[i][3]));
+		vecRings[0].push_back(osg::Vec2d(pRects[i][0], pRects[i][3]));
+		vecFences.push_back(vecRings);
+	}
+
+	//,һ,һֵĶ,һϸб
+	for (unsigned int i = 0; i < 40; i ++)
+	{
+		double dCenterLon = Random(95.0, 110.0);
+		double dCenterLat = Random(25.0, 35.0);
+		double dRadius = Random(0.05, 1.5);
+		unsigned int nPoints = 3 + i % 40;
+
+		std::vector<std::vector<osg::Vec2d> > vecRings(1);
+		for (unsigned int j = 0; j < nPoints; j ++)
+		{
+			double dAngle = osg::PI * 2.0 * j / nPoints;
+			double dScale = (j & 1) ? Random(0.3, 1.0) : 1.0;
+			vecRings[0].push_back(osg::Vec2d(dCenterLon + dRadius * dScale * cos(dAngle), dCenterLat + dRadius * dScale * sin(dAngle)));
+		}
+
+		if (i % 5 == 1)
+		{
+			vecRings.push_back(std::vector<osg::Vec2d>());
+			for (unsigned int j = 0; j < 8; j ++)
+			{
+				double dAngle = osg::PI * 2.0 * j / 8;
+				vecRings.back().push_back(osg::Vec2d(dCenterLon + dRadius * 0.2 * cos(dAngle), dCenterLat + dRadius * 0.2 * sin(dAngle)));
+			}
+		}
+		if (i % 5 == 2)
+		{
+			vecRings.push_back(vecRings[0]);
+			for (size_t j = 0; j < vecRings.back().size(); j ++)
+				vecRings.back()[j].x() += dRadius * 3.0;
+		}
+		if (i % 5 == 3)
+		{
+			vecRings[0].clear();
+			vecRings[0].push_back(osg::Vec2d(dCenterLon, dCenterLat));
+			vecRings[0].push_back(osg::Vec2d(dCenterLon + dRadius, dCenterLat + dRadius * 0.9));
+			vecRings[0].push_back(osg::Vec2d(dCenterLon + dRadius, dCenterLat + dRadius * 0.9 + 0.001));
+		}
+		vecFences.push_back(vecRings);
+	}
+
+	Geofence geofence;
+	for (size_t i = 0; i < vecFences.size(); i ++)
+		geofence.AddFence("check", vecFences[i]);
+
+	//㱾ߵеķֵ㡢νǵ,ټ
+	std::vector<osg::Vec2d> vecPoints;
+	for (size_t i = 0; i < vecFences.size(); i ++)
+	{
+		for (size_t r = 0; r < vecFences[i].size(); r ++)
+		{
+			const std::vector<osg::Vec2d>& vecRing = vecFences[i][r];
+			for (size_t j = 0; j < vecRing.size(); j ++)
+			{
+				const osg::Vec2d& a = vecRing[j];
+				const osg::Vec2d& b = vecRing[(j + 1) % vecRing.size()];
+				vecPoints.push_back(a);
+				vecPoints.push_back((a + b) * 0.5);
+				vecPoints.push_back(a + (b - a) * 0.25);
+				vecPoints.push_back(osg::Vec2d(a.x(), (a.y() + b.y()) * 0.5));
+				vecPoints.push_back(osg::Vec2d((a.x() + b.x()) * 0.5, a.y()));
+			}
+		}
+	}
+	for (unsigned int i = 0; i < 100000; i ++)
+		vecPoints.push_back(osg::Vec2d(Random(94.0, 112.0), Random(24.0, 37.0)));
+	for (unsigned int i = 0; i < 2000; i ++)
+		vecPoints.push_back(osg::Vec2d(Random(-180.0, 180.0), Random(-90.0, 90.0)));
+
+	unsigned int nMismatches = 0;
+	unsigned int nHits = 0;
+	std::vector<unsigned int> vecFound;
+	std::vector<unsigned int> vecExpected;
+	for (size_t i = 0; i < vecPoints.size(); i ++)
+	{
+		const osg::Vec2d& point = vecPoints[i];
+		geofence.Query(point.x(), point.y(), vecFound);
+
+		vecExpected.clear();
+		for (unsigned int f = 0; f < vecFences.size(); f ++)
+		{
+			if (ReferenceInside(vecFences[f], point.x(), point.y()))
+				vecExpected.push_back(f);
+		}
+
+		nHits += vecExpected.size();
+		if (vecFound != vecExpected && nMismatches ++ < 5)
+			Fail("query (%.9f, %.9f): %u fences found, %u expected", point.x(), point.y(), (unsigned int)vecFound.size(), (unsigned int)vecExpected.size());
+	}
+	printf("  %u points, %u fence hits\n", (unsigned int)vecPoints.size(), nHits);
+
+	//һ,¼ǰΰϵĲͬ
+	std::vector<Geofence::Event> vecEvents;
+	std::vector<unsigned int> vecPrevious;
+	for (unsigned int i = 0; i < 20000 && nMismatches == 0; i ++)
+	{
+		double dLon = 95.0 + (i % 4000) * 0.004;
+		double dLat = 25.0 + (i / 4000) * 2.0 + (i % 7) * 0.01;
+
+		vecEvents.clear();
+		geofence.Update(7, dLon, dLat, vecEvents);
+
+		vecExpected.clear();
+		for (unsigned int f = 0; f < vecFences.size(); f ++)
+		{
+			if (ReferenceInside(vecFences[f], dLon, dLat))
+				vecExpected.push_back(f);
+		}
+
+		std::vector<unsigned int> vecState = vecPrevious;
+		for (size_t e = 0; e < vecEvents.size(); e ++)
+		{
+			std::vector<unsigned int>::iterator it = std::lower_bound(vecState.begin(), vecState.end(), vecEvents[e].nFenceId);
+			bool bIn = it != vecState.end() && *it == vecEvents[e].nFenceId;
+			if (bIn == vecEvents[e].bEnter)
+				Fail("update (%.4f, %.4f): %s fence %u twice", dLon, dLat, bIn ? "entered" : "left", vecEvents[e].nFenceId);
+			else if (bIn)
+				vecState.erase(it);
+			else
+				vecState.insert(it, vecEvents[e].nFenceId);
+		}
+
+		if (vecState != vecExpected && nMismatches ++ < 5)
+			Fail("update (%.4f, %.4f): events do not lead to the fences containing the point", dLon, dLat);
+		vecPrevious = vecExpected;
+	}
+}
+
+struct CheckCase
+{
+	const char* pName;
+	void (*func)();
+};
+
+static const CheckCase s_pCases[] =
+{
+	{ "texture_compressor", CheckTextureCompressor },
+	{ "track_spatial_index", CheckTrackSpatialIndex },
+	{ "conflict_probe", CheckConflictProbe },
+	{ "geofence", CheckGeofence }
+};
+
+static void PrintUsage()
+{
+	printf("usage: routemonitor_check [--filter name]\n"
+		"exit code: 0 passed, 1 a check failed\n");
+}
+
+int main(int argc, char** argv)
+{
+	std::string strFilter;
+	for (int i = 1; i < argc; i ++)
+	{
+		if (!strcmp(argv[i], "--filter") && i + 1 < argc)
+			strFilter = argv[++i];
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	for (unsigned int i = 0; i < sizeof(s_pCases) / sizeof(s_pCases[0]); i ++)
+	{
+		if (!strFilter.empty() && std::string(s_pCases[i].pName).find(strFilter) == std::string::npos)
+			continue;
+
+		unsigned int nFailures = s_nFailures;
+		printf("%s\n", s_pCases[i].pName);
+		s_pCases[i].func();
+		printf("%s: %s\n", s_pCases[i].pName, s_nFailures == nFailures ? "ok" : "FAILED");
+	}
+
+	return s_nFailures ? 1 : 0;
+}
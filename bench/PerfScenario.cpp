@@ -0,0 +1,391 @@
+#include "PerfScenario.h"
+
+#include "../Metrics.h"
+
+#include "../UDPServer.h"
+#include "../AeroLineLoader.h"
+#include "../MyManipulator.h"
+#include "../MyPlaceNode.h"
+
+#include <osgDB/ReadFile>
+#include <osgEarthUtil/AutoClipPlaneHandler>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QSettings>
+
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+extern osg::Node* g_earthNode;
+extern osgEarth::MapNode* g_MapNode;
+extern RouteConformance* g_pRouteConformance;
+
+//ϳɺٶ(/)
+static const double s_dTrackSpeed = 250.0;
+static const double s_dMetersPerDegree = 111320.0;
+
+//Ƽ֡,󷢳ıҲʾ
+static const int s_nDrainFrames = 10;
+
+namespace
+{
+	struct CameraKey
+	{
+		double dLon;
+		double dLat;
+		double dHeading;
+		double dPitch;
+		double dRange;
+	};
+
+	//·: ȫͼ,Ͽ,ƽ,б,Զ
+	const CameraKey s_pCameraPath[] = {
+		{ 105.0, 30.0, 0.0, -90.0, 8e6 },
+		{ 105.0, 28.0, 0.0, -90.0, 8e5 },
+		{ 112.0, 30.0, 0.0, -90.0, 8e5 },
+		{ 112.0, 30.0, 45.0, -30.0, 3e5 },
+		{ 100.0, 25.0, 90.0, -60.0, 2e7 }
+	};
+
+	const int s_nCameraKeys = sizeof(s_pCameraPath) / sizeof(s_pCameraPath[0]);
+
+	double Percentile(std::vector<double>& vecValues, double dQuantile)
+	{
+		if (vecValues.empty())
+			return 0.0;
+
+		std::sort(vecValues.begin(), vecValues.end());
+		return vecValues[(size_t)(dQuantile * (vecValues.size() - 1) + 0.5)];
+	}
+}
+
+ScenarioOptions::ScenarioOptions()
+	: strEarthFile("bench/data/scenario.earth")
+	, strRouteFile("bench/data/scenario_routes.dat")
+	, nTracks(200)
+	, nFrames(1800)
+	, nWarmupFrames(60)
+	, dFrameTime(1.0 / 60.0)
+	, dRate(4.0)
+	, nWidth(1280)
+	, nHeight(720)
+	, nBasePort(17000)
+{
+
+}
+
+ScenarioResult::ScenarioResult()
+	: dFrameP50(0.0), dFrameP90(0.0), dFrameP99(0.0), dFrameMax(0.0)
+	, dLatencyP50(0.0), dLatencyP99(0.0), dPeakMemoryMB(0.0)
+	, nDatagramsSent(0), nDatagramsDisplayed(0)
+{
+
+}
+
+PerfScenario::PerfScenario(const ScenarioOptions& options)
+	: m_options(options)
+	, m_pManipulator(nullptr)
+	, m_pAeroLineLoader(nullptr)
+{
+
+}
+
+PerfScenario::~PerfScenario()
+{
+	for (unsigned int i = 0; i < m_vecServers.size(); i ++)
+		delete m_vecServers[i];
+
+	delete m_pAeroLineLoader;
+}
+
+bool PerfScenario::Setup(QString& strError)
+{
+	osg::Node* pEarthNode = osgDB::readNodeFile(m_options.strEarthFile.toLocal8Bit().data());
+	m_pMapNode = osgEarth::MapNode::findMapNode(pEarthNode);
+	if (!m_pMapNode.valid())
+	{
+		strError = "cannot load earth file " + m_options.strEarthFile;
+		return false;
+	}
+
+	g_earthNode = pEarthNode;
+	g_MapNode = m_pMapNode.get();
+
+	m_pRoot = new osg::Group;
+	m_pRoot->addChild(pEarthNode);
+
+	m_pAeroLineLoader = new AeroLineLoader(m_pRoot.get(), m_pMapNode->getMapSRS()->getEllipsoid());
+	g_pRouteConformance = m_pAeroLineLoader->GetConformance();
+	if (!m_pAeroLineLoader->Load(m_options.strRouteFile))
+	{
+		strError = "cannot load route file " + m_options.strRouteFile;
+		return false;
+	}
+
+	//Ⱦ
+	osg::ref_ptr<osg::GraphicsContext::Traits> traits = new osg::GraphicsContext::Traits;
+	traits->x = 0;
+	traits->y = 0;
+	traits->width = m_options.nWidth;
+	traits->height = m_options.nHeight;
+	traits->red = traits->green = traits->blue = traits->alpha = 8;
+	traits->depth = 24;
+	traits->stencil = 8;
+	traits->doubleBuffer = false;
+	traits->pbuffer = true;
+
+	osg::ref_ptr<osg::GraphicsContext> gc = osg::GraphicsContext::createGraphicsContext(traits.get());
+	if (!gc.valid())
+	{
+		strError = "cannot create a pbuffer context";
+		return false;
+	}
+
+	m_pViewer = new osgViewer::Viewer;
+	m_pViewer->setThreadingModel(osgViewer::ViewerBase::SingleThreaded);
+	m_pViewer->getCamera()->setGraphicsContext(gc.get());
+	m_pViewer->getCamera()->setViewport(0, 0, m_options.nWidth, m_options.nHeight);
+	m_pViewer->getCamera()->setProjectionMatrixAsPerspective(30.0, (double)m_options.nWidth / m_options.nHeight, 1.0, 1e4);
+	m_pViewer->getCamera()->setDrawBuffer(GL_FRONT);
+	m_pViewer->getCamera()->setReadBuffer(GL_FRONT);
+	m_pViewer->getCamera()->addCullCallback(new osgEarth::Util::AutoClipPlaneCullCallback(m_pMapNode.get()));
+
+	m_pManipulator = new MyManipulator;
+	m_pViewer->setCameraManipulator(m_pManipulator);
+
+	//ÿһ˿,ӦеUDPServerȫͬ
+	const osgEarth::SpatialReference* pwgs84 = osgEarth::SpatialReference::get("wgs84");
+	for (int i = 0; i < m_options.nTracks; i ++)
+	{
+		Track track;
+		track.dLon = 95.0 + (i % 20) * 1.2;
+		track.dLat = 20.0 + ((i / 20) % 15) * 1.0;
+		track.dHeading = (i * 37) % 360;
+		track.dNextSend = (i % 16) / (16.0 * m_options.dRate);
+		track.nLastVertices = 0;
+		m_vecTracks.push_back(track);
+
+		osg::Group* pTrailGroup = new osg::Group;
+		pTrailGroup->getOrCreateStateSet()->setMode(GL_LIGHTING, osg::StateAttribute::OFF | osg::StateAttribute::OVERRIDE);
+		m_pRoot->addChild(pTrailGroup);
+
+		osgEarth::Annotation::MyPlaceNode* pPlaceNode = new osgEarth::Annotation::MyPlaceNode(m_pMapNode.get(),
+			osgEarth::GeoPoint(pwgs84, track.dLon, track.dLat, 2000.0), "", osgEarth::Symbology::Style());
+		m_pRoot->addChild(pPlaceNode);
+
+		m_vecServers.push_back(new UDPServer(pTrailGroup, m_options.nBasePort + i, m_pViewer.get(), pPlaceNode));
+	}
+
+	m_pViewer->setSceneData(m_pRoot.get());
+	m_pViewer->realize();
+
+	return true;
+}
+
+void PerfScenario::SendDatagrams(double dSimTime, unsigned int& nSent)
+{
+	double dInterval = 1.0 / m_options.dRate;
+	osg::Timer* pTimer = osg::Timer::instance();
+
+	for (unsigned int i = 0; i < m_vecTracks.size(); i ++)
+	{
+		Track& track = m_vecTracks[i];
+		while (track.dNextSend <= dSimTime)
+		{
+			double dDistance = s_dTrackSpeed * dInterval;
+			double dHeading = osg::DegreesToRadians(track.dHeading);
+			track.dLat += dDistance * cos(dHeading) / s_dMetersPerDegree;
+			track.dLon += dDistance * sin(dHeading) / (s_dMetersPerDegree * cos(osg::DegreesToRadians(track.dLat)));
+			track.dNextSend += dInterval;
+
+			char datagram[25];
+			memset(datagram, 0, sizeof(datagram));
+			memcpy(datagram + 1, &track.dLon, 8);
+			memcpy(datagram + 9, &track.dLat, 8);
+			memcpy(datagram + 17, &track.dHeading, 8);
+
+			track.dequeSent.push_back(pTimer->tick());
+			m_sender.writeDatagram(datagram, sizeof(datagram), QHostAddress::LocalHost, m_options.nBasePort + i);
+			nSent ++;
+		}
+	}
+}
+
+void PerfScenario::CollectLatency(osg::Timer_t tickDisplayed, std::vector<double>* pLatency, unsigned int& nDisplayed)
+{
+	osg::Timer* pTimer = osg::Timer::instance();
+
+	for (unsigned int i = 0; i < m_vecTracks.size(); i ++)
+	{
+		Track& track = m_vecTracks[i];
+		unsigned int nVertices = m_vecServers[i]->m_pTrail->GetTrail().GetNumPoints();
+
+		//޻ᶪϵĿ,ʱµǰ
+		unsigned int nNew = nVertices >= track.nLastVertices ? nVertices - track.nLastVertices : nVertices;
+		track.nLastVertices = nVertices;
+
+		for (unsigned int n = 0; n < nNew && !track.dequeSent.empty(); n ++)
+		{
+			if (pLatency)
+				pLatency->push_back(pTimer->delta_m(track.dequeSent.front(), tickDisplayed));
+			track.dequeSent.pop_front();
+			nDisplayed ++;
+		}
+	}
+}
+
+osgEarth::Viewpoint PerfScenario::CameraAt(double dProgress) const
+{
+	double dKey = osg::clampBetween(dProgress, 0.0, 1.0) * (s_nCameraKeys - 1);
+	int nKey = osg::minimum((int)dKey, s_nCameraKeys - 2);
+	double t = dKey - nKey;
+
+	const CameraKey& a = s_pCameraPath[nKey];
+	const CameraKey& b = s_pCameraPath[nKey + 1];
+
+	//밴ֵ,ٶȲž
+	double dRange = exp(log(a.dRange) + (log(b.dRange) - log(a.dRange)) * t);
+
+	return osgEarth::Viewpoint("scenario",
+		a.dLon + (b.dLon - a.dLon) * t,
+		a.dLat + (b.dLat - a.dLat) * t,
+		0.0,
+		a.dHeading + (b.dHeading - a.dHeading) * t,
+		a.dPitch + (b.dPitch - a.dPitch) * t,
+		dRange);
+}
+
+ScenarioResult PerfScenario::Run()
+{
+	ScenarioResult result;
+	osg::Timer* pTimer = osg::Timer::instance();
+
+	std::vector<double> vecFrame;
+	std::vector<double> vecLatency;
+	vecFrame.reserve(m_options.nFrames);
+
+	int nTotalFrames = m_options.nFrames + s_nDrainFrames;
+	for (int nFrame = 0; nFrame < nTotalFrames; nFrame ++)
+	{
+		bool bMeasured = nFrame >= m_options.nWarmupFrames && nFrame < m_options.nFrames;
+		double dSimTime = nFrame * m_options.dFrameTime;
+
+		osg::Timer_t tickStart = pTimer->tick();
+
+		if (nFrame < m_options.nFrames)
+			SendDatagrams(dSimTime, result.nDatagramsSent);
+
+		//UDPServerĲۺ,Ӧõ¼ѭͬ
+		QCoreApplication::processEvents();
+
+		m_pManipulator->setViewpoint(CameraAt((double)nFrame / m_options.nFrames));
+		m_pViewer->frame(dSimTime);
+
+		osg::Timer_t tickEnd = pTimer->tick();
+
+		//ԤȽ׶εıֻ,ӳ
+		CollectLatency(tickEnd, nFrame >= m_options.nWarmupFrames ? &vecLatency : nullptr, result.nDatagramsDisplayed);
+
+		if (bMeasured)
+			vecFrame.push_back(pTimer->delta_m(tickStart, tickEnd));
+
+		result.dPeakMemoryMB = osg::maximum(result.dPeakMemoryMB, Metrics::GetResidentBytes() / (1024.0 * 1024.0));
+	}
+
+	result.dFrameP50 = Percentile(vecFrame, 0.5);
+	result.dFrameP90 = Percentile(vecFrame, 0.9);
+	result.dFrameP99 = Percentile(vecFrame, 0.99);
+	result.dFrameMax = vecFrame.empty() ? 0.0 : vecFrame.back();
+	result.dLatencyP50 = Percentile(vecLatency, 0.5);
+	result.dLatencyP99 = Percentile(vecLatency, 0.99);
+
+	return result;
+}
+
+namespace
+{
+	struct BaselineValue
+	{
+		const char* pKey;
+		double ScenarioResult::* pValue;
+	};
+
+	const BaselineValue s_pBaselineValues[] = {
+		{ "frame_p50_ms", &ScenarioResult::dFrameP50 },
+		{ "frame_p90_ms", &ScenarioResult::dFrameP90 },
+		{ "frame_p99_ms", &ScenarioResult::dFrameP99 },
+		{ "latency_p50_ms", &ScenarioResult::dLatencyP50 },
+		{ "latency_p99_ms", &ScenarioResult::dLatencyP99 },
+		{ "peak_memory_mb", &ScenarioResult::dPeakMemoryMB }
+	};
+
+	const int s_nBaselineValues = sizeof(s_pBaselineValues) / sizeof(s_pBaselineValues[0]);
+
+	//δʾıĳʧ,˵ո
+	const double s_dMaxLostRatio = 0.01;
+}
+
+bool PerfScenario::CompareBaseline(const ScenarioResult& result, const QString& strBaselineFile, QStringList& listFailures)
+{
+	QSettings settings(strBaselineFile, QSettings::IniFormat);
+
+	for (int i = 0; i < s_nBaselineValues; i ++)
+	{
+		const BaselineValue& value = s_pBaselineValues[i];
+		QString strKey = value.pKey;
+
+		if (!settings.contains("baseline/" + strKey))
+			continue;
+
+		double dBaseline = settings.value("baseline/" + strKey).toDouble();
+		double dTolerance = settings.value("tolerance/" + strKey, settings.value("tolerance/default", 0.2)).toDouble();
+		double dActual = result.*value.pValue;
+
+		if (dActual > dBaseline * (1.0 + dTolerance))
+		{
+			listFailures << QString("%1 %2 exceeds baseline %3 by more than %4%")
+				.arg(strKey).arg(dActual, 0, 'f', 3).arg(dBaseline, 0, 'f', 3).arg(dTolerance * 100.0, 0, 'f', 0);
+		}
+	}
+
+	if (result.nDatagramsSent > 0 && result.nDatagramsDisplayed < result.nDatagramsSent * (1.0 - s_dMaxLostRatio))
+	{
+		listFailures << QString("only %1 of %2 datagrams were displayed")
+			.arg(result.nDatagramsDisplayed).arg(result.nDatagramsSent);
+	}
+
+	return listFailures.isEmpty();
+}
+
+void PerfScenario::WriteBaseline(const ScenarioResult& result, const QString& strBaselineFile, double dTolerance)
+{
+	QSettings settings(strBaselineFile, QSettings::IniFormat);
+
+	for (int i = 0; i < s_nBaselineValues; i ++)
+		settings.setValue(QString("baseline/") + s_pBaselineValues[i].pKey, result.*s_pBaselineValues[i].pValue);
+
+	if (!settings.contains("tolerance/default"))
+		settings.setValue("tolerance/default", dTolerance);
+}
+
+std::string PerfScenario::ToJson(const ScenarioResult& result)
+{
+	std::string strOut = "{\n";
+	char szLine[128];
+
+	for (int i = 0; i < s_nBaselineValues; i ++)
+	{
+		sprintf(szLine, "  \"%s\": %.3f,\n", s_pBaselineValues[i].pKey, result.*s_pBaselineValues[i].pValue);
+		strOut += szLine;
+	}
+
+	sprintf(szLine, "  \"frame_max_ms\": %.3f,\n", result.dFrameMax);
+	strOut += szLine;
+	sprintf(szLine, "  \"datagrams_sent\": %u,\n  \"datagrams_displayed\": %u\n", result.nDatagramsSent, result.nDatagramsDisplayed);
+	strOut += szLine;
+
+	strOut += "}\n";
+	return strOut;
+}
@@ -0,0 +1,118 @@
+#ifndef PERFSCENARIO_H
+#define PERFSCENARIO_H
+
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtNetwork/QUdpSocket>
+
+#include <osg/Timer>
+#include <osgViewer/Viewer>
+#include <osgEarth/MapNode>
+#include <osgEarth/Viewpoint>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+class UDPServer;
+class AeroLineLoader;
+class MyManipulator;
+
+struct ScenarioOptions
+{
+	ScenarioOptions();
+
+	QString strEarthFile;
+	QString strRouteFile;
+	int nTracks;
+	int nFrames;
+
+	//frames before this one are rendered but not measured
+	int nWarmupFrames;
+
+	//simulated seconds per frame and datagrams per track per simulated second
+	double dFrameTime;
+	double dRate;
+
+	int nWidth;
+	int nHeight;
+	int nBasePort;
+};
+
+struct ScenarioResult
+{
+	ScenarioResult();
+
+	double dFrameP50;
+	double dFrameP90;
+	double dFrameP99;
+	double dFrameMax;
+	double dLatencyP50;
+	double dLatencyP99;
+	double dPeakMemoryMB;
+	unsigned int nDatagramsSent;
+	unsigned int nDatagramsDisplayed;
+};
+
+/**
+* Headless end-to-end run of the monitor.
+*
+* Loads a fixed earth file and route file, renders into an offscreen pbuffer
+* and, frame by frame, sends a deterministic stream of position datagrams
+* for N synthetic tracks to one UDPServer per track over the loopback, while
+* MyManipulator flies a scripted camera path. Frame times (ms), the latency
+* from sending a datagram to the end of the frame that first draws it (ms)
+* and the peak resident memory (MB) are compared against a QSettings ini
+* baseline with relative tolerances.
+*/
+class PerfScenario
+{
+public:
+
+	PerfScenario(const ScenarioOptions& options);
+	~PerfScenario();
+
+	bool Setup(QString& strError);
+
+	ScenarioResult Run();
+
+	//false if any value exceeds baseline * (1 + tolerance); listFailures explains why
+	static bool CompareBaseline(const ScenarioResult& result, const QString& strBaselineFile, QStringList& listFailures);
+
+	static void WriteBaseline(const ScenarioResult& result, const QString& strBaselineFile, double dTolerance);
+
+	static std::string ToJson(const ScenarioResult& result);
+
+private:
+
+	struct Track
+	{
+		double dLon;
+		double dLat;
+		double dHeading;
+		double dNextSend;
+		std::deque<osg::Timer_t> dequeSent;
+		unsigned int nLastVertices;
+	};
+
+	void SendDatagrams(double dSimTime, unsigned int& nSent);
+
+	//drawn datagrams are popped from the send queues and their latency recorded
+	void CollectLatency(osg::Timer_t tickDisplayed, std::vector<double>* pLatency, unsigned int& nDisplayed);
+
+	osgEarth::Viewpoint CameraAt(double dProgress) const;
+
+	ScenarioOptions m_options;
+
+	osg::ref_ptr<osgViewer::Viewer> m_pViewer;
+	osg::ref_ptr<osg::Group> m_pRoot;
+	osg::ref_ptr<osgEarth::MapNode> m_pMapNode;
+	MyManipulator* m_pManipulator;
+	AeroLineLoader* m_pAeroLineLoader;
+
+	std::vector<Track> m_vecTracks;
+	std::vector<UDPServer*> m_vecServers;
+	QUdpSocket m_sender;
+};
+
+#endif // PERFSCENARIO_H
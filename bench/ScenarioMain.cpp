@@ -0,0 +1,115 @@
+#include "PerfScenario.h"
+
+#include "../RouteConformance.h"
+
+#include <osg/Geometry>
+#include <osgText/Text>
+
+#include <QtWidgets/QApplication>
+
+#include <stdio.h>
+#include <string.h>
+
+//Ӧóﶨȫֱ,Լṩ
+osg::Node* g_earthNode = nullptr;
+RouteConformance* g_pRouteConformance = nullptr;
+osgEarth::MapNode* g_MapNode = nullptr;
+osg::Geometry* g_GeoScaleLine = nullptr;
+osgText::Text* g_pText = nullptr;
+
+static void PrintUsage()
+{
+	printf("usage: routemonitor_scenario [--earth file] [--routes file] [--tracks n] [--frames n] [--rate hz]\n"
+		"                             [--baseline file] [--write-baseline file] [--tolerance ratio] [--json file]\n"
+		"exit code: 0 passed, 1 regression against the baseline, 2 setup failed\n");
+}
+
+int main(int argc, char** argv)
+{
+	QApplication app(argc, argv);
+
+	ScenarioOptions options;
+	QString strBaseline;
+	QString strWriteBaseline;
+	double dTolerance = 0.2;
+	std::string strJsonFile;
+
+	for (int i = 1; i < argc; i ++)
+	{
+		bool bValue = i + 1 < argc;
+		if (!strcmp(argv[i], "--earth") && bValue)
+			options.strEarthFile = QString::fromLocal8Bit(argv[++i]);
+		else if (!strcmp(argv[i], "--routes") && bValue)
+			options.strRouteFile = QString::fromLocal8Bit(argv[++i]);
+		else if (!strcmp(argv[i], "--tracks") && bValue)
+			options.nTracks = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--frames") && bValue)
+			options.nFrames = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--rate") && bValue)
+			options.dRate = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--baseline") && bValue)
+			strBaseline = QString::fromLocal8Bit(argv[++i]);
+		else if (!strcmp(argv[i], "--write-baseline") && bValue)
+			strWriteBaseline = QString::fromLocal8Bit(argv[++i]);
+		else if (!strcmp(argv[i], "--tolerance") && bValue)
+			dTolerance = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--json") && bValue)
+			strJsonFile = argv[++i];
+		else
+		{
+			PrintUsage();
+			return 2;
+		}
+	}
+
+	//MyManipulatorÿ֡,ֻҪ
+	osg::ref_ptr<osg::Geometry> scaleLine = new osg::Geometry;
+	scaleLine->setVertexArray(new osg::Vec3dArray(7));
+	osg::ref_ptr<osgText::Text> scaleText = new osgText::Text;
+	g_GeoScaleLine = scaleLine.get();
+	g_pText = scaleText.get();
+
+	PerfScenario scenario(options);
+
+	QString strError;
+	if (!scenario.Setup(strError))
+	{
+		printf("setup failed: %s\n", strError.toLocal8Bit().data());
+		return 2;
+	}
+
+	ScenarioResult result = scenario.Run();
+	std::string strJson = PerfScenario::ToJson(result);
+	printf("%s", strJson.c_str());
+
+	if (!strJsonFile.empty())
+	{
+		FILE* pFile = fopen(strJsonFile.c_str(), "wb");
+		if (pFile)
+		{
+			fwrite(strJson.data(), 1, strJson.size(), pFile);
+			fclose(pFile);
+		}
+	}
+
+	if (!strWriteBaseline.isEmpty())
+	{
+		PerfScenario::WriteBaseline(result, strWriteBaseline, dTolerance);
+		printf("baseline written to %s\n", strWriteBaseline.toLocal8Bit().data());
+	}
+
+	if (!strBaseline.isEmpty())
+	{
+		QStringList listFailures;
+		if (!PerfScenario::CompareBaseline(result, strBaseline, listFailures))
+		{
+			for (int i = 0; i < listFailures.size(); i ++)
+				printf("PERFORMANCE REGRESSION: %s\n", listFailures[i].toLocal8Bit().data());
+			return 1;
+		}
+
+		printf("within baseline %s\n", strBaseline.toLocal8Bit().data());
+	}
+
+	return 0;
+}
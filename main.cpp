@@ -44,6 +44,8 @@
 #include <osgEarthAnnotation/LocalGeometryNode>
 
 #include <osgEarthDrivers/bing/bingoptions>
+#include <osgEarthDrivers/xyz/XYZOptions>
+#include <osgEarthDrivers/cache_filesystem/FileSystemCache>
 
 #include <QAction>
 #include <QDockWidget>
@@ -52,6 +54,18 @@
 #include <QApplication>
 #include "MainWindow.h"
 #include "UDPServer.h"
+#include "MetricsServer.h"
+#include "TrackTable.h"
+#include "TrackHistoryStore.h"
+#include "TrackSpatialIndex.h"
+#include "Geofence.h"
+#include "ElevationCache.h"
+#include "CountingCache.h"
+#include "TilePrefetcher.h"
+#include "TileArchiveSource.h"
+#include "ConflictNode.h"
+#include "TerrainClearanceNode.h"
+#include "WorkerPool.h"
 #include <osg/LineWidth>
 
 #include <osg/PointSprite>
@@ -89,20 +103,20 @@ static osg::ref_ptr<osg::Group> s_annoGroup;
 static osgEarth::Util::SkyNode* s_sky = 0L;
 static osgEarth::Util::OceanNode* s_ocean = 0L;
 
-extern double g_dPlanePosLon;
-extern double g_dPlanePosLat;
-extern double g_dPlanePosAngle;
+extern TrackHistoryStore* g_pTrackHistory;
+extern TrackSpatialIndex* g_pTrackIndex;
+extern Geofence* g_pGeofence;
+extern ElevationCache* g_pElevationCache;
+extern TilePrefetcher* g_pTilePrefetcher;
 
-extern double g_dTargetPosLon;
-extern double g_dTargetPosLat;
-
-
-extern osg::ref_ptr<osg::Geode> g_geode;
-extern osg::ref_ptr<osg::Geode> g_geodeTarget;
+extern osg::ref_ptr<osg::Group> g_groupTrail;
+extern osg::ref_ptr<osg::Group> g_groupTrailTarget;
 
 osg::Camera* g_hudCamera = nullptr;
 osgEarth::MapNode* g_MapNode = nullptr;
 osg::Geometry* g_GeoScaleLine = nullptr;
+StatsHUD* g_pStatsHUD = nullptr;
+TrackPlayback* g_pTrackPlayback = nullptr;
 
 //------------------------------------------------------------------
 
@@ -120,37 +134,6 @@ usage(const std::string& msg)
 	return -1;
 }
 
-osg::StateSet* makeStateSet(float size)
-{
-	osg::StateSet *set = new osg::StateSet();
-
-	/// Setup cool blending
-	set->setMode(GL_BLEND, osg::StateAttribute::ON);
-	osg::BlendFunc *fn = new osg::BlendFunc();
-	fn->setFunction(osg::BlendFunc::SRC_ALPHA, osg::BlendFunc::DST_ALPHA);
-	set->setAttributeAndModes(fn, osg::StateAttribute::ON);
-
-	/// Setup the point sprites
-	osg::PointSprite *sprite = new osg::PointSprite();
-	set->setTextureAttributeAndModes(0, sprite, osg::StateAttribute::ON);
-
-	/// Give some size to the points to be able to see the sprite
-	osg::Point *point = new osg::Point();
-	point->setSize(size);
-	set->setAttribute(point);
-
-	/// Disable depth test to avoid sort problems and Lighting
-	set->setMode(GL_DEPTH_TEST, osg::StateAttribute::OFF);
-	set->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
-
-	/// The texture for the sprites
-	osg::Texture2D *tex = new osg::Texture2D();
-	tex->setImage(osgDB::readImageFile("C:/OSG_OSGEarth/OpenSceneGraph-Data/Images/particle.rgb"));
-	set->setTextureAttributeAndModes(0, tex, osg::StateAttribute::ON);
-
-	return set;
-}
-
 //------------------------------------------------------------------
 
 osgEarth::Annotation::LocalGeometryNode* CreatePlaneTag(MapNode* pMapNode)
@@ -185,8 +168,8 @@ osgEarth::Annotation::LocalGeometryNode* CreatePlaneTag(MapNode* pMapNode)
 	return pLocalGeoNode;
 }
 
-osg::ref_ptr<osg::Geode> g_geode = nullptr;
-osg::ref_ptr<osg::Geode> g_geodeTarget = nullptr;
+osg::ref_ptr<osg::Group> g_groupTrail = nullptr;
+osg::ref_ptr<osg::Group> g_groupTrailTarget = nullptr;
 
 osg::Group* g_root = nullptr;
 osg::Node* g_earthNode = nullptr;
@@ -202,12 +185,13 @@ void LoadPosFromFile()
 	strIniFile += "/data/pos.ini";
 
 	QSettings settings(strIniFile, QSettings::IniFormat);
-	g_dPlanePosLon = settings.value("lon").toDouble();
-	g_dPlanePosLat = settings.value("lat").toDouble();
-	g_dPlanePosAngle = settings.value("angle").toDouble();
 
-	g_dTargetPosLon = settings.value("targetlon").toDouble();
-	g_dTargetPosLat = settings.value("targetlat").toDouble();
+	//ϴ˳ʱķɻĿλд뺽,Ϊʼλ
+	TrackTable* pTrackTable = TrackTable::Instance();
+	pTrackTable->Update(pTrackTable->Register(6665), 0.0, settings.value("lon").toDouble(), settings.value("lat").toDouble(), settings.value("alt", 10000.0).toDouble()
+		, settings.value("angle").toDouble(), TrackTable::FLAG_RESTORED);
+	pTrackTable->Update(pTrackTable->Register(6666), 0.0, settings.value("targetlon").toDouble(), settings.value("targetlat").toDouble(), settings.value("targetalt", 10000.0).toDouble()
+		, 0.0, TrackTable::FLAG_RESTORED);
 
 	g_dOriginHeight = settings.value("height", 500000.0).toDouble();
 }
@@ -219,12 +203,23 @@ void SavePosFromFile()
 	strIniFile += "/data/pos.ini";
 
 	QSettings settings(strIniFile, QSettings::IniFormat);
-	settings.setValue("lon", g_dPlanePosLon);
-	settings.setValue("lat", g_dPlanePosLat);
-	settings.setValue("angle", g_dPlanePosAngle);
 
-	settings.setValue("targetlon", g_dTargetPosLon);
-	settings.setValue("targetlat", g_dTargetPosLat);
+	TrackTable* pTrackTable = TrackTable::Instance();
+	TrackTable::Row row;
+	if (pTrackTable->Read(pTrackTable->Find(6665), row))
+	{
+		settings.setValue("lon", row.dLon);
+		settings.setValue("lat", row.dLat);
+		settings.setValue("alt", row.dAlt);
+		settings.setValue("angle", row.dHeading);
+	}
+
+	if (pTrackTable->Read(pTrackTable->Find(6666), row))
+	{
+		settings.setValue("targetlon", row.dLon);
+		settings.setValue("targetlat", row.dLat);
+		settings.setValue("targetalt", row.dAlt);
+	}
 	settings.setValue("height", g_dOriginHeight);
 }
 
@@ -270,6 +265,9 @@ osg::Node* createScaleBarHUD(osgText::Text* updateText)
 
 		linesGeom->setVertexArray(vertices);
 		linesGeom->setDataVariance(osg::Object::DYNAMIC);
+		//߶ԭ޸,ʹVBOؽʾб
+		linesGeom->setUseDisplayList(false);
+		linesGeom->setUseVertexBufferObjects(true);
 
 		// set the colors as before, plus using the above
 		osg::ref_ptr<osg::Vec4Array> colors = new osg::Vec4Array;
@@ -385,6 +383,29 @@ main(int argc, char** argv)
 
 	LoadPosFromFile();
 
+	//ʷ¼ڳĿ¼history,򲻿ʱֻǲ¼
+	TrackHistoryStore trackHistory;
+	if (trackHistory.Open(QFileInfo(QApplication::applicationFilePath()).absolutePath() + "/history"))
+		g_pTrackHistory = &trackHistory;
+
+	TrackSpatialIndex trackIndex;
+	g_pTrackIndex = &trackIndex;
+
+	//ͻ̽ȷ㹲õĹ߳
+	WorkerPool workerPool;
+
+	//: data/geofenceµshpgeojsonļ,ȡnameֶ
+	Geofence geofence;
+	{
+		QDir dirGeofence(strResourcePath + "geofence");
+		QStringList listFiles = dirGeofence.entryList(QStringList() << "*.shp" << "*.geojson" << "*.json", QDir::Files);
+		for (int i = 0; i < listFiles.size(); i ++)
+			geofence.Load(dirGeofence.absoluteFilePath(listFiles[i]));
+
+		if (geofence.GetNumFences() > 0)
+			g_pGeofence = &geofence;
+	}
+
 	QString strResourcePath1 = QApplication::applicationFilePath();
 	strResourcePath1 = QFileInfo(strResourcePath1).absolutePath();
 	strResourcePath1 += "/temp";
@@ -448,10 +469,57 @@ main(int argc, char** argv)
 	strFilePath = QFileInfo(strFilePath).absolutePath();
 
 	osg::ref_ptr<osgEarth::QtGui::DataManager> dataManager = new osgEarth::QtGui::DataManager(mapNode.get());
-	osgEarth::Drivers::BingOptions bing;
-	QByteArray arrayTemp1 = QString(strFilePath + "/data/1").toLocal8Bit();
-	bing.key() = arrayTemp1.data();
-	dataManager->map()->addImageLayer(new osgEarth::ImageLayer("TileImage", bing));
+
+	//õƬĿ¼,·ԤҲд;Ҫڼͼ֮ǰ
+	QSettings seedSettings(strResourcePath + "seed.ini", QSettings::IniFormat);
+	QString strCachePath = seedSettings.value("cache/path").toString();
+	if (!strCachePath.isEmpty())
+	{
+		osgEarth::Drivers::FileSystemCacheOptions cacheOptions;
+		cacheOptions.rootPath() = strCachePath.toLocal8Bit().data();
+
+		//һ,ʴָӿڵ
+		osgEarth::Cache* pCache = osgEarth::CacheFactory::create(cacheOptions);
+		if (pCache)
+			dataManager->map()->setCache(new CountingCache(pCache));
+	}
+
+	//ӰƬϴǰѹBC1/BC3,ʡԴ;texture.inicompressionΪnone,bc1,bc3auto
+	QSettings textureSettings(strResourcePath + "texture.ini", QSettings::IniFormat);
+	g_nTextureCompression = CompressedImageLayer::ParseFormat(textureSettings.value("texture/compression", "none").toString().toLower().toStdString());
+
+	//source/xyz_urlָ򱾵Ŀ¼ʱBing,file:///d:/tiles/{z}/{x}/{y}.png
+	QString strXYZUrl = seedSettings.value("source/xyz_url").toString();
+	if (!strXYZUrl.isEmpty())
+	{
+		osgEarth::Drivers::XYZOptions xyz;
+		xyz.url() = osgEarth::URI(strXYZUrl.toLocal8Bit().data());
+		xyz.profile() = osgEarth::ProfileOptions("spherical-mercator");
+		dataManager->map()->addImageLayer(CompressedImageLayer::Create(osgEarth::ImageLayerOptions("TileImage", xyz), g_nTextureCompression));
+	}
+	else
+	{
+		osgEarth::Drivers::BingOptions bing;
+		QByteArray arrayTemp1 = QString(strFilePath + "/data/1").toLocal8Bit();
+		bing.key() = arrayTemp1.data();
+		dataManager->map()->addImageLayer(CompressedImageLayer::Create(osgEarth::ImageLayerOptions("TileImage", bing), g_nTextureCompression));
+	}
+
+	//data/tilesµĴƬ,Ӱڵͼ,߳Ϊ߳ͼ
+	QDir dirTiles(strResourcePath + "tiles");
+	QStringList listArchives = dirTiles.entryList(QStringList("*.rmta"), QDir::Files, QDir::Name);
+	for (int i = 0; i < listArchives.size(); i ++)
+	{
+		osg::ref_ptr<TileArchiveSource> source = new TileArchiveSource(dirTiles.filePath(listArchives[i]));
+		if (!source->IsOpen())
+			continue;
+
+		std::string strName = QFileInfo(listArchives[i]).completeBaseName().toLocal8Bit().data();
+		if (source->IsElevation())
+			dataManager->map()->addElevationLayer(new osgEarth::ElevationLayer(osgEarth::ElevationLayerOptions(strName), source.get()));
+		else
+			dataManager->map()->addImageLayer(CompressedImageLayer::Create(osgEarth::ImageLayerOptions(strName), g_nTextureCompression, source.get()));
+	}
 
 	DemoMainWindow appWin(dataManager.get(), mapNode.get(), s_annoGroup);
 
@@ -468,6 +536,10 @@ main(int argc, char** argv)
 	MyManipulator* pCameraManipulator = new MyManipulator;
 	pViewer->setCameraManipulator(pCameraManipulator);
 
+#ifdef ROUTEMONITOR_TRACE
+	TraceInstallViewer(pViewer);
+#endif
+
 	{
 		osgEarth::Viewpoint viewPoint = pCameraManipulator->getViewpoint();
 		double dRange = viewPoint.getRange();
@@ -507,16 +579,19 @@ main(int argc, char** argv)
 	}
 	else
 	{
-		/*osg::ref_ptr<osg::Geode> geode*/g_geode = new osg::Geode();
-		g_geodeTarget = new osg::Geode();
-		//g_geode->addDrawable(linesGeom);
-		g_geode->getOrCreateStateSet()->setMode(GL_LIGHTING, osg::StateAttribute::OFF | osg::StateAttribute::OVERRIDE);
-		g_geodeTarget->getOrCreateStateSet()->setMode(GL_LIGHTING, osg::StateAttribute::OFF | osg::StateAttribute::OVERRIDE);
-
-		root->addChild(g_geode);
-		root->addChild(g_geodeTarget);
+		g_groupTrail = new osg::Group();
+		g_groupTrailTarget = new osg::Group();
+		g_groupTrail->getOrCreateStateSet()->setMode(GL_LIGHTING, osg::StateAttribute::OFF | osg::StateAttribute::OVERRIDE);
+		g_groupTrailTarget->getOrCreateStateSet()->setMode(GL_LIGHTING, osg::StateAttribute::OFF | osg::StateAttribute::OVERRIDE);
+
+		root->addChild(g_groupTrail);
+		root->addChild(g_groupTrailTarget);
 	}
 
+	//ͻ̽,ϱʧȥĺ
+	osg::ref_ptr<ConflictNode> conflictNode = new ConflictNode(osgEarth::SpatialReference::get("wgs84")->getEllipsoid(), &workerPool);
+	root->addChild(conflictNode.get());
+
 	//طɻ
 	QString strPlanePath = strResourcePath + "plane.png";
 	QByteArray arrayPlane = strPlanePath.toLocal8Bit();
@@ -526,11 +601,13 @@ main(int argc, char** argv)
 	pin.getOrCreate<IconSymbol>()->url()->setLiteral(pPathPlanePNG);
 	pin.getOrCreate<IconSymbol>()->alignment() = osgEarth::Symbology::IconSymbol::ALIGN_CENTER_CENTER;
 	//PlaceNode* pPlaneTag = new PlaceNode(mapNode, GeoPoint(osgEarth::SpatialReference::get("wgs84"), 0.0, 0.0, 10000.0), "", pin);
-	MyPlaceNode* pPlaneTag = new MyPlaceNode(mapNode, GeoPoint(osgEarth::SpatialReference::get("wgs84"), g_dPlanePosLon, g_dPlanePosLat, 10000.0), "", pin);
-	pPlaneTag->RotateHeading(g_dPlanePosAngle);
+	TrackTable::Row rowPlane;
+	TrackTable::Instance()->Read(TrackTable::Instance()->Find(6665), rowPlane);
+	MyPlaceNode* pPlaneTag = new MyPlaceNode(mapNode, GeoPoint(osgEarth::SpatialReference::get("wgs84"), rowPlane.dLon, rowPlane.dLat, rowPlane.dAlt), "", pin);
+	pPlaneTag->RotateHeading(rowPlane.dHeading);
 
 	dataManager->addAnnotation(pPlaneTag, s_annoGroup);
-	UDPServer udpServer(g_geode.get(), g_dPlanePosLon, g_dPlanePosLat, g_dPlanePosAngle, 6665, pViewBase, pPlaneTag);
+	UDPServer udpServer(g_groupTrail.get(), 6665, pViewBase, pPlaneTag);
 
 	//Ŀ
 	QString strTargetPath = strResourcePath + "target.png";
@@ -540,11 +617,124 @@ main(int argc, char** argv)
 	Style pin2;
 	pin2.getOrCreate<IconSymbol>()->url()->setLiteral(pPathTargetPNG);
 	pin2.getOrCreate<IconSymbol>()->alignment() = osgEarth::Symbology::IconSymbol::ALIGN_CENTER_CENTER;
-	MyPlaceNode* pTargetTag = new MyPlaceNode(mapNode, GeoPoint(osgEarth::SpatialReference::get("wgs84"), g_dTargetPosLon, g_dTargetPosLat, 10000.0), "", pin2);
+	TrackTable::Row rowTarget;
+	TrackTable::Instance()->Read(TrackTable::Instance()->Find(6666), rowTarget);
+	MyPlaceNode* pTargetTag = new MyPlaceNode(mapNode, GeoPoint(osgEarth::SpatialReference::get("wgs84"), rowTarget.dLon, rowTarget.dLat, rowTarget.dAlt), "", pin2);
 
-	double nTemp;
 	dataManager->addAnnotation(pTargetTag, s_annoGroup);
-	UDPServer udpServer2(g_geodeTarget.get(), g_dTargetPosLon, g_dTargetPosLat, nTemp, 6666, pViewBase, pTargetTag);
+	UDPServer udpServer2(g_groupTrailTarget.get(), 6666, pViewBase, pTargetTag);
+
+	//θ߶Ȼ,̨߳ѯ,ÿ֡ϲ
+	ElevationCache elevationCache(mapNode->getMap(), 2, 12, 4096);
+	g_pElevationCache = &elevationCache;
+	pViewer->addEventHandler(new ElevationFrameHandler(&elevationCache));
+
+	//ɻʱٺԤȡҰƬ;seed.iniû仺Ŀ¼ʱԤȡ
+	TilePrefetcher tilePrefetcher(mapNode->getMap());
+	g_pTilePrefetcher = &tilePrefetcher;
+
+	//Ԥ⺽ظ߶,͸߶Ȼͬһ߳
+	osg::ref_ptr<TerrainClearanceNode> clearanceNode = new TerrainClearanceNode(osgEarth::SpatialReference::get("wgs84")->getEllipsoid(), &elevationCache, &workerPool);
+	root->addChild(clearanceNode.get());
+
+	//data/tracks.iniа˿ڷ,[6665] clamp_to_terrain=true height_above_terrain=150
+	{
+		QSettings settings(strResourcePath + "tracks.ini", QSettings::IniFormat);
+		UDPServer* pServers[] = { &udpServer, &udpServer2 };
+		for (int i = 0; i < 2; i ++)
+		{
+			settings.beginGroup(QString::number(pServers[i]->m_nPort));
+			pServers[i]->SetTerrainClamp(settings.value("clamp_to_terrain", false).toBool()
+				, settings.value("height_above_terrain", 0.0).toDouble());
+			settings.endGroup();
+		}
+	}
+
+	QObject::connect(&udpServer, SIGNAL(sigConformanceChanged(int, bool, double)), &appWin, SLOT(slotConformanceChanged(int, bool, double)));
+	QObject::connect(&udpServer2, SIGNAL(sigConformanceChanged(int, bool, double)), &appWin, SLOT(slotConformanceChanged(int, bool, double)));
+	QObject::connect(&udpServer, SIGNAL(sigGeofenceChanged(int, QString, bool)), &appWin, SLOT(slotGeofenceChanged(int, QString, bool)));
+	QObject::connect(&udpServer2, SIGNAL(sigGeofenceChanged(int, QString, bool)), &appWin, SLOT(slotGeofenceChanged(int, QString, bool)));
+
+	//ͳHUD,Ĭ,ɹ
+	g_pStatsHUD = new StatsHUD(pViewer);
+	g_pStatsHUD->AddListener(&udpServer);
+	g_pStatsHUD->AddListener(&udpServer2);
+	g_hudCamera->addChild(g_pStatsHUD);
+
+	//ʷط,ڵײʱ
+	TrackPlayback trackPlayback(&trackHistory);
+	trackPlayback.AddTrack(&udpServer);
+	trackPlayback.AddTrack(&udpServer2);
+	g_pTrackPlayback = &trackPlayback;
+	pViewer->addEventHandler(new PlaybackFrameHandler(&trackPlayback));
+
+	QObject::connect(&trackPlayback, SIGNAL(sigTimeChanged(double)), &appWin, SLOT(slotPlaybackTimeChanged(double)));
+
+	//ѡPrometheusָ˿,data/metrics.iniп
+	MetricsServer metricsServer;
+	{
+		QSettings settings(strResourcePath + "metrics.ini", QSettings::IniFormat);
+		if (settings.value("enabled", false).toBool())
+		{
+			Metrics* pMetrics = Metrics::Instance();
+			AeroLineLoader* pAeroLineLoader = appWin.GetAeroLineLoader();
+
+			pMetrics->AddGauge("routemonitor_pager_queue_length", "Database pager queue depth.", "queue=\"request\"",
+				[pViewer]() { return pViewer->getDatabasePager() ? (double)pViewer->getDatabasePager()->getFileRequestListSize() : 0.0; });
+			pMetrics->AddGauge("routemonitor_pager_queue_length", "Database pager queue depth.", "queue=\"compile\"",
+				[pViewer]() { return pViewer->getDatabasePager() ? (double)pViewer->getDatabasePager()->getDataToCompileListSize() : 0.0; });
+			pMetrics->AddGauge("routemonitor_pager_queue_length", "Database pager queue depth.", "queue=\"merge\"",
+				[pViewer]() { return pViewer->getDatabasePager() ? (double)pViewer->getDatabasePager()->getDataToMergeListSize() : 0.0; });
+
+			pMetrics->AddGauge("routemonitor_memory_bytes", "Resident memory, whole process and estimated per subsystem.", "subsystem=\"process\"",
+				[]() { return Metrics::GetResidentBytes(); });
+			pMetrics->AddGauge("routemonitor_memory_bytes", "Resident memory, whole process and estimated per subsystem.", "subsystem=\"trails\"",
+				[&udpServer, &udpServer2]() -> double
+			{
+				double dBytes = 0.0;
+				dBytes += udpServer.m_pTrail->GetMemoryBytes();
+				dBytes += udpServer2.m_pTrail->GetMemoryBytes();
+				return dBytes;
+			});
+			pMetrics->AddGauge("routemonitor_memory_bytes", "Resident memory, whole process and estimated per subsystem.", "subsystem=\"routes\"",
+				[pAeroLineLoader]() -> double
+			{
+				double dBytes = 0.0;
+				for (unsigned int i = 0; i < RouteBatchNode::NUM_LEVELS; i ++)
+					dBytes += pAeroLineLoader->GetRouteNode()->GetNumVertices(i) * sizeof(osg::Vec3);
+				return dBytes;
+			});
+
+			pMetrics->AddGauge("routemonitor_memory_bytes", "Resident memory, whole process and estimated per subsystem.", "subsystem=\"elevation\"",
+				[&elevationCache]() { return (double)elevationCache.GetMemoryBytes(); });
+
+			pMetrics->AddGauge("routemonitor_tracks", "Tracks with a known position in the track table.", "",
+				[]() -> double
+			{
+				std::vector<TrackTable::Row> vecRows;
+				TrackTable::Instance()->Snapshot(vecRows);
+				return (double)vecRows.size();
+			});
+
+			pMetrics->AddGauge("routemonitor_conflicts", "Track pairs predicted to lose separation within the look-ahead.", "",
+				[conflictNode]() { return (double)conflictNode->GetNumConflicts(); });
+			pMetrics->AddGauge("routemonitor_conflict_probe_seconds", "Duration of the last conflict probe run.", "",
+				[conflictNode]() { return conflictNode->GetRunTime() / 1000.0; });
+			pMetrics->AddGauge("routemonitor_prefetch_queue_length", "Tiles predicted ahead of the followed aircraft and not fetched yet.", "",
+				[&tilePrefetcher]() { return (double)tilePrefetcher.GetNumQueued(); });
+			pMetrics->AddGauge("routemonitor_prefetch_fetched", "Tiles fetched ahead of the followed aircraft since the start.", "",
+				[&tilePrefetcher]() { return (double)tilePrefetcher.GetNumFetched(); });
+			pMetrics->AddGauge("routemonitor_terrain_warnings", "Tracks whose projected path comes within the margin above the terrain.", "",
+				[clearanceNode]() { return (double)clearanceNode->GetNumWarnings(); });
+			pMetrics->AddGauge("routemonitor_terrain_clearance_seconds", "Duration of the last terrain clearance run.", "",
+				[clearanceNode]() { return clearanceNode->GetRunTime() / 1000.0; });
+
+			pViewer->addEventHandler(new FrameMetricsHandler);
+
+			if (!metricsServer.Listen(settings.value("address", "127.0.0.1").toString(), settings.value("port", 9464).toInt()))
+				OE_WARN << "metrics endpoint could not listen" << std::endl;
+		}
+	}
 
 #if OSG_MIN_VERSION_REQUIRED(3,3,2)
 	// Enable touch events on the viewer
@@ -621,5 +811,14 @@ main(int argc, char** argv)
 	int nRes = app.exec();
 
 	SavePosFromFile();
+
+	g_pTrackPlayback = nullptr;
+	g_pTilePrefetcher = nullptr;
+	g_pElevationCache = nullptr;
+	g_pTrackIndex = nullptr;
+	g_pGeofence = nullptr;
+	g_pRouteConformance = nullptr;
+	g_pTrackHistory = nullptr;
+	trackHistory.Close();
 	return nRes;
 }
@@ -0,0 +1,128 @@
+#include "../GeoTiffPrep.h"
+
+#include <osgEarth/Registry>
+#include <osgEarth/ImageLayer>
+#include <osgEarthDrivers/gdal/GDALOptions>
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFileInfo>
+
+#include <stdio.h>
+#include <string.h>
+
+static void PrintUsage()
+{
+	printf("usage: routemonitor_tiffprep file.tif [--out file] [--block n] [--compress NONE|DEFLATE|LZW|JPEG]\n"
+		"                               [--resampling NEAREST|AVERAGE|...] [--no-reproject] [--force] [--measure n]\n"
+		"writes file.tiled.tif by default, which the layer loaders pick up instead of file.tif;\n"
+		"--measure compares the tiles per second of the two files over n tiles\n");
+}
+
+//osgEarth GDALͼƬٶ,ļ
+static double MeasureTileRate(const QString& strFile, const std::vector<osgEarth::TileKey>& vecKeys, unsigned int& nValid)
+{
+	osgEarth::Drivers::GDALOptions gdal;
+	gdal.url() = osgEarth::URI(strFile.toUtf8().data());
+	osg::ref_ptr<osgEarth::ImageLayer> layer = new osgEarth::ImageLayer(osgEarth::ImageLayerOptions("measure", gdal));
+	layer->setTargetProfileHint(osgEarth::Registry::instance()->getGlobalGeodeticProfile());
+	nValid = 0;
+	if (!layer->getTileSource())
+		return 0.0;
+
+	QElapsedTimer timer;
+	timer.start();
+	for (size_t i = 0; i < vecKeys.size(); i ++)
+	{
+		if (layer->createImage(vecKeys[i]).valid())
+			nValid ++;
+	}
+
+	double dSeconds = timer.nsecsElapsed() * 1e-9;
+	return dSeconds > 0.0 ? vecKeys.size() / dSeconds : 0.0;
+}
+
+int main(int argc, char** argv)
+{
+	QString strSource;
+	QString strTarget;
+	GeoTiffPrep::Options options;
+	bool bForce = false;
+	unsigned int nMeasure = 0;
+
+	for (int i = 1; i < argc; i ++)
+	{
+		bool bValue = i + 1 < argc;
+		if (!strcmp(argv[i], "--out") && bValue)
+			strTarget = QString::fromLocal8Bit(argv[++i]);
+		else if (!strcmp(argv[i], "--block") && bValue)
+			options.nBlockSize = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--compress") && bValue)
+			options.strCompress = argv[++i];
+		else if (!strcmp(argv[i], "--resampling") && bValue)
+			options.strResampling = argv[++i];
+		else if (!strcmp(argv[i], "--measure") && bValue)
+			nMeasure = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--no-reproject"))
+			options.bReproject = false;
+		else if (!strcmp(argv[i], "--force"))
+			bForce = true;
+		else if (argv[i][0] != '-' && strSource.isEmpty())
+			strSource = QString::fromLocal8Bit(argv[i]);
+		else
+		{
+			PrintUsage();
+			return 2;
+		}
+	}
+
+	if (strSource.isEmpty() || options.nBlockSize < 16)
+	{
+		PrintUsage();
+		return 2;
+	}
+
+	if (strTarget.isEmpty())
+		strTarget = GeoTiffPrep::GetPreparedName(strSource);
+
+	//Ѿұԭļ¾Ͳ
+	bool bUpToDate = QFileInfo(strTarget).exists() && QFileInfo(strTarget).lastModified() >= QFileInfo(strSource).lastModified()
+		&& GeoTiffPrep::IsPrepared(strTarget);
+	if (bForce || !bUpToDate)
+	{
+		QElapsedTimer timer;
+		timer.start();
+
+		QString strError;
+		if (!GeoTiffPrep::Prepare(strSource, strTarget, options, strError, true))
+		{
+			printf("%s\n", strError.toLocal8Bit().data());
+			return 1;
+		}
+
+		printf("%s written in %.1f s\n", strTarget.toLocal8Bit().data(), timer.elapsed() * 1e-3);
+	}
+	else
+		printf("%s is up to date\n", strTarget.toLocal8Bit().data());
+
+	if (nMeasure > 0)
+	{
+		std::vector<osgEarth::TileKey> vecKeys;
+		GeoTiffPrep::CollectSampleKeys(strSource, nMeasure, vecKeys);
+		if (vecKeys.empty())
+		{
+			printf("no tiles to measure over %s\n", strSource.toLocal8Bit().data());
+			return 1;
+		}
+
+		unsigned int nSourceValid, nTargetValid;
+		double dSourceRate = MeasureTileRate(strSource, vecKeys, nSourceValid);
+		double dTargetRate = MeasureTileRate(strTarget, vecKeys, nTargetValid);
+		printf("levels %u-%u, %u tiles\n", vecKeys.front().getLOD(), vecKeys.back().getLOD(), (unsigned int)vecKeys.size());
+		printf("source   %8.1f tiles/s (%u images)\n", dSourceRate, nSourceValid);
+		printf("prepared %8.1f tiles/s (%u images)\n", dTargetRate, nTargetValid);
+		if (dSourceRate > 0.0)
+			printf("speedup  %8.2fx\n", dTargetRate / dSourceRate);
+	}
+
+	return 0;
+}
@@ -0,0 +1,288 @@
+#include "../TileArchive.h"
+#include "../GeoTiffPrep.h"
+
+#include <osgEarth/Registry>
+#include <osgEarth/ImageLayer>
+#include <osgEarth/ElevationLayer>
+#include <osgEarth/ImageUtils>
+#include <osgEarth/HeightFieldUtils>
+#include <osgEarth/TileKey>
+#include <osgEarthDrivers/gdal/GDALOptions>
+#include <osgDB/Registry>
+#include <osgDB/ReadFile>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#include <sstream>
+#include <stdio.h>
+#include <string.h>
+
+static void PrintUsage()
+{
+	printf("usage: routemonitor_tilepacker --out file.rmta (--cache dir [--tms] [--ext png|jpg] | --tif file [--elevation])\n"
+		"                                 [--profile geodetic|mercator] [--format png|jpg|rgba|f32] [--tile-size n]\n"
+		"                                 [--min-level n] [--max-level n]\n"
+		"--cache reads an XYZ directory dir/{z}/{x}/{y}.ext (TMS rows with --tms), --tif reads a GeoTIFF through GDAL\n");
+}
+
+//洢ʽһͼ
+static bool EncodeImage(osg::Image* pImage, const std::string& strFormat, unsigned int nTileSize, std::string& strData)
+{
+	osg::ref_ptr<osg::Image> image = pImage;
+	if (image->s() != (int)nTileSize || image->t() != (int)nTileSize)
+	{
+		osg::ref_ptr<osg::Image> resized;
+		if (!osgEarth::ImageUtils::resizeImage(image.get(), nTileSize, nTileSize, resized))
+			return false;
+		image = resized;
+	}
+
+	if (strFormat == "rgba")
+	{
+		if (image->getPixelFormat() != GL_RGBA || image->getDataType() != GL_UNSIGNED_BYTE)
+			image = osgEarth::ImageUtils::convertToRGBA8(image.get());
+		if (!image.valid())
+			return false;
+
+		strData.assign(reinterpret_cast<const char*>(image->data()), nTileSize * nTileSize * 4);
+		return true;
+	}
+
+	osgDB::ReaderWriter* pWriter = osgDB::Registry::instance()->getReaderWriterForExtension(strFormat);
+	if (!pWriter)
+		return false;
+
+	std::ostringstream stream;
+	if (!pWriter->writeImage(*image, stream).success())
+		return false;
+
+	strData = stream.str();
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	QString strOut;
+	QString strCache;
+	QString strTif;
+	std::string strExt = "png";
+	std::string strProfile;
+	std::string strFormat;
+	bool bTms = false;
+	bool bElevation = false;
+	unsigned int nTileSize = 0;
+	unsigned int nMinLevel = 0;
+	unsigned int nMaxLevel = 12;
+
+	for (int i = 1; i < argc; i ++)
+	{
+		bool bValue = i + 1 < argc;
+		if (!strcmp(argv[i], "--out") && bValue)
+			strOut = QString::fromLocal8Bit(argv[++i]);
+		else if (!strcmp(argv[i], "--cache") && bValue)
+			strCache = QString::fromLocal8Bit(argv[++i]);
+		else if (!strcmp(argv[i], "--tif") && bValue)
+			strTif = QString::fromLocal8Bit(argv[++i]);
+		else if (!strcmp(argv[i], "--ext") && bValue)
+			strExt = argv[++i];
+		else if (!strcmp(argv[i], "--profile") && bValue)
+			strProfile = argv[++i];
+		else if (!strcmp(argv[i], "--format") && bValue)
+			strFormat = argv[++i];
+		else if (!strcmp(argv[i], "--tile-size") && bValue)
+			nTileSize = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--min-level") && bValue)
+			nMinLevel = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--max-level") && bValue)
+			nMaxLevel = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--tms"))
+			bTms = true;
+		else if (!strcmp(argv[i], "--elevation"))
+			bElevation = true;
+		else
+		{
+			PrintUsage();
+			return 2;
+		}
+	}
+
+	if (strOut.isEmpty() || strCache.isEmpty() == strTif.isEmpty() || nMaxLevel < nMinLevel || (bElevation && strTif.isEmpty()))
+	{
+		PrintUsage();
+		return 2;
+	}
+
+	//ƬĿ¼һWebī,GeoTIFFĬϰ
+	TileArchive::Info info;
+	info.nContent = bElevation ? TileArchive::CONTENT_ELEVATION : TileArchive::CONTENT_IMAGE;
+	if (strProfile.empty())
+		strProfile = strCache.isEmpty() ? "geodetic" : "mercator";
+	info.nProfile = strProfile == "mercator" ? TileArchive::PROFILE_MERCATOR : TileArchive::PROFILE_GEODETIC;
+	info.strFormat = !strFormat.empty() ? strFormat : (bElevation ? "f32" : (strCache.isEmpty() ? "png" : strExt));
+	info.nTileSize = nTileSize > 0 ? nTileSize : (bElevation ? 65 : 256);
+	info.nMinLevel = nMinLevel;
+	info.nMaxLevel = nMaxLevel;
+
+	if (bElevation != (info.strFormat == "f32"))
+	{
+		printf("elevation is stored as f32 and imagery as png, jpg or rgba\n");
+		return 2;
+	}
+
+	const osgEarth::Profile* pProfile = info.nProfile == TileArchive::PROFILE_MERCATOR
+		? osgEarth::Registry::instance()->getSphericalMercatorProfile()
+		: osgEarth::Registry::instance()->getGlobalGeodeticProfile();
+
+	TileArchiveWriter writer(info);
+	TileArchiveWriter::ReadFunc func;
+
+	osg::ref_ptr<osgEarth::ImageLayer> imageLayer;
+	osg::ref_ptr<osgEarth::ElevationLayer> elevationLayer;
+
+	if (!strCache.isEmpty())
+	{
+		//Ŀ¼ЩƬʹЩ
+		QDir dirCache(strCache);
+		QString strSuffix = QString::fromLocal8Bit(strExt.c_str());
+		for (unsigned int nLevel = nMinLevel; nLevel <= nMaxLevel; nLevel ++)
+		{
+			unsigned int nTilesX, nTilesY;
+			pProfile->getNumTiles(nLevel, nTilesX, nTilesY);
+
+			QDir dirLevel(dirCache.filePath(QString::number(nLevel)));
+			QStringList listColumns = dirLevel.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+			for (int i = 0; i < listColumns.size(); i ++)
+			{
+				bool bOk = false;
+				unsigned int x = listColumns[i].toUInt(&bOk);
+				if (!bOk || x >= nTilesX)
+					continue;
+
+				QStringList listRows = QDir(dirLevel.filePath(listColumns[i])).entryList(QStringList("*." + strSuffix), QDir::Files);
+				for (int j = 0; j < listRows.size(); j ++)
+				{
+					unsigned int y = QFileInfo(listRows[j]).completeBaseName().toUInt(&bOk);
+					if (bOk && y < nTilesY)
+						writer.Add(nLevel, x, bTms ? nTilesY - 1 - y : y);
+				}
+			}
+		}
+
+		func = [&](unsigned int nLevel, unsigned int x, unsigned int y, std::string& strData) -> bool
+		{
+			unsigned int nTilesX, nTilesY;
+			pProfile->getNumTiles(nLevel, nTilesX, nTilesY);
+			QString strFile = dirCache.filePath(QString("%1/%2/%3.%4").arg(nLevel).arg(x).arg(bTms ? nTilesY - 1 - y : y).arg(strSuffix));
+
+			//ʽͬʱԭ,±
+			if (info.strFormat == strExt)
+			{
+				QFile file(strFile);
+				if (!file.open(QIODevice::ReadOnly))
+					return false;
+				QByteArray arrayData = file.readAll();
+				strData.assign(arrayData.constData(), arrayData.size());
+				return !strData.empty();
+			}
+
+			osg::ref_ptr<osg::Image> image = osgDB::readImageFile(strFile.toLocal8Bit().data());
+			return image.valid() && EncodeImage(image.get(), info.strFormat, info.nTileSize, strData);
+		};
+	}
+	else
+	{
+		osgEarth::Drivers::GDALOptions gdal;
+		gdal.url() = osgEarth::URI(GeoTiffPrep::Resolve(strTif).toLocal8Bit().data());
+
+		osgEarth::TileSource* pSource = nullptr;
+		if (bElevation)
+		{
+			elevationLayer = new osgEarth::ElevationLayer(osgEarth::ElevationLayerOptions("pack", gdal));
+			elevationLayer->setTargetProfileHint(pProfile);
+			pSource = elevationLayer->getTileSource();
+		}
+		else
+		{
+			imageLayer = new osgEarth::ImageLayer(osgEarth::ImageLayerOptions("pack", gdal));
+			imageLayer->setTargetProfileHint(pProfile);
+			pSource = imageLayer->getTileSource();
+		}
+
+		if (!pSource || !pSource->getProfile())
+		{
+			printf("cannot open %s\n", strTif.toLocal8Bit().data());
+			return 2;
+		}
+
+		//Ӱ񸲸ǵƬ
+		std::vector<osgEarth::GeoExtent> vecExtents;
+		const osgEarth::DataExtentList& listExtents = pSource->getDataExtents();
+		for (osgEarth::DataExtentList::const_iterator it = listExtents.begin(); it != listExtents.end(); ++ it)
+			vecExtents.push_back(*it);
+		if (vecExtents.empty())
+			vecExtents.push_back(pSource->getProfile()->getExtent());
+
+		for (size_t i = 0; i < vecExtents.size(); i ++)
+		{
+			osgEarth::GeoExtent extent = vecExtents[i].transform(pProfile->getSRS());
+			for (unsigned int nLevel = nMinLevel; nLevel <= nMaxLevel; nLevel ++)
+			{
+				std::vector<osgEarth::TileKey> vecKeys;
+				pProfile->getIntersectingTiles(extent, nLevel, vecKeys);
+				for (size_t j = 0; j < vecKeys.size(); j ++)
+					writer.Add(nLevel, vecKeys[j].getTileX(), vecKeys[j].getTileY());
+			}
+		}
+
+		func = [&](unsigned int nLevel, unsigned int x, unsigned int y, std::string& strData) -> bool
+		{
+			osgEarth::TileKey key(nLevel, x, y, pProfile);
+			if (imageLayer.valid())
+			{
+				osgEarth::GeoImage geoImage = imageLayer->createImage(key);
+				return geoImage.valid() && EncodeImage(geoImage.getImage(), info.strFormat, info.nTileSize, strData);
+			}
+
+			osgEarth::GeoHeightField geoHeightField = elevationLayer->createHeightField(key);
+			if (!geoHeightField.valid())
+				return false;
+
+			osg::ref_ptr<osg::HeightField> heightField = geoHeightField.getHeightField();
+			if (heightField->getNumColumns() != info.nTileSize || heightField->getNumRows() != info.nTileSize)
+				heightField = osgEarth::HeightFieldUtils::resampleHeightField(heightField.get(), key.getExtent(),
+					info.nTileSize, info.nTileSize, osgEarth::INTERP_BILINEAR);
+
+			strData.assign(reinterpret_cast<const char*>(&heightField->getHeightList()[0]), info.nTileSize * info.nTileSize * sizeof(float));
+			return true;
+		};
+	}
+
+	unsigned long long nTiles = writer.GetNumTiles();
+	unsigned long long nDone = 0;
+	printf("%llu tiles, levels %u-%u\n", nTiles, nMinLevel, nMaxLevel);
+
+	TileArchiveWriter::ReadFunc funcProgress = [&](unsigned int nLevel, unsigned int x, unsigned int y, std::string& strData) -> bool
+	{
+		if (++ nDone % 1000 == 0)
+			printf("%llu/%llu\n", nDone, nTiles);
+		return func(nLevel, x, y, strData);
+	};
+
+	if (!writer.Write(strOut, funcProgress))
+	{
+		printf("cannot write %s\n", strOut.toLocal8Bit().data());
+		return 1;
+	}
+
+	TileArchive archive;
+	if (!archive.Open(strOut))
+	{
+		printf("cannot read back %s\n", strOut.toLocal8Bit().data());
+		return 1;
+	}
+
+	printf("%llu tiles written to %s\n", archive.GetNumTiles(), strOut.toLocal8Bit().data());
+	return 0;
+}